@@ -7,6 +7,7 @@
 
 #include <array>
 #include <ostream>
+#include <span>
 
 #include "nbl/core/declarations.h"
 #include "nbl/system/path.h"
@@ -14,6 +15,7 @@
 
 #include "nbl/system/ISystem.h"
 #include "nbl/system/IFile.h"
+#include "nbl/system/CWorkStealingThreadPool.h"
 #include "nbl/asset/interchange/IAssetLoader.h"
 #include "nbl/asset/interchange/IAssetWriter.h"
 
@@ -35,9 +37,10 @@ std::function<void(SAssetBundle&)> makeAssetDisposeFunc(const IAssetManager* con
 
 //! Class responsible for handling loading of assets from file system or other resources
 /**
-	It provides a loading, writing and creation functionality that is almost thread-safe.
-	There is one issue with threading, starting loading the same asset at the exact same time 
-	may end up with two copies in the cache.
+	It provides a loading, writing and creation functionality that is thread-safe.
+	Loading the same asset at the same time from many threads only runs the loader once
+	(as long as the top level gets cached), the other threads wait for it and get the cached result.
+	Many assets can be loaded at once with getAssets(), which runs the loads on a shared pool of worker threads.
 
 	IAssetManager performs caching of CPU assets associated with resource handles such as names, 
 	filenames, UUIDs. However there are separate caches for each asset type.
@@ -123,14 +126,66 @@ class NBL_API2 IAssetManager : public core::IReferenceCounted, public core::Quit
         // called as a part of constructor only
         void initializeMeshTools();
 
+        // the normal quantization cache is expensive to fill, so it gets kept across runs
+        system::path m_quantNormalCachePath;
+        size_t m_quantNormalCacheLoadedCount = 0ull;
+        void loadQuantNormalCache();
+        void saveQuantNormalCache();
+
+        //! A load which will end up in the cache, so whoever else wants it meanwhile can wait instead of loading a copy
+        struct SInFlightLoad
+        {
+            std::thread::id owner;
+            std::atomic_bool done = false;
+            SAssetBundle result;
+        };
+        std::mutex m_inFlightLock;
+        core::unordered_map<std::string,std::shared_ptr<SInFlightLoad>> m_inFlight;
+        //! Returns nullptr if the caller should just load without tracking, otherwise `_owner` tells whether to load or wait
+        std::shared_ptr<SInFlightLoad> beginLoad(const std::string& _key, bool& _owner);
+        void finishLoad(const std::string& _key, SInFlightLoad& _load, const SAssetBundle& _result);
+        void waitForLoad(const SInFlightLoad& _load);
+        //! Finishes the load when going out of scope, so nobody waits forever on a loader which threw
+        struct SInFlightLoadGuard
+        {
+            inline ~SInFlightLoadGuard() {finish({});}
+
+            inline void finish(const SAssetBundle& _result)
+            {
+                if (!load)
+                    return;
+                manager->finishLoad(key,*load,_result);
+                load = nullptr;
+            }
+
+            IAssetManager* manager;
+            std::string key;
+            std::shared_ptr<SInFlightLoad> load;
+        };
+
+        // created on first use of `getAssets`
+        std::once_flag m_loadPoolInit;
+        std::atomic_bool m_loadPoolReady = false;
+        core::smart_refctd_ptr<system::CWorkStealingThreadPool> m_loadPool;
+        system::CWorkStealingThreadPool* getLoadPool();
+        //! What loaders (and `getAssetsInHierarchy`) wait on their tasks with, see `waitForLoad` for why it matters
+        void waitForLoadTasks(const system::CWorkStealingThreadPool::CTaskGroup& _group);
+
     public:
+        //! In the system's temporary directory
+        static system::path getDefaultQuantNormalCachePath();
+
         //! Constructor
-        explicit IAssetManager(core::smart_refctd_ptr<system::ISystem>&& system, core::smart_refctd_ptr<CCompilerSet>&& compilerSet = nullptr) :
+        /** The 10-10-10-2 normal quantization cache of the mesh manipulator gets loaded from `quantNormalCachePath` here and written back on destruction if it grew,
+        pass an empty path to disable that. */
+        explicit IAssetManager(core::smart_refctd_ptr<system::ISystem>&& system, core::smart_refctd_ptr<CCompilerSet>&& compilerSet = nullptr, system::path&& quantNormalCachePath = getDefaultQuantNormalCachePath()) :
             m_system(std::move(system)),
             m_compilerSet(std::move(compilerSet)),
-            m_defaultLoaderOverride(this)
+            m_defaultLoaderOverride(this),
+            m_quantNormalCachePath(std::move(quantNormalCachePath))
         {
             initializeMeshTools();
+            loadQuantNormalCache();
 
             for (size_t i = 0u; i < m_assetCache.size(); ++i)
                 m_assetCache[i] = new AssetCacheType(asset::makeAssetGreetFunc(this), asset::makeAssetDisposeFunc(this));
@@ -151,6 +206,7 @@ class NBL_API2 IAssetManager : public core::IReferenceCounted, public core::Quit
 		virtual ~IAssetManager()
 		{
             quitEventHandler.execute();
+            saveQuantNormalCache();
 
 			for (size_t i = 0u; i < m_assetCache.size(); ++i)
 				if (m_assetCache[i])
@@ -243,6 +299,31 @@ class NBL_API2 IAssetManager : public core::IReferenceCounted, public core::Quit
             if (!file)
                 return {};//return empty bundle
 
+            // someone else might be loading the same cached asset right now, in which case we wait for them and take it from the cache
+            const bool willBeCached = (levelFlags & IAssetLoader::ECF_DONT_CACHE_TOP_LEVEL) != IAssetLoader::ECF_DONT_CACHE_TOP_LEVEL;
+            bool loadOwner = true;
+            auto inFlight = willBeCached ? beginLoad(filename.string(), loadOwner) : nullptr;
+            if (!loadOwner)
+            {
+                waitForLoad(*inFlight);
+                auto found = findAssets(filename.string());
+                if (found->size())
+                    return _override->chooseRelevantFromFound(found->begin(), found->end(), ctx, _hierarchyLevel);
+                return inFlight->result;
+            }
+            SInFlightLoadGuard inFlightGuard{this,filename.string(),std::move(inFlight)};
+            // the asset could have been cached between the lookup above and becoming the owner
+            if (inFlightGuard.load && (levelFlags & IAssetLoader::ECF_DUPLICATE_TOP_LEVEL) != IAssetLoader::ECF_DUPLICATE_TOP_LEVEL)
+            {
+                auto found = findAssets(filename.string());
+                if (found->size())
+                {
+                    bundle = _override->chooseRelevantFromFound(found->begin(), found->end(), ctx, _hierarchyLevel);
+                    inFlightGuard.finish(bundle);
+                    return bundle;
+                }
+            }
+
             auto ext = system::extension_wo_dot(filename);
             auto capableLoadersRng = m_loaders.perFileExt.findRange(ext);
             // loaders associated with the file's extension tryout
@@ -270,6 +351,7 @@ class NBL_API2 IAssetManager : public core::IReferenceCounted, public core::Quit
                 if (!bundle.getContents().empty() && addToCache)
                     _override->insertAssetIntoCache(bundle, filename.string(), ctx, _hierarchyLevel);
             }
+            inFlightGuard.finish(bundle);
 
             auto whole_bundle_not_dummy = [restoreLevels](const SAssetBundle& _b) {
                 auto rng = _b.getContents();
@@ -387,6 +469,10 @@ class NBL_API2 IAssetManager : public core::IReferenceCounted, public core::Quit
             return getAssetInHierarchy_impl<true>(_filename, _params, _hierarchyLevel);
         }
 
+        //! Loads every one of `_filenames` as a separate task on the load pool and waits for all of them (running tasks itself meanwhile).
+        /** When called by a loader running on the pool, the loads become child tasks which idle workers can steal. */
+        core::vector<SAssetBundle> getAssetsInHierarchy(std::span<const std::string> _filenames, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel, IAssetLoader::IAssetLoaderOverride* _override);
+
     public:
         //! These can be grabbed and dropped, but you must not use drop() to try to unload/release memory of a cached IAsset (which is cached if IAsset::isInAResourceCache() returns true). See IAsset::E_CACHING_FLAGS
         /** Instead for a cached asset you call IAsset::removeSelfFromCache() instead of IAsset::drop() as the cache has an internal grab of the IAsset and it will drop it on removal from cache, which will result in deletion if nothing else is holding onto the IAsset through grabs (in that sense the last drop will delete the object). */
@@ -431,6 +517,18 @@ class NBL_API2 IAssetManager : public core::IReferenceCounted, public core::Quit
             return getAssetWholeBundleRestore(_file, _supposedFilename, _params, &m_defaultLoaderOverride);
         }
 
+        //! Loads many assets concurrently, the returned bundles are in the same order as `_filenames`.
+        /** The loads run on a pool of worker threads (one less than there are hardware threads, the calling thread helps out until the batch is done).
+        Same as with getAsset(), requests for an asset which is already being loaded wait for that load instead of starting another. */
+        core::vector<SAssetBundle> getAssets(std::span<const std::string> _filenames, const IAssetLoader::SAssetLoadParams& _params, IAssetLoader::IAssetLoaderOverride* _override)
+        {
+            return getAssetsInHierarchy(_filenames, _params, 0u, _override);
+        }
+        core::vector<SAssetBundle> getAssets(std::span<const std::string> _filenames, const IAssetLoader::SAssetLoadParams& _params)
+        {
+            return getAssets(_filenames, _params, &m_defaultLoaderOverride);
+        }
+
         //TODO change name
 		//! Check whether Assets exist in cache using a key and optionally their types
 		/*
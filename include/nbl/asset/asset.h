@@ -17,6 +17,7 @@
 // format
 #include "nbl/asset/format/EFormat.h"
 #include "nbl/asset/format/convertColor.h"
+#include "nbl/asset/format/convertPixelRow.h"
 #include "nbl/asset/format/decodePixels.h"
 #include "nbl/asset/format/encodePixels.h"
 
@@ -34,6 +35,7 @@
 #include "nbl/asset/filters/CPaddedCopyImageFilter.h"
 #include "nbl/asset/filters/CConvertFormatImageFilter.h"
 #include "nbl/asset/filters/CSwizzleAndConvertImageFilter.h"
+#include "nbl/asset/filters/CBlockCompressionImageFilter.h"
 #include "nbl/asset/filters/CFlattenRegionsImageFilter.h"
 #include "nbl/asset/filters/CMipMapGenerationImageFilter.h"
 #include "nbl/asset/filters/CSummedAreaTableImageFilter.h"
@@ -83,5 +85,6 @@
 // #include "nbl/asset/utils/CCPUMeshPackerV1.h"
 // #include "nbl/asset/utils/CCPUMeshPackerV2.h"
 #include "nbl/asset/utils/ICPUVirtualTexture.h"
+#include "nbl/asset/utils/CVirtualTextureResidencyManager.h"
 
 #endif
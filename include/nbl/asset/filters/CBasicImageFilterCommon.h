@@ -9,6 +9,8 @@
 #include "nbl/core/execution.h"
 
 #include <algorithm>
+#include <atomic>
+#include <thread>
 
 #include "nbl/asset/filters/IImageFilter.h"
 
@@ -158,88 +160,66 @@ class CBasicImageFilterCommon
 				}
 		};
 
-		template<class ExecutionPolicy, typename F>
-		static inline void executePerBlock(ExecutionPolicy&& policy, const ICPUImage* image, const IImage::SBufferCopy& region, F& f)
+		//! Hands out indices of scratch arenas to tasks running concurrently, so each can have its own, no matter how many threads there are
+		class CScratchArenaAllocator
 		{
-			const auto& subresource = region.imageSubresource;
-
-			const auto& params = image->getCreationParameters();
-			TexelBlockInfo blockInfo(params.format);
-
-			core::vectorSIMDu32 trueOffset;
-			trueOffset.x = region.imageOffset.x;
-			trueOffset.y = region.imageOffset.y;
-			trueOffset.z = region.imageOffset.z;
-			trueOffset = blockInfo.convertTexelsToBlocks(trueOffset);
-			trueOffset.w = subresource.baseArrayLayer;
-			
-			core::vectorSIMDu32 trueExtent;
-			trueExtent.x = region.imageExtent.width;
-			trueExtent.y = region.imageExtent.height;
-			trueExtent.z = region.imageExtent.depth;
-			trueExtent  = blockInfo.convertTexelsToBlocks(trueExtent);
-			trueExtent.w = subresource.layerCount;
-
-			const auto strides = region.getByteStrides(blockInfo);
-			
-			auto batch1D = [&f,&region,trueExtent,strides,trueOffset](const std::array<uint32_t,3u>& batchCoord)
-			{
-				for (auto xBlock=0u; xBlock<trueExtent.x; ++xBlock)
+			public:
+				explicit inline CScratchArenaAllocator(const uint32_t arenaCount) : m_wordCount((arenaCount+63u)/64u), m_used(std::make_unique<std::atomic_uint64_t[]>(m_wordCount))
 				{
-					const core::vectorSIMDu32 localCoord(xBlock,batchCoord[0],batchCoord[1],batchCoord[2]);
-					f(region.getByteOffset(localCoord,strides),localCoord+trueOffset);
+					for (uint32_t i=0u; i<m_wordCount; i++)
+						m_used[i].store(0ull,std::memory_order_relaxed);
+					// the bits past the end are never free
+					if (arenaCount%64u)
+						m_used[m_wordCount-1u].store(~0ull<<(arenaCount%64u),std::memory_order_relaxed);
 				}
-			};
-			auto batch2D = [&f,&region,trueExtent,strides,trueOffset](const std::array<uint32_t,2u>& batchCoord)
-			{
-				for (auto yBlock=0u; yBlock<trueExtent.y; ++yBlock)
-				for (auto xBlock=0u; xBlock<trueExtent.x; ++xBlock)
+
+				template<bool isSeqPolicy>
+				inline uint32_t alloc()
 				{
-					const core::vectorSIMDu32 localCoord(xBlock,yBlock,batchCoord[0],batchCoord[1]);
-					f(region.getByteOffset(localCoord,strides),localCoord+trueOffset);
+					if constexpr (isSeqPolicy)
+						return 0u;
+
+					while (true)
+					{
+						for (uint32_t i=0u; i<m_wordCount; i++)
+						{
+							uint64_t used = m_used[i].load(std::memory_order_relaxed);
+							while (~used)
+							{
+								const uint32_t firstFree = core::findLSB(~used);
+								if (m_used[i].compare_exchange_weak(used,used|(0x1ull<<firstFree),std::memory_order_acquire,std::memory_order_relaxed))
+									return i*64u+firstFree;
+							}
+						}
+						// more tasks in flight than arenas, wait for one to finish
+						std::this_thread::yield();
+					}
 				}
-			};
-			auto batch3D = [&f,&region,trueExtent,strides,trueOffset](const std::array<uint32_t,1u>& batchCoord)
-			{
-				for (auto zBlock=0u; zBlock<trueExtent.z; ++zBlock)
-				for (auto yBlock=0u; yBlock<trueExtent.y; ++yBlock)
-				for (auto xBlock=0u; xBlock<trueExtent.x; ++xBlock)
+
+				template<bool isSeqPolicy>
+				inline void free(const uint32_t index)
 				{
-					const core::vectorSIMDu32 localCoord(xBlock,yBlock,zBlock,batchCoord[0]);
-					f(region.getByteOffset(localCoord,strides),localCoord+trueOffset);
+					if constexpr (!isSeqPolicy)
+						m_used[index/64u].fetch_and(~(0x1ull<<(index%64u)),std::memory_order_release);
 				}
-			};
 
-			constexpr uint32_t batchSizeThreshold = 0x80u;
-			const core::vectorSIMDu32 spaceFillingEnd(0u,0u,0u,trueExtent.w);
-			if (std::is_same_v<ExecutionPolicy,core::execution::sequenced_policy> || trueExtent.x*trueExtent.y<batchSizeThreshold)
-			{
-				constexpr uint32_t batch_dims = 1u;
-				BlockIterator<batch_dims> begin(trueExtent.pointer+4u-batch_dims);
-				BlockIterator<batch_dims> end(begin.getExtentBatches(),spaceFillingEnd.pointer+4u-batch_dims);
-				std::for_each(std::forward<ExecutionPolicy>(policy),begin,end,batch3D);
-			}
-			else if (trueExtent.x<batchSizeThreshold)
-			{
-				constexpr uint32_t batch_dims = 2u;
-				BlockIterator<batch_dims> begin(trueExtent.pointer+4u-batch_dims);
-				BlockIterator<batch_dims> end(begin.getExtentBatches(),spaceFillingEnd.pointer+4u-batch_dims);
-				std::for_each(std::forward<ExecutionPolicy>(policy),begin,end,batch2D);
-			}
-			else
-			{
-				constexpr uint32_t batch_dims = 3u;
-				BlockIterator<batch_dims> begin(trueExtent.pointer+4u-batch_dims);
-				BlockIterator<batch_dims> end(begin.getExtentBatches(),spaceFillingEnd.pointer+4u-batch_dims);
-				std::for_each(std::forward<ExecutionPolicy>(policy),begin,end,batch1D);
-			}
-		}
-		template<typename F>
-		static inline void executePerBlock(const ICPUImage* image, const IImage::SBufferCopy& region, F& f)
+			private:
+				const uint32_t m_wordCount;
+				std::unique_ptr<std::atomic_uint64_t[]> m_used;
+		};
+
+		//! Regions get split into tiles of about this many bytes of texel blocks (whole rows when they fit) for parallel execution, enough to amortize the scheduling and small enough to stay in cache
+		static inline constexpr uint32_t TileByteSize = 0x1u<<16u;
+
+		template<class ExecutionPolicy, typename F>
+		static inline void executePerBlock(ExecutionPolicy&& policy, const ICPUImage* image, const IImage::SBufferCopy& region, F& f)
 		{
-			executePerBlock(core::execution::seq,image,region,f);
-		}
+			constexpr bool is_seq_policy_v = std::is_same_v<std::remove_cvref_t<ExecutionPolicy>,core::execution::sequenced_policy>;
 
+			STiledRegions tiled(image);
+			tiled.template addRegion<is_seq_policy_v>(region);
+			tiled.execute(std::forward<ExecutionPolicy>(policy),f);
+		}
 		struct default_region_functor_t
 		{
 			constexpr default_region_functor_t() = default;
@@ -300,6 +280,9 @@ class CBasicImageFilterCommon
 			}
 		};
 		
+		//! With a parallel policy all tiles of all regions get spread over threads together, unless regions overlap, then they go in waves keeping the order of the overlapping ones.
+		//! This only happens for the region functors which don't carry state between regions (`default_region_functor_t` and `clip_region_functor_t`),
+		//! other functors get called right before their region executes, as `f` might depend on what they did.
 		template<class ExecutionPolicy, typename F, typename G>
 		static inline void executePerRegion(ExecutionPolicy&& policy,
 											const ICPUImage* image, F& f,
@@ -307,11 +290,33 @@ class CBasicImageFilterCommon
 											const IImage::SBufferCopy* _end,
 											G& g)
 		{
-			for (auto it=_begin; it!=_end; it++)
+			constexpr bool is_seq_policy_v = std::is_same_v<std::remove_cvref_t<ExecutionPolicy>,core::execution::sequenced_policy>;
+			constexpr bool stateless_region_functor_v = std::is_same_v<std::remove_cv_t<G>,default_region_functor_t> || std::is_same_v<std::remove_cv_t<G>,clip_region_functor_t>;
+			if constexpr (is_seq_policy_v || !stateless_region_functor_v)
 			{
-				IImage::SBufferCopy region = *it;
-				if (g(region,it))
-					executePerBlock<ExecutionPolicy,F>(std::forward<ExecutionPolicy>(policy),image,region,f);
+				for (auto it=_begin; it!=_end; it++)
+				{
+					IImage::SBufferCopy region = *it;
+					if (g(region,it))
+						executePerBlock<ExecutionPolicy,F>(std::forward<ExecutionPolicy>(policy),image,region,f);
+				}
+			}
+			else
+			{
+				STiledRegions wave(image);
+				for (auto it=_begin; it!=_end; it++)
+				{
+					IImage::SBufferCopy region = *it;
+					if (!g(region,it))
+						continue;
+					if (wave.overlaps(region))
+					{
+						wave.execute(policy,f);
+						wave.clear();
+					}
+					wave.template addRegion<false>(region);
+				}
+				wave.execute(policy,f);
 			}
 		}
 		template<typename F, typename G>
@@ -334,6 +339,144 @@ class CBasicImageFilterCommon
 	protected:
 		virtual NBL_API2 ~CBasicImageFilterCommon() =0;
 
+		//! Regions of one image cut up into tiles, the unit of work handed out to threads
+		class STiledRegions
+		{
+			public:
+				explicit inline STiledRegions(const ICPUImage* _image) : blockInfo(_image->getCreationParameters().format), blockByteSize(getTexelOrBlockBytesize(_image->getCreationParameters().format)) {}
+
+				//! sequential execution gets the whole region as one tile, so `f` sees the blocks in the same order as always
+				template<bool wholeRegionTile>
+				inline void addRegion(const IImage::SBufferCopy& region)
+				{
+					const auto& subresource = region.imageSubresource;
+
+					SRegion info;
+					info.region = region;
+					info.trueOffset.x = region.imageOffset.x;
+					info.trueOffset.y = region.imageOffset.y;
+					info.trueOffset.z = region.imageOffset.z;
+					info.trueOffset = blockInfo.convertTexelsToBlocks(info.trueOffset);
+					info.trueOffset.w = subresource.baseArrayLayer;
+
+					info.trueExtent.x = region.imageExtent.width;
+					info.trueExtent.y = region.imageExtent.height;
+					info.trueExtent.z = region.imageExtent.depth;
+					info.trueExtent = blockInfo.convertTexelsToBlocks(info.trueExtent);
+					info.trueExtent.w = subresource.layerCount;
+
+					info.strides = region.getByteStrides(blockInfo);
+					const uint32_t regionIx = regions.size();
+					regions.push_back(info);
+
+					const auto& extent = info.trueExtent;
+					if ((extent==core::vectorSIMDu32(0u)).any())
+						return;
+					if constexpr (wholeRegionTile)
+					{
+						tiles.push_back({regionIx,core::vectorSIMDu32(0u),extent});
+						return;
+					}
+
+					// grow the tile along x first, then y, z and only then layers, so it covers whole rows of the buffer
+					const uint32_t tileBlocks = core::max(TileByteSize/blockByteSize,1u);
+					core::vectorSIMDu32 tileExtent(1u);
+					uint32_t remaining = tileBlocks;
+					for (uint32_t i=0u; i<4u; i++)
+					{
+						tileExtent[i] = core::max(core::min(extent[i],remaining),1u);
+						remaining /= tileExtent[i];
+						if (tileExtent[i]!=extent[i] || remaining==0u)
+							break;
+					}
+					for (uint32_t w=0u; w<extent.w; w+=tileExtent.w)
+					for (uint32_t z=0u; z<extent.z; z+=tileExtent.z)
+					for (uint32_t y=0u; y<extent.y; y+=tileExtent.y)
+					for (uint32_t x=0u; x<extent.x; x+=tileExtent.x)
+					{
+						const core::vectorSIMDu32 begin(x,y,z,w);
+						tiles.push_back({regionIx,begin,core::min(begin+tileExtent,extent)});
+					}
+				}
+
+				//! whether the region would read or write any texel or buffer byte which the already added ones do
+				inline bool overlaps(const IImage::SBufferCopy& region) const
+				{
+					const auto bufferRange = getBufferRange(region);
+					for (const auto& other : regions)
+					{
+						const auto otherBufferRange = getBufferRange(other.region);
+						if (bufferRange.first<otherBufferRange.second && otherBufferRange.first<bufferRange.second)
+							return true;
+
+						const auto& a = region;
+						const auto& b = other.region;
+						if (a.imageSubresource.mipLevel!=b.imageSubresource.mipLevel)
+							continue;
+						const core::vectorSIMDu32 aBegin(a.imageOffset.x,a.imageOffset.y,a.imageOffset.z,a.imageSubresource.baseArrayLayer);
+						const core::vectorSIMDu32 bBegin(b.imageOffset.x,b.imageOffset.y,b.imageOffset.z,b.imageSubresource.baseArrayLayer);
+						const core::vectorSIMDu32 aEnd = aBegin+core::vectorSIMDu32(a.imageExtent.width,a.imageExtent.height,a.imageExtent.depth,a.imageSubresource.layerCount);
+						const core::vectorSIMDu32 bEnd = bBegin+core::vectorSIMDu32(b.imageExtent.width,b.imageExtent.height,b.imageExtent.depth,b.imageSubresource.layerCount);
+						if ((aBegin<bEnd).allBits() && (bBegin<aEnd).allBits())
+							return true;
+					}
+					return false;
+				}
+
+				template<class ExecutionPolicy, typename F>
+				inline void execute(ExecutionPolicy&& policy, F& f) const
+				{
+					std::for_each(std::forward<ExecutionPolicy>(policy),tiles.begin(),tiles.end(),[&](const STile& tile) -> void
+					{
+						const SRegion& info = regions[tile.regionIx];
+						for (auto wBlock=tile.begin.w; wBlock<tile.end.w; ++wBlock)
+						for (auto zBlock=tile.begin.z; zBlock<tile.end.z; ++zBlock)
+						for (auto yBlock=tile.begin.y; yBlock<tile.end.y; ++yBlock)
+						for (auto xBlock=tile.begin.x; xBlock<tile.end.x; ++xBlock)
+						{
+							const core::vectorSIMDu32 localCoord(xBlock,yBlock,zBlock,wBlock);
+							f(info.region.getByteOffset(localCoord,info.strides),localCoord+info.trueOffset);
+						}
+					});
+				}
+
+				inline void clear()
+				{
+					regions.clear();
+					tiles.clear();
+				}
+
+			private:
+				struct SRegion
+				{
+					IImage::SBufferCopy region;
+					core::vectorSIMDu32 trueOffset;
+					core::vectorSIMDu32 trueExtent;
+					core::vectorSIMDu32 strides;
+				};
+				struct STile
+				{
+					uint32_t regionIx;
+					core::vectorSIMDu32 begin;
+					core::vectorSIMDu32 end;
+				};
+
+				inline std::pair<size_t,size_t> getBufferRange(const IImage::SBufferCopy& region) const
+				{
+					core::vectorSIMDu32 extent(region.imageExtent.width,region.imageExtent.height,region.imageExtent.depth);
+					extent = blockInfo.convertTexelsToBlocks(extent);
+					extent.w = region.imageSubresource.layerCount;
+					const auto strides = region.getByteStrides(blockInfo);
+					const size_t end = region.getByteOffset(extent-core::vectorSIMDu32(1u),strides)+blockByteSize;
+					return {region.bufferOffset,end};
+				}
+
+				const TexelBlockInfo blockInfo;
+				const uint32_t blockByteSize;
+				core::vector<SRegion> regions;
+				core::vector<STile> tiles;
+		};
+
 		static inline bool validateSubresourceAndRange(	const ICPUImage::SSubresourceLayers& subresource,
 														const IImageFilter::IState::TexelRange& range,
 														const ICPUImage* image)
@@ -9,6 +9,7 @@
 
 #include <type_traits>
 #include <algorithm>
+#include <numeric>
 
 #include "nbl/asset/filters/CMatchedSizeInOutImageFilterCommon.h"
 #include "nbl/asset/filters/CSwizzleAndConvertImageFilter.h"
@@ -395,26 +396,29 @@ class CBlitImageFilter :
 					uint32_t* histograms = reinterpret_cast<uint32_t*>(state->scratchMemory + getScratchOffset(state, ESU_ALPHA_HISTOGRAM));
 					memset(histograms, 0, m_maxParallelism* state->alphaBinCount * sizeof(uint32_t));
 
-					ParallelScratchHelper scratchHelper;
+					constexpr bool is_seq_policy_v = std::is_same_v<std::remove_cvref_t<ExecutionPolicy>, core::execution::sequenced_policy>;
+					CBasicImageFilterCommon::CScratchArenaAllocator histogramArenas(m_maxParallelism);
 
-					constexpr bool is_seq_policy_v = std::is_same_v<std::remove_reference_t<ExecutionPolicy>, core::execution::sequenced_policy>;
-
-					struct DummyTexelType
-					{
-						double texel[ChannelCount];
-					};
-					std::for_each(policy, reinterpret_cast<DummyTexelType*>(intermediateStorage[axis]), reinterpret_cast<DummyTexelType*>(intermediateStorage[axis] + outputTexelCount*ChannelCount), [&sampler, outFormat, &histograms, &scratchHelper, alphaChannel, state](const DummyTexelType& dummyTexel)
+					const uint32_t texelsPerTile = core::max<uint32_t>(CBasicImageFilterCommon::TileByteSize/(ChannelCount*sizeof(value_t)),1u);
+					core::vector<uint32_t> tiles((outputTexelCount+texelsPerTile-1u)/texelsPerTile);
+					std::iota(tiles.begin(),tiles.end(),0u);
+					std::for_each(policy, tiles.begin(), tiles.end(), [&sampler, outFormat, histograms, &histogramArenas, alphaChannel, state, intermediateStorage, axis, texelsPerTile, outputTexelCount](const uint32_t tile)
 					{
-						const uint32_t index = scratchHelper.template alloc<is_seq_policy_v>();
+						const uint32_t index = histogramArenas.template alloc<is_seq_policy_v>();
+						uint32_t* const histogram = histograms+index*state->alphaBinCount;
 
-						value_t texelAlpha = dummyTexel.texel[alphaChannel];
-						texelAlpha -= double(sampler.nextSample()) * (asset::getFormatPrecision<value_t>(outFormat, alphaChannel, texelAlpha) / double(~0u));
+						const uint32_t texelEnd = core::min(tile*texelsPerTile+texelsPerTile,outputTexelCount);
+						for (uint32_t texel=tile*texelsPerTile; texel<texelEnd; texel++)
+						{
+							value_t texelAlpha = intermediateStorage[axis][texel*ChannelCount+alphaChannel];
+							texelAlpha -= double(sampler.nextSample()) * (asset::getFormatPrecision<value_t>(outFormat, alphaChannel, texelAlpha) / double(~0u));
 
-						const uint32_t binIndex = uint32_t(core::round(core::clamp(texelAlpha, 0.0, 1.0) * double(state->alphaBinCount - 1)));
-						assert(binIndex < state->alphaBinCount);
-						histograms[index*state->alphaBinCount+binIndex]++;
+							const uint32_t binIndex = uint32_t(core::round(core::clamp(texelAlpha, 0.0, 1.0) * double(state->alphaBinCount - 1)));
+							assert(binIndex < state->alphaBinCount);
+							histogram[binIndex]++;
+						}
 
-						scratchHelper.template free<is_seq_policy_v>(index);
+						histogramArenas.template free<is_seq_policy_v>(index);
 					});
 
 					uint32_t* mergedHistogram = histograms;
@@ -477,7 +481,7 @@ class CBlitImageFilter :
 				const auto windowMinCoord = windowMinCoordBase+vLayer;
 				const auto outOffsetLayer = outOffsetBaseLayer+vLayer;
 				// reset coverage counter
-				constexpr bool is_seq_policy_v = std::is_same_v<std::remove_reference_t<ExecutionPolicy>,core::execution::sequenced_policy>;
+				constexpr bool is_seq_policy_v = std::is_same_v<std::remove_cvref_t<ExecutionPolicy>,core::execution::sequenced_policy>;
 				using cond_atomic_int32_t = std::conditional_t<is_seq_policy_v,int32_t,std::atomic_int32_t>;
 				using cond_atomic_uint32_t = std::conditional_t<is_seq_policy_v,uint32_t,std::atomic_uint32_t>;
 				cond_atomic_uint32_t cvg_num(0u);
@@ -495,24 +499,10 @@ class CBlitImageFilter :
 					// z x y output along y
 					// x y z output along z
 					const int loopCoordID[2] = {/*axis,*/axis!=IImage::ET_2D ? 1:0,axis!=IImage::ET_3D ? 2:0};
-					//
-					assert(is_seq_policy_v || std::thread::hardware_concurrency()<=64u);
-					ParallelScratchHelper scratchHelper;
-
-					constexpr uint32_t batch_dims = 2u;
-					const uint32_t batchExtent[batch_dims] = {
-						static_cast<uint32_t>(intermediateExtent[axis][loopCoordID[0]]),
-						static_cast<uint32_t>(intermediateExtent[axis][loopCoordID[1]])
-					};
-					CBasicImageFilterCommon::BlockIterator<batch_dims> begin(batchExtent);
-					const uint32_t spaceFillingEnd[batch_dims] = {0u,batchExtent[1]};
-					CBasicImageFilterCommon::BlockIterator<batch_dims> end(begin.getExtentBatches(),spaceFillingEnd);
-					std::for_each(policy,begin,end,[&](const std::array<uint32_t,batch_dims>& batchCoord) -> void
+					// the first pass decodes every line into its own arena of the scratch, as many as there can be lines in flight
+					CBasicImageFilterCommon::CScratchArenaAllocator decodeArenas(m_maxParallelism);
+					auto filterLine = [&](const std::array<uint32_t,2u>& batchCoord, const uint32_t decode_offset) -> void
 					{
-						constexpr bool is_seq_policy_v = std::is_same_v<std::remove_reference_t<ExecutionPolicy>, core::execution::sequenced_policy>;
-
-						// we need some tmp memory for threads in the first pass so that they dont step on each other
-						uint32_t decode_offset;
 						// whole line plus window borders
 						value_t* lineBuffer;
 						core::vectorSIMDi32 localTexCoord(0);
@@ -523,7 +513,6 @@ class CBlitImageFilter :
 						else
 						{
 							const auto inputEnd = inExtent.width+real_window_size.x;
-							decode_offset = scratchHelper.template alloc<is_seq_policy_v>();
 							lineBuffer = intermediateStorage[1]+decode_offset*ChannelCount*inputEnd;
 							for (auto& i=localTexCoord.x; i<inputEnd; i++)
 							{
@@ -605,8 +594,35 @@ class CBlitImageFilter :
 							if (++phaseIndex == phaseCount[axis])
 								phaseIndex = 0;
 						}
-						if (axis == IImage::ET_1D)
-							scratchHelper.template free<is_seq_policy_v>(decode_offset);
+					};
+					//
+					constexpr uint32_t batch_dims = 2u;
+					const uint32_t batchExtent[batch_dims] = {
+						static_cast<uint32_t>(intermediateExtent[axis][loopCoordID[0]]),
+						static_cast<uint32_t>(intermediateExtent[axis][loopCoordID[1]])
+					};
+					// consecutive lines get batched into tiles, so a thread grabs a decode arena once per tile and the work still spreads over all threads
+					const uint32_t lineCount = batchExtent[0]*batchExtent[1];
+					const uint32_t lineByteSize = (axis!=IImage::ET_1D ? intermediateExtent[axis-1][axis]:(inExtent.width+real_window_size.x))*ChannelCount*sizeof(value_t);
+					const uint32_t linesPerTile = core::max(core::min(CBasicImageFilterCommon::TileByteSize/lineByteSize,lineCount/(core::max(std::thread::hardware_concurrency(),1u)*4u)),1u);
+					core::vector<uint32_t> tiles((lineCount+linesPerTile-1u)/linesPerTile);
+					std::iota(tiles.begin(),tiles.end(),0u);
+					std::for_each(policy,tiles.begin(),tiles.end(),[&](const uint32_t tile) -> void
+					{
+						// we need some tmp memory for threads in the first pass so that they dont step on each other
+						uint32_t decode_offset = 0u;
+						if (axis==IImage::ET_1D)
+							decode_offset = decodeArenas.template alloc<is_seq_policy_v>();
+
+						const uint32_t lineEnd = core::min(tile*linesPerTile+linesPerTile,lineCount);
+						for (uint32_t line=tile*linesPerTile; line<lineEnd; line++)
+						{
+							const std::array<uint32_t,batch_dims> batchCoord = {line%batchExtent[0],line/batchExtent[0]};
+							filterLine(batchCoord,decode_offset);
+						}
+
+						if (axis==IImage::ET_1D)
+							decodeArenas.template free<is_seq_policy_v>(decode_offset);
 					});
 					// we'll only get here if we have to do coverage adjustment
 					if (needsNormalization && lastPass)
@@ -629,52 +645,7 @@ class CBlitImageFilter :
 
 	private:
 		static inline constexpr uint32_t VectorizationBoundSTL = /*AVX2*/16u;
-		static inline const uint32_t m_maxParallelism = std::thread::hardware_concurrency() * VectorizationBoundSTL;
-
-		class ParallelScratchHelper
-		{
-		public:
-			ParallelScratchHelper()
-			{
-				std::fill_n(indices, VectorizationBoundSTL, ~0ull);
-			}
-
-			template<bool isSeqPolicy>
-			inline uint32_t alloc()
-			{
-				if constexpr (isSeqPolicy)
-					return 0;
-
-				std::unique_lock<std::mutex> lock(mutex);
-				for (uint32_t j = 0u; j < VectorizationBoundSTL; ++j)
-				{
-					int32_t firstFree = core::findLSB(indices[j]);
-					if (firstFree != -1)
-					{
-						indices[j] ^= (0x1u << firstFree); // mark using
-						return j * MaxCores + firstFree;
-					}
-				}
-				assert(false);
-				return 0xdeadbeef;
-			}
-
-			template<bool isSeqPolicy>
-			inline void free(const uint32_t index)
-			{
-				if constexpr (!isSeqPolicy)
-				{
-					std::unique_lock<std::mutex> lock(mutex);
-					indices[index / MaxCores] ^= (0x1u << (index % MaxCores)); // mark free
-				}
-			}
-
-		private:
-			static inline constexpr auto MaxCores = 64;
-
-			uint64_t indices[VectorizationBoundSTL];
-			std::mutex mutex;
-		};
+		static inline const uint32_t m_maxParallelism = core::max(std::thread::hardware_concurrency(),1u) * VectorizationBoundSTL;
 
 		static inline void getIntermediateExtents(core::vectorSIMDi32* intermediateExtent, const state_type* state, const core::vectorSIMDi32& real_window_size)
 		{
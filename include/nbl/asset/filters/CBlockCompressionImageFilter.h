@@ -0,0 +1,195 @@
+// Copyright (C) 2018-2023 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+#ifndef _NBL_ASSET_C_BLOCK_COMPRESSION_IMAGE_FILTER_H_INCLUDED_
+#define _NBL_ASSET_C_BLOCK_COMPRESSION_IMAGE_FILTER_H_INCLUDED_
+
+#include "nbl/core/declarations.h"
+
+#include <numeric>
+
+#include "nbl/asset/filters/CMatchedSizeInOutImageFilterCommon.h"
+#include "nbl/asset/format/convertPixelRow.h"
+
+namespace nbl::asset
+{
+
+//! The block encoders behind `CBlockCompressionImageFilter`, usable on their own
+class NBL_API2 CBlockCompressionImageFilterBase
+{
+	public:
+		//! Trades encode time for quality, mostly through how the endpoints get picked and refined
+		enum E_PRESET : uint8_t
+		{
+			EP_FAST = 0,	//!< principal axis (bounding box for BC1-5) endpoints and a single index pass
+			EP_BALANCED,	//!< principal axis endpoints plus one least squares refinement
+			EP_BEST			//!< several refinement rounds keeping the best, alternate alpha modes and every BC7 p-bit combination
+		};
+
+		//! BC1 to BC5 in all their UNORM, SRGB and SNORM variants, BC6H_UFLOAT and BC7
+		static bool isSupportedFormat(const E_FORMAT format);
+
+		//! Encodes one 4x4 block into `out`, `texels` are row-major and hold values the same way `encodePixels` takes them (so linear for sRGB formats)
+		static void encodeBlock(const E_FORMAT format, const double texels[16][4], void* out, const E_PRESET preset);
+};
+
+//! Block Compression Filter
+/*
+	Compresses a window of an uncompressed image into a BCn format image, the state is the same
+	as for the other matched size in-out filters plus a quality preset.
+	The input format can be anything `decodePixelsRuntime` handles except for integer, planar and compressed formats.
+	The output window has to start on a block boundary, if its extent doesn't end on one then the
+	last row/column/slice inside it gets replicated to fill the partial blocks.
+	Blocks are independent so a parallel policy spreads the block rows over threads.
+
+	@see IImageFilter
+	@see CConvertFormatImageFilter
+*/
+class CBlockCompressionImageFilter : public CImageFilter<CBlockCompressionImageFilter>, public CMatchedSizeInOutImageFilterCommon, public CBlockCompressionImageFilterBase
+{
+	public:
+		virtual ~CBlockCompressionImageFilter() {}
+
+		class CState : public CMatchedSizeInOutImageFilterCommon::state_type
+		{
+			public:
+				virtual ~CState() {}
+
+				E_PRESET preset = EP_BALANCED;
+		};
+		using state_type = CState;
+
+		static inline bool validate(state_type* state)
+		{
+			if (!CMatchedSizeInOutImageFilterCommon::validate(state))
+				return false;
+
+			const auto inFormat = state->inImage->getCreationParameters().format;
+			if (isBlockCompressionFormat(inFormat) || isPlanarFormat(inFormat) || isIntegerFormat(inFormat))
+				return false;
+
+			const auto outFormat = state->outImage->getCreationParameters().format;
+			if (!isSupportedFormat(outFormat))
+				return false;
+
+			const auto blockDims = getBlockDimensions(outFormat);
+			if (state->outOffset.x%blockDims.x || state->outOffset.y%blockDims.y)
+				return false;
+
+			return true;
+		}
+
+		template<class ExecutionPolicy>
+		static inline bool execute(ExecutionPolicy&& policy, state_type* state)
+		{
+			if (!validate(state))
+				return false;
+
+			const auto* const inImg = state->inImage;
+			auto* const outImg = state->outImage;
+			const E_FORMAT inFormat = inImg->getCreationParameters().format;
+			const E_FORMAT outFormat = outImg->getCreationParameters().format;
+			const TexelBlockInfo inInfo(inFormat);
+			const TexelBlockInfo outInfo(outFormat);
+			const uint8_t* const inData = reinterpret_cast<const uint8_t*>(inImg->getBuffer()->getPointer());
+			uint8_t* const outData = reinterpret_cast<uint8_t*>(outImg->getBuffer()->getPointer());
+			const auto inRegions = inImg->getRegions(state->inMipLevel);
+			const E_PRESET preset = state->preset;
+
+			// xyz in texels and the array layer as w, everything below is in output image space
+			const uint32_t windowBegin[4] = {state->outOffset.x,state->outOffset.y,state->outOffset.z,state->outBaseLayer};
+			const uint32_t windowEnd[4] = {windowBegin[0]+state->extent.width,windowBegin[1]+state->extent.height,windowBegin[2]+state->extent.depth,windowBegin[3]+state->layerCount};
+			const uint32_t inBegin[4] = {state->inOffset.x,state->inOffset.y,state->inOffset.z,state->inBaseLayer};
+
+			// returns the input region holding the texel or nullptr
+			auto findInputRegion = [&inRegions](const uint32_t texel[4]) -> const IImage::SBufferCopy*
+			{
+				for (const auto& region : inRegions)
+				{
+					const uint32_t begin[4] = {static_cast<uint32_t>(region.imageOffset.x),static_cast<uint32_t>(region.imageOffset.y),static_cast<uint32_t>(region.imageOffset.z),region.imageSubresource.baseArrayLayer};
+					const uint32_t extent[4] = {region.imageExtent.width,region.imageExtent.height,region.imageExtent.depth,region.imageSubresource.layerCount};
+					bool inside = true;
+					for (auto i=0; i<4; i++)
+						inside = inside && texel[i]>=begin[i] && texel[i]-begin[i]<extent[i];
+					if (inside)
+						return &region;
+				}
+				return nullptr;
+			};
+
+			for (const auto& outRegion : outImg->getRegions(state->outMipLevel))
+			{
+				const uint32_t regionBegin[4] = {static_cast<uint32_t>(outRegion.imageOffset.x),static_cast<uint32_t>(outRegion.imageOffset.y),static_cast<uint32_t>(outRegion.imageOffset.z),outRegion.imageSubresource.baseArrayLayer};
+				const uint32_t regionExtent[4] = {outRegion.imageExtent.width,outRegion.imageExtent.height,outRegion.imageExtent.depth,outRegion.imageSubresource.layerCount};
+				uint32_t begin[4], end[4];
+				bool empty = false;
+				for (auto i=0; i<4; i++)
+				{
+					begin[i] = core::max(windowBegin[i],regionBegin[i]);
+					end[i] = core::min(windowEnd[i],regionBegin[i]+regionExtent[i]);
+					empty = empty || begin[i]>=end[i];
+				}
+				if (empty)
+					continue;
+
+				const auto outByteStrides = outRegion.getByteStrides(outInfo);
+				const uint32_t blocksX = (end[0]-begin[0]+3u)/4u;
+				const uint32_t blocksY = (end[1]-begin[1]+3u)/4u;
+				const uint32_t slices = end[2]-begin[2];
+				core::vector<uint32_t> blockRows(blocksY*slices*(end[3]-begin[3]));
+				std::iota(blockRows.begin(),blockRows.end(),0u);
+				std::for_each(policy,blockRows.begin(),blockRows.end(),[&](const uint32_t blockRow) -> void
+				{
+					const uint32_t layer = begin[3]+blockRow/(blocksY*slices);
+					const uint32_t z = begin[2]+(blockRow/blocksY)%slices;
+					const uint32_t y0 = begin[1]+(blockRow%blocksY)*4u;
+					for (uint32_t blockX=0u; blockX<blocksX; blockX++)
+					{
+						const uint32_t x0 = begin[0]+blockX*4u;
+						double texels[16][4];
+						for (auto& texel : texels)
+						{
+							std::fill_n(texel,3u,0.0);
+							texel[3] = 1.0;
+						}
+						for (uint32_t ty=0u; ty<4u; ty++)
+						{
+							uint32_t texel[4] = {x0,core::min(y0+ty,end[1]-1u),z,layer};
+							for (auto i=0; i<4; i++)
+								texel[i] += inBegin[i]-windowBegin[i];
+							for (uint32_t tx=0u; tx<4u;)
+							{
+								const uint32_t x = core::min(x0+tx,end[0]-1u);
+								texel[0] = x+inBegin[0]-windowBegin[0];
+								const auto* inRegion = findInputRegion(texel);
+								if (!inRegion)
+								{
+									tx++;
+									continue;
+								}
+								const uint32_t localTexel[4] = {texel[0]-inRegion->imageOffset.x,texel[1]-inRegion->imageOffset.y,texel[2]-inRegion->imageOffset.z,texel[3]-inRegion->imageSubresource.baseArrayLayer};
+								const uint8_t* src = inData+inRegion->getByteOffset(core::vectorSIMDu32(localTexel[0],localTexel[1],localTexel[2],localTexel[3]),inRegion->getByteStrides(inInfo));
+								// decode the rest of the block row in one go when it doesn't need clamping and lies within the same region
+								uint32_t count = 1u;
+								if (tx==0u && x0+3u<end[0] && localTexel[0]+3u<inRegion->imageExtent.width)
+									count = 4u;
+								decodePixelRowRuntime(inFormat,src,texels[ty*4u+tx],count);
+								tx += count;
+							}
+						}
+						const core::vectorSIMDu32 localBlock((x0-regionBegin[0])/4u,(y0-regionBegin[1])/4u,z-regionBegin[2],layer-regionBegin[3]);
+						encodeBlock(outFormat,texels,outData+outRegion.getByteOffset(localBlock,outByteStrides),preset);
+					}
+				});
+			}
+			return true;
+		}
+		static inline bool execute(state_type* state)
+		{
+			return execute(core::execution::seq,state);
+		}
+};
+
+} // end namespace nbl::asset
+
+#endif
@@ -9,6 +9,8 @@
 
 #include <type_traits>
 #include <functional>
+#include <numeric>
+#include <thread>
 
 #include "nbl/asset/filters/CMatchedSizeInOutImageFilterCommon.h"
 #include "CConvertFormatImageFilter.h"
@@ -17,6 +19,41 @@ namespace nbl
 {
 namespace asset
 {
+namespace impl
+{
+
+// Kahan's correction term is zero under reassociation, so the one loop that relies on it opts out of /fp:fast and -ffast-math
+#if defined(_MSC_VER) && !defined(__clang__)
+#pragma float_control(precise,on,push)
+#define NBL_SAT_PRECISE_FP
+#elif defined(__clang__)
+#define NBL_SAT_PRECISE_FP
+#elif defined(__GNUC__)
+#define NBL_SAT_PRECISE_FP __attribute__((optimize("no-fast-math")))
+#else
+#define NBL_SAT_PRECISE_FP
+#endif
+//! adds the line at `previous` to the line at `current` in place, carrying the rounding error of every element in `compensation`
+template<typename T>
+NBL_SAT_PRECISE_FP inline void kahanAddLine(T* const current, const T* const previous, T* const compensation, const size_t length)
+{
+	#ifdef __clang__
+	#pragma clang fp reassociate(off)
+	#endif
+	for (size_t i=0u; i<length; i++)
+	{
+		const T y = current[i]-compensation[i];
+		const T t = previous[i]+y;
+		compensation[i] = (t-previous[i])-y;
+		current[i] = t;
+	}
+}
+#undef NBL_SAT_PRECISE_FP
+#if defined(_MSC_VER) && !defined(__clang__)
+#pragma float_control(pop)
+#endif
+
+}
 
 template<bool ExclusiveMode>
 class CSummedAreaTableImageFilterBase
@@ -26,18 +63,28 @@ class CSummedAreaTableImageFilterBase
 		{
 			public:
 
+				//! How the sums of non-integer formats are accumulated, integer formats always sum in `uint64_t`
+				enum E_ACCUMULATION : uint8_t
+				{
+					EA_DOUBLE = 0,		//!< 8 bytes per channel of scratch
+					EA_FLOAT,			//!< half the scratch, sums over large images lose their low bits
+					EA_KAHAN_FLOAT		//!< float scratch with compensated summation along every axis, precision close to `EA_DOUBLE`
+				};
+
 				static inline constexpr size_t decodeTypeByteSize = sizeof(double);
 				uint8_t*	scratchMemory = nullptr;										//!< memory covering all regions used for temporary filling within computation of sum values
 				size_t	scratchMemoryByteSize = {};											//!< required byte size for entire scratch memory
 				bool normalizeImageByTotalSATValues = false;								//!< after sum performation division will be performed for the entire image by the max sum values in (maxX, 0, z) depending on input image - needed for UNORM and SNORM
 				uint8_t axesToSum = 0u;														//!< which axes you want to sum; X: bit0, Y: bit1, Z: bit2 // TODO: make ALL_AXES the default and make sure examples using it work as expected.
+				E_ACCUMULATION accumulation = EA_DOUBLE;
 
-				static inline size_t getRequiredScratchByteSize(const ICPUImage* inputImage, asset::VkExtent3D extent)
+				static inline size_t getRequiredScratchByteSize(const ICPUImage* inputImage, asset::VkExtent3D extent, const E_ACCUMULATION accumulation=EA_DOUBLE)
 				{
 					const auto& inputCreationParams = inputImage->getCreationParameters();
 					const auto channels = asset::getFormatChannelCount(inputCreationParams.format);
+					const size_t valueByteSize = isIntegerFormat(inputCreationParams.format)||accumulation==EA_DOUBLE ? decodeTypeByteSize:sizeof(float);
 
-					size_t retval = extent.width * extent.height * extent.depth * channels * decodeTypeByteSize;
+					size_t retval = extent.width * extent.height * extent.depth * channels * valueByteSize;
 					
 					return retval;
 				}
@@ -94,7 +141,7 @@ class CSummedAreaTableImageFilter : public CMatchedSizeInOutImageFilterCommon, p
 			const auto inFormat = inParams.format;
 			const auto outFormat = outParams.format;
 
-			if (state->scratchMemoryByteSize < state_type::getRequiredScratchByteSize(state->inImage, state->extent))
+			if (state->scratchMemoryByteSize < state_type::getRequiredScratchByteSize(state->inImage, state->extent, state->accumulation))
 				return false;
 			
 			if (state->axesToSum == 0u)
@@ -117,9 +164,17 @@ class CSummedAreaTableImageFilter : public CMatchedSizeInOutImageFilterCommon, p
 
 			auto checkFormat = state->inImage->getCreationParameters().format;
 			if (isIntegerFormat(checkFormat))
-				return executeInterprated(std::forward<ExecutionPolicy>(policy), state, reinterpret_cast<uint64_t*>(state->scratchMemory));
-			else
-				return executeInterprated(std::forward<ExecutionPolicy>(policy), state, reinterpret_cast<double*>(state->scratchMemory));
+				return executeInterprated<ExecutionPolicy,uint64_t,false>(std::forward<ExecutionPolicy>(policy), state, reinterpret_cast<uint64_t*>(state->scratchMemory));
+			switch (state->accumulation)
+			{
+				case state_type::EA_FLOAT:
+					return executeInterprated<ExecutionPolicy,float,false>(std::forward<ExecutionPolicy>(policy), state, reinterpret_cast<float*>(state->scratchMemory));
+				case state_type::EA_KAHAN_FLOAT:
+					return executeInterprated<ExecutionPolicy,float,true>(std::forward<ExecutionPolicy>(policy), state, reinterpret_cast<float*>(state->scratchMemory));
+				default:
+					break;
+			}
+			return executeInterprated<ExecutionPolicy,double,false>(std::forward<ExecutionPolicy>(policy), state, reinterpret_cast<double*>(state->scratchMemory));
 		}	
 		static inline bool execute(state_type* state)
 		{
@@ -127,49 +182,85 @@ class CSummedAreaTableImageFilter : public CMatchedSizeInOutImageFilterCommon, p
 		}
 
 	private:
+		// runs `f` for every index in [0,count) spread over the threads of the policy
+		template<class ExecutionPolicy, typename F>
+		static inline void parallelFor(ExecutionPolicy&& policy, const uint32_t count, F&& f)
+		{
+			core::vector<uint32_t> indices(count);
+			std::iota(indices.begin(),indices.end(),0u);
+			std::for_each(policy,indices.begin(),indices.end(),f);
+		}
+
+		/*
+			Inclusive prefix sum of `steps` lines `stepStride` values apart, each `innerCount` values long, repeated for `outerCount` blocks `outerStride` apart.
+			Every axis is a case of it: X has the channels of a texel as the line, Y a row of the image and Z a whole slice, so the inner loop always walks
+			contiguous memory and vectorizes. Long lines get cut into strips which are scanned independently, that is what spreads the Y and Z passes over threads.
+		*/
+		template<typename T, bool Kahan, class ExecutionPolicy>
+		static inline void prefixSum(ExecutionPolicy&& policy, T* data, const uint32_t outerCount, const size_t outerStride, const uint32_t steps, const size_t stepStride, const size_t innerCount)
+		{
+			// enough strips for every worker to get a few, but not so narrow the inner loop stops paying off
+			constexpr size_t MinStripLength = 256u;
+			constexpr size_t MaxStripLength = 4096u;
+			const size_t targetTasks = size_t(core::max(std::thread::hardware_concurrency(),1u))*4u;
+			const size_t stripsPerLine = core::max<size_t>((targetTasks+outerCount-1u)/outerCount,1u);
+			const size_t stripLength = core::max(core::min((innerCount+stripsPerLine-1u)/stripsPerLine,MaxStripLength),core::min(MinStripLength,innerCount));
+			const uint32_t strips = static_cast<uint32_t>((innerCount+stripLength-1u)/stripLength);
+			parallelFor(policy,outerCount*strips,[&](const uint32_t task) -> void
+			{
+				const size_t stripBegin = (task%strips)*stripLength;
+				const size_t length = core::min(stripLength,innerCount-stripBegin);
+				T* const base = data+(task/strips)*outerStride+stripBegin;
+				if constexpr (Kahan)
+				{
+					// the running sum is the previous line itself, only the lost low bits need keeping
+					T compensation[MaxStripLength];
+					std::fill_n(compensation,length,T(0));
+					for (uint32_t step=1u; step<steps; step++)
+					{
+						T* const current = base+step*stepStride;
+						impl::kahanAddLine(current,current-stepStride,compensation,length);
+					}
+				}
+				else
+				{
+					for (uint32_t step=1u; step<steps; step++)
+					{
+						T* const current = base+step*stepStride;
+						const T* const previous = current-stepStride;
+						for (size_t i=0u; i<length; i++)
+							current[i] += previous[i];
+					}
+				}
+			});
+		}
 
-		template<class ExecutionPolicy, typename decodeType> //!< double or uint64_t
-		static inline bool executeInterprated(ExecutionPolicy&& policy, state_type* state, decodeType* scratchMemory)
+		template<class ExecutionPolicy, typename T, bool Kahan> //!< T is the scratch storage: double, float or uint64_t
+		static inline bool executeInterprated(ExecutionPolicy&& policy, state_type* state, T* scratchMemory)
 		{
+			// what the texels decode to and encode from, the sums get computed in `T`
+			using decodeType = std::conditional_t<std::is_integral_v<T>,uint64_t,double>;
+
 			const asset::E_FORMAT inFormat = state->inImage->getCreationParameters().format;
 			const asset::E_FORMAT outFormat = state->outImage->getCreationParameters().format;
-			const auto inTexelByteSize = asset::getTexelOrBlockBytesize(inFormat);
-			const auto outTexelByteSize = asset::getTexelOrBlockBytesize(outFormat);
 			const auto currentChannelCount = asset::getFormatChannelCount(inFormat);
-			const auto arrayLayers = state->inImage->getCreationParameters().arrayLayers;
 			static constexpr auto maxChannels = 4u;
 
 			#ifdef _NBL_DEBUG
 			memset(scratchMemory, 0, state->scratchMemoryByteSize);
 			#endif // _NBL_DEBUG
 
-			const core::vector3du32_SIMD scratchByteStrides = [&]()
-			{
-				const core::vectorSIMDu32 trueExtent = state->extentLayerCount;
-
-				switch (currentChannelCount)
-				{
-					case 1:
-					{
-						return TexelBlockInfo(asset::E_FORMAT::EF_R64_SFLOAT).convert3DTexelStridesTo1DByteStrides(trueExtent);
-					}
+			const size_t rowLength = size_t(state->extent.width)*currentChannelCount;
+			const size_t sliceLength = rowLength*state->extent.height;
+			const uint32_t rowCount = state->extent.height*state->extent.depth;
+			const core::vector3du32_SIMD scratchByteStrides(sizeof(T)*currentChannelCount, sizeof(T)*rowLength, sizeof(T)*sliceLength);
 
-					case 2:
-					{
-						return TexelBlockInfo(asset::E_FORMAT::EF_R64G64_SFLOAT).convert3DTexelStridesTo1DByteStrides(trueExtent);
-					}
-
-					case 3:
-					{
-						return TexelBlockInfo(asset::E_FORMAT::EF_R64G64B64_SFLOAT).convert3DTexelStridesTo1DByteStrides(trueExtent);
-					}
-					case 4:
-					{
-						return TexelBlockInfo(asset::E_FORMAT::EF_R64G64B64A64_SFLOAT).convert3DTexelStridesTo1DByteStrides(trueExtent);
-					}
-				}
-			}();
-			const auto scratchTexelByteSize = scratchByteStrides[0];
+			auto storeToScratch = [&](const size_t offset, const decodeType* values) -> void
+			{
+				T* dst = reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(scratchMemory)+offset);
+				for (auto i = 0u; i < currentChannelCount; ++i)
+					dst[i] = static_cast<T>(values[i]);
+			};
 
 			const auto&& [copyInBaseLayer, copyOutBaseLayer, copyLayerCount] = std::make_tuple(state->inBaseLayer, state->outBaseLayer, state->layerCount);
 			state->layerCount = 1u;
@@ -182,11 +273,8 @@ class CSummedAreaTableImageFilter : public CMatchedSizeInOutImageFilterCommon, p
 				state->layerCount = copyLayerCount;
 			};
 
-			for (uint16_t w = 0u; w < copyLayerCount; ++w) // this could be parallelized
+			for (uint16_t w = 0u; w < copyLayerCount; ++w) // the scratch covers a single layer
 			{
-				std::array<decodeType, maxChannels> minDecodeValues = {};
-				std::array<decodeType, maxChannels> maxDecodeValues = {};
-
 				{
 					const uint8_t* inData = reinterpret_cast<const uint8_t*>(state->inImage->getBuffer()->getPointer());
 					const auto blockDims = asset::getBlockDimensions(state->inImage->getCreationParameters().format);
@@ -200,7 +288,7 @@ class CSummedAreaTableImageFilter : public CMatchedSizeInOutImageFilterCommon, p
 					bool is2DAndBelow = state->inImage->getCreationParameters().type == IImage::ET_2D;
 					bool is3DAndBelow = state->inImage->getCreationParameters().type == IImage::ET_3D;
 					const core::vectorSIMDu32 limit(1, is2DAndBelow, is3DAndBelow);
-					const core::vectorSIMDu32 movingExclusiveVector = limit, movingOnYZorXZorXYCheckingVector = limit;
+					const core::vectorSIMDu32 movingExclusiveVector = limit;
 
 					auto decode = [&](uint32_t readBlockArrayOffset, core::vectorSIMDu32 readBlockPos) -> void
 					{
@@ -223,7 +311,7 @@ class CSummedAreaTableImageFilter : public CMatchedSizeInOutImageFilterCommon, p
 									{
 										asset::decodePixelsRuntime(inFormat, inSourcePixels, decodeBuffer, blockX, blockY);
 										const size_t movedOffset = asset::IImage::SBufferCopy::getLocalByteOffset(core::vector3du32_SIMD(movedLocalOutPos.x + blockX, movedLocalOutPos.y + blockY, movedLocalOutPos.z), scratchByteStrides);
-										memcpy(reinterpret_cast<uint8_t*>(scratchMemory) + movedOffset, decodeBuffer, scratchTexelByteSize);
+										storeToScratch(movedOffset, decodeBuffer);
 									}
 							}
 						}
@@ -235,7 +323,7 @@ class CSummedAreaTableImageFilter : public CMatchedSizeInOutImageFilterCommon, p
 								{
 									asset::decodePixelsRuntime(inFormat, inSourcePixels, decodeBuffer, blockX, blockY);
 									const size_t offset = asset::IImage::SBufferCopy::getLocalByteOffset(core::vector3du32_SIMD(localOutPos.x + blockX, localOutPos.y + blockY, localOutPos.z), scratchByteStrides);
-									memcpy(reinterpret_cast<uint8_t*>(scratchMemory) + offset, decodeBuffer, scratchTexelByteSize);
+									storeToScratch(offset, decodeBuffer);
 								}
 						}
 					};
@@ -249,132 +337,76 @@ class CSummedAreaTableImageFilter : public CMatchedSizeInOutImageFilterCommon, p
 
 					if constexpr (ExclusiveMode)
 					{
-						core::vector3du32_SIMD localCoord;
-						for (auto& z = localCoord[2] = 0u; z < state->extent.depth; ++z) // TODO: parallelize
-							for (auto& y = localCoord[1] = 0u; y < state->extent.height; ++y)
-								for (auto& x = localCoord[0] = 0u; x < state->extent.width; ++x)
-								{
-									auto resetSATMemory = [&](const core::vector3du32_SIMD& position)
-									{
-										const size_t offset = asset::IImage::SBufferCopy::getLocalByteOffset(position, scratchByteStrides);
-										memset(reinterpret_cast<uint8_t*>(scratchMemory) + offset, 0, scratchTexelByteSize);
-									};
-
-									const auto doesItMoveOnYZorXZorXY = (localCoord < movingOnYZorXZorXYCheckingVector);
-									if (doesItMoveOnYZorXZorXY.any())
-										resetSATMemory(localCoord);
-								}
+						// zero the leading planes the decoded texels got shifted away from
+						parallelFor(policy, rowCount, [&](const uint32_t row) -> void
+						{
+							const uint32_t y = row % state->extent.height;
+							const uint32_t z = row / state->extent.height;
+							T* const rowData = scratchMemory + size_t(row) * rowLength;
+							if (y < limit.y || z < limit.z)
+								std::fill_n(rowData, rowLength, T(0));
+							else if (limit.x)
+								std::fill_n(rowData, currentChannelCount * core::min(limit.x, state->extent.width), T(0));
+						});
 					}
 				}
 
 				{
-					auto getScratchPixel = [&](core::vector4di32_SIMD readBlockPos) -> decodeType*
-					{
-						const size_t scratchOffset = asset::IImage::SBufferCopy::getLocalByteOffset(core::vector3du32_SIMD(readBlockPos.x, readBlockPos.y, readBlockPos.z, 0), scratchByteStrides);
-						return reinterpret_cast<decodeType*>(reinterpret_cast<uint8_t*>(scratchMemory) + scratchOffset);
-					};
-
-					auto sum = [&](core::vectorSIMDi32 readBlockPos) -> void
+					/*
+						A summed area table is the prefix sum along each summed axis in turn, so the axes get scanned separately
+						instead of the per texel inclusion-exclusion recurrence which had to go serially through the whole image.
+					*/
+					if (state->axesToSum & 0x1u)
+						prefixSum<T,Kahan>(policy, scratchMemory, rowCount, rowLength, state->extent.width, currentChannelCount, currentChannelCount);
+					if (state->axesToSum & 0x2u)
+						prefixSum<T,Kahan>(policy, scratchMemory, state->extent.depth, sliceLength, state->extent.height, rowLength, rowLength);
+					if (state->axesToSum & 0x4u)
+						prefixSum<T,Kahan>(policy, scratchMemory, 1u, 0u, state->extent.depth, sliceLength, sliceLength);
+
+					// per row ranges of the final sums, starting out at 0 like the totals
+					core::vector<std::array<decodeType,maxChannels>> rowMinValues(rowCount), rowMaxValues(rowCount);
+					parallelFor(policy, rowCount, [&](const uint32_t row) -> void
 					{
-						decodeType* current = getScratchPixel(readBlockPos);
-
-						auto areAxisSafe = [&]()
-						{
-							const auto position = core::vectorSIMDi32(0u, 0u, 0u, 0u);
-
-							const bool shouldSumX = (state->axesToSum >> 0) & 0x1u;
-							const bool shouldSumY = (state->axesToSum >> 1) & 0x1u;
-							const bool shouldSumZ = (state->axesToSum >> 2) & 0x1u;
-
-							return core::vector4du32_SIMD
-							(
-								(readBlockPos.x > position.x) && (shouldSumX),
-								(readBlockPos.y > position.y) && (shouldSumY),
-								(readBlockPos.z > position.z) && (shouldSumZ),
-								(readBlockPos.w > position.w)
-							);
-						};
-
-						auto addScratchPixelToCurrentOne = [&](const decodeType* values)
-						{
-							for (auto i = 0; i < currentChannelCount; ++i)
-								current[i] += values[i];
-						};
-						
-						auto substractScratchPixelFromCurrentOne = [&](const decodeType* values)
-						{
-							for (auto i = 0; i < currentChannelCount; ++i)
-								current[i] -= values[i];
-						};
-
-						const auto axisSafe = areAxisSafe();
-
-						if (axisSafe.z)
-							addScratchPixelToCurrentOne(getScratchPixel(readBlockPos - core::vectorSIMDi32(0, 0, 1, 0)));					// add box x<=current_x && y<=current_y && z<current_z
-						if (axisSafe.y)
-						{
-							addScratchPixelToCurrentOne(getScratchPixel(readBlockPos - core::vectorSIMDi32(0, 1, 0, 0)));					// add box x<=current_x && y<current_y && z<=current_z
-							if (axisSafe.z)
-								substractScratchPixelFromCurrentOne(getScratchPixel(readBlockPos - core::vectorSIMDi32(0, 1, 1, 0)));		// remove overlap box x<=current_x && y<current_y && z<current_z
-						}
-
-						/*
-							Now I have the sum of all layers below me in the bound x<=current_x && y<=current_y && z<current_z and the current pixel.
-							Time to add the missing top layer pixels.
-						*/
-
-						if (axisSafe.x)
+						auto& minValues = rowMinValues[row];
+						auto& maxValues = rowMaxValues[row];
+						minValues.fill(decodeType(0));
+						maxValues.fill(decodeType(0));
+						const T* const rowData = scratchMemory + size_t(row) * rowLength;
+						for (size_t i = 0u; i < rowLength; i += currentChannelCount)
+						for (uint8_t channel = 0; channel < currentChannelCount; ++channel)
 						{
-							addScratchPixelToCurrentOne(getScratchPixel(readBlockPos - core::vectorSIMDi32(1, 0, 0, 0)));					 // add box x<current_x && y<=current_y && z<=current_z
-							if (axisSafe.z)
-								substractScratchPixelFromCurrentOne(getScratchPixel(readBlockPos - core::vectorSIMDi32(1, 0, 1, 0)));		 // remove overlap box x<current_x && y<=current_y && z<current_z
-							if (axisSafe.y)
-							{
-								substractScratchPixelFromCurrentOne(getScratchPixel(readBlockPos - core::vectorSIMDi32(1, 1, 0, 0)));		 // remove future overlap box x<current_x && y<current_y && z<=current_z
-								if (axisSafe.z)
-									addScratchPixelToCurrentOne(getScratchPixel(readBlockPos - core::vectorSIMDi32(1, 1, 1, 0)));			 // add box x<current_x && y<current_y && z<current_z
-							}
+							const decodeType value = rowData[i + channel];
+							if (maxValues[channel] < value)
+								maxValues[channel] = value;
+							if (minValues[channel] > value)
+								minValues[channel] = value;
 						}
-
-						std::for_each(current, current + currentChannelCount,
-							[&](const decodeType& itrValue)
-							{
-								uint8_t offset = &itrValue - current;
-
-								if (maxDecodeValues[offset] < itrValue)
-									maxDecodeValues[offset] = itrValue;
-
-								if (minDecodeValues[offset] > itrValue)
-									minDecodeValues[offset] = itrValue;
-							}
-						);
-					};
-
+					});
+					std::array<decodeType, maxChannels> minDecodeValues = {};
+					std::array<decodeType, maxChannels> maxDecodeValues = {};
+					for (uint32_t row = 0u; row < rowCount; ++row)
+					for (uint8_t channel = 0; channel < currentChannelCount; ++channel)
 					{
-						core::vector3du32_SIMD localCoord;
-						for (auto& z = localCoord[2] = 0u; z < state->extent.depth; ++z)  // TODO: parallelize (will be tough!)
-							for (auto& y = localCoord[1] = 0u; y < state->extent.height; ++y)
-								for (auto& x = localCoord[0] = 0u; x < state->extent.width; ++x)
-									sum(core::vectorSIMDu32(x, y, z));
+						minDecodeValues[channel] = core::min(minDecodeValues[channel], rowMinValues[row][channel]);
+						maxDecodeValues[channel] = core::max(maxDecodeValues[channel], rowMaxValues[row][channel]);
 					}
 
 					auto normalizeScratch = [&](bool isSignedFormat)
 					{
-						core::vector3du32_SIMD localCoord;
-							for (auto& z = localCoord[2] = 0u; z < state->extent.depth; ++z) // TODO: parallelize
-								for (auto& y = localCoord[1] = 0u; y < state->extent.height; ++y)
-									for (auto& x = localCoord[0] = 0u; x < state->extent.width; ++x)
-									{
-										const size_t scratchOffset = asset::IImage::SBufferCopy::getLocalByteOffset(localCoord, scratchByteStrides);
-										decodeType* entryScratchAdress = reinterpret_cast<decodeType*>(reinterpret_cast<uint8_t*>(scratchMemory) + scratchOffset);
-
-										if(isSignedFormat)
-											for (uint8_t channel = 0; channel < currentChannelCount; ++channel)
-												entryScratchAdress[channel] = (2.0 * entryScratchAdress[channel] - maxDecodeValues[channel] - minDecodeValues[channel]) / (maxDecodeValues[channel] - minDecodeValues[channel]);
-										else
-											for (uint8_t channel = 0; channel < currentChannelCount; ++channel)
-												entryScratchAdress[channel] = (entryScratchAdress[channel] - minDecodeValues[channel]) / (maxDecodeValues[channel] - minDecodeValues[channel]);
-									}
+						parallelFor(policy, rowCount, [&](const uint32_t row) -> void
+						{
+							T* const rowData = scratchMemory + size_t(row) * rowLength;
+							for (size_t i = 0u; i < rowLength; i += currentChannelCount)
+							{
+								T* entryScratchAdress = rowData + i;
+								if(isSignedFormat)
+									for (uint8_t channel = 0; channel < currentChannelCount; ++channel)
+										entryScratchAdress[channel] = static_cast<T>((2.0 * decodeType(entryScratchAdress[channel]) - maxDecodeValues[channel] - minDecodeValues[channel]) / (maxDecodeValues[channel] - minDecodeValues[channel]));
+								else
+									for (uint8_t channel = 0; channel < currentChannelCount; ++channel)
+										entryScratchAdress[channel] = static_cast<T>((decodeType(entryScratchAdress[channel]) - minDecodeValues[channel]) / (maxDecodeValues[channel] - minDecodeValues[channel]));
+							}
+						});
 					};
 
 					bool normalized = asset::isNormalizedFormat(inFormat);
@@ -391,7 +423,10 @@ class CSummedAreaTableImageFilter : public CMatchedSizeInOutImageFilterCommon, p
 							uint8_t* outDataAdress = outData + writeBlockArrayOffset;
 
 							const size_t offset = asset::IImage::SBufferCopy::getLocalByteOffset(localOutPos, scratchByteStrides);
-							asset::encodePixelsRuntime(outFormat, outDataAdress, reinterpret_cast<uint8_t*>(scratchMemory) + offset); // overrrides texels, so region-overlapping case is fine
+							const T* sums = reinterpret_cast<const T*>(reinterpret_cast<uint8_t*>(scratchMemory) + offset);
+							decodeType encodeBuffer[maxChannels] = {};
+							std::copy_n(sums, currentChannelCount, encodeBuffer);
+							asset::encodePixelsRuntime(outFormat, outDataAdress, encodeBuffer); // overrrides texels, so region-overlapping case is fine
 						};
 
 						IImage::SSubresourceLayers subresource = { static_cast<IImage::E_ASPECT_FLAGS>(0u), state->outMipLevel, state->outBaseLayer, 1 };
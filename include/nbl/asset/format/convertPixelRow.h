@@ -0,0 +1,384 @@
+// Copyright (C) 2018-2020 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#ifndef __NBL_ASSET_CONVERT_PIXEL_ROW_H_INCLUDED__
+#define __NBL_ASSET_CONVERT_PIXEL_ROW_H_INCLUDED__
+
+#include <cassert>
+#include <array>
+
+#include "nbl/asset/format/EFormat.h"
+#include "decodePixels.h"
+#include "encodePixels.h"
+
+namespace nbl
+{
+namespace asset
+{
+    /*
+        Row-at-a-time versions of `decodePixelsRuntime` and `encodePixelsRuntime`.
+        Decoded texels are always 4 channels of 8 bytes (`double`, `uint64_t` or `int64_t` depending on the format) laid out back to back,
+        channels the format doesn't have are left untouched exactly like the per-texel functions do.
+        The formats which get streamed the most have dedicated kernels producing the very same bits as the scalar specializations,
+        everything else (and any value the kernels can't prove they'd handle identically) goes through the scalar path texel by texel.
+    */
+    namespace impl
+    {
+        constexpr uint32_t DecodedTexelSize = 4u*sizeof(uint64_t);
+
+        template<uint32_t maxValue>
+        inline const double* getUNORMDecodeLUT()
+        {
+            static const auto lut = []() -> std::array<double,maxValue+1u>
+            {
+                std::array<double,maxValue+1u> retval;
+                for (uint32_t i=0u; i<=maxValue; i++)
+                    retval[i] = i/double(maxValue);
+                return retval;
+            }();
+            return lut.data();
+        }
+        inline const double* getSRGBDecodeLUT()
+        {
+            static const auto lut = []() -> std::array<double,256u>
+            {
+                std::array<double,256u> retval;
+                for (uint32_t i=0u; i<256u; i++)
+                    retval[i] = core::srgb2lin(i/255.);
+                return retval;
+            }();
+            return lut.data();
+        }
+
+        //! `threshold[k]` is the smallest input in [0,1] which the scalar SRGB encode turns into `k` or more (2.0 if none does)
+        struct SSRGBEncodeTable
+        {
+            static inline uint8_t scalarEncode(const double x)
+            {
+                double inp = core::lin2srgb(x);
+                inp *= 255.;
+                return uint64_t(inp)&0xffull;
+            }
+
+            static inline double fromBits(const uint64_t bits)
+            {
+                double retval;
+                memcpy(&retval,&bits,8);
+                return retval;
+            }
+
+            SSRGBEncodeTable()
+            {
+                uint64_t one;
+                {
+                    const double tmp = 1.0;
+                    memcpy(&one,&tmp,8);
+                }
+                threshold[0] = 0.0;
+                for (uint32_t k=1u; k<256u; k++)
+                {
+                    if (scalarEncode(1.0)<k)
+                    {
+                        threshold[k] = 2.0;
+                        continue;
+                    }
+                    // non-negative doubles sort the same as their bit patterns
+                    uint64_t lo = 0ull, hi = one;
+                    while (lo<hi)
+                    {
+                        const uint64_t mid = lo+((hi-lo)>>1u);
+                        if (scalarEncode(fromBits(mid))<k)
+                            lo = mid+1ull;
+                        else
+                            hi = mid;
+                    }
+                    threshold[k] = fromBits(lo);
+                }
+                for (uint32_t b=0u, k=0u; b<BucketCount; b++)
+                {
+                    while (k!=255u && threshold[k+1u]<=double(b)/BucketCount)
+                        k++;
+                    bucketStart[b] = k;
+                }
+            }
+
+            //! `pow` is only accurate to an ULP, so it isn't guaranteed to be monotonic right at a threshold, hand those back to the scalar path
+            inline bool encode(const double x, uint8_t& out) const
+            {
+                if (!(x>=0.0 && x<=1.0))
+                    return false;
+                // the curve's slope never exceeds a code per bucket by much, so this is 0 or 1 steps almost always
+                uint32_t k = bucketStart[core::min(static_cast<uint32_t>(x*BucketCount),BucketCount-1u)];
+                while (k!=255u && threshold[k+1u]<=x)
+                    k++;
+                constexpr double Guard = 1.0/double(1ull<<40);
+                if (k && x-threshold[k]<=threshold[k]*Guard)
+                    return false;
+                if (k!=255u && threshold[k+1u]-x<=x*Guard)
+                    return false;
+                out = k;
+                return true;
+            }
+
+            static inline constexpr uint32_t BucketCount = 4096u;
+            uint8_t bucketStart[BucketCount];
+            double threshold[256];
+        };
+        inline const SSRGBEncodeTable& getSRGBEncodeTable()
+        {
+            static const SSRGBEncodeTable table;
+            return table;
+        }
+
+        template<bool BGRA, bool SRGB>
+        inline void decodeRGBA8Row(const uint32_t* src, double* dst, const uint32_t texelCount)
+        {
+            const double* unorm = getUNORMDecodeLUT<255u>();
+            const double* color = SRGB ? getSRGBDecodeLUT():unorm;
+            for (uint32_t i=0u; i<texelCount; i++,dst+=4)
+            {
+                const uint32_t pix = src[i];
+                dst[BGRA ? 2:0] = color[pix&0xffu];
+                dst[1] = color[(pix>>8u)&0xffu];
+                dst[BGRA ? 0:2] = color[(pix>>16u)&0xffu];
+                dst[3] = unorm[pix>>24u];
+            }
+        }
+
+        //! `_mm_cvttpd_epi32` only agrees with the scalar `uint64_t` cast for products in [0,2^31)
+        inline bool castableToInt32(const __m128d product)
+        {
+            const __m128d ok = _mm_and_pd(_mm_cmpge_pd(product,_mm_setzero_pd()),_mm_cmplt_pd(product,_mm_set1_pd(2147483648.0)));
+            return _mm_movemask_pd(ok)==0x3;
+        }
+
+        template<bool BGRA, bool SRGB>
+        inline void encodeRGBA8Row(uint32_t* dst, const double* src, const uint32_t texelCount)
+        {
+            constexpr E_FORMAT Format = BGRA ? (SRGB ? EF_B8G8R8A8_SRGB:EF_B8G8R8A8_UNORM):(SRGB ? EF_R8G8B8A8_SRGB:EF_R8G8B8A8_UNORM);
+            const __m128d scale = _mm_set1_pd(255.);
+            const auto* srgbTable = SRGB ? &getSRGBEncodeTable():nullptr;
+            for (uint32_t i=0u; i<texelCount; i++,src+=4)
+            {
+                if constexpr (SRGB)
+                {
+                    uint8_t rgb[3];
+                    const double alpha = src[3]*255.;
+                    if (srgbTable->encode(src[0],rgb[0]) && srgbTable->encode(src[1],rgb[1]) && srgbTable->encode(src[2],rgb[2]) && alpha>=0.0 && alpha<2147483648.0)
+                    {
+                        const uint32_t a = static_cast<uint32_t>(alpha)&0xffu;
+                        dst[i] = uint32_t(rgb[BGRA ? 2:0])|(uint32_t(rgb[1])<<8u)|(uint32_t(rgb[BGRA ? 0:2])<<16u)|(a<<24u);
+                        continue;
+                    }
+                }
+                else
+                {
+                    __m128d lo = _mm_mul_pd(_mm_loadu_pd(src),scale);
+                    __m128d hi = _mm_mul_pd(_mm_loadu_pd(src+2),scale);
+                    if (castableToInt32(lo) && castableToInt32(hi))
+                    {
+                        if constexpr (BGRA)
+                        {
+                            const __m128d b = _mm_shuffle_pd(hi,lo,0x2); // {src[2],src[1]}
+                            hi = _mm_shuffle_pd(lo,hi,0x2); // {src[0],src[3]}
+                            lo = b;
+                        }
+                        __m128i v = _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo),_mm_cvttpd_epi32(hi));
+                        v = _mm_and_si128(v,_mm_set1_epi32(0xff));
+                        v = _mm_packus_epi32(v,v);
+                        dst[i] = _mm_cvtsi128_si32(_mm_packus_epi16(v,v));
+                        continue;
+                    }
+                }
+                encodePixels<Format,double>(dst+i,src);
+            }
+        }
+
+        inline void decodeA2B10G10R10Row(const uint32_t* src, double* dst, const uint32_t texelCount)
+        {
+            const double* color = getUNORMDecodeLUT<1023u>();
+            const double* alpha = getUNORMDecodeLUT<3u>();
+            for (uint32_t i=0u; i<texelCount; i++,dst+=4)
+            {
+                const uint32_t pix = src[i];
+                dst[0] = color[pix&0x3ffu];
+                dst[1] = color[(pix>>10u)&0x3ffu];
+                dst[2] = color[(pix>>20u)&0x3ffu];
+                dst[3] = alpha[pix>>30u];
+            }
+        }
+        inline void encodeA2B10G10R10Row(uint32_t* dst, const double* src, const uint32_t texelCount)
+        {
+            const __m128d scale = _mm_set1_pd(1023.);
+            const __m128d alphaScale = _mm_set_pd(3.,1023.);
+            for (uint32_t i=0u; i<texelCount; i++,src+=4)
+            {
+                const __m128d lo = _mm_mul_pd(_mm_loadu_pd(src),scale);
+                const __m128d hi = _mm_mul_pd(_mm_loadu_pd(src+2),alphaScale);
+                if (castableToInt32(lo) && castableToInt32(hi))
+                {
+                    __m128i v = _mm_unpacklo_epi64(_mm_cvttpd_epi32(lo),_mm_cvttpd_epi32(hi));
+                    v = _mm_and_si128(v,_mm_set_epi32(0x3,0x3ff,0x3ff,0x3ff));
+                    dst[i] = uint32_t(_mm_cvtsi128_si32(v))|(uint32_t(_mm_extract_epi32(v,1))<<10u)|(uint32_t(_mm_extract_epi32(v,2))<<20u)|(uint32_t(_mm_extract_epi32(v,3))<<30u);
+                }
+                else
+                    encodePixels<EF_A2B10G10R10_UNORM_PACK32,double>(dst+i,src);
+            }
+        }
+
+        inline void decodeRGBA16FRow(const uint16_t* src, double* dst, const uint32_t texelCount)
+        {
+            for (uint32_t i=0u; i<texelCount; i++,src+=4,dst+=4)
+            {
+                const __m128 v = core::Float16Compressor::decompress4(src);
+                _mm_storeu_pd(dst,_mm_cvtps_pd(v));
+                _mm_storeu_pd(dst+2,_mm_cvtps_pd(_mm_movehl_ps(v,v)));
+            }
+        }
+        inline void encodeRGBA16FRow(uint16_t* dst, const double* src, const uint32_t texelCount)
+        {
+            for (uint32_t i=0u; i<texelCount; i++,src+=4,dst+=4)
+                core::Float16Compressor::compress4(dst,_mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(src)),_mm_cvtpd_ps(_mm_loadu_pd(src+2))));
+        }
+
+        inline void decodeRGBA32FRow(const float* src, double* dst, const uint32_t texelCount)
+        {
+            for (uint32_t i=0u; i<texelCount; i++,src+=4,dst+=4)
+            {
+                const __m128 v = _mm_loadu_ps(src);
+                _mm_storeu_pd(dst,_mm_cvtps_pd(v));
+                _mm_storeu_pd(dst+2,_mm_cvtps_pd(_mm_movehl_ps(v,v)));
+            }
+        }
+        inline void encodeRGBA32FRow(float* dst, const double* src, const uint32_t texelCount)
+        {
+            for (uint32_t i=0u; i<texelCount; i++,src+=4,dst+=4)
+                _mm_storeu_ps(dst,_mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(src)),_mm_cvtpd_ps(_mm_loadu_pd(src+2))));
+        }
+    }
+
+    //! Decodes `texelCount` consecutive texels of `_fmt` from `_src`, see above for the layout of `_output`
+    inline void decodePixelRowRuntime(asset::E_FORMAT _fmt, const void* _src, void* _output, const uint32_t texelCount)
+    {
+        assert(!isBlockCompressionFormat(_fmt) && !isPlanarFormat(_fmt));
+        double* out = reinterpret_cast<double*>(_output);
+        switch (_fmt)
+        {
+            case asset::EF_R8G8B8A8_UNORM:
+                impl::decodeRGBA8Row<false,false>(reinterpret_cast<const uint32_t*>(_src),out,texelCount);
+                return;
+            case asset::EF_R8G8B8A8_SRGB:
+                impl::decodeRGBA8Row<false,true>(reinterpret_cast<const uint32_t*>(_src),out,texelCount);
+                return;
+            case asset::EF_B8G8R8A8_UNORM:
+                impl::decodeRGBA8Row<true,false>(reinterpret_cast<const uint32_t*>(_src),out,texelCount);
+                return;
+            case asset::EF_B8G8R8A8_SRGB:
+                impl::decodeRGBA8Row<true,true>(reinterpret_cast<const uint32_t*>(_src),out,texelCount);
+                return;
+            case asset::EF_A2B10G10R10_UNORM_PACK32:
+                impl::decodeA2B10G10R10Row(reinterpret_cast<const uint32_t*>(_src),out,texelCount);
+                return;
+            case asset::EF_R16G16B16A16_SFLOAT:
+                impl::decodeRGBA16FRow(reinterpret_cast<const uint16_t*>(_src),out,texelCount);
+                return;
+            case asset::EF_R32G32B32A32_SFLOAT:
+                impl::decodeRGBA32FRow(reinterpret_cast<const float*>(_src),out,texelCount);
+                return;
+            case asset::EF_E5B9G9R9_UFLOAT_PACK32:
+                // already just integer ops, what it gains is skipping the per texel format switch
+                for (uint32_t i=0u; i<texelCount; i++)
+                {
+                    const void* srcPix[4] = {reinterpret_cast<const uint32_t*>(_src)+i,nullptr,nullptr,nullptr};
+                    decodePixels<asset::EF_E5B9G9R9_UFLOAT_PACK32,double>(srcPix,out+i*4u,0u,0u);
+                }
+                return;
+            default:
+                break;
+        }
+        const uint32_t texelSize = getTexelOrBlockBytesize(_fmt);
+        for (uint32_t i=0u; i<texelCount; i++)
+        {
+            const void* srcPix[4] = {reinterpret_cast<const uint8_t*>(_src)+i*texelSize,nullptr,nullptr,nullptr};
+            decodePixelsRuntime(_fmt,srcPix,reinterpret_cast<uint8_t*>(_output)+i*impl::DecodedTexelSize,0u,0u);
+        }
+    }
+
+    //! Encodes `texelCount` consecutive texels into `_dst`, `_input` is laid out like the output of `decodePixelRowRuntime`
+    inline void encodePixelRowRuntime(asset::E_FORMAT _fmt, void* _dst, const void* _input, const uint32_t texelCount)
+    {
+        assert(!isBlockCompressionFormat(_fmt) && !isPlanarFormat(_fmt));
+        const double* in = reinterpret_cast<const double*>(_input);
+        switch (_fmt)
+        {
+            case asset::EF_R8G8B8A8_UNORM:
+                impl::encodeRGBA8Row<false,false>(reinterpret_cast<uint32_t*>(_dst),in,texelCount);
+                return;
+            case asset::EF_R8G8B8A8_SRGB:
+                impl::encodeRGBA8Row<false,true>(reinterpret_cast<uint32_t*>(_dst),in,texelCount);
+                return;
+            case asset::EF_B8G8R8A8_UNORM:
+                impl::encodeRGBA8Row<true,false>(reinterpret_cast<uint32_t*>(_dst),in,texelCount);
+                return;
+            case asset::EF_B8G8R8A8_SRGB:
+                impl::encodeRGBA8Row<true,true>(reinterpret_cast<uint32_t*>(_dst),in,texelCount);
+                return;
+            case asset::EF_A2B10G10R10_UNORM_PACK32:
+                impl::encodeA2B10G10R10Row(reinterpret_cast<uint32_t*>(_dst),in,texelCount);
+                return;
+            case asset::EF_R16G16B16A16_SFLOAT:
+                impl::encodeRGBA16FRow(reinterpret_cast<uint16_t*>(_dst),in,texelCount);
+                return;
+            case asset::EF_R32G32B32A32_SFLOAT:
+                impl::encodeRGBA32FRow(reinterpret_cast<float*>(_dst),in,texelCount);
+                return;
+            case asset::EF_E5B9G9R9_UFLOAT_PACK32:
+                for (uint32_t i=0u; i<texelCount; i++)
+                    encodePixels<asset::EF_E5B9G9R9_UFLOAT_PACK32,double>(reinterpret_cast<uint32_t*>(_dst)+i,in+i*4u);
+                return;
+            default:
+                break;
+        }
+        const uint32_t texelSize = getTexelOrBlockBytesize(_fmt);
+        for (uint32_t i=0u; i<texelCount; i++)
+            encodePixelsRuntime(_fmt,reinterpret_cast<uint8_t*>(_dst)+i*texelSize,reinterpret_cast<const uint8_t*>(_input)+i*impl::DecodedTexelSize);
+    }
+
+    //! Row version of the runtime `convertColor` without a swizzle, goes through a small stack buffer so the decoded row stays in L1
+    inline void convertPixelRow(asset::E_FORMAT sF, asset::E_FORMAT dF, const void* _src, void* _dst, const uint32_t texelCount)
+    {
+        constexpr uint32_t ChunkTexels = 64u;
+        uint64_t decbuf[ChunkTexels*4u];
+
+        const uint32_t srcTexelSize = getTexelOrBlockBytesize(sF);
+        const uint32_t dstTexelSize = getTexelOrBlockBytesize(dF);
+        for (uint32_t i=0u; i<texelCount; i+=ChunkTexels)
+        {
+            const uint32_t count = core::min(texelCount-i,ChunkTexels);
+            // same defaults as the compile-time `convertColor` for channels the source format lacks
+            if (isIntegerFormat(sF))
+            {
+                for (uint32_t j=0u; j<count; j++)
+                {
+                    decbuf[j*4u+0u] = decbuf[j*4u+1u] = decbuf[j*4u+2u] = 0ull;
+                    decbuf[j*4u+3u] = 1ull;
+                }
+            }
+            else
+            {
+                double* decoded = reinterpret_cast<double*>(decbuf);
+                for (uint32_t j=0u; j<count; j++)
+                {
+                    decoded[j*4u+0u] = decoded[j*4u+1u] = decoded[j*4u+2u] = 0.0;
+                    decoded[j*4u+3u] = 1.0;
+                }
+            }
+            decodePixelRowRuntime(sF,reinterpret_cast<const uint8_t*>(_src)+i*srcTexelSize,decbuf,count);
+            encodePixelRowRuntime(dF,reinterpret_cast<uint8_t*>(_dst)+i*dstTexelSize,decbuf,count);
+        }
+    }
+}
+}
+
+#endif
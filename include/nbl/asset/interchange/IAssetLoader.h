@@ -9,9 +9,12 @@
 
 #include "nbl/system/ISystem.h"
 #include "nbl/system/ILogger.h"
+#include "nbl/system/CWorkStealingThreadPool.h"
 
 #include "nbl/asset/interchange/SAssetBundle.h"
 
+#include <span>
+
 namespace nbl::asset
 {
 
@@ -82,6 +85,8 @@ public:
 		a way that it'll look correctly in right-handed camera system. If it isn't set, compatibility with 
 		left-handed coordinate camera is assumed.
 		E_LOADER_PARAMETER_FLAGS::ELPF_DONT_COMPILE_GLSL means that GLSL won't be compiled to SPIR-V if it is loaded or generated.
+		E_LOADER_PARAMETER_FLAGS::ELPF_DEDUPLICATE_VERTICES asks loaders of unindexed triangle soups (such as STL) to merge
+		bitwise identical vertices and emit an index buffer instead.
 	*/
 
 	enum E_LOADER_PARAMETER_FLAGS : uint64_t
@@ -89,7 +94,8 @@ public:
 		ELPF_NONE = 0,											//!< default value, it doesn't do anything
 		ELPF_RIGHT_HANDED_MESHES = 0x1,							//!< specifies that a mesh will be flipped in such a way that it'll look correctly in right-handed camera system
 		ELPF_DONT_COMPILE_GLSL = 0x2,							//!< it states that GLSL won't be compiled to SPIR-V if it is loaded or generated
-		ELPF_LOAD_METADATA_ONLY = 0x4							//!< it forces the loader to not load the entire scene for performance in special cases to fetch metadata.
+		ELPF_LOAD_METADATA_ONLY = 0x4,							//!< it forces the loader to not load the entire scene for performance in special cases to fetch metadata.
+		ELPF_DEDUPLICATE_VERTICES = 0x8							//!< loaders which would produce unindexed geometry merge identical vertices and produce an index buffer
 	};
 
     struct SAssetLoadParams
@@ -316,6 +322,13 @@ protected:
 	SAssetBundle interm_getAssetInHierarchyWholeBundleRestore(IAssetManager* _mgr, system::IFile* _file, const std::string& _supposedFilename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel);
 	SAssetBundle interm_getAssetInHierarchyWholeBundleRestore(IAssetManager* _mgr, const std::string& _filename, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel);
 
+	//! For loaders which know many of their dependencies up-front, they get loaded in parallel as child tasks instead of one after the other
+	core::vector<SAssetBundle> interm_getAssetsInHierarchy(IAssetManager* _mgr, std::span<const std::string> _filenames, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel, IAssetLoader::IAssetLoaderOverride* _override);
+	//! The pool `interm_getAssetsInHierarchy` runs on, for loaders which want to spread their own CPU work over it
+	system::CWorkStealingThreadPool* interm_getLoadPool(IAssetManager* _mgr);
+	//! Use instead of `wait` on the load pool, a loader's thread might own loads others are waiting on so it can't run just any task meanwhile
+	void interm_waitForLoadTasks(IAssetManager* _mgr, const system::CWorkStealingThreadPool::CTaskGroup& _group);
+
     void interm_setAssetMutability(const IAssetManager* _mgr, IAsset* _asset, IAsset::E_MUTABILITY _val);
 	//void interm_restoreDummyAsset(IAssetManager* _mgr, SAssetBundle& _bundle);
 	//void interm_restoreDummyAsset(IAssetManager* _mgr, IAsset* _asset, const std::string _path);
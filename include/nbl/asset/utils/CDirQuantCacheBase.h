@@ -9,11 +9,14 @@
 #include <iostream>
 #include <limits>
 #include <cmath>
+#include <numeric>
+#include <shared_mutex>
 
 #include "parallel-hashmap/parallel_hashmap/phmap_dump.h"
 
 
 #include "nbl/core/declarations.h"
+#include "nbl/core/execution.h"
 #include "vectorSIMD.h"
 
 #include "nbl/system/declarations.h"
@@ -243,6 +246,7 @@ struct CDirQuantCacheBase::value_type<EF_R16G16B16A16_SNORM>
 }
 
 
+//! All methods are safe to call from multiple threads, lookups only take a shared lock and the best fit for a miss gets searched without holding any.
 template<typename Key, class Hash, E_FORMAT... Formats>
 class CDirQuantCacheBase : public impl::CDirQuantCacheBase
 { 
@@ -264,9 +268,18 @@ class CDirQuantCacheBase : public impl::CDirQuantCacheBase
 		template<E_FORMAT CacheFormat>
 		inline void insertIntoCache(const Key& key, const value_type_t<CacheFormat>& value)
 		{
+			std::unique_lock lock(cacheLock);
 			std::get<cache_type_t<CacheFormat>>(cache).insert(std::make_pair(key,value));		
 		}
 
+		//!
+		template<E_FORMAT CacheFormat>
+		inline size_t getCacheEntryCount() const
+		{
+			std::shared_lock lock(cacheLock);
+			return std::get<cache_type_t<CacheFormat>>(cache).size();
+		}
+
 		//!
 		template<E_FORMAT CacheFormat>
 		inline bool loadCacheFromBuffer(const SBufferRange<const ICPUBuffer>& buffer, bool replaceCurrentContents = true)
@@ -275,6 +288,7 @@ class CDirQuantCacheBase : public impl::CDirQuantCacheBase
 			if (!validateSerializedCache<CacheFormat>(buffer))
 				return false;
 
+			std::unique_lock lock(cacheLock);
 			auto& particularCache = std::get<cache_type_t<CacheFormat>>(cache);
 			cache_type_t<CacheFormat> backup;
 
@@ -329,11 +343,13 @@ class CDirQuantCacheBase : public impl::CDirQuantCacheBase
 			const uint64_t bufferSize = buffer.buffer.get()->getSize();
 			const uint64_t offset = buffer.offset;
 
-			if (bufferSize+offset>getSerializedCacheSizeInBytes<CacheFormat>())
+			std::shared_lock lock(cacheLock);
+			const auto& particularCache = std::get<cache_type_t<CacheFormat>>(cache);
+			if (offset>bufferSize || bufferSize-offset<getSerializedCacheSizeInBytes_impl<CacheFormat>(particularCache.capacity()))
 				return false;
 
 			CBufferPhmapOutputArchive buffWrap(buffer);
-			return std::get<cache_type_t<CacheFormat>>(cache).dump(buffWrap);
+			return particularCache.dump(buffWrap);
 		}
 
 		//!
@@ -348,7 +364,9 @@ class CDirQuantCacheBase : public impl::CDirQuantCacheBase
 			bufferRange.size = getSerializedCacheSizeInBytes<CacheFormat>();
 			bufferRange.buffer = core::make_smart_refctd_ptr<asset::ICPUBuffer>(bufferRange.size);
 		
-			saveCacheToBuffer<CacheFormat>(bufferRange);
+			// the cache could have grown in between
+			if (!saveCacheToBuffer<CacheFormat>(bufferRange))
+				return false;
 
 			system::IFile::success_t succ;
 			file->write(succ,bufferRange.buffer->getPointer(), 0, bufferRange.buffer->getSize());
@@ -370,11 +388,13 @@ class CDirQuantCacheBase : public impl::CDirQuantCacheBase
 		template<E_FORMAT CacheFormat>
 		inline size_t getSerializedCacheSizeInBytes()
 		{
+			std::shared_lock lock(cacheLock);
 			return getSerializedCacheSizeInBytes_impl<CacheFormat>(std::get<cache_type_t<CacheFormat>>(cache).capacity());
 		}
 
 	protected:
 		std::tuple<cache_type_t<Formats>...> cache;
+		mutable std::shared_mutex cacheLock;
 		
 		template<uint32_t dimensions, E_FORMAT CacheFormat>
 		value_type_t<CacheFormat> quantize(const core::vectorSIMDf& value)
@@ -388,10 +408,15 @@ class CDirQuantCacheBase : public impl::CDirQuantCacheBase
 			value_type_t<CacheFormat> quantized;
 			{
 				auto& particularCache = std::get<cache_type_t<CacheFormat>>(cache);
-				auto found = particularCache.find(key);
-				if (found != particularCache.end() && (found->first == key))
-					quantized = found->second;
-				else
+				bool hit;
+				{
+					std::shared_lock lock(cacheLock);
+					auto found = particularCache.find(key);
+					hit = found != particularCache.end() && (found->first == key);
+					if (hit)
+						quantized = found->second;
+				}
+				if (!hit)
 				{
 					const core::vectorSIMDf fit = findBestFit<dimensions,quantizationBits>(absValue);
 
@@ -400,6 +425,83 @@ class CDirQuantCacheBase : public impl::CDirQuantCacheBase
 				}
 			}
 
+			return restoreSigns<CacheFormat>(quantized,negativeMask);
+		}
+
+		//! Same results as calling `quantize` on every value, but the misses get deduplicated, fitted 4 at a time and spread over threads
+		template<uint32_t dimensions, E_FORMAT CacheFormat>
+		void quantize(const core::vectorSIMDf* values, value_type_t<CacheFormat>* out, const size_t count)
+		{
+			constexpr auto quantizationBits = quantization_bits_v<CacheFormat>;
+			auto& particularCache = std::get<cache_type_t<CacheFormat>>(cache);
+			auto getAbsValue = [values](const size_t i) -> core::vectorSIMDf
+			{
+				core::vectorSIMDf absValue = core::abs(values[i]);
+				if constexpr (dimensions==3u)
+					absValue.makeSafe3D();
+				return absValue;
+			};
+
+			// inputs which missed, and which of the unique missing keys they map to
+			core::vector<std::pair<size_t,uint32_t>> misses;
+			core::vector<core::vectorSIMDf> missingValues;
+			{
+				core::unordered_map<Key,uint32_t,Hash> missingKeys;
+				std::shared_lock lock(cacheLock);
+				for (size_t i=0u; i<count; i++)
+				{
+					const auto absValue = getAbsValue(i);
+					const Key key(absValue);
+					if (auto found=particularCache.find(key); found!=particularCache.end())
+					{
+						out[i] = found->second;
+						continue;
+					}
+					const auto inserted = missingKeys.emplace(key,static_cast<uint32_t>(missingValues.size()));
+					if (inserted.second)
+						missingValues.push_back(absValue);
+					misses.emplace_back(i,inserted.first->second);
+				}
+			}
+
+			if (!missingValues.empty())
+			{
+				core::vector<value_type_t<CacheFormat>> fits(missingValues.size());
+				constexpr size_t ChunkSize = 256u;
+				core::vector<size_t> chunks((missingValues.size()-1u)/ChunkSize+1u);
+				std::iota(chunks.begin(),chunks.end(),0u);
+				std::for_each(core::execution::par_unseq,chunks.begin(),chunks.end(),[&](const size_t chunk) -> void
+				{
+					const size_t end = core::min((chunk+1u)*ChunkSize,missingValues.size());
+					for (size_t i=chunk*ChunkSize; i<end; i+=4u)
+					{
+						// the last batch gets padded with repeats
+						core::vectorSIMDf batch[4],batchFits[4];
+						for (size_t j=0u; j<4u; j++)
+							batch[j] = missingValues[core::min(i+j,end-1u)];
+						findBestFit4<dimensions,quantizationBits>(batch,batchFits);
+						for (size_t j=0u; j<4u && i+j<end; j++)
+							fits[i+j] = core::vectorSIMDu32(core::abs(batchFits[j]));
+					}
+				});
+
+				{
+					std::unique_lock lock(cacheLock);
+					for (size_t i=0u; i<missingValues.size(); i++)
+						particularCache.insert(std::make_pair(Key(missingValues[i]),fits[i]));
+				}
+				for (const auto& miss : misses)
+					out[miss.first] = fits[miss.second];
+			}
+
+			for (size_t i=0u; i<count; i++)
+				out[i] = restoreSigns<CacheFormat>(out[i],values[i]<core::vectorSIMDf(0.0f));
+		}
+
+		template<E_FORMAT CacheFormat>
+		static inline value_type_t<CacheFormat> restoreSigns(const value_type_t<CacheFormat>& quantized, const core::vector4db_SIMD& negativeMask)
+		{
+			constexpr auto quantizationBits = quantization_bits_v<CacheFormat>;
 			const core::vectorSIMDu32 xorflag((0x1u<<(quantizationBits+1u))-1u);
 			auto restoredAsVec = quantized.getValue()^core::mix(core::vectorSIMDu32(0u),xorflag,negativeMask);
 			restoredAsVec += core::mix(core::vectorSIMDu32(0u),core::vectorSIMDu32(1u),negativeMask);
@@ -484,6 +586,104 @@ class CDirQuantCacheBase : public impl::CDirQuantCacheBase
 
 			return bestFit;
 		}
+
+		//! Same search as `findBestFit` for 4 values at once, every register holds one component of all 4 of them
+		template<uint32_t dimensions, uint32_t quantizationBits>
+		static inline void findBestFit4(const core::vectorSIMDf* values, core::vectorSIMDf* fits)
+		{
+			static_assert(dimensions>1u,"No point");
+			static_assert(dimensions<=4u,"High Dimensions are Hard!");
+			using mask_t = core::vector4db_SIMD;
+
+			core::vectorSIMDf comps[dimensions];
+			for (auto i=0u; i<dimensions; i++)
+				comps[i] = core::vectorSIMDf(values[0][i],values[1][i],values[2][i],values[3][i]);
+
+			// precise normalize
+			core::vectorSIMDf vectorForDots[dimensions];
+			{
+				core::vectorSIMDf lengthSquared(0.f);
+				for (auto i=0u; i<dimensions; i++)
+					lengthSquared += comps[i]*comps[i];
+				const core::vectorSIMDf length = core::sqrt(lengthSquared);
+				for (auto i=0u; i<dimensions; i++)
+					vectorForDots[i] = comps[i].preciseDivision(length);
+			}
+
+			// first largest component of every lane, like the scalar version
+			core::vectorSIMDf maxDirectionComp = comps[0];
+			for (auto i=1u; i<dimensions; i++)
+				maxDirectionComp = core::max(maxDirectionComp,comps[i]);
+			mask_t isMax[dimensions];
+			mask_t afterMax[dimensions];
+			{
+				mask_t seen(false);
+				for (auto i=0u; i<dimensions; i++)
+				{
+					afterMax[i] = seen;
+					isMax[i] = (comps[i]==maxDirectionComp)&(~seen);
+					seen = seen|isMax[i];
+				}
+			}
+			//max component of 3d normal cannot be less than sqrt(1/D)
+			const mask_t degenerate = maxDirectionComp<core::vectorSIMDf(std::sqrtf(0.9998f/float(dimensions)));
+
+			core::vectorSIMDf fittingVector[dimensions];
+			core::vectorSIMDf floorOffset[dimensions];
+			for (auto i=0u; i<dimensions; i++)
+			{
+				fittingVector[i] = comps[i].preciseDivision(maxDirectionComp);
+				floorOffset[i] = core::mix(core::vectorSIMDf(0.f),core::vectorSIMDf(0.499f),isMax[i]);
+			}
+			// corner 0 is the bottom fit itself, the k-th component which isn't the largest gets bit k of the corner index
+			constexpr uint32_t cornerCount = 0x1u<<(dimensions-1u);
+			core::vectorSIMDf corners[cornerCount][dimensions];
+			for (auto corn=0u; corn<cornerCount; corn++)
+			for (auto i=0u; i<dimensions; i++)
+			{
+				const core::vectorSIMDf bitBefore(float((corn>>i)&0x1u));
+				const core::vectorSIMDf bitAfter(i ? float((corn>>(i-1u))&0x1u):0.f);
+				corners[corn][i] = core::mix(core::mix(bitBefore,bitAfter,afterMax[i]),core::vectorSIMDf(0.f),isMax[i]);
+			}
+
+			core::vectorSIMDf bestFit[dimensions];
+			core::vectorSIMDf closestTo1(-1.f);
+			constexpr uint32_t cubeHalfSize = (0x1u << quantizationBits) - 1u;
+			const core::vectorSIMDf cubeHalfSizeND = core::vectorSIMDf(cubeHalfSize);
+			for (uint32_t n=cubeHalfSize; n>0u; n--)
+			{
+				core::vectorSIMDf bottomFit[dimensions];
+				for (auto i=0u; i<dimensions; i++)
+					bottomFit[i] = core::floor(fittingVector[i]*float(n)+floorOffset[i]);
+				for (auto corn=0u; corn<cornerCount; corn++)
+				{
+					core::vectorSIMDf newFit[dimensions];
+					mask_t inside(true);
+					core::vectorSIMDf dp(0.f),newFitLengthSquared(0.f);
+					for (auto i=0u; i<dimensions; i++)
+					{
+						newFit[i] = bottomFit[i]+corners[corn][i];
+						inside = inside&(newFit[i]<=cubeHalfSizeND);
+						dp += newFit[i]*vectorForDots[i];
+						newFitLengthSquared += newFit[i]*newFit[i];
+					}
+					dp = dp.preciseDivision(core::sqrt(newFitLengthSquared));
+					const mask_t better = inside&(dp>closestTo1);
+					closestTo1 = core::mix(closestTo1,dp,better);
+					for (auto i=0u; i<dimensions; i++)
+						bestFit[i] = core::mix(bestFit[i],newFit[i],better);
+				}
+			}
+
+			for (auto i=0u; i<dimensions; i++)
+				bestFit[i] = core::mix(bestFit[i],core::vectorSIMDf(0.f),degenerate);
+			for (auto lane=0u; lane<4u; lane++)
+			{
+				fits[lane] = core::vectorSIMDf(0.f);
+				for (auto i=0u; i<dimensions; i++)
+					fits[lane][i] = bestFit[i][lane];
+			}
+		}
 		
 		template<E_FORMAT CacheFormat>
 		static inline size_t getSerializedCacheSizeInBytes_impl(size_t capacity)
@@ -503,10 +703,10 @@ class CDirQuantCacheBase : public impl::CDirQuantCacheBase
 			if (size == 0)
 				return true;
 
-			if (buffer.size-sizeof(size_t)*2ull<getSerializedCacheSizeInBytes_impl<CacheFormat>(capacity))
+			if (buffer.size<getSerializedCacheSizeInBytes_impl<CacheFormat>(capacity))
 				return false;
 
-			return false;
+			return true;
 		}
 };
 
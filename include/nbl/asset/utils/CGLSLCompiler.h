@@ -44,8 +44,7 @@ class NBL_API2 CGLSLCompiler final : public IShaderCompiler
 
 		@returns Shader containing SPIR-V bytecode.
 		*/
-
-		core::smart_refctd_ptr<ICPUShader> compileToSPIRV(const char* code, const IShaderCompiler::SCompilerOptions& options) const override;
+		using IShaderCompiler::compileToSPIRV;
 
 		/*
 		 If original code contains #version specifier,
@@ -129,7 +128,10 @@ class NBL_API2 CGLSLCompiler final : public IShaderCompiler
 
 		std::string preprocessShader(std::string&& code, IShader::E_SHADER_STAGE& stage, const SPreprocessorOptions& preprocessOptions) const override;
 
+		std::string_view getCompilerVersion() const override;
+
 	protected:
+		core::smart_refctd_ptr<ICPUShader> compileToSPIRV_impl(const char* code, const IShaderCompiler::SCompilerOptions& options, core::vector<SDependency>* dependencies) const override;
 
 		void insertIntoStart(std::string& code, std::ostringstream&& ins) const override;
 
@@ -12,7 +12,7 @@
 
 namespace nbl::asset::impl
 {
-	class DXC;
+	struct DXC;
 }
 
 namespace nbl::asset
@@ -32,7 +32,7 @@ class NBL_API2 CHLSLCompiler final : public IShaderCompiler
 			IShader::E_CONTENT_TYPE getCodeContentType() const override { return IShader::E_CONTENT_TYPE::ECT_HLSL; };
 		};
 
-		core::smart_refctd_ptr<ICPUShader> compileToSPIRV(const char* code, const IShaderCompiler::SCompilerOptions& options) const override;
+		using IShaderCompiler::compileToSPIRV;
 
 		template<typename... Args>
 		static core::smart_refctd_ptr<ICPUShader> createOverridenCopy(const ICPUShader* original, const char* fmt, Args... args)
@@ -48,12 +48,22 @@ class NBL_API2 CHLSLCompiler final : public IShaderCompiler
 
 		std::string preprocessShader(std::string&& code, IShader::E_SHADER_STAGE& stage, const SPreprocessorOptions& preprocessOptions) const override;
 
+		//! DXC reports its version and commit at runtime, so swapping the `dxcompiler` library gets noticed too
+		std::string_view getCompilerVersion() const override { return m_compilerVersion; }
+
+		//! Debugging aid for when the preprocessed source is too long for the debugger to show, off by default.
+		//! When on, `preprocessShader` writes its output next to the source as "<source filename>.preprocessed.hlsl".
+		inline void setDumpPreprocessedSource(const bool enable) { m_dumpPreprocessedSource = enable; }
+
 		void insertIntoStart(std::string& code, std::ostringstream&& ins) const override;
 	protected:
+		core::smart_refctd_ptr<ICPUShader> compileToSPIRV_impl(const char* code, const IShaderCompiler::SCompilerOptions& options, core::vector<SDependency>* dependencies) const override;
 
 		// This can't be a unique_ptr due to it being an undefined type 
 		// when Nabla is used as a lib
 		nbl::asset::impl::DXC* m_dxcCompilerTypes;
+		std::string m_compilerVersion;
+		bool m_dumpPreprocessedSource = false;
 
 		static CHLSLCompiler::SOptions option_cast(const IShaderCompiler::SCompilerOptions& options)
 		{
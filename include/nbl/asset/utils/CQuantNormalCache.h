@@ -61,6 +61,12 @@ class CQuantNormalCache : public CDirQuantCacheBase<impl::VectorUV,impl::QuantNo
 			normal.makeSafe3D();
 			return Base::quantize<3u,CacheFormat>(normal);
 		}
+		//! Worth it over quantizing one by one whenever many of the normals could miss the cache
+		template<E_FORMAT CacheFormat>
+		void quantize(const core::vectorSIMDf* normals, value_type_t<CacheFormat>* out, const size_t count)
+		{
+			Base::quantize<3u,CacheFormat>(normals,out,count);
+		}
 };
 
 }
@@ -64,6 +64,12 @@ class CQuantQuaternionCache : public CDirQuantCacheBase<impl::Projection,impl::Q
 		{
 			return Base::quantize<4u,CacheFormat>(reinterpret_cast<const core::vectorSIMDf&>(quat));
 		}
+		//!
+		template<E_FORMAT CacheFormat>
+		void quantize(const core::quaternion* quats, value_type_t<CacheFormat>* out, const size_t count)
+		{
+			Base::quantize<4u,CacheFormat>(reinterpret_cast<const core::vectorSIMDf*>(quats),out,count);
+		}
 };
 
 }
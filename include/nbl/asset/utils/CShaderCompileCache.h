@@ -0,0 +1,74 @@
+// Copyright (C) 2018-2022 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#ifndef _NBL_ASSET_C_SHADER_COMPILE_CACHE_H_INCLUDED_
+#define _NBL_ASSET_C_SHADER_COMPILE_CACHE_H_INCLUDED_
+
+#include "nbl/asset/utils/IShaderCompiler.h"
+
+#include <mutex>
+
+namespace nbl::asset
+{
+
+//! Persistent store of compiled SPIR-V keyed by a hash of the source code and everything in the compile options which changes the output.
+//! Entries remember every include the source pulled in together with a hash of its contents, so a lookup only hits if all of them still resolve to the same text.
+//! The file is laid out as a sorted table of keys followed by the entries, it gets mapped (or read) once and searched in place,
+//! entries inserted afterwards live in memory until `flush` writes a new file.
+class NBL_API2 CShaderCompileCache final : public core::IReferenceCounted
+{
+	public:
+		using hash_t = std::array<uint64_t,4>;
+
+		//! A missing or unreadable file just means starting with an empty cache, `nullptr` only comes back for an empty path or no system
+		static core::smart_refctd_ptr<CShaderCompileCache> create(core::smart_refctd_ptr<system::ISystem>&& system, system::path&& path, system::logger_opt_smart_ptr&& logger=nullptr);
+
+		//! Returns `nullptr` if there's no entry for the key or any of its includes changed or failed to resolve through `includeFinder`
+		core::smart_refctd_ptr<ICPUShader> find(const hash_t& key, const IShaderCompiler::CIncludeFinder* includeFinder, std::string&& filepathHint) const;
+
+		//! Replaces any previous entry with the same key
+		void insert(const hash_t& key, core::vector<IShaderCompiler::SDependency>&& dependencies, const ICPUShader* spirv);
+
+		//! Writes all entries, old and new, to a temporary file and moves it over the cache file. Does nothing if nothing got inserted.
+		bool flush();
+
+		inline const system::path& getPath() const {return m_path;}
+
+	protected:
+		CShaderCompileCache(core::smart_refctd_ptr<system::ISystem>&& system, system::path&& path, system::logger_opt_smart_ptr&& logger)
+			: m_system(std::move(system)), m_path(std::move(path)), m_logger(std::move(logger)) {}
+		//! flushes
+		~CShaderCompileCache();
+
+	private:
+		struct SKeyHash
+		{
+			inline size_t operator()(const hash_t& key) const {return key[0]^key[3];}
+		};
+		//! what the file is currently read from, either the mapped `IFile` or a buffer it got read into
+		struct SSnapshot
+		{
+			core::smart_refctd_ptr<system::IFile> file = nullptr;
+			core::smart_refctd_ptr<ICPUBuffer> buffer = nullptr;
+			const uint8_t* data = nullptr;
+			size_t size = 0ull;
+		};
+
+		SSnapshot load() const;
+
+		core::smart_refctd_ptr<system::ISystem> m_system;
+		const system::path m_path;
+		system::logger_opt_smart_ptr m_logger;
+
+		mutable std::mutex m_lock;
+		// held for the whole of `flush`, while `m_lock` only guards the members
+		std::mutex m_flushLock;
+		SSnapshot m_snapshot;
+		// serialized the same way as in the file
+		core::unordered_map<hash_t,core::smart_refctd_ptr<ICPUBuffer>,SKeyHash> m_inserted;
+};
+
+}
+
+#endif
@@ -0,0 +1,176 @@
+// Copyright (C) 2018-2023 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+#ifndef _NBL_ASSET_C_VIRTUAL_TEXTURE_RESIDENCY_MANAGER_H_INCLUDED_
+#define _NBL_ASSET_C_VIRTUAL_TEXTURE_RESIDENCY_MANAGER_H_INCLUDED_
+
+#include "nbl/core/declarations.h"
+#include "nbl/core/containers/LRUCache.h"
+#include "nbl/system/CWorkStealingThreadPool.h"
+
+#include "nbl/asset/utils/ICPUVirtualTexture.h"
+
+namespace nbl::asset
+{
+
+//! Streams the pages of textures into an `ICPUVirtualTexture` on demand, instead of committing whole textures up front
+/*
+	Textures get registered with the address `ICPUVirtualTexture::alloc` gave them and their original image, nothing gets
+	generated or copied at that point. Every frame the pages the GPU wanted (read back from a feedback buffer) are passed to
+	`requestPages`, the ones which aren't resident yet get padded and copied into physical pages on a worker pool and `update`
+	publishes the finished ones into the page table.
+	Requesting a page makes all of its coarser ancestors resident too, so a shader missing a page always has a lower mip to fall back to.
+	When a physical storage runs out of tiles the least recently requested pages get evicted, never ones requested in the current frame.
+
+	The padded power-of-two mip chain a texture's pages are cut from (what `createPoTPaddedSquareImageWithMipLevels` makes) only gets built
+	when a page of the texture is first needed, and only a limited number of them are kept around.
+	All member functions have to be called from the same thread, only the page generation runs on the pool.
+*/
+class NBL_API2 CVirtualTextureResidencyManager final : public core::IReferenceCounted
+{
+	public:
+		using texture_id_t = uint32_t;
+		_NBL_STATIC_INLINE_CONSTEXPR texture_id_t invalid_texture_id = ~0u;
+
+		//! One feedback buffer entry, the page table texel (at `mipLevel`) a virtual texture lookup went through
+		struct SPageRequest
+		{
+			uint32_t x : 8;
+			uint32_t y : 8;
+			uint32_t layer : 8;
+			uint32_t mipLevel : 8;
+		};
+		static_assert(sizeof(SPageRequest)==sizeof(uint32_t), "SPageRequest is not 32bit!");
+
+		struct SCreationParams
+		{
+			core::smart_refctd_ptr<ICPUVirtualTexture> virtualTexture = nullptr;
+			//! nullptr makes the manager create its own pool
+			core::smart_refctd_ptr<system::CWorkStealingThreadPool> threadPool = nullptr;
+			//! How many padded mip chains to keep around for cutting pages from
+			uint32_t mipChainCacheSize = 64u;
+			//! Upper bound on the number of pages one `requestPages` call schedules
+			uint32_t maxPagesPerRequest = 256u;
+		};
+		//! The virtual texture has to be past `shrink()`, so its physical storages exist
+		explicit CVirtualTextureResidencyManager(SCreationParams&& params);
+
+		//! `_addr` has to come from `alloc` of the managed virtual texture and `_subres` is what would be passed to `commit` along with the image
+		//! `createPoTPaddedSquareImageWithMipLevels` makes out of `_img`.
+		//! The manager takes over the allocation, it gets freed by `unregisterTexture` or the manager's destruction so don't `commit` or `free` it yourself.
+		texture_id_t registerTexture(const ICPUVirtualTexture::SMasterTextureData& _addr, core::smart_refctd_ptr<const ICPUImage>&& _img, const IImage::SSubresourceRange& _subres, ISampler::E_TEXTURE_CLAMP _uwrap, ISampler::E_TEXTURE_CLAMP _vwrap, ISampler::E_TEXTURE_BORDER_COLOR _borderColor);
+		//! Evicts all pages of the texture and frees its allocation in the virtual texture, waits for its pages still being generated
+		bool unregisterTexture(const texture_id_t id);
+
+		//! Marks the requested pages and their ancestors as used this frame and schedules the missing ones, coarsest first.
+		//! Requests not matching any registered texture are ignored.
+		//! @returns the number of pages scheduled for generation
+		uint32_t requestPages(const core::SRange<const SPageRequest>& requests);
+
+		//! Publishes the pages the pool finished into the page table, the page table and physical storage images need reuploading after a non-zero return.
+		//! @returns the number of pages made resident
+		uint32_t update();
+		//! Waits for every scheduled page, then does `update`
+		uint32_t flush();
+
+		inline ICPUVirtualTexture* getVirtualTexture() const {return m_virtualTexture.get();}
+		inline uint32_t getResidentPageCount() const {return m_residentPageCount;}
+		inline uint32_t getPendingPageCount() const {return static_cast<uint32_t>(m_pendingPages.size());}
+
+	protected:
+		~CVirtualTextureResidencyManager();
+
+	private:
+		using storage_t = ICPUVirtualTexture::ICPUVTResidentStorage;
+		using tile_alctr_t = storage_t::phys_pg_addr_alctr_t;
+		// the bits of `SPageRequest`, identifies a virtual page
+		using page_key_t = uint32_t;
+
+		struct STexture
+		{
+			// the texture data isn't default constructible
+			inline STexture(const ICPUVirtualTexture::SMasterTextureData& _addr) : addr(_addr) {}
+
+			ICPUVirtualTexture::SMasterTextureData addr;
+			core::smart_refctd_ptr<const ICPUImage> image;
+			IImage::SSubresourceRange subresource;
+			ISampler::E_TEXTURE_CLAMP wrap[2];
+			ISampler::E_TEXTURE_BORDER_COLOR borderColor;
+			storage_t* storage;
+			// side of the page table square the texture occupies
+			uint32_t pageTableExtent_log2;
+			uint32_t levelsTakingAtLeastOnePage;
+			uint32_t levelsToPack;
+			// pages currently being generated on the pool
+			uint32_t pendingPages = 0u;
+			bool mipChainPending = false;
+		};
+		struct SResidentPage
+		{
+			texture_id_t texture;
+			uint32_t lastRequestFrame;
+			// raw tile allocator addresses, `invalid_address` when not used
+			uint32_t tile;
+			uint32_t miptailTile;
+		};
+		using page_cache_t = core::LRUCache<page_key_t,SResidentPage>;
+		struct SStoragePages
+		{
+			storage_t* storage;
+			std::unique_ptr<page_cache_t> residentPages;
+		};
+		struct SPageJob
+		{
+			page_key_t key;
+			uint32_t level, x, y;
+			uint32_t tile, miptailTile;
+		};
+		struct SFinishedBatch
+		{
+			texture_id_t texture;
+			core::smart_refctd_ptr<ICPUImage> mipChain;
+			// whether this batch was the one building the mip chain, `mipChain` is null if that failed
+			bool builtMipChain;
+			core::vector<SPageJob> jobs;
+			bool success;
+		};
+
+		static inline page_key_t packKey(const uint32_t x, const uint32_t y, const uint32_t layer, const uint32_t level)
+		{
+			return x|(y<<8u)|(layer<<16u)|(level<<24u);
+		}
+		static inline page_key_t pageTableOriginKey(const uint32_t x, const uint32_t y, const uint32_t layer)
+		{
+			return packKey(x,y,layer,0u);
+		}
+
+		texture_id_t findTexture(const SPageRequest& request) const;
+		SStoragePages& getStoragePages(storage_t* storage);
+		// allocates one tile evicting pages not requested this frame if needed, `invalid_address` when that's not enough
+		uint32_t allocTile(SStoragePages& pages);
+		void freeTiles(storage_t* storage, const uint32_t tile, const uint32_t miptailTile);
+		void evict(storage_t* storage, const page_key_t key, const SResidentPage& page);
+
+		core::smart_refctd_ptr<ICPUVirtualTexture> m_virtualTexture;
+		core::smart_refctd_ptr<system::CWorkStealingThreadPool> m_threadPool;
+		system::CWorkStealingThreadPool::CTaskGroup m_taskGroup;
+		const uint32_t m_maxPagesPerRequest;
+
+		core::unordered_map<texture_id_t,STexture> m_textures;
+		// page table origin of a texture to its id
+		core::unordered_map<page_key_t,texture_id_t> m_pageTableOrigins;
+		texture_id_t m_nextTextureID = 0u;
+
+		core::unordered_map<storage_t*,SStoragePages> m_storagePages;
+		core::LRUCache<texture_id_t,core::smart_refctd_ptr<ICPUImage>> m_mipChains;
+		core::unordered_set<page_key_t> m_pendingPages;
+		uint32_t m_residentPageCount = 0u;
+		uint32_t m_frame = 0u;
+
+		std::mutex m_finishedLock;
+		core::vector<SFinishedBatch> m_finished;
+};
+
+}
+
+#endif
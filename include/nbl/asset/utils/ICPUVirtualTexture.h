@@ -353,59 +353,13 @@ public:
                         // physical double-address to write into page table
                         const uint32_t physAddrToWrite = physPgAddr;
 
-                        const auto texelPos = core::vectorSIMDu32(pgtOffset.x>>i, pgtOffset.y>>i, 0u, pgtOffset.z) + core::vectorSIMDu32(x, y, 0u, 0u);
-                        const auto* region = m_pageTable->getRegion(i, texelPos);
-                        const uint64_t byteoffset = region->getByteOffset(texelPos, region->getByteStrides(m_pageTable->getTexelBlockInfo()));
-                        uint8_t* bufptr = reinterpret_cast<uint8_t*>(m_pageTable->getBuffer()->getPointer()) + byteoffset;
-                        reinterpret_cast<uint32_t*>(bufptr)[0] = physAddrToWrite;
+                        writePageTableEntry(i, (pgtOffset.x>>i)+x, (pgtOffset.y>>i)+y, pgtOffset.z, physAddrToWrite);
                     }
 
                     if (!SPhysPgOffset(physPgAddr).valid())
                         continue;
 
-                    core::vector3du32_SIMD physPg = ICPUVTResidentStorage::pageCoords(physPgAddr, m_pgSzxy, m_tilePadding);
-                    physPg -= core::vector2du32_SIMD(m_tilePadding, m_tilePadding);
-
-                    const core::vector2du32_SIMD miptailOffset = (i>=levelsTakingAtLeastOnePageCount) ? core::vector2du32_SIMD(m_miptailOffsets[i-levelsTakingAtLeastOnePageCount].x,m_miptailOffsets[i-levelsTakingAtLeastOnePageCount].y) : core::vector2du32_SIMD(0u,0u);
-                    physPg += miptailOffset;
-
-                    CPaddedCopyImageFilter::state_type copy;
-                    copy.outOffsetBaseLayer = (physPg).xyzz();/*physPg.z is layer*/ copy.outOffset.z = 0u;
-                    copy.inOffsetBaseLayer = core::vector2du32_SIMD(x,y)*m_pgSzxy;
-                    copy.extentLayerCount = core::vectorSIMDu32(m_pgSzxy, m_pgSzxy, 1u, 1u);
-                    copy.relativeOffset = {0u,0u,0u};
-                    if (x == w-1u)
-                        copy.extentLayerCount.x = std::max<uint32_t>(extent.width>>i,1u)-copy.inOffsetBaseLayer.x;
-                    if (y == h-1u)
-                        copy.extentLayerCount.y = std::max<uint32_t>(extent.height>>i,1u)-copy.inOffsetBaseLayer.y;
-                    memcpy(&copy.paddedExtent.width,(copy.extentLayerCount+core::vectorSIMDu32(2u*m_tilePadding)).pointer, 2u*sizeof(uint32_t));
-                    copy.paddedExtent.depth = 1u;
-                    if (w>1u)
-                        copy.extentLayerCount.x += m_tilePadding;
-                    if (x>0u && x<w-1u)
-                        copy.extentLayerCount.x += m_tilePadding;
-                    if (h>1u)
-                        copy.extentLayerCount.y += m_tilePadding;
-                    if (y>0u && y<h-1u)
-                        copy.extentLayerCount.y += m_tilePadding;
-                    if (x == 0u)
-                        copy.relativeOffset.x = m_tilePadding;
-                    else
-                        copy.inOffsetBaseLayer.x -= m_tilePadding;
-                    if (y == 0u)
-                        copy.relativeOffset.y = m_tilePadding;
-                    else
-                        copy.inOffsetBaseLayer.y -= m_tilePadding;
-                    copy.inOffsetBaseLayer.w = _subres.baseArrayLayer;
-                    copy.inMipLevel = _subres.baseMipLevel + i;
-                    copy.outMipLevel = 0u;
-                    copy.inImage = _img;
-                    copy.outImage = storage->image.get();
-                    copy.axisWraps[0] = _uwrap;
-                    copy.axisWraps[1] = _vwrap;
-                    copy.axisWraps[2] = ISampler::ETC_CLAMP_TO_EDGE;
-                    copy.borderColor = _borderColor;
-                    if (!CPaddedCopyImageFilter::execute(core::execution::par_unseq,&copy))
+                    if (!copyToPhysicalPage(core::execution::par_unseq, storage, physPgAddr, _img, _subres, extent, i, x, y, w, h, levelsTakingAtLeastOnePageCount, _uwrap, _vwrap, _borderColor))
                         assert(false);
                 }
         }
@@ -415,11 +369,7 @@ public:
             // physical double-address to write into page table
             uint32_t physAddrToWrite = SPhysPgOffset::invalid_addr | (miptailPgAddr << SPhysPgOffset::PAGE_ADDR_BITLENGTH);
 
-            const auto texelPos = core::vectorSIMDu32(pgtOffset.x, pgtOffset.y, 0u, pgtOffset.z);
-            const auto* region = m_pageTable->getRegion(0u, texelPos);
-            const uint64_t byteoffset = region->getByteOffset(texelPos, region->getByteStrides(m_pageTable->getTexelBlockInfo()));
-            uint8_t* bufptr = reinterpret_cast<uint8_t*>(m_pageTable->getBuffer()->getPointer()) + byteoffset;
-            reinterpret_cast<uint32_t*>(bufptr)[0] = physAddrToWrite;
+            writePageTableEntry(0u, pgtOffset.x, pgtOffset.y, pgtOffset.z, physAddrToWrite);
         }
 
         return true;
@@ -572,6 +522,66 @@ public:
     }
 
 protected:
+    friend class CVirtualTextureResidencyManager;
+
+    void writePageTableEntry(uint32_t _level, uint32_t _x, uint32_t _y, uint32_t _layer, uint32_t _physAddr)
+    {
+        const auto texelPos = core::vectorSIMDu32(_x, _y, 0u, _layer);
+        const auto* region = m_pageTable->getRegion(_level, texelPos);
+        const uint64_t byteoffset = region->getByteOffset(texelPos, region->getByteStrides(m_pageTable->getTexelBlockInfo()));
+        uint8_t* bufptr = reinterpret_cast<uint8_t*>(m_pageTable->getBuffer()->getPointer()) + byteoffset;
+        reinterpret_cast<uint32_t*>(bufptr)[0] = _physAddr;
+    }
+
+    //! Copies page (x,y) of mip `i` of `_img` together with its padding into the physical page `physPgAddr`, levels past `levelsTakingAtLeastOnePageCount` go to their spot in the mip-tail page
+    template<class ExecutionPolicy>
+    bool copyToPhysicalPage(ExecutionPolicy&& policy, ICPUVTResidentStorage* storage, uint32_t physPgAddr, const ICPUImage* _img, const IImage::SSubresourceRange& _subres, const VkExtent3D& extent, uint32_t i, uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t levelsTakingAtLeastOnePageCount, ISampler::E_TEXTURE_CLAMP _uwrap, ISampler::E_TEXTURE_CLAMP _vwrap, ISampler::E_TEXTURE_BORDER_COLOR _borderColor) const
+    {
+        core::vector3du32_SIMD physPg = ICPUVTResidentStorage::pageCoords(physPgAddr, m_pgSzxy, m_tilePadding);
+        physPg -= core::vector2du32_SIMD(m_tilePadding, m_tilePadding);
+
+        const core::vector2du32_SIMD miptailOffset = (i>=levelsTakingAtLeastOnePageCount) ? core::vector2du32_SIMD(m_miptailOffsets[i-levelsTakingAtLeastOnePageCount].x,m_miptailOffsets[i-levelsTakingAtLeastOnePageCount].y) : core::vector2du32_SIMD(0u,0u);
+        physPg += miptailOffset;
+
+        CPaddedCopyImageFilter::state_type copy;
+        copy.outOffsetBaseLayer = (physPg).xyzz();/*physPg.z is layer*/ copy.outOffset.z = 0u;
+        copy.inOffsetBaseLayer = core::vector2du32_SIMD(x,y)*m_pgSzxy;
+        copy.extentLayerCount = core::vectorSIMDu32(m_pgSzxy, m_pgSzxy, 1u, 1u);
+        copy.relativeOffset = {0u,0u,0u};
+        if (x == w-1u)
+            copy.extentLayerCount.x = std::max<uint32_t>(extent.width>>i,1u)-copy.inOffsetBaseLayer.x;
+        if (y == h-1u)
+            copy.extentLayerCount.y = std::max<uint32_t>(extent.height>>i,1u)-copy.inOffsetBaseLayer.y;
+        memcpy(&copy.paddedExtent.width,(copy.extentLayerCount+core::vectorSIMDu32(2u*m_tilePadding)).pointer, 2u*sizeof(uint32_t));
+        copy.paddedExtent.depth = 1u;
+        if (w>1u)
+            copy.extentLayerCount.x += m_tilePadding;
+        if (x>0u && x<w-1u)
+            copy.extentLayerCount.x += m_tilePadding;
+        if (h>1u)
+            copy.extentLayerCount.y += m_tilePadding;
+        if (y>0u && y<h-1u)
+            copy.extentLayerCount.y += m_tilePadding;
+        if (x == 0u)
+            copy.relativeOffset.x = m_tilePadding;
+        else
+            copy.inOffsetBaseLayer.x -= m_tilePadding;
+        if (y == 0u)
+            copy.relativeOffset.y = m_tilePadding;
+        else
+            copy.inOffsetBaseLayer.y -= m_tilePadding;
+        copy.inOffsetBaseLayer.w = _subres.baseArrayLayer;
+        copy.inMipLevel = _subres.baseMipLevel + i;
+        copy.outMipLevel = 0u;
+        copy.inImage = _img;
+        copy.outImage = storage->image.get();
+        copy.axisWraps[0] = _uwrap;
+        copy.axisWraps[1] = _vwrap;
+        copy.axisWraps[2] = ISampler::ETC_CLAMP_TO_EDGE;
+        copy.borderColor = _borderColor;
+        return CPaddedCopyImageFilter::execute(std::forward<ExecutionPolicy>(policy),&copy);
+    }
+
     core::smart_refctd_ptr<ICPUImageView> createPageTableView() const override
     {
         return ICPUImageView::create(createPageTableViewCreationParams());
@@ -44,6 +44,11 @@ public:
     core::smart_refctd_ptr<ICPUBuffer> optimize(const uint32_t* _spirv, uint32_t _dwordCount, system::logger_opt_ptr logger) const;
     core::smart_refctd_ptr<ICPUBuffer> optimize(const ICPUBuffer* _spirv, system::logger_opt_ptr logger) const;
 
+    inline std::span<const E_OPTIMIZER_PASS> getPasses() const { return {m_passes.begin(),m_passes.size()}; }
+
+    //! Version of the SPIRV-Tools the passes come from, both compilers also use them for legalization and validation
+    static const char* getToolsVersion();
+
 protected:
     const std::initializer_list<E_OPTIMIZER_PASS> m_passes;
 };
@@ -10,6 +10,10 @@
 
 #include "nbl/system/IFile.h"
 #include "nbl/system/ISystem.h"
+#include "nbl/system/CWorkStealingThreadPool.h"
+
+#include <future>
+#include <shared_mutex>
 
 #include "nbl/asset/ICPUSpecializedShader.h"
 #include "nbl/asset/utils/ISPIRVOptimizer.h"
@@ -17,6 +21,8 @@
 namespace nbl::asset
 {
 
+class CShaderCompileCache;
+
 class NBL_API2 IShaderCompiler : public core::IReferenceCounted
 {
 	public:
@@ -48,13 +54,20 @@ class NBL_API2 IShaderCompiler : public core::IReferenceCounted
 			protected:
 
 				using HandleFunc_t = std::function<std::string(const std::string&)>;
+				// ! only gets called once, the first time `getInclude` needs it
 				virtual core::vector<std::pair<std::regex,HandleFunc_t>> getBuiltinNamesToFunctionMapping() const = 0;
 
 				// ! Parses arguments from include path
 				// ! template is path/to/shader.hlsl/arg0/arg1/...
 				static core::vector<std::string> parseArgumentsFromPath(const std::string& _path);
+
+			private:
+				mutable std::once_flag m_builtinNamesCreated;
+				mutable core::vector<std::pair<std::regex,HandleFunc_t>> m_builtinNames;
 		};
 
+		//! Keeps the contents of every include it loaded in memory, shared by all compilations using the loader and safe to use from several threads.
+		//! Files on disk get reloaded when their modification time or size changes, files coming from mounted archives are assumed never to change.
 		class NBL_API2 CFileSystemIncludeLoader : public IIncludeLoader
 		{
 			public:
@@ -62,8 +75,39 @@ class NBL_API2 IShaderCompiler : public core::IReferenceCounted
 
 				IIncludeLoader::found_t getInclude(const system::path& searchPath, const std::string& includeName) const override;
 
+				//! Forgets everything loaded so far, needed if a mounted archive gets replaced by one with different contents for the same paths
+				void clearCache();
+
 			protected:
+				struct SCachedFile
+				{
+					system::path absolutePath;
+					std::string contents;
+					// only meaningful when `onDisk`, what gets checked for modifications
+					system::path diskPath;
+					std::filesystem::file_time_type lastWriteTime;
+					uintmax_t size;
+					bool onDisk;
+				};
+
+				// loads without looking at the cache, nullptr if the file can't be opened
+				std::shared_ptr<const SCachedFile> load(const system::path& path) const;
+
 				core::smart_refctd_ptr<system::ISystem> m_system;
+				mutable std::shared_mutex m_cacheLock;
+				// the path an include got requested by (search path joined with the include name) to its file
+				mutable core::unordered_map<std::string,std::shared_ptr<const SCachedFile>> m_requestedPaths;
+				// interns files by their absolute path, so the same file reached through different search paths is kept once
+				mutable core::unordered_map<std::string,std::shared_ptr<const SCachedFile>> m_files;
+		};
+
+		//! An include resolved during preprocessing, with enough information to resolve it again and tell whether its contents changed
+		struct SDependency
+		{
+			system::path requestingSourceDir;
+			std::string identifier;
+			bool standardInclude;
+			std::array<uint64_t,4> hash;
 		};
 
 		class NBL_API2 CIncludeFinder : public core::IReferenceCounted
@@ -71,6 +115,10 @@ class NBL_API2 IShaderCompiler : public core::IReferenceCounted
 			public:
 				CIncludeFinder(core::smart_refctd_ptr<system::ISystem>&& system);
 
+				// ! dispatches to `getIncludeStandard` or `getIncludeRelative`
+				// @param dependencies: if not nullptr, a successfully found include gets appended to it along with the hash of its contents
+				IIncludeLoader::found_t getInclude(const system::path& requestingSourceDir, const std::string& includeName, const bool standard, core::vector<SDependency>* dependencies=nullptr) const;
+
 				// ! includes within <>
 				// @param requestingSourceDir: the directory where the incude was requested
 				// @param includeName: the string within <> of the include preprocessing directive
@@ -127,6 +175,8 @@ class NBL_API2 IShaderCompiler : public core::IReferenceCounted
 				std::string_view definition;
 			};
 			std::span<const SMacroDefinition> extraDefines = {};
+			//! Optional, every include resolved by the preprocessor gets recorded here
+			core::vector<SDependency>* dependencies = nullptr;
 		};
 
 		// https://github.com/microsoft/DirectXShaderCompiler/blob/main/docs/SPIR-V.rst#debugging
@@ -155,6 +205,8 @@ class NBL_API2 IShaderCompiler : public core::IReferenceCounted
 				@includeFinder Optional parameter; if not nullptr, it will resolve the includes in the code
 				@maxSelfInclusionCount used only when includeFinder is not nullptr
 				@extraDefines adds extra defines to the shader before compilation
+				@dependencies Optional parameter; ignored by `compileToSPIRV` which records into its own list when it needs to
+			@compileCache Optional parameter; if not nullptr, SPIR-V is looked up there first and stored there after a successful compilation
 		*/
 		struct SCompilerOptions
 		{
@@ -163,6 +215,7 @@ class NBL_API2 IShaderCompiler : public core::IReferenceCounted
 			const ISPIRVOptimizer* spirvOptimizer = nullptr;
 			core::bitflag<E_DEBUG_INFO_FLAGS> debugInfoFlags = core::bitflag<E_DEBUG_INFO_FLAGS>(E_DEBUG_INFO_FLAGS::EDIF_SOURCE_BIT) | E_DEBUG_INFO_FLAGS::EDIF_TOOL_BIT;
 			SPreprocessorOptions preprocessorOptions = {};
+			CShaderCompileCache* compileCache = nullptr;
 
 			void setCommonData(const SCompilerOptions& opt)
 			{
@@ -173,7 +226,7 @@ class NBL_API2 IShaderCompiler : public core::IReferenceCounted
 		};
 
 
-		virtual core::smart_refctd_ptr<ICPUShader> compileToSPIRV(const char* code, const SCompilerOptions& options) const = 0;
+		core::smart_refctd_ptr<ICPUShader> compileToSPIRV(const char* code, const SCompilerOptions& options) const;
 
 		inline core::smart_refctd_ptr<ICPUShader> compileToSPIRV(system::IFile* sourceFile, const SCompilerOptions& options) const
 		{
@@ -188,6 +241,20 @@ class NBL_API2 IShaderCompiler : public core::IReferenceCounted
 				return nullptr;
 		}
 
+		struct SCompileRequest
+		{
+			const char* code;
+			const SCompilerOptions* options;
+		};
+		using compile_future_t = std::future<core::smart_refctd_ptr<ICPUShader>>;
+		/*
+			Compiles every request as a separate task on `threadPool` (or a pool the compiler creates on first use), returns a future per request in the same order.
+			The compiler and the code and options of the requests have to stay alive until the futures are ready, and so do the loggers, include finders, optimizers
+			and compile caches they point to, all of which need to be safe to use from several threads at once (the ones Nabla provides are).
+			Don't wait on the futures from a task of the same pool, it won't help with the work like `CWorkStealingThreadPool::wait` does.
+		*/
+		core::vector<compile_future_t> compileToSPIRV(std::span<const SCompileRequest> requests, system::CWorkStealingThreadPool* threadPool=nullptr) const;
+
 		/**
 		Resolves ALL #include directives regardless of any other preprocessor directive.
 		This is done in order to support `#include` AND simultaneulsy be able to store (serialize) such ICPUShader (mostly High Level source) into ONE file which, upon loading, will compile on every hardware/driver predicted by shader's author.
@@ -293,16 +360,23 @@ class NBL_API2 IShaderCompiler : public core::IReferenceCounted
 
 		virtual IShader::E_CONTENT_TYPE getCodeContentType() const = 0;
 
+		//! Identifies the frontend build doing the compiling, it's part of every compile cache key so a different compiler never gets served stale SPIR-V
+		virtual std::string_view getCompilerVersion() const = 0;
+
 		CIncludeFinder* getDefaultIncludeFinder() { return m_defaultIncludeFinder.get(); }
 
 		const CIncludeFinder* getDefaultIncludeFinder() const { return m_defaultIncludeFinder.get(); }
 	protected:
+		//! `dependencies` needs to be forwarded to the preprocessor when not nullptr
+		virtual core::smart_refctd_ptr<ICPUShader> compileToSPIRV_impl(const char* code, const SCompilerOptions& options, core::vector<SDependency>* dependencies) const = 0;
 
 		virtual void insertIntoStart(std::string& code, std::ostringstream&& ins) const = 0;
 
 		core::smart_refctd_ptr<system::ISystem> m_system;
 	private:
 		core::smart_refctd_ptr<CIncludeFinder> m_defaultIncludeFinder;
+		mutable std::once_flag m_defaultThreadPoolCreated;
+		mutable core::smart_refctd_ptr<system::CWorkStealingThreadPool> m_defaultThreadPool;
 };
 
 NBL_ENUM_ADD_BITWISE_OPERATORS(IShaderCompiler::E_DEBUG_INFO_FLAGS)
@@ -6,11 +6,15 @@
 #define __NBL_CORE_RADIX_SORT_H_INCLUDED__
 
 #include <algorithm>
+#include <array>
 #include <bitset>
 #include <cstdint>
 #include <numeric>
+#include <thread>
+#include <vector>
 
 #include "nbl/macros.h"
+#include "nbl/core/execution.h"
 
 namespace nbl
 {
@@ -91,6 +95,142 @@ struct RadixSorter
 		alignas(sizeof(histogram_t)) histogram_t histogram[histogram_size];
 };
 
+//! Tag for sorting keys without a payload
+struct no_radix_values_t {};
+
+//! LSD radix sort over `block_count` contiguous blocks of the input, each block gets its own histogram and scatters independently
+template<size_t key_bit_count>
+struct ParallelRadixSorter
+{
+		// 256 bins keep every per-block histogram in L1 and the scatter's write streams within what the TLB can cover
+		_NBL_STATIC_INLINE_CONSTEXPR uint8_t radix_bits = 8u;
+		_NBL_STATIC_INLINE_CONSTEXPR size_t histogram_size = 0x1ull<<radix_bits;
+		_NBL_STATIC_INLINE_CONSTEXPR size_t pass_count = (key_bit_count+radix_bits-1ull)/size_t(radix_bits);
+		_NBL_STATIC_INLINE_CONSTEXPR uint16_t radix_mask = static_cast<uint16_t>(histogram_size-1u);
+		// below this many elements per block the threading overhead dominates
+		_NBL_STATIC_INLINE_CONSTEXPR size_t min_block_size = 0x1ull<<14u;
+
+		using histogram_t = std::array<size_t,histogram_size>;
+
+		//! Returns whether the sorted keys (and values) ended up in the scratch ranges
+		template<class ExecutionPolicy, class KeyIt, class ValueIt, class KeyAccessor>
+		inline bool operator()(ExecutionPolicy&& policy, KeyIt keys, KeyIt keyScratch, ValueIt values, ValueIt valueScratch, const size_t rangeSize, const KeyAccessor& comp)
+		{
+			if (rangeSize==0ull)
+				return false;
+
+			size_t blockCount = 1ull;
+			if constexpr (!std::is_same_v<std::remove_cvref_t<ExecutionPolicy>,execution::sequenced_policy>)
+				blockCount = std::clamp<size_t>(rangeSize/min_block_size,1ull,std::max(std::thread::hardware_concurrency(),1u));
+			blockSize = (rangeSize+blockCount-1ull)/blockCount;
+			this->rangeSize = rangeSize;
+
+			blocks.resize(blockCount);
+			std::iota(blocks.begin(),blocks.end(),0u);
+			blockHistograms.resize(blockCount*pass_count);
+
+			// The digit histograms don't depend on the order of the keys, so one read over the input gathers all of them,
+			// the totals let us skip every pass where all keys share the same digit.
+			std::for_each(policy,blocks.begin(),blocks.end(),[&](const uint32_t block) -> void
+			{
+				histogram_t* hist = blockHistograms.data()+block*pass_count;
+				for (size_t p=0ull; p<pass_count; p++)
+					hist[p].fill(0ull);
+				const auto end = blockEnd(block);
+				for (size_t i=block*blockSize; i<end; i++)
+					countAllPasses<0ull>(hist,comp,keys[i]);
+			});
+
+			bool dataMoved = false;
+			pass<0ull>(policy,keys,keyScratch,values,valueScratch,comp,dataMoved);
+			return inScratch;
+		}
+
+	private:
+		inline size_t blockEnd(const uint32_t block) const
+		{
+			return std::min<size_t>((block+1ull)*blockSize,rangeSize);
+		}
+
+		template<size_t pass_ix, class KeyAccessor, typename Key>
+		inline void countAllPasses(histogram_t* hist, const KeyAccessor& comp, const Key& key)
+		{
+			constexpr auto shift = radix_bits*pass_ix;
+			++hist[pass_ix][comp.template operator()<shift,radix_mask>(key)];
+			if constexpr (pass_ix+1ull!=pass_count)
+				countAllPasses<pass_ix+1ull>(hist,comp,key);
+		}
+
+		template<size_t pass_ix, class ExecutionPolicy, class KeyIt, class ValueIt, class KeyAccessor>
+		inline void pass(ExecutionPolicy&& policy, KeyIt input, KeyIt output, ValueIt values, ValueIt valuesOut, const KeyAccessor& comp, bool& dataMoved)
+		{
+			constexpr auto shift = radix_bits*pass_ix;
+			const auto blockCount = blocks.size();
+
+			bool trivial = false;
+			for (size_t digit=0ull; digit<histogram_size && !trivial; digit++)
+			{
+				size_t total = 0ull;
+				for (size_t block=0ull; block<blockCount; block++)
+					total += blockHistograms[block*pass_count+pass_ix][digit];
+				trivial = total==rangeSize;
+			}
+
+			if (!trivial)
+			{
+				// the histograms gathered up front are only valid for blocks whose contents haven't been shuffled yet
+				if (dataMoved)
+				std::for_each(policy,blocks.begin(),blocks.end(),[&](const uint32_t block) -> void
+				{
+					histogram_t& hist = blockHistograms[block*pass_count+pass_ix];
+					hist.fill(0ull);
+					const auto end = blockEnd(block);
+					for (size_t i=block*blockSize; i<end; i++)
+						++hist[comp.template operator()<shift,radix_mask>(input[i])];
+				});
+				// exclusive prefix sum, digit-major so that equal keys keep their block order (stability)
+				size_t sum = 0ull;
+				for (size_t digit=0ull; digit<histogram_size; digit++)
+				for (size_t block=0ull; block<blockCount; block++)
+				{
+					auto& offset = blockHistograms[block*pass_count+pass_ix][digit];
+					const auto count = offset;
+					offset = sum;
+					sum += count;
+				}
+				// scatter
+				std::for_each(policy,blocks.begin(),blocks.end(),[&](const uint32_t block) -> void
+				{
+					histogram_t& offsets = blockHistograms[block*pass_count+pass_ix];
+					const auto end = blockEnd(block);
+					for (size_t i=block*blockSize; i<end; i++)
+					{
+						const auto outIx = offsets[comp.template operator()<shift,radix_mask>(input[i])]++;
+						output[outIx] = input[i];
+						if constexpr (!std::is_same_v<ValueIt,no_radix_values_t*>)
+							valuesOut[outIx] = values[i];
+					}
+				});
+				dataMoved = true;
+				inScratch = !inScratch;
+			}
+
+			if constexpr (pass_ix+1ull!=pass_count)
+			{
+				if (trivial)
+					pass<pass_ix+1ull>(policy,input,output,values,valuesOut,comp,dataMoved);
+				else
+					pass<pass_ix+1ull>(policy,output,input,valuesOut,values,comp,dataMoved);
+			}
+		}
+
+		std::vector<uint32_t> blocks;
+		std::vector<histogram_t> blockHistograms;
+		size_t blockSize = 0ull;
+		size_t rangeSize = 0ull;
+		bool inScratch = false;
+};
+
 }
 
 template<class RandomIt, class KeyAccessor>
@@ -113,6 +253,43 @@ inline RandomIt radix_sort(RandomIt input, RandomIt scratch, const size_t rangeS
 	return radix_sort<RandomIt>(input,scratch,rangeSize,impl::KeyAdaptor<decltype(*input)>());
 }
 
+//! Parallel variant, sorts with per-thread histograms and scatters and skips passes in which all keys have the same digit.
+//! Just like the serial version the final sorted range can be either in `input` or `scratch`.
+template<class ExecutionPolicy, class RandomIt, class KeyAccessor> requires is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>
+inline RandomIt radix_sort(ExecutionPolicy&& policy, RandomIt input, RandomIt scratch, const size_t rangeSize, const KeyAccessor& comp)
+{
+	assert(std::abs(std::distance(input,scratch))>=rangeSize);
+
+	impl::no_radix_values_t* noValues = nullptr;
+	const bool inScratch = impl::ParallelRadixSorter<KeyAccessor::key_bit_count>()(std::forward<ExecutionPolicy>(policy),input,scratch,noValues,noValues,rangeSize,comp);
+	return inScratch ? scratch:input;
+}
+template<class ExecutionPolicy, class RandomIt> requires is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>
+inline RandomIt radix_sort(ExecutionPolicy&& policy, RandomIt input, RandomIt scratch, const size_t rangeSize)
+{
+	using key_t = std::remove_cvref_t<decltype(*input)>;
+	return radix_sort(std::forward<ExecutionPolicy>(policy),input,scratch,rangeSize,impl::KeyAdaptor<key_t>());
+}
+
+//! Sorts `values` alongside `keys`, the returned pair tells where the sorted keys and values ended up (both in `input` or both in `scratch`)
+template<class ExecutionPolicy, class KeyIt, class ValueIt, class KeyAccessor> requires is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>
+inline std::pair<KeyIt,ValueIt> radix_sort_by_key(ExecutionPolicy&& policy, KeyIt keys, KeyIt keyScratch, ValueIt values, ValueIt valueScratch, const size_t rangeSize, const KeyAccessor& comp)
+{
+	assert(std::abs(std::distance(keys,keyScratch))>=rangeSize);
+	assert(std::abs(std::distance(values,valueScratch))>=rangeSize);
+
+	const bool inScratch = impl::ParallelRadixSorter<KeyAccessor::key_bit_count>()(std::forward<ExecutionPolicy>(policy),keys,keyScratch,values,valueScratch,rangeSize,comp);
+	if (inScratch)
+		return {keyScratch,valueScratch};
+	return {keys,values};
+}
+template<class ExecutionPolicy, class KeyIt, class ValueIt> requires is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>
+inline std::pair<KeyIt,ValueIt> radix_sort_by_key(ExecutionPolicy&& policy, KeyIt keys, KeyIt keyScratch, ValueIt values, ValueIt valueScratch, const size_t rangeSize)
+{
+	using key_t = std::remove_cvref_t<decltype(*keys)>;
+	return radix_sort_by_key(std::forward<ExecutionPolicy>(policy),keys,keyScratch,values,valueScratch,rangeSize,impl::KeyAdaptor<key_t>());
+}
+
 }
 }
 
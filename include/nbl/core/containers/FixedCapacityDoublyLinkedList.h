@@ -114,6 +114,8 @@ class FixedCapacityDoublyLinkedList : private impl::FixedCapacityDoublyLinkedLis
 				get(backNode->prev)->next = invalid_iterator;
 			uint32_t temp = m_back;
 			m_back = backNode->prev;
+			if (m_begin == temp)
+				m_begin = invalid_iterator;
 			common_delete(temp);
 		}
 
@@ -143,6 +145,10 @@ class FixedCapacityDoublyLinkedList : private impl::FixedCapacityDoublyLinkedLis
 			assert(nodeAddr != invalid_iterator);
 			assert(nodeAddr < cap);
 			node_t* node = get(nodeAddr);
+			if (m_begin == nodeAddr)
+				m_begin = node->next;
+			if (m_back == nodeAddr)
+				m_back = node->prev;
 			common_detach(node);
 			common_delete(nodeAddr);
 		}
@@ -156,6 +162,8 @@ class FixedCapacityDoublyLinkedList : private impl::FixedCapacityDoublyLinkedLis
 			getBegin()->prev = nodeAddr;
 
 			auto node = get(nodeAddr);
+			if (m_back == nodeAddr)
+				m_back = node->prev;
 			common_detach(node);
 			node->next = m_begin;
 			node->prev = invalid_iterator;
@@ -175,13 +183,8 @@ class FixedCapacityDoublyLinkedList : private impl::FixedCapacityDoublyLinkedLis
 		{
 			if (m_dispose_f && m_begin != invalid_iterator)
 			{
-				auto* begin = getBegin();
-				auto* back = getBack();
-				do 
-				{
-					m_dispose_f(begin->data);
-					begin = get(begin->next);
-				} while (begin != back);
+				for (auto nodeAddr=m_begin; nodeAddr!=invalid_iterator; nodeAddr=get(nodeAddr)->next)
+					m_dispose_f(get(nodeAddr)->data);
 			}
 			_NBL_ALIGNED_FREE(m_reservedSpace);
 		}
@@ -199,6 +199,16 @@ class LRUCache : private impl::LRUCacheBase<Key,Value,MapHash,MapEquals>
 				return nullptr;
 		}
 
+		//get the least recently used element, or nullptr if the cache is empty. Does not alter the value use order
+		inline const assoc_t* peekLeastRecentlyUsed() const
+		{
+			const uint32_t i = base_t::m_list.getLastAddress();
+			if (i!=invalid_iterator)
+				return &(base_t::m_list.get(i)->data);
+			else
+				return nullptr;
+		}
+
 		//remove element at key if present
 		inline void erase(const Key& key)
 		{
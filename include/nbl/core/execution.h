@@ -28,6 +28,8 @@ namespace nbl::core
 {
 #if __has_include(<execution>)
 namespace execution = std::execution;
+template<class T>
+constexpr inline bool is_execution_policy_v = std::is_execution_policy_v<T>;
 
 ALIAS_TEMPLATE_FUNCTION(for_each_n, std::for_each_n)
 ALIAS_TEMPLATE_FUNCTION(for_each, std::for_each)
@@ -43,6 +45,8 @@ ALIAS_TEMPLATE_FUNCTION(nth_element, std::nth_element)
 //const auto swap_ranges = std::swap_ranges<_ExPo, _FwdIt1, _FwdIt2>;
 #else
 namespace execution = oneapi::dpl::execution;
+template<class T>
+constexpr inline bool is_execution_policy_v = oneapi::dpl::execution::is_execution_policy_v<T>;
 
 ALIAS_TEMPLATE_FUNCTION(for_each_n, oneapi::dpl::for_each_n)
 ALIAS_TEMPLATE_FUNCTION(for_each, oneapi::dpl::for_each)
@@ -8,6 +8,9 @@
 #include "nbl/core/sampling/RandomSampler.h"
 #include "nbl/core/sampling/SobolSampler.h"
 
+#include <future>
+#include <thread>
+
 namespace nbl
 {
 namespace core
@@ -18,7 +21,7 @@ namespace core
 	class OwenSampler : protected SequenceSampler
 	{
 	public:
-		OwenSampler(uint32_t _dimensions, uint32_t _seed) : SequenceSampler(_dimensions)
+		OwenSampler(uint32_t _dimensions, uint32_t _seed) : SequenceSampler(_dimensions), seed(_seed)
 		{
 			mersenneTwister.seed(_seed);
 			cachedFlip.resize(MAX_SAMPLES-1u);
@@ -86,7 +89,157 @@ namespace core
 			lastDim = dimension;
 		}
 
+		//! Same values as a freshly constructed sampler with the same seed returns from `sample(dim,i)` for every dimension in order and the first `sampleCount` samples,
+		//! written to `out[dim*sampleCount+i]`. Leaves the state of this sampler alone.
+		/** Every dimension's flip tree consumes `MAX_SAMPLES-1` draws of one Mersenne Twister stream, which can't be split, so that runs on the calling thread.
+		It only keeps the draws which end up in the flips of the first `sampleCount` samples, while the previous batch of dimensions gets its points
+		generated and scrambled on other threads. */
+		inline void generateTable(uint32_t* out, const uint32_t sampleCount) const
+		{
+			assert(sampleCount<=MAX_SAMPLES);
+			const uint32_t dimensions = SequenceSampler::dimensions;
+			if (!dimensions || !sampleCount)
+				return;
+
+			constexpr uint32_t leafLevel = MAX_SAMPLES_LOG2-1u;
+			// the first `sampleCount` points only differ in their top `prefixBits` bits, so they only reach every node of the levels above that
+			const uint32_t prefixBits = std::min<uint32_t>(std::bit_width(sampleCount-1u),leafLevel);
+			const uint32_t leafCount = 0x1u<<prefixBits;
+			auto getLevelSize = [prefixBits,leafCount](const uint32_t level) -> uint32_t
+			{
+				return level<=prefixBits ? (0x1u<<level):leafCount;
+			};
+			// same order as `resetDimensionCounter` draws them, level by level
+			auto drawTree = [&](CTwister& twister, core::vector<uint32_t>& draws) -> void
+			{
+				for (uint32_t level=0u; level<=leafLevel; level++)
+				{
+					if (level<=prefixBits)
+					{
+						for (uint32_t i=0u; i<getLevelSize(level); i++)
+							draws.push_back(twister());
+						continue;
+					}
+					const uint64_t skip = (0x1ull<<(level-prefixBits))-1ull;
+					for (uint32_t i=0u; i<leafCount; i++)
+					{
+						draws.push_back(twister());
+						twister.discard(skip);
+					}
+				}
+			};
+			auto scramble = [=](uint32_t* row, const core::vector<uint32_t>& draws) -> void
+			{
+				core::vector<uint32_t> flips(leafCount);
+				for (uint32_t leaf=0u; leaf<leafCount; leaf++)
+				{
+					uint32_t flip = 0u;
+					size_t levelStart = 0u;
+					for (uint32_t level=0u; level<=leafLevel; level++)
+					{
+						const uint32_t node = level<=prefixBits ? (leaf>>(prefixBits-level)):leaf;
+						const uint32_t randMask = level<leafLevel ? 0x80000000u:0xffffffffu;
+						flip |= draws[levelStart+node]&(randMask>>level);
+						levelStart += getLevelSize(level);
+					}
+					flips[leaf] = flip;
+				}
+				for (uint32_t i=0u; i<sampleCount; i++)
+					row[i] ^= flips[(row[i]>>(OUT_BITS+1u-MAX_SAMPLES_LOG2))>>(leafLevel-prefixBits)];
+			};
+
+			// enough dimensions in flight to keep the threads busy, but not so many that the kept draws take up too much memory
+			size_t treeSize = 0u;
+			for (uint32_t level=0u; level<=leafLevel; level++)
+				treeSize += getLevelSize(level);
+			constexpr size_t MaxDrawsInFlight = 0x1ull<<26u;
+			const uint32_t batchSize = static_cast<uint32_t>(std::clamp<size_t>(MaxDrawsInFlight/treeSize,1u,std::max(std::thread::hardware_concurrency(),1u)));
+
+			CTwister twister(seed);
+			std::future<void> pending;
+			for (uint32_t first=0u; first<dimensions; first+=batchSize)
+			{
+				const uint32_t count = std::min(batchSize,dimensions-first);
+				core::vector<core::vector<uint32_t>> draws(count);
+				for (auto& tree : draws)
+				{
+					tree.reserve(treeSize);
+					drawTree(twister,tree);
+				}
+				if (pending.valid())
+					pending.get();
+				pending = std::async(std::launch::async,[this,out,sampleCount,first,count,scramble,draws=std::move(draws)]() -> void
+				{
+					uint32_t* const rows = out+size_t(first)*sampleCount;
+					SequenceSampler::generateTable(rows,first,count,sampleCount);
+					core::vector<uint32_t> dims(count);
+					std::iota(dims.begin(),dims.end(),0u);
+					std::for_each(core::execution::par_unseq,dims.begin(),dims.end(),[&](const uint32_t dim) -> void
+					{
+						scramble(rows+size_t(dim)*sampleCount,draws[dim]);
+					});
+				});
+			}
+			pending.get();
+		}
+
 	protected:
+		//! Produces exactly what `std::mt19937` does, but skipping ahead only regenerates the state instead of tempering and throwing away every draw
+		class CTwister
+		{
+			public:
+				inline CTwister(const uint32_t _seed)
+				{
+					state[0] = _seed;
+					for (uint32_t i=1u; i<StateSize; i++)
+						state[i] = 1812433253u*(state[i-1u]^(state[i-1u]>>30u))+i;
+				}
+
+				inline uint32_t operator()()
+				{
+					if (next==StateSize)
+						twist();
+					uint32_t y = state[next++];
+					y ^= y>>11u;
+					y ^= (y<<7u)&0x9d2c5680u;
+					y ^= (y<<15u)&0xefc60000u;
+					return y^(y>>18u);
+				}
+
+				inline void discard(uint64_t count)
+				{
+					while (count>StateSize-next)
+					{
+						count -= StateSize-next;
+						twist();
+					}
+					next += static_cast<uint32_t>(count);
+				}
+
+			private:
+				static inline constexpr uint32_t StateSize = 624u;
+				static inline constexpr uint32_t ShiftSize = 397u;
+
+				inline void twist()
+				{
+					auto mix = [](const uint32_t upper, const uint32_t lower, const uint32_t shifted) -> uint32_t
+					{
+						const uint32_t y = (upper&0x80000000u)|(lower&0x7fffffffu);
+						return shifted^(y>>1u)^((y&0x1u) ? 0x9908b0dfu:0u);
+					};
+					uint32_t i = 0u;
+					for (; i<StateSize-ShiftSize; i++)
+						state[i] = mix(state[i],state[i+1u],state[i+ShiftSize]);
+					for (; i<StateSize-1u; i++)
+						state[i] = mix(state[i],state[i+1u],state[i+ShiftSize-StateSize]);
+					state[StateSize-1u] = mix(state[StateSize-1u],state[0],state[ShiftSize-1u]);
+					next = 0u;
+				}
+
+				uint32_t state[StateSize];
+				uint32_t next = StateSize;
+		};
+
 		// if we don't limit the sample count, then due to IEEE754 precision, we'll get duplicate sample coordinate values, ruining the net property
 		_NBL_STATIC_INLINE_CONSTEXPR uint32_t OUT_BITS = sizeof(uint32_t)*8u;
 		_NBL_STATIC_INLINE_CONSTEXPR uint32_t MAX_SAMPLES_LOG2 = 24u;
@@ -98,6 +251,7 @@ namespace core
 		}
 
 		std::mt19937 mersenneTwister;
+		uint32_t seed;
 		uint32_t lastDim;
 		core::vector<uint32_t> cachedFlip;
 	};
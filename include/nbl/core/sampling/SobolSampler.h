@@ -6,6 +6,11 @@
 #define __NBL_CORE_SOBOL_SAMPLER_H_
 
 #include "nbl/core/decl/Types.h"
+#include "nbl/core/execution.h"
+
+#include <bit>
+#include <numeric>
+#include <emmintrin.h>
 
 namespace nbl::core
 {
@@ -91,6 +96,50 @@ class SobolSampler
 			return retval;
 		}
 
+		//! Same values as `sample(dim,i)` for `dimCount` dimensions starting at `firstDim` and the first `sampleCount` samples, written to `out[(dim-firstDim)*sampleCount+i]`.
+		//! Walks the samples in Gray code order so every one costs a single XOR, 4 dimensions at a time, with blocks of dimensions spread over threads.
+		inline void generateTable(uint32_t* out, const uint32_t firstDim, const uint32_t dimCount, const uint32_t sampleCount) const
+		{
+			assert(firstDim+dimCount<=dimensions);
+			if (!dimCount || !sampleCount)
+				return;
+
+			constexpr uint32_t Lanes = 4u;
+			const auto vectors = *reinterpret_cast<const uint32_t(*)[][SOBOL_BITS]>(directions);
+			// sample `i^(i>>1)` differs from the previous one by the direction of the lowest set bit of `i`,
+			// so walk up to the next power of two and skip whatever lands past `sampleCount`
+			const uint64_t walkLength = std::bit_ceil(uint64_t(sampleCount));
+
+			core::vector<uint32_t> blocks((dimCount-1u)/Lanes+1u);
+			std::iota(blocks.begin(),blocks.end(),0u);
+			std::for_each(core::execution::par_unseq,blocks.begin(),blocks.end(),[&](const uint32_t block) -> void
+			{
+				const uint32_t blockDim = block*Lanes;
+				const uint32_t laneCount = std::min(Lanes,dimCount-blockDim);
+				// direction numbers of the block's dimensions side by side, unused lanes stay 0
+				alignas(16) uint32_t transposed[SOBOL_BITS][Lanes] = {};
+				for (uint32_t lane=0u; lane<laneCount; lane++)
+				for (uint32_t i=0u; i<SOBOL_BITS; i++)
+					transposed[i][lane] = vectors[firstDim+blockDim+lane][i];
+
+				uint32_t* const rows = out+size_t(blockDim)*sampleCount;
+				__m128i value = _mm_setzero_si128();
+				alignas(16) uint32_t lanes[Lanes];
+				for (uint64_t i=0ull; i<walkLength; i++)
+				{
+					const uint64_t gray = i^(i>>1ull);
+					if (gray<sampleCount)
+					{
+						_mm_store_si128(reinterpret_cast<__m128i*>(lanes),value);
+						for (uint32_t lane=0u; lane<laneCount; lane++)
+							rows[size_t(lane)*sampleCount+gray] = lanes[lane];
+					}
+					if (i+1ull<walkLength)
+						value = _mm_xor_si128(value,_mm_load_si128(reinterpret_cast<const __m128i*>(transposed[std::countr_zero(i+1ull)])));
+				}
+			});
+		}
+
 	protected:
 		typedef struct SobolDirectionNumbers {
 			uint32_t d, s, a;
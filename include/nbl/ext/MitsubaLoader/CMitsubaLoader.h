@@ -62,6 +62,8 @@ class CMitsubaLoader : public asset::IRenderpassIndependentPipelineLoader
 
 	protected:
 		system::ISystem* m_system;
+		//! not the one registered with the asset manager, called directly so only the meshes a scene references get inflated
+		core::smart_refctd_ptr<CSerializedLoader> m_serializedLoader;
 
 		//! Destructor
 		virtual ~CMitsubaLoader() = default;
@@ -72,6 +74,12 @@ class CMitsubaLoader : public asset::IRenderpassIndependentPipelineLoader
 		core::vector<SContext::shape_ass_type>	getMesh(SContext& ctx, uint32_t hierarchyLevel, CElementShape* shape, const system::logger_opt_ptr& logger);
 		core::vector<SContext::shape_ass_type>	loadShapeGroup(SContext& ctx, uint32_t hierarchyLevel, const CElementShape::ShapeGroup* shapegroup, const core::matrix3x4SIMD& relTform, const system::logger_opt_ptr& _logger);
 		SContext::shape_ass_type				loadBasicShape(SContext& ctx, uint32_t hierarchyLevel, CElementShape* shape, const core::matrix3x4SIMD& relTform, const system::logger_opt_ptr& logger);
+		//! Loads all models in one batch and creates the meshes of all shapes which will get instanced, in parallel where possible
+		void									prepareShapes(SContext& ctx, uint32_t hierarchyLevel, const core::vector<std::pair<CElementShape*,std::string>>& shapes, const system::logger_opt_ptr& logger);
+		//! Only touches `ctx` for reading when the shape is a model (OBJ, PLY, serialized) so those can be created concurrently
+		SContext::shape_ass_type				createShapeMesh(SContext& ctx, uint32_t hierarchyLevel, CElementShape* shape, const system::logger_opt_ptr& logger);
+		asset::SAssetBundle						loadSerializedMeshes(SContext& ctx, uint32_t hierarchyLevel, const std::string& filename, std::span<const uint32_t> meshIndices);
+		static const SContext::group_ass_type&	flattenShapeGroup(SContext& ctx, const CElementShape::ShapeGroup* shapegroup);
 		
 		void									cacheTexture(SContext& ctx, uint32_t hierarchyLevel, const CElementTexture* texture, const CMitsubaMaterialCompilerFrontend::E_IMAGE_VIEW_SEMANTIC semantic);
 
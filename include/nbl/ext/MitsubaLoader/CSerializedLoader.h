@@ -7,6 +7,8 @@
 
 #include "nbl/asset/asset.h"
 
+#include <span>
+
 namespace nbl
 {
 namespace ext
@@ -47,6 +49,10 @@ class CSerializedLoader final : public asset::IRenderpassIndependentPipelineLoad
 		//! creates/loads an animated mesh from the file.
 		asset::SAssetBundle loadAsset(system::IFile* _file, const asset::IAssetLoader::SAssetLoadParams& _params, asset::IAssetLoader::IAssetLoaderOverride* _override = nullptr, uint32_t _hierarchyLevel = 0u) override;
 
+		//! Only inflates the meshes with the given indices into the file's mesh table, all of them if `meshIndices` is empty.
+		//! The meshes get inflated concurrently, `CMitsubaSerializedMetadata::CMesh::m_id` tells which index each returned mesh had.
+		asset::SAssetBundle loadMeshes(system::IFile* _file, std::span<const uint32_t> meshIndices, const asset::IAssetLoader::SAssetLoadParams& _params, asset::IAssetLoader::IAssetLoaderOverride* _override, uint32_t _hierarchyLevel = 0u);
+
 	private:
 
 		struct FileHeader
@@ -65,6 +71,7 @@ class CSerializedLoader final : public asset::IRenderpassIndependentPipelineLoad
 		{
 			IAssetLoader::SAssetLoadContext inner;
 			uint32_t meshCount;
+			// offsets of the compressed streams, followed by their sizes
 			core::smart_refctd_dynamic_array<uint64_t> meshOffsets;
 		};
 };
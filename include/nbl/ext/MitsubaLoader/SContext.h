@@ -41,12 +41,16 @@ namespace MitsubaLoader
 		_NBL_STATIC_INLINE_CONSTEXPR uint32_t VT_PAGE_PADDING = 8u;
 		_NBL_STATIC_INLINE_CONSTEXPR uint32_t VT_MAX_ALLOCATABLE_TEX_SZ_LOG2 = 12u;//4096
 
-		//
-		using group_ass_type = core::vector<core::smart_refctd_ptr<asset::ICPUMesh>>;
-		//core::map<const CElementShape::ShapeGroup*, group_ass_type> groupCache;
+		// basic shapes of a shape group, nested groups flattened depth first
+		using group_ass_type = core::vector<CElementShape*>;
+		core::unordered_map<const CElementShape::ShapeGroup*, group_ass_type> groupCache;
 		//
 		using shape_ass_type = core::smart_refctd_ptr<asset::ICPUMesh>;
 		core::map<const CElementShape*, shape_ass_type> shapeCache;
+		// models referenced by shapes, all loaded in one batch before any shape gets created
+		core::unordered_map<std::string, asset::SAssetBundle> modelCache;
+		// meshes created ahead of instancing (on the loader's thread pool where possible), nullptr if the shape failed to load
+		core::unordered_map<const CElementShape*, shape_ass_type> preparedShapes;
 		//image, sampler
 		using tex_ass_type = std::tuple<core::smart_refctd_ptr<asset::ICPUImageView>,core::smart_refctd_ptr<asset::ICPUSampler>>;
 		//image, scale
@@ -0,0 +1,90 @@
+#ifndef _NBL_SYSTEM_C_WORK_STEALING_THREAD_POOL_H_INCLUDED_
+#define _NBL_SYSTEM_C_WORK_STEALING_THREAD_POOL_H_INCLUDED_
+
+#include "nbl/core/declarations.h"
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace nbl::system
+{
+
+//! Fixed set of workers with a task deque each. Tasks submitted from a worker go to the back of its own deque (depth first, the data is hot),
+//! idle workers steal from the front of the others' deques.
+//! Threads waiting on a task group run queued tasks instead of blocking, so tasks spawning and joining more tasks never need more threads than cores.
+class NBL_API2 CWorkStealingThreadPool final : public core::IReferenceCounted
+{
+	public:
+		using task_t = std::function<void()>;
+
+		//! Tracks completion of the tasks submitted with it, must outlive them
+		class CTaskGroup
+		{
+			public:
+				inline bool done() const {return m_pending.load(std::memory_order_acquire)==0u;}
+
+			private:
+				friend class CWorkStealingThreadPool;
+				std::atomic_uint32_t m_pending = 0u;
+		};
+
+		//! 0 means one less than `std::thread::hardware_concurrency()`, because whoever waits on a group works too
+		explicit CWorkStealingThreadPool(uint32_t workerCount=0u);
+
+		inline uint32_t getWorkerCount() const {return static_cast<uint32_t>(m_threads.size());}
+
+		//! The pool the calling thread is a worker of, if any
+		static CWorkStealingThreadPool* getCurrent();
+
+		void submit(CTaskGroup& group, task_t&& task);
+
+		//! Runs queued tasks on the calling thread until every task of `group` has finished
+		inline void wait(const CTaskGroup& group)
+		{
+			helpUntil([&group]()->bool{return group.done();});
+		}
+		//! Like `wait` but only runs tasks of `group` itself, for callers which hold something other tasks might be waiting on
+		//! and so can't have unrelated tasks (which could end up waiting on them) stacked on top of them
+		void waitOnly(const CTaskGroup& group);
+		//! Same as `wait` but for any condition, `pred` is polled between tasks and whenever `notifyWaiters` gets called
+		void helpUntil(const std::function<bool()>& pred);
+		//! For conditions of `helpUntil` which don't depend on tasks of this pool
+		void notifyWaiters();
+
+	protected:
+		~CWorkStealingThreadPool();
+
+	private:
+		struct STask
+		{
+			task_t func;
+			CTaskGroup* group;
+		};
+		struct alignas(64) SQueue
+		{
+			std::mutex lock;
+			core::deque<STask> tasks;
+		};
+
+		//! `only` restricts it to tasks of one group
+		bool tryRunOne(const uint32_t self, const CTaskGroup* only=nullptr);
+		void worker(const uint32_t index);
+
+		std::unique_ptr<SQueue[]> m_queues;
+		uint32_t m_queueCount;
+		std::atomic_uint32_t m_nextQueue = 0u;
+		// tasks sitting in the queues, lets idle threads park without scanning
+		std::atomic_uint64_t m_queued = 0u;
+
+		std::mutex m_parkLock;
+		std::condition_variable m_parkCvar;
+		bool m_quit = false;
+
+		core::vector<std::thread> m_threads;
+};
+
+}
+
+#endif
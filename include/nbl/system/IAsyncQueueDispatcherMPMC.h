@@ -0,0 +1,230 @@
+#ifndef _NBL_I_ASYNC_QUEUE_DISPATCHER_MPMC_H_INCLUDED_
+#define _NBL_I_ASYNC_QUEUE_DISPATCHER_MPMC_H_INCLUDED_
+
+#include "nbl/system/IAsyncQueueDispatcher.h"
+
+namespace nbl::system
+{
+
+/**
+* Multi-worker sibling of `IAsyncQueueDispatcher`, same futures and cancellation semantics but:
+* - the circular buffer is a lock-free bounded MPMC ring (per-slot sequence numbers a'la Vyukov), `request()` never takes a mutex
+* - every worker claims up to `BatchSize` consecutive requests with a single CAS and processes them back to back
+* - idle workers spin for a while and then park on an atomic (futex) instead of a condvar, producers only pay for a wakeup syscall if someone is parked
+*
+* Required accessible public methods of class being CRTP parameter:
+*
+* void process_request(future_base_t*, request_metadata_t&); // called concurrently from many workers!
+*
+* Because workers call into the CRTP, the derived class should call `terminate()` in its destructor if `process_request` touches its members.
+*/
+template<typename CRTP, typename request_metadata_t, uint32_t BufferSize=256u, uint32_t BatchSize=16u>
+class IAsyncQueueDispatcherMPMC : protected impl::IAsyncQueueDispatcherBase
+{
+        static_assert(BufferSize>0u, "BufferSize must not be 0!");
+        static_assert(core::isPoT(BufferSize), "BufferSize must be power of two!");
+        static_assert(BatchSize>0u && BatchSize<=BufferSize, "BatchSize must be in [1,BufferSize]!");
+
+    protected:
+        struct request_t : public request_base_t
+        {
+            inline request_t() : request_base_t() {}
+
+            request_metadata_t m_metadata = {};
+        };
+
+    private:
+        constexpr static inline uint32_t MaxRequestCount = BufferSize;
+        // how many times an idle worker polls the ring before parking
+        constexpr static inline uint32_t SpinCount = 256u;
+
+        using atomic_counter_t = std::atomic_uint64_t;
+        using counter_t = atomic_counter_t::value_type;
+
+        struct alignas(64) slot_t
+        {
+            request_t req;
+            // `pos` when free for the producer with ticket `pos`, `pos+1` when ready for consumption
+            atomic_counter_t sequence;
+        };
+        slot_t request_pool[MaxRequestCount];
+        // keep the hot counters on separate cachelines
+        alignas(64) atomic_counter_t cb_end = 0u;
+        alignas(64) atomic_counter_t cb_begin = 0u;
+        alignas(64) std::atomic_uint32_t m_sleepers = 0u;
+        std::atomic_uint32_t m_wakeEpoch = 0u;
+        std::atomic_bool m_quit = false;
+
+        core::vector<std::thread> m_workers;
+
+        static inline counter_t wrapAround(counter_t x)
+        {
+            constexpr counter_t Mask = static_cast<counter_t>(BufferSize) - static_cast<counter_t>(1);
+            return x & Mask;
+        }
+
+    public:
+        template<typename T>
+        using future_t = impl::IAsyncQueueDispatcherBase::future_t<T>;
+        template<typename T>
+        using cancellable_future_t = impl::IAsyncQueueDispatcherBase::cancellable_future_t<T>;
+
+        inline IAsyncQueueDispatcherMPMC()
+        {
+            for (uint32_t i=0u; i<MaxRequestCount; i++)
+                request_pool[i].sequence.store(i,std::memory_order_relaxed);
+        }
+
+        //! Has no effect if workers are already running, 0 means `std::thread::hardware_concurrency()`
+        inline bool start(uint32_t workerCount=0u)
+        {
+            if (!m_workers.empty())
+                return false;
+            if (workerCount==0u)
+                workerCount = core::max(std::thread::hardware_concurrency(),1u);
+            m_quit.store(false);
+            m_workers.reserve(workerCount);
+            for (uint32_t i=0u; i<workerCount; i++)
+                m_workers.emplace_back(&IAsyncQueueDispatcherMPMC::worker,this);
+            return true;
+        }
+
+        //! Workers drain everything already requested before exiting
+        inline void terminate()
+        {
+            m_quit.store(true);
+            wakeWorkers<true>();
+            for (auto& worker : m_workers)
+                worker.join();
+            m_workers.clear();
+        }
+
+        inline uint32_t getWorkerCount() const {return static_cast<uint32_t>(m_workers.size());}
+
+        //! Constructs a request with `args` on the ring after there's enough space to accomodate it.
+        //! Then it associates the request to a future passed in as the first argument.
+        template<typename T, typename... Args>
+        void request(future_t<T>* _future, Args&&... args)
+        {
+            // take a ticket, every producer gets a unique slot and lap
+            const auto virtualIx = cb_end.fetch_add(1u,std::memory_order_relaxed);
+            slot_t& slot = request_pool[wrapAround(virtualIx)];
+            // protect against overflow by waiting for the worker(s) to be done with our slot's previous lap
+            for (counter_t seq; (seq=slot.sequence.load(std::memory_order_acquire))!=virtualIx; )
+                slot.sequence.wait(seq);
+
+            request_t& req = slot.req;
+            req.start();
+            req.m_metadata = request_metadata_t(std::forward<Args>(args)...);
+            req.finalize(_future);
+
+            // publish
+            slot.sequence.store(virtualIx+1u,std::memory_order_release);
+            // pairs with the fence in `park()`, either we see the sleeper or it sees our request
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_sleepers.load(std::memory_order_relaxed))
+                wakeWorkers<false>();
+        }
+
+    protected:
+        inline ~IAsyncQueueDispatcherMPMC()
+        {
+            terminate();
+        }
+
+    private:
+        template<bool all>
+        inline void wakeWorkers()
+        {
+            m_wakeEpoch.fetch_add(1u,std::memory_order_release);
+            if constexpr (all)
+                m_wakeEpoch.notify_all();
+            else
+                m_wakeEpoch.notify_one();
+        }
+
+        //! Claims up to `BatchSize` consecutive published requests, returns the first ticket and writes how many were claimed
+        inline counter_t claim(uint32_t& count)
+        {
+            auto pos = cb_begin.load(std::memory_order_relaxed);
+            while (true)
+            {
+                count = 0u;
+                while (count<BatchSize)
+                {
+                    const auto seq = request_pool[wrapAround(pos+count)].sequence.load(std::memory_order_acquire);
+                    if (seq!=pos+count+1u)
+                        break;
+                    count++;
+                }
+                if (count==0u)
+                    return pos;
+                // on failure `pos` gets reloaded and we try again from wherever the other workers left off
+                if (cb_begin.compare_exchange_weak(pos,pos+count,std::memory_order_relaxed))
+                    return pos;
+            }
+        }
+
+        inline bool empty() const
+        {
+            const auto pos = cb_begin.load(std::memory_order_relaxed);
+            return request_pool[wrapAround(pos)].sequence.load(std::memory_order_acquire)!=pos+1u;
+        }
+
+        inline void park()
+        {
+            const auto epoch = m_wakeEpoch.load(std::memory_order_acquire);
+            m_sleepers.fetch_add(1u,std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (empty() && !m_quit.load(std::memory_order_relaxed))
+                m_wakeEpoch.wait(epoch,std::memory_order_acquire);
+            m_sleepers.fetch_sub(1u,std::memory_order_relaxed);
+        }
+
+        void worker()
+        {
+            CRTP* this_ = static_cast<CRTP*>(this);
+
+            uint32_t idleIterations = 0u;
+            while (true)
+            {
+                uint32_t count;
+                const auto first = claim(count);
+                if (count==0u)
+                {
+                    if (m_quit.load(std::memory_order_relaxed))
+                        break;
+                    if (++idleIterations<SpinCount)
+                        std::this_thread::yield();
+                    else
+                    {
+                        park();
+                        idleIterations = 0u;
+                    }
+                    continue;
+                }
+                idleIterations = 0u;
+
+                for (uint32_t i=0u; i<count; i++)
+                {
+                    const auto virtualIx = first+i;
+                    slot_t& slot = request_pool[wrapAround(virtualIx)];
+                    request_t& req = slot.req;
+                    // do NOT allow cancelling or modification of the request while working on it
+                    if (future_base_t* future=req.wait())
+                    {
+                        // if the request supports cancelling and got cancelled, then `wait()` function may return false
+                        this_->process_request(future,req.m_metadata);
+                        req.notify();
+                    }
+                    // hand the slot over to the producer of the next lap
+                    slot.sequence.store(virtualIx+MaxRequestCount,std::memory_order_release);
+                    slot.sequence.notify_all();
+                }
+            }
+        }
+};
+
+}
+
+#endif
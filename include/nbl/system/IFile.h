@@ -91,6 +91,8 @@ class IFile : public IFileBase, private ISystem::IFutureManipulator
 	protected:
 		// this is an abstract interface class so this stays protected
 		using IFileBase::IFileBase;
+		// for files which produce their data synchronously in `unmappedRead`
+		using ISystem::IFutureManipulator::set_result;
 
 		//
 		virtual void unmappedRead(ISystem::future_t<size_t>& fut, void* buffer, size_t offset, size_t sizeToRead)
@@ -37,8 +37,19 @@ class NBL_API2 ISystem : public core::IReferenceCounted
 
                 template <typename... Args>
                 inline void set_result(Args&&... args)
+                {
+                    begin_result();
+                    finish_result(std::forward<Args>(args)...);
+                }
+                //! Split version of `set_result` for when the result gets produced on another thread without going through a request,
+                //! after `begin_result` the future counts as executing, so `wait()` and the destructor will block until `finish_result`
+                inline void begin_result()
                 {
                     base_t::state.waitTransition(base_t::STATE::EXECUTING,base_t::STATE::INITIAL);
+                }
+                template <typename... Args>
+                inline void finish_result(Args&&... args)
+                {
                     base_t::construct(std::forward<Args>(args)...);
                     base_t::notify();
                 }
@@ -50,6 +61,14 @@ class NBL_API2 ISystem : public core::IReferenceCounted
                 {
                     future.set_result(value);
                 }
+                inline void begin_result(future_t<size_t>& future) const
+                {
+                    future.begin_result();
+                }
+                inline void finish_result(future_t<size_t>& future, const size_t value) const
+                {
+                    future.finish_result(value);
+                }
         };
 		
 		#ifndef NBL_EMBED_BUILTIN_RESOURCES
@@ -102,6 +121,9 @@ class NBL_API2 ISystem : public core::IReferenceCounted
         // can only perform operations on non-virtual filesystem paths
         std::error_code moveFileOrDirectory(const system::path& oldPath, const system::path& newPath);
 
+        //! A path next to `target` which no other writer (thread or process) will come up with, for writing a file in full before moving it over `target`
+        static system::path getUniqueTemporaryPath(const system::path& target);
+
         /*
             Recursively copy a directory or a file from one place to another.
             from - a path to the source file or directory. Must exist. Can be both readonly and mutable path.
@@ -174,6 +196,11 @@ class NBL_API2 ISystem : public core::IReferenceCounted
                 // each per-platform backend must override this function
                 virtual core::smart_refctd_ptr<ISystemFile> createFile(const std::filesystem::path& filename, const core::bitflag<IFileBase::E_CREATE_FLAGS> flags) = 0;
 
+                // Backends which can keep many reads in flight (and complete them out of order) override this and return true,
+                // the default makes unmapped reads go serially through the `CAsyncQueue` like every other request.
+                // NOTE: called from the requesting thread, not the dispatcher thread!
+                virtual bool submitRead(ISystemFile* file, future_t<size_t>& future, void* buffer, size_t offset, size_t size) {return false;}
+
                 // these contain some hoisted common sense checks
                 bool invalidateMapping(IFile* file, size_t offset, size_t size);
                 bool flushMapping(IFile* file, size_t offset, size_t size);
@@ -270,6 +297,8 @@ class NBL_API2 ISystem : public core::IReferenceCounted
 
                 void process_request(base_t::future_base_t* _future_base, SRequestType& req);
 
+                inline ICaller* getCaller() const {return m_caller.get();}
+
                 void init() {}
         };
         // friendship needed to be able to know about the request types
@@ -26,6 +26,10 @@ class ISystemFile : public IFile
 		//
 		inline void unmappedRead(ISystem::future_t<size_t>& fut, void* buffer, size_t offset, size_t sizeToRead) override final
 		{
+			// backend might want to keep multiple reads in flight instead of queueing behind the dispatcher thread
+			if (m_system->m_dispatcher.getCaller()->submitRead(this,fut,buffer,offset,sizeToRead))
+				return;
+
 			ISystem::SRequestParams_READ params;
 			params.buffer = buffer;
 			params.file = this;
@@ -10,15 +10,30 @@ namespace nbl::system
 {
 
 #if defined(_NBL_PLATFORM_LINUX_) || defined (_NBL_PLATFORM_ANDROID_)
+#ifdef _NBL_PLATFORM_LINUX_
+class CFileReadQueueLinux;
+#endif
+
 class ISystemPOSIX : public ISystem
 {
     protected:
         class CCaller final : public ISystem::ICaller
         {
             public:
-                inline CCaller(ISystemPOSIX* _system) : ICaller(_system) {}
+                NBL_API2 CCaller(ISystemPOSIX* _system);
 
                 NBL_API2 core::smart_refctd_ptr<ISystemFile> createFile(const std::filesystem::path& filename, const core::bitflag<IFile::E_CREATE_FLAGS> flags) override;
+
+            #ifdef _NBL_PLATFORM_LINUX_
+                // reads of read-only files bypass the dispatcher thread and get many in flight at once (io_uring or a thread pool)
+                NBL_API2 bool submitRead(ISystemFile* file, future_t<size_t>& future, void* buffer, size_t offset, size_t size) override;
+
+            protected:
+                NBL_API2 ~CCaller();
+
+            private:
+                core::smart_refctd_ptr<CFileReadQueueLinux> m_readQueue;
+            #endif
         };
 
         inline ISystemPOSIX() : ISystem(core::make_smart_refctd_ptr<CCaller>(this)) {}
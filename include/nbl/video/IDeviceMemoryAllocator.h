@@ -26,9 +26,10 @@ public:
 
 	struct SAllocateInfo
 	{
-		size_t size : 54 = 0ull;
+		size_t size : 48 = 0ull;
 		size_t flags : 5 = 0u; // IDeviceMemoryAllocation::E_MEMORY_ALLOCATE_FLAGS
 		size_t memoryTypeIndex : 5 = 0u;
+		size_t alignmentLog2 : 6 = 0u; // only matters to allocators which sub-allocate, the logical device always returns offset 0
 		IDeviceMemoryBacked* dedication = nullptr; // if you make the info have a `dedication` the memory will be bound right away, also it will use VK_KHR_dedicated_allocation on vulkan
 		// size_t opaqueCaptureAddress = 0u; Note that this mechanism is intended only to support capture/replay tools, and is not recommended for use in other applications.
 	};
@@ -58,6 +59,7 @@ public:
 			ret.size = m_reqs.size;
 			ret.flags = m_allocateFlags;
 			ret.memoryTypeIndex = dereference();
+			ret.alignmentLog2 = m_reqs.alignmentLog2;
 			ret.dedication = dedication;
 			return ret;
 		}
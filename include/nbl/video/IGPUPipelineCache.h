@@ -22,7 +22,12 @@ class IGPUPipelineCache : public core::IReferenceCounted, public IBackendObject
 	public:
 		explicit IGPUPipelineCache(core::smart_refctd_ptr<const ILogicalDevice>&& dev) : IBackendObject(std::move(dev)) {}
 
-		virtual void merge(uint32_t _count, const IGPUPipelineCache** _srcCaches) = 0;
+		//! Adds the contents of the other caches to this one, they all have to come from the same device
+		virtual bool merge(uint32_t _count, const IGPUPipelineCache** _srcCaches) = 0;
+
+		//! What can be passed to `ILogicalDevice::createPipelineCache` in a later run, nullptr on failure
+		//! (in Vulkan this is the blob from `vkGetPipelineCacheData` starting with the header identifying the device and driver)
+		virtual core::smart_refctd_dynamic_array<uint8_t> getData() const = 0;
 
 		virtual core::smart_refctd_ptr<asset::ICPUPipelineCache> convertToCPUCache() const = 0;
 };
@@ -59,6 +59,9 @@ class NBL_API2 ILogicalDevice : public core::IReferenceCounted, public IDeviceMe
             std::array<SQueueCreationParams,MaxQueueFamilies> queueParams = {};
             SPhysicalDeviceFeatures featuresToEnable = {};
             core::smart_refctd_ptr<asset::CCompilerSet> compilerSet = nullptr;
+            //! The device keeps a pipeline cache used whenever pipelines get created without one, if this is set it gets loaded from that file
+            //! on creation and written back on destruction (or `saveDefaultPipelineCache`), so later runs don't compile the same pipelines again
+            system::path pipelineCachePath = {};
         };
 
         struct SDescriptorSetCreationParams
@@ -271,8 +274,19 @@ class NBL_API2 ILogicalDevice : public core::IReferenceCounted, public IDeviceMe
         //! Create a sampler object to use with images
         virtual core::smart_refctd_ptr<IGPUSampler> createSampler(const IGPUSampler::SParams& _params) = 0;
 
-        //! Create a pipeline cache object
-        virtual core::smart_refctd_ptr<IGPUPipelineCache> createPipelineCache() { return nullptr; }
+        //! Create a pipeline cache object, optionally filled with what `IGPUPipelineCache::getData` returned in an earlier run
+        //! Data coming from a different device or driver version gets ignored and an empty cache is created instead.
+        virtual core::smart_refctd_ptr<IGPUPipelineCache> createPipelineCache(const void* initialData=nullptr, const size_t initialDataSize=0ull) { return nullptr; }
+
+        //! Create a pipeline cache from a file written by `savePipelineCache`, a missing or stale file gives an empty cache
+        core::smart_refctd_ptr<IGPUPipelineCache> loadPipelineCache(const system::path& path);
+        //! Writes the cache's data to a file, replacing it only once all of it got written
+        bool savePipelineCache(const IGPUPipelineCache* cache, const system::path& path);
+
+        //! Contents of the cache used when pipelines get created without one
+        virtual core::smart_refctd_dynamic_array<uint8_t> getDefaultPipelineCacheData() const { return nullptr; }
+        //! Writes the default pipeline cache to `SCreationParams::pipelineCachePath`, does nothing and returns false if that wasn't set
+        bool saveDefaultPipelineCache();
 
         //! Create a descriptor set layout (@see ICPUDescriptorSetLayout)
         core::smart_refctd_ptr<IGPUDescriptorSetLayout> createDescriptorSetLayout(const IGPUDescriptorSetLayout::SBinding* _begin, const IGPUDescriptorSetLayout::SBinding* _end);
@@ -434,8 +448,6 @@ class NBL_API2 ILogicalDevice : public core::IReferenceCounted, public IDeviceMe
         //vkCreateGraphicsPipelines // no graphics pipelines yet (just renderpass independent)
         //vkGetDescriptorSetLayoutSupport
         //vkTrimCommandPool // for this you need to Optimize OpenGL commandrecording to use linked list
-        //vkGetPipelineCacheData //as pipeline cache method?? (why not)
-        //vkMergePipelineCaches //as pipeline cache method (why not)
         
         virtual core::smart_refctd_ptr<IQueryPool> createQueryPool(IQueryPool::SCreationParams&& params) { return nullptr; }
 
@@ -481,6 +493,9 @@ class NBL_API2 ILogicalDevice : public core::IReferenceCounted, public IDeviceMe
     protected:
         ILogicalDevice(core::smart_refctd_ptr<IAPIConnection>&& api, IPhysicalDevice* physicalDevice, const SCreationParams& params);
 
+        core::smart_refctd_dynamic_array<uint8_t> readPipelineCacheFile(const system::path& path) const;
+        bool writePipelineCacheFile(const system::path& path, const core::smart_refctd_dynamic_array<uint8_t>& data) const;
+
         // must be called by implementations of mapMemory()
         static void post_mapMemory(IDeviceMemoryAllocation* memory, void* ptr, IDeviceMemoryAllocation::MemoryRange rng, core::bitflag<IDeviceMemoryAllocation::E_MAPPING_CPU_ACCESS_FLAGS> access) 
         {
@@ -538,6 +553,7 @@ class NBL_API2 ILogicalDevice : public core::IReferenceCounted, public IDeviceMe
         core::smart_refctd_ptr<IAPIConnection> m_api;
         SPhysicalDeviceFeatures m_enabledFeatures;
         IPhysicalDevice* m_physicalDevice;
+        system::path m_pipelineCachePath;
 
         using queues_array_t = core::smart_refctd_dynamic_array<CThreadSafeGPUQueueAdapter*>;
         queues_array_t m_queues;
@@ -0,0 +1,155 @@
+// Copyright (C) 2018-2023 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#ifndef _NBL_VIDEO_C_DEVICE_MEMORY_SUB_ALLOCATOR_H_
+#define _NBL_VIDEO_C_DEVICE_MEMORY_SUB_ALLOCATOR_H_
+
+#include "nbl/video/IDeviceMemoryAllocator.h"
+#include "nbl/video/ILogicalDevice.h"
+
+#include <mutex>
+#include <shared_mutex>
+
+namespace nbl::video
+{
+
+//! Carves allocations out of large blocks of device memory instead of making a `vkAllocateMemory` for each of them
+/*
+    Blocks are kept separately for every memory type and allocate flags combination. Allocations up to `maxSizeClass` get rounded
+    up to a power of two size class served by a `core::PoolAddressAllocator` per block, bigger ones share `core::GeneralpurposeAddressAllocator` blocks.
+    Dedicated allocations, ones bigger than `maxSubAllocationSize` and ones aligned to more than `maxAlignment` are forwarded to the device,
+    so they keep getting an offset of 0 and their own memory.
+
+    Every offset and size is padded to the device's `bufferImageGranularity`, as nothing tells whether a buffer or an image is going to get bound,
+    and to `nonCoherentAtomSize` in non-coherent host visible memory so flushing or invalidating one allocation never touches another.
+    Host visible blocks are persistently mapped on creation, use `memory->getMappedPointer()` plus the offset and never map or unmap them yourself.
+
+    Nothing tells the allocator when a resource goes away, so every allocation which came from it has to be given back with `deallocate`.
+    A block's memory stays alive as long as anything references it, so the resource may be dropped before or after the `deallocate`.
+
+    All member functions can be called from several threads at once. Small allocations freed by a thread get cached for it to reuse without taking
+    the allocator wide lock, threads get mapped onto a fixed number of caches by their id.
+*/
+class NBL_API2 CDeviceMemorySubAllocator final : public core::IReferenceCounted, public IDeviceMemoryAllocator
+{
+    public:
+        struct SCreationParams
+        {
+            core::smart_refctd_ptr<ILogicalDevice> device = nullptr;
+            //! size of the blocks backing allocations bigger than `maxSizeClass`, if the device can't give that much a smaller block gets tried
+            size_t blockSize = 64ull<<20ull;
+            //! size of the blocks backing each size class
+            size_t sizeClassBlockSize = 4ull<<20ull;
+            //! smallest and biggest size class, both get rounded up to a power of two
+            size_t minSizeClass = 256ull;
+            size_t maxSizeClass = 64ull<<10ull;
+            //! anything bigger goes straight to the device, defaults to half of `blockSize` when 0
+            size_t maxSubAllocationSize = 0ull;
+            //! anything aligned to more goes straight to the device
+            size_t maxAlignment = 64ull<<10ull;
+            //! how many freed allocations of each size class a thread cache holds before giving them back to the blocks
+            uint32_t threadCacheSize = 32u;
+        };
+        //! returns nullptr when the parameters make no sense
+        static core::smart_refctd_ptr<CDeviceMemorySubAllocator> create(SCreationParams&& params);
+
+        using IDeviceMemoryAllocator::allocate;
+        SMemoryOffset allocate(const SAllocateInfo& info) override;
+
+        //! `size` is the one the allocation was requested with, allocations which got forwarded to the device are ignored
+        void deallocate(const SMemoryOffset& allocation, const size_t size);
+
+        //! Gives back cached allocations and frees blocks nothing is allocated from anymore
+        //! @returns the number of blocks freed
+        uint32_t trim();
+
+        //! Defragmentation hook, as Vulkan can't rebind memory only the owner of the resources can move them
+        /*
+            Blocks using at most `maxOccupancy` of their size stop being allocated from and get passed to `evacuate` one by one (least used first).
+            The callback should recreate the resources bound to that memory (new allocations land in other blocks), copy their contents over and
+            `deallocate` the old allocations, a block gets freed as soon as nothing is allocated from it anymore.
+            Blocks the callback didn't empty go back to being allocated from when `defragment` returns.
+            @returns the number of blocks freed
+        */
+        uint32_t defragment(const float maxOccupancy, const std::function<void(IDeviceMemoryAllocation*)>& evacuate);
+
+        struct SStatistics
+        {
+            uint32_t blockCount = 0u;
+            //! total size of all blocks
+            size_t blockBytes = 0ull;
+            //! including padding and the cached allocations
+            size_t allocatedBytes = 0ull;
+        };
+        SStatistics getStatistics() const;
+
+        inline ILogicalDevice* getDevice() const {return m_params.device.get();}
+
+    protected:
+        ~CDeviceMemorySubAllocator();
+
+    private:
+        struct SBlock;
+        struct SPool
+        {
+            // general purpose blocks
+            core::vector<std::unique_ptr<SBlock>> blocks;
+            // pool blocks of each size class
+            core::vector<core::vector<std::unique_ptr<SBlock>>> sizeClassBlocks;
+        };
+        struct SCachedAllocation
+        {
+            SBlock* block;
+            size_t offset;
+        };
+        _NBL_STATIC_INLINE_CONSTEXPR uint32_t ThreadCacheCount = 16u;
+        struct alignas(64) SThreadCache
+        {
+            std::mutex lock;
+            // per pool key and size class
+            core::unordered_map<uint32_t,core::vector<SCachedAllocation>> allocations;
+        };
+
+        explicit CDeviceMemorySubAllocator(SCreationParams&& params);
+
+        static inline uint32_t getPoolKey(const SAllocateInfo& info)
+        {
+            return static_cast<uint32_t>(info.memoryTypeIndex|(info.flags<<5u));
+        }
+        inline uint32_t getCacheKey(const uint32_t poolKey, const uint32_t sizeClass) const
+        {
+            return poolKey*m_sizeClassCount+sizeClass;
+        }
+        inline size_t getSizeClassBytes(const uint32_t sizeClass) const
+        {
+            return 0x1ull<<(m_minSizeClassLog2+sizeClass);
+        }
+        SThreadCache& getThreadCache();
+
+        // all need `m_lock` to be held
+        SBlock* createBlock(const SAllocateInfo& info, const uint32_t sizeClass, const size_t minSize);
+        void freeInBlock(SBlock* block, const size_t offset, const size_t size);
+        void destroyBlock(SBlock* block);
+        void flushThreadCaches();
+        uint32_t freeEmptyBlocks(const bool drainingOnly);
+
+        SCreationParams m_params;
+        // per memory type padding of offsets and sizes
+        size_t m_granularities[32];
+        size_t m_generalPurposeMinBlockSize;
+        uint32_t m_minSizeClassLog2;
+        uint32_t m_sizeClassCount;
+
+        mutable std::mutex m_lock;
+        core::unordered_map<uint32_t,SPool> m_pools;
+        // finds the block of an allocation being freed, gets written with `m_lock` held
+        mutable std::shared_mutex m_blockLookupLock;
+        core::unordered_map<const IDeviceMemoryAllocation*,SBlock*> m_blockLookup;
+
+        SThreadCache m_threadCaches[ThreadCacheCount];
+};
+
+}
+
+#endif
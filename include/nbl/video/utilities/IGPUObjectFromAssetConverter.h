@@ -8,6 +8,8 @@
 
 #include "nbl/core/declarations.h"
 #include "nbl/core/alloc/LinearAddressAllocator.h"
+#include "nbl/core/xxHash256.h"
+#include "nbl/system/CWorkStealingThreadPool.h"
 
 #include <iterator>
 
@@ -112,10 +114,18 @@ class IGPUObjectFromAssetConverter
             ILogicalDevice* device = nullptr;
             //! Required not null
             asset::IAssetManager* assetManager = nullptr;
+            //! Pipelines get created with this cache, nullptr uses the device's default one (@see ILogicalDevice::SCreationParams::pipelineCachePath)
             IGPUPipelineCache* pipelineCache = nullptr;
 
             uint32_t finalQueueFamIx = 0u;
 
+            //! Buffers, images and shaders with the same contents get a single GPU object even if they're different assets (e.g. loaded from different files),
+            //! this holds across all conversions done with the same params. Ones with usages letting the GPU write to them (storage, attachments, transfer destination)
+            //! always get their own. Off by default, as it changes which assets end up sharing a GPU object.
+            bool deduplicateByContent = false;
+            //! Runs the hashing for `deduplicateByContent`, nullptr makes the params create a pool on first use
+            core::smart_refctd_ptr<system::CWorkStealingThreadPool> threadPool = nullptr;
+
             // @sadiuk put here more parameters if needed
 
             SPerQueue perQueue[EQU_COUNT];
@@ -177,6 +187,8 @@ class IGPUObjectFromAssetConverter
             }
 
             core::smart_refctd_ptr<IGPUFence> fences[EQU_COUNT] = {};
+            // GPU objects created so far by the content hash of their assets, keeps them alive as long as the params
+            core::map<std::array<uint64_t,4>,core::smart_refctd_ptr<core::IReferenceCounted>> contentCache;
         };
 
 	protected:
@@ -265,13 +277,70 @@ class IGPUObjectFromAssetConverter
 
 			if (notFound.size())
 			{
+				using gpu_object_t = typename video::asset_traits<AssetType>::GPUObjectType;
+				// assets whose contents match an earlier one get its GPU object instead of creating their own
+				core::vector<content_hash_t> hashes;
+				core::vector<uint8_t> hashable;
+				struct SDuplicate
+				{
+					AssetType* asset;
+					size_t pos;
+					// into the deduplicated `notFound`
+					size_t uniqueIx;
+				};
+				core::vector<SDuplicate> duplicates;
+				if constexpr (is_content_hashable_v<AssetType>)
+				if (_params.deduplicateByContent)
+				{
+					hashes.resize(notFound.size());
+					hashable.resize(notFound.size());
+					hashContents(notFound.data(),notFound.size(),hashes.data(),hashable.data(),_params);
+
+					core::map<content_hash_t,size_t> firstOccur;
+					size_t uniqueCount = 0u;
+					for (size_t i=0u; i<notFound.size(); ++i)
+					{
+						if (hashable[i])
+						{
+							if (auto found=_params.contentCache.find(hashes[i]); found!=_params.contentCache.end())
+							{
+								auto gpu = core::smart_refctd_ptr_dynamic_cast<gpu_object_t>(found->second);
+								handleGPUObjCaching(_params.assetManager,notFound[i],gpu);
+								res->operator[](pos[i]) = std::move(gpu);
+								continue;
+							}
+							auto inserted = firstOccur.insert({hashes[i],uniqueCount});
+							if (!inserted.second)
+							{
+								duplicates.push_back({notFound[i],pos[i],inserted.first->second});
+								continue;
+							}
+						}
+						// compact in place, never writes past `i`
+						notFound[uniqueCount] = notFound[i];
+						pos[uniqueCount] = pos[i];
+						hashes[uniqueCount] = hashes[i];
+						hashable[uniqueCount++] = hashable[i];
+					}
+					notFound.resize(uniqueCount);
+					pos.resize(uniqueCount);
+				}
+
 				decltype(res) created = create(const_cast<const AssetType**>(notFound.data()), const_cast<const AssetType**>(notFound.data()+notFound.size()), _params);
 				for (size_t i=0u; i<created->size(); ++i)
 				{
 					auto& input = created->operator[](i);
                     handleGPUObjCaching(_params.assetManager,notFound[i],input);
+					if (!hashable.empty() && hashable[i] && input)
+						_params.contentCache.insert({hashes[i],input});
 					res->operator[](pos[i]) = std::move(input); // ok to move because the `created` array will die after the next scope
 				}
+				for (const auto& duplicate : duplicates)
+				{
+					auto gpu = res->operator[](pos[duplicate.uniqueIx]);
+					handleGPUObjCaching(_params.assetManager,duplicate.asset,gpu);
+					res->operator[](duplicate.pos) = std::move(gpu);
+				}
 			}
 
 			return res;
@@ -379,6 +448,76 @@ class IGPUObjectFromAssetConverter
 
 			return redirs;
 		}
+
+        using content_hash_t = std::array<uint64_t,4>;
+        template<typename AssetType>
+        static inline constexpr bool is_content_hashable_v = std::is_same_v<AssetType,asset::ICPUBuffer> || std::is_same_v<AssetType,asset::ICPUImage> || std::is_same_v<AssetType,asset::ICPUShader>;
+
+        //! Hashes everything the created GPU object depends on, returns false for assets which must not share a GPU object
+        static inline bool getContentHash(const asset::ICPUBuffer* _buffer, content_hash_t& _out)
+        {
+            constexpr uint32_t WritableUsages = asset::IBuffer::EUF_STORAGE_TEXEL_BUFFER_BIT|asset::IBuffer::EUF_STORAGE_BUFFER_BIT|asset::IBuffer::EUF_ACCELERATION_STRUCTURE_STORAGE_BIT|asset::IBuffer::EUF_TRANSFER_DST_BIT;
+            if (!_buffer->getPointer() || _buffer->getSize()==0ull || (_buffer->getUsageFlags().value&WritableUsages))
+                return false;
+
+            uint64_t key[7] = {asset::ICPUBuffer::AssetType,_buffer->getSize(),_buffer->getUsageFlags().value};
+            core::XXHash_256(_buffer->getPointer(),_buffer->getSize(),key+3);
+            core::XXHash_256(key,sizeof(key),_out.data());
+            return true;
+        }
+        static inline bool getContentHash(const asset::ICPUImage* _image, content_hash_t& _out)
+        {
+            constexpr uint32_t WritableUsages = asset::IImage::EUF_STORAGE_BIT|asset::IImage::EUF_COLOR_ATTACHMENT_BIT|asset::IImage::EUF_DEPTH_STENCIL_ATTACHMENT_BIT|asset::IImage::EUF_TRANSFER_DST_BIT;
+            const auto& params = _image->getCreationParameters();
+            const auto* buffer = _image->getBuffer();
+            // images without contents are render targets and the like
+            if (_image->getRegions().empty() || !buffer || !buffer->getPointer() || (params.usage.value&WritableUsages))
+                return false;
+
+            core::vector<uint64_t> key = {
+                asset::ICPUImage::AssetType,params.type,params.samples,params.format,params.extent.width,params.extent.height,params.extent.depth,
+                params.mipLevels,params.arrayLayers,params.flags.value,params.usage.value,buffer->getSize(),0ull,0ull,0ull,0ull
+            };
+            core::XXHash_256(buffer->getPointer(),buffer->getSize(),key.data()+key.size()-4u);
+            for (const auto& region : _image->getRegions())
+            {
+                key.insert(key.end(),{
+                    region.bufferOffset,region.bufferRowLength,region.bufferImageHeight,
+                    region.imageSubresource.aspectMask.value,region.imageSubresource.mipLevel,region.imageSubresource.baseArrayLayer,region.imageSubresource.layerCount,
+                    static_cast<uint32_t>(region.imageOffset.x),static_cast<uint32_t>(region.imageOffset.y),static_cast<uint32_t>(region.imageOffset.z),
+                    region.imageExtent.width,region.imageExtent.height,region.imageExtent.depth
+                });
+            }
+            core::XXHash_256(key.data(),key.size()*sizeof(uint64_t),_out.data());
+            return true;
+        }
+        static inline bool getContentHash(const asset::ICPUShader* _shader, content_hash_t& _out)
+        {
+            const auto* content = _shader->getContent();
+            if (!content || !content->getPointer() || content->getSize()==0ull)
+                return false;
+
+            uint64_t key[8] = {asset::ICPUShader::AssetType,_shader->getStage(),static_cast<uint64_t>(_shader->getContentType()),0ull};
+            // includes of shaders which still need compiling get resolved relative to their path
+            if (_shader->getContentType()!=asset::IShader::E_CONTENT_TYPE::ECT_SPIRV)
+                key[3] = std::hash<std::string>{}(_shader->getFilepathHint());
+            core::XXHash_256(content->getPointer(),content->getSize(),key+4);
+            core::XXHash_256(key,sizeof(key),_out.data());
+            return true;
+        }
+
+        //! Hashes the contents of the assets on `_params.threadPool`, `_outHashable` is set to whether an asset got a hash at all
+        template<typename AssetType>
+        static inline void hashContents(AssetType* const* _assets, const size_t _count, content_hash_t* _outHashes, uint8_t* _outHashable, SParams& _params)
+        {
+            if (!_params.threadPool)
+                _params.threadPool = core::make_smart_refctd_ptr<system::CWorkStealingThreadPool>();
+
+            system::CWorkStealingThreadPool::CTaskGroup group;
+            for (size_t i=0u; i<_count; ++i)
+                _params.threadPool->submit(group,[=]()->void{_outHashable[i] = _assets[i] && getContentHash(_assets[i],_outHashes[i]);});
+            _params.threadPool->wait(group);
+        }
 };
 
 
@@ -797,26 +936,14 @@ auto IGPUObjectFromAssetConverter::create(const asset::ICPUImage** const _begin,
 
     bool needToGenMips = false;
     
-    core::unordered_map<const asset::ICPUImage*, core::smart_refctd_ptr<IGPUBuffer>> img2gpubuf;
+    // the data goes through the streaming staging buffer, nothing else needs allocating for the upload
+    size_t imagesToUpload = 0ull;
     for (ptrdiff_t i = 0u; i < assetCount; ++i)
     {
         const asset::ICPUImage* cpuimg = _begin[i];
         if (cpuimg->getRegions().size() == 0ull)
             continue;
-
-        // TODO: Why isn't this buffer cached and why are we not going through recursive asset creation and getting ICPUBuffer equivalents? 
-        //(we can always discard/not cache the GPU Buffers created only for image data upload)
-        IGPUBuffer::SCreationParams params = {};
-        params.usage = core::bitflag(video::IGPUBuffer::EUF_TRANSFER_SRC_BIT) | video::IGPUBuffer::EUF_TRANSFER_DST_BIT;
-        const auto& cpuimgParams = cpuimg->getCreationParameters();
-        params.size = cpuimg->getBuffer()->getSize();
-
-        auto gpubuf = _params.device->createBuffer(std::move(params));
-        auto mreqs = gpubuf->getMemoryReqs();
-        mreqs.memoryTypeBits &= _params.device->getPhysicalDevice()->getDeviceLocalMemoryTypeBits();
-        auto gpubufMem = _params.device->allocate(mreqs, gpubuf.get());
-
-        img2gpubuf.insert({ cpuimg, std::move(gpubuf) });
+        ++imagesToUpload;
 
         const auto format = cpuimg->getCreationParameters().format;
         if (!asset::isIntegerFormat(format) && !asset::isBlockCompressionFormat(format))
@@ -829,7 +956,7 @@ auto IGPUObjectFromAssetConverter::create(const asset::ICPUImage** const _begin,
     auto cmdbuf_transfer = _params.perQueue[EQU_TRANSFER].cmdbuf;
     auto cmdbuf_compute = _params.perQueue[EQU_COMPUTE].cmdbuf;
 
-    if (img2gpubuf.size())
+    if (imagesToUpload)
     {
         transfer_fence = _params.device->createFence(static_cast<IGPUFence::E_CREATE_FLAGS>(0));
 
@@ -1089,7 +1216,7 @@ auto IGPUObjectFromAssetConverter::create(const asset::ICPUImage** const _begin,
 		res->operator[](i) = std::move(gpuimg);
     }
 
-    if (img2gpubuf.size() == 0ull)
+    if (imagesToUpload == 0ull)
         return res;
 
     auto it = _begin;
@@ -1460,12 +1587,50 @@ inline created_gpu_object_array<asset::ICPUComputePipeline> IGPUObjectFromAssetC
     auto gpuShaders = getGPUObjectsFromAssets<asset::ICPUSpecializedShader>(cpuShaders.data(), cpuShaders.data() + cpuShaders.size(), _params);
     auto gpuLayouts = getGPUObjectsFromAssets<asset::ICPUPipelineLayout>(cpuLayouts.data(), cpuLayouts.data() + cpuLayouts.size(), _params);
 
+    // create in batches so the driver gets to compile them together, pipelines with missing dependencies stay null
+    constexpr size_t MaxBatchSize = 32ull;
+    core::vector<IGPUComputePipeline::SCreationParams> batch;
+    core::vector<size_t> batchOutputs;
+    batch.reserve(MaxBatchSize);
+    batchOutputs.reserve(MaxBatchSize);
+    auto createBatch = [&]() -> void
+    {
+        core::smart_refctd_ptr<IGPUComputePipeline> created[MaxBatchSize];
+        if (_params.device->createComputePipelines(_params.pipelineCache, { batch.data(), batch.data() + batch.size() }, created))
+        {
+            for (size_t j = 0ull; j < batch.size(); ++j)
+            {
+                const char* debugName = batch[j].shader->getObjectDebugName();
+                if (created[j] && debugName[0])
+                    created[j]->setObjectDebugName(debugName);
+                (*res)[batchOutputs[j]] = std::move(created[j]);
+            }
+        }
+        else // one bad pipeline fails the whole batch, don't let it take the others down
+        for (size_t j = 0ull; j < batch.size(); ++j)
+            (*res)[batchOutputs[j]] = _params.device->createComputePipeline(_params.pipelineCache, std::move(batch[j].layout), std::move(batch[j].shader));
+        batch.clear();
+        batchOutputs.clear();
+    };
     for (ptrdiff_t i = 0; i < assetCount; ++i)
     {
-        auto layout = (*gpuLayouts)[layoutRedirs[i]];
-        auto shdr = (*gpuShaders)[shdrRedirs[i]];
-        (*res)[i] = _params.device->createComputePipeline(_params.pipelineCache, std::move(layout), std::move(shdr));
+        auto& layout = (*gpuLayouts)[layoutRedirs[i]];
+        auto& shdr = (*gpuShaders)[shdrRedirs[i]];
+        if (!layout || !shdr)
+            continue;
+
+        auto& params = batch.emplace_back();
+        params.flags = static_cast<IGPUComputePipeline::E_PIPELINE_CREATION>(0);
+        params.layout = layout;
+        params.shader = shdr;
+        params.basePipeline = nullptr;
+        params.basePipelineIndex = -1;
+        batchOutputs.push_back(i);
+        if (batch.size() == MaxBatchSize)
+            createBatch();
     }
+    if (!batch.empty())
+        createBatch();
 
     return res;
 }
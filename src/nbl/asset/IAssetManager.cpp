@@ -129,6 +129,38 @@ void IAssetManager::initializeMeshTools()
         m_compilerSet = core::make_smart_refctd_ptr<CCompilerSet>(core::smart_refctd_ptr(m_system));
 }
 
+system::path IAssetManager::getDefaultQuantNormalCachePath()
+{
+	std::error_code error;
+	const auto tmpDir = std::filesystem::temp_directory_path(error);
+	if (error)
+		return {};
+	return tmpDir/"nbl_quant_normal_cache_A2B10G10R10.bin";
+}
+
+void IAssetManager::loadQuantNormalCache()
+{
+	if (m_quantNormalCachePath.empty() || !m_system->exists(m_quantNormalCachePath,system::IFile::ECF_READ))
+		return;
+	auto* cache = m_meshManipulator->getQuantNormalCache();
+	cache->loadCacheFromFile<EF_A2B10G10R10_SNORM_PACK32>(m_system.get(),m_quantNormalCachePath,true);
+	m_quantNormalCacheLoadedCount = cache->getCacheEntryCount<EF_A2B10G10R10_SNORM_PACK32>();
+}
+
+void IAssetManager::saveQuantNormalCache()
+{
+	auto* cache = m_meshManipulator->getQuantNormalCache();
+	if (m_quantNormalCachePath.empty() || cache->getCacheEntryCount<EF_A2B10G10R10_SNORM_PACK32>()<=m_quantNormalCacheLoadedCount)
+		return;
+	// write the whole thing first so an interrupted save or another process never sees half a file,
+	// the default path is in the shared temp directory so every writer needs a temporary of its own
+	const system::path tmpPath = system::ISystem::getUniqueTemporaryPath(m_quantNormalCachePath);
+	if (cache->saveCacheToFile<EF_A2B10G10R10_SNORM_PACK32>(m_system.get(),tmpPath) && !m_system->moveFileOrDirectory(tmpPath,m_quantNormalCachePath))
+		return;
+	std::error_code error;
+	std::filesystem::remove(tmpPath,error);
+}
+
 const IGeometryCreator* IAssetManager::getGeometryCreator() const
 {
 	return m_geometryCreator.get();
@@ -139,6 +171,89 @@ IMeshManipulator* IAssetManager::getMeshManipulator()
 	return m_meshManipulator.get();
 }
 
+namespace
+{
+// how many in-flight loads the calling thread is the owner of, across all asset managers
+thread_local uint32_t t_ownedInFlightLoads = 0u;
+}
+
+std::shared_ptr<IAssetManager::SInFlightLoad> IAssetManager::beginLoad(const std::string& _key, bool& _owner)
+{
+	const auto thisThread = std::this_thread::get_id();
+
+	std::lock_guard lock(m_inFlightLock);
+	auto [it,inserted] = m_inFlight.try_emplace(_key);
+	if (inserted)
+	{
+		it->second = std::make_shared<SInFlightLoad>();
+		it->second->owner = thisThread;
+		t_ownedInFlightLoads++;
+	}
+	_owner = inserted || it->second->owner==thisThread;
+	// a loader which ends up asking for its own asset would wait on itself forever,
+	// so let it load another copy like it always did
+	if (!inserted && _owner)
+		return nullptr;
+	return it->second;
+}
+
+void IAssetManager::finishLoad(const std::string& _key, SInFlightLoad& _load, const SAssetBundle& _result)
+{
+	_load.result = _result;
+	{
+		std::lock_guard lock(m_inFlightLock);
+		m_inFlight.erase(_key);
+	}
+	assert(_load.owner==std::this_thread::get_id() && t_ownedInFlightLoads);
+	t_ownedInFlightLoads--;
+	_load.done.store(true,std::memory_order_release);
+	_load.done.notify_all();
+	if (m_loadPoolReady.load(std::memory_order_acquire))
+		m_loadPool->notifyWaiters();
+}
+
+void IAssetManager::waitForLoad(const SInFlightLoad& _load)
+{
+	// workers keep running other loads instead of sitting idle, unless they own a load themselves: a stolen task could end up
+	// waiting on a load whose owner waits on ours, which can't finish until the stolen task returns as it's further down the stack
+	auto* pool = system::CWorkStealingThreadPool::getCurrent();
+	if (pool && !t_ownedInFlightLoads)
+		pool->helpUntil([&_load]()->bool{return _load.done.load(std::memory_order_acquire);});
+	else
+		_load.done.wait(false,std::memory_order_acquire);
+}
+
+system::CWorkStealingThreadPool* IAssetManager::getLoadPool()
+{
+	std::call_once(m_loadPoolInit,[this]()->void
+	{
+		m_loadPool = core::make_smart_refctd_ptr<system::CWorkStealingThreadPool>();
+		m_loadPoolReady.store(true,std::memory_order_release);
+	});
+	return m_loadPool.get();
+}
+
+void IAssetManager::waitForLoadTasks(const system::CWorkStealingThreadPool::CTaskGroup& _group)
+{
+	// same reasoning as in `waitForLoad`, only here the group's own tasks can still be run
+	if (t_ownedInFlightLoads)
+		getLoadPool()->waitOnly(_group);
+	else
+		getLoadPool()->wait(_group);
+}
+
+core::vector<SAssetBundle> IAssetManager::getAssetsInHierarchy(std::span<const std::string> _filenames, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel, IAssetLoader::IAssetLoaderOverride* _override)
+{
+	core::vector<SAssetBundle> retval(_filenames.size());
+	auto* pool = getLoadPool();
+
+	system::CWorkStealingThreadPool::CTaskGroup group;
+	for (size_t i=0u; i<_filenames.size(); i++)
+		pool->submit(group,[&,i]()->void{retval[i] = getAssetInHierarchy(_filenames[i],_params,_hierarchyLevel,_override);});
+	waitForLoadTasks(group);
+	return retval;
+}
+
 void IAssetManager::addLoadersAndWriters()
 {
 #ifdef _NBL_COMPILE_WITH_STL_LOADER_
@@ -0,0 +1,839 @@
+// Copyright (C) 2018-2023 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#include "nbl/asset/filters/CBlockCompressionImageFilter.h"
+
+using namespace nbl;
+using namespace nbl::asset;
+
+namespace
+{
+using preset_t = CBlockCompressionImageFilterBase::E_PRESET;
+
+// working copy of a block, 8 bit range for the UNORM formats, [-127,127] for SNORM and F16 bit patterns stretched to the BC6H interpolation range
+struct alignas(16) SBlock
+{
+	float texels[16][4];
+};
+
+// BC6H and BC7 fields are packed LSB first into a 128 bit little endian integer
+struct SBitWriter
+{
+	inline void write(const uint32_t value, const uint32_t bits)
+	{
+		const uint64_t v = uint64_t(value)&((0x1ull<<bits)-1ull);
+		const uint32_t shift = pos&63u;
+		data[pos>>6u] |= v<<shift;
+		if (shift+bits>64u)
+			data[1] |= v>>(64u-shift);
+		pos += bits;
+	}
+
+	uint64_t data[2] = {0ull,0ull};
+	uint32_t pos = 0u;
+};
+
+inline float dot4(const __m128 a, const __m128 b)
+{
+	return _mm_cvtss_f32(_mm_dp_ps(a,b,0xf1));
+}
+
+//! Principal axis of the texels in `mask` over the first `N` channels, through power iteration on their covariance
+template<uint32_t N>
+void principalAxis(const SBlock& block, const uint32_t mask, float mean[4], float axis[4])
+{
+	std::fill_n(mean,4u,0.f);
+	std::fill_n(axis,4u,0.f);
+	uint32_t count = 0u;
+	for (uint32_t i=0u; i<16u; i++)
+	if (mask&(0x1u<<i))
+	{
+		for (uint32_t c=0u; c<N; c++)
+			mean[c] += block.texels[i][c];
+		count++;
+	}
+	if (!count)
+		return;
+	for (uint32_t c=0u; c<N; c++)
+		mean[c] /= float(count);
+
+	float cov[N][N] = {};
+	for (uint32_t i=0u; i<16u; i++)
+	if (mask&(0x1u<<i))
+	{
+		float d[N];
+		for (uint32_t c=0u; c<N; c++)
+			d[c] = block.texels[i][c]-mean[c];
+		for (uint32_t r=0u; r<N; r++)
+		for (uint32_t c=r; c<N; c++)
+			cov[r][c] += d[r]*d[c];
+	}
+	for (uint32_t r=0u; r<N; r++)
+	for (uint32_t c=0u; c<r; c++)
+		cov[r][c] = cov[c][r];
+
+	// start from the row with most variance, it can't be orthogonal to the principal axis unless the block is degenerate
+	uint32_t start = 0u;
+	for (uint32_t c=1u; c<N; c++)
+	if (cov[c][c]>cov[start][start])
+		start = c;
+	float v[N];
+	std::copy_n(cov[start],N,v);
+	for (uint32_t iter=0u; iter<8u; iter++)
+	{
+		float next[N] = {};
+		float maxAbs = 0.f;
+		for (uint32_t r=0u; r<N; r++)
+		{
+			for (uint32_t c=0u; c<N; c++)
+				next[r] += cov[r][c]*v[c];
+			maxAbs = core::max(maxAbs,std::abs(next[r]));
+		}
+		if (maxAbs<=FLT_MIN)
+			break;
+		for (uint32_t c=0u; c<N; c++)
+			v[c] = next[c]/maxAbs;
+	}
+	float lenSq = 0.f;
+	for (uint32_t c=0u; c<N; c++)
+		lenSq += v[c]*v[c];
+	if (lenSq<=FLT_MIN)
+		return;
+	const float rcpLen = 1.f/std::sqrt(lenSq);
+	for (uint32_t c=0u; c<N; c++)
+		axis[c] = v[c]*rcpLen;
+}
+
+//! Ends of the segment through `mean` along `axis` which covers the projections of all texels in `mask`
+template<uint32_t N>
+void axisEndpoints(const SBlock& block, const uint32_t mask, const float mean[4], const float axis[4], float lo[4], float hi[4])
+{
+	float tMin = FLT_MAX, tMax = -FLT_MAX;
+	for (uint32_t i=0u; i<16u; i++)
+	if (mask&(0x1u<<i))
+	{
+		float t = 0.f;
+		for (uint32_t c=0u; c<N; c++)
+			t += (block.texels[i][c]-mean[c])*axis[c];
+		tMin = core::min(tMin,t);
+		tMax = core::max(tMax,t);
+	}
+	if (tMin>tMax)
+		tMin = tMax = 0.f;
+	for (uint32_t c=0u; c<N; c++)
+	{
+		lo[c] = mean[c]+axis[c]*tMin;
+		hi[c] = mean[c]+axis[c]*tMax;
+	}
+}
+
+//! Least squares fit of two endpoints given each texel's weight of the second endpoint, returns false if the system is singular
+template<uint32_t N>
+bool refineEndpoints(const SBlock& block, const uint32_t mask, const float weights[16], float e0[4], float e1[4])
+{
+	float aa = 0.f, ab = 0.f, bb = 0.f;
+	float ax[N] = {}, bx[N] = {};
+	for (uint32_t i=0u; i<16u; i++)
+	if (mask&(0x1u<<i))
+	{
+		const float b = weights[i];
+		const float a = 1.f-b;
+		aa += a*a;
+		ab += a*b;
+		bb += b*b;
+		for (uint32_t c=0u; c<N; c++)
+		{
+			ax[c] += a*block.texels[i][c];
+			bx[c] += b*block.texels[i][c];
+		}
+	}
+	const float det = aa*bb-ab*ab;
+	if (std::abs(det)<=1e-6f)
+		return false;
+	const float rcpDet = 1.f/det;
+	for (uint32_t c=0u; c<N; c++)
+	{
+		e0[c] = (bb*ax[c]-ab*bx[c])*rcpDet;
+		e1[c] = (aa*bx[c]-ab*ax[c])*rcpDet;
+	}
+	return true;
+}
+
+/*
+	BC1 colour block, shared by BC2 and BC3
+*/
+inline uint16_t quantize565(const float c[4])
+{
+	const uint32_t r = static_cast<uint32_t>(core::clamp(c[0]*(31.f/255.f)+0.5f,0.f,31.f));
+	const uint32_t g = static_cast<uint32_t>(core::clamp(c[1]*(63.f/255.f)+0.5f,0.f,63.f));
+	const uint32_t b = static_cast<uint32_t>(core::clamp(c[2]*(31.f/255.f)+0.5f,0.f,31.f));
+	return (r<<11u)|(g<<5u)|b;
+}
+inline __m128 expand565(const uint16_t c)
+{
+	const uint32_t r = c>>11u, g = (c>>5u)&0x3fu, b = c&0x1fu;
+	return _mm_setr_ps(float((r<<3u)|(r>>2u)),float((g<<2u)|(g>>4u)),float((b<<3u)|(b>>2u)),0.f);
+}
+
+struct SColorResult
+{
+	uint16_t c0, c1;
+	uint32_t indices;
+	float error;
+};
+
+// decoded palette for a pair of endpoints, index 3 of the 3 colour mode is transparent black and never picked for opaque texels
+inline uint32_t colorPalette(const uint16_t c0, const uint16_t c1, const bool threeColor, __m128 palette[4], float weights[4])
+{
+	palette[0] = expand565(c0);
+	palette[1] = expand565(c1);
+	weights[0] = 0.f;
+	weights[1] = 1.f;
+	if (threeColor)
+	{
+		palette[2] = _mm_mul_ps(_mm_add_ps(palette[0],palette[1]),_mm_set1_ps(0.5f));
+		weights[2] = 0.5f;
+		return 3u;
+	}
+	const __m128 third = _mm_set1_ps(1.f/3.f);
+	palette[2] = _mm_mul_ps(_mm_add_ps(_mm_add_ps(palette[0],palette[0]),palette[1]),third);
+	palette[3] = _mm_mul_ps(_mm_add_ps(_mm_add_ps(palette[1],palette[1]),palette[0]),third);
+	weights[2] = 1.f/3.f;
+	weights[3] = 2.f/3.f;
+	return 4u;
+}
+
+SColorResult fitColorIndices(const SBlock& block, const uint32_t opaqueMask, uint16_t c0, uint16_t c1, const bool threeColor, float texelWeights[16])
+{
+	// 4 colour mode needs c0>c1, 3 colour mode c0<=c1
+	if (threeColor ? (c0>c1):(c0<c1))
+		std::swap(c0,c1);
+	const bool flat = !threeColor && c0==c1;
+
+	__m128 palette[4];
+	float weights[4];
+	const uint32_t paletteSize = flat ? 1u:colorPalette(c0,c1,threeColor,palette,weights);
+	if (flat)
+	{
+		palette[0] = expand565(c0);
+		weights[0] = 0.f;
+	}
+
+	SColorResult result = {c0,c1,0u,0.f};
+	for (uint32_t i=0u; i<16u; i++)
+	{
+		if (!(opaqueMask&(0x1u<<i)))
+		{
+			result.indices |= 0x3u<<(i*2u);
+			texelWeights[i] = 0.f;
+			continue;
+		}
+		const __m128 texel = _mm_load_ps(block.texels[i]);
+		uint32_t best = 0u;
+		float bestError = FLT_MAX;
+		for (uint32_t p=0u; p<paletteSize; p++)
+		{
+			const __m128 d = _mm_mul_ps(_mm_sub_ps(texel,palette[p]),_mm_setr_ps(1.f,1.f,1.f,0.f));
+			const float error = dot4(d,d);
+			if (error<bestError)
+			{
+				bestError = error;
+				best = p;
+			}
+		}
+		result.indices |= best<<(i*2u);
+		result.error += bestError;
+		texelWeights[i] = weights[best];
+	}
+	return result;
+}
+
+uint64_t encodeColorBlock(const SBlock& block, const uint32_t opaqueMask, const bool threeColor, const preset_t preset)
+{
+	float lo[4], hi[4];
+	if (preset==CBlockCompressionImageFilterBase::EP_FAST)
+	{
+		// bounding box inset by a 16th of its size, the classic real-time DXT1 trick
+		std::fill_n(lo,4u,255.f);
+		std::fill_n(hi,4u,0.f);
+		for (uint32_t i=0u; i<16u; i++)
+		if (opaqueMask&(0x1u<<i))
+		for (uint32_t c=0u; c<3u; c++)
+		{
+			lo[c] = core::min(lo[c],block.texels[i][c]);
+			hi[c] = core::max(hi[c],block.texels[i][c]);
+		}
+		for (uint32_t c=0u; c<3u; c++)
+		{
+			const float inset = (hi[c]-lo[c])/16.f;
+			lo[c] += inset;
+			hi[c] -= inset;
+		}
+	}
+	else
+	{
+		float mean[4], axis[4];
+		principalAxis<3u>(block,opaqueMask,mean,axis);
+		axisEndpoints<3u>(block,opaqueMask,mean,axis,lo,hi);
+	}
+
+	float texelWeights[16];
+	SColorResult best = fitColorIndices(block,opaqueMask,quantize565(hi),quantize565(lo),threeColor,texelWeights);
+	const uint32_t refinements = preset==CBlockCompressionImageFilterBase::EP_FAST ? 0u:(preset==CBlockCompressionImageFilterBase::EP_BALANCED ? 1u:4u);
+	for (uint32_t r=0u; r<refinements && best.error>0.f; r++)
+	{
+		float e0[4], e1[4];
+		if (!refineEndpoints<3u>(block,opaqueMask,texelWeights,e0,e1))
+			break;
+		float nextWeights[16];
+		const SColorResult candidate = fitColorIndices(block,opaqueMask,quantize565(e0),quantize565(e1),threeColor,nextWeights);
+		if (candidate.error>=best.error)
+			break;
+		best = candidate;
+		std::copy_n(nextWeights,16u,texelWeights);
+	}
+	return uint64_t(best.c0)|(uint64_t(best.c1)<<16u)|(uint64_t(best.indices)<<32u);
+}
+
+/*
+	BC4 style single channel block, used by BC3 alpha, BC4 and BC5
+*/
+template<bool Signed>
+struct SChannelResult
+{
+	float error;
+	uint64_t bits;
+};
+
+template<bool Signed>
+SChannelResult<Signed> fitChannelIndices(const float values[16], float a0, float a1, const bool sixValue, float texelWeights[16])
+{
+	constexpr float MinValue = Signed ? -127.f:0.f;
+	constexpr float MaxValue = Signed ? 127.f:255.f;
+	const int32_t q0 = static_cast<int32_t>(std::round(core::clamp(a0,MinValue,MaxValue)));
+	const int32_t q1 = static_cast<int32_t>(std::round(core::clamp(a1,MinValue,MaxValue)));
+	// 8 value mode needs a0>a1, 6 value mode a0<=a1
+	int32_t e0 = q0, e1 = q1;
+	if (sixValue ? (e0>e1):(e0<e1))
+		std::swap(e0,e1);
+
+	float palette[8], weights[8];
+	palette[0] = float(e0);
+	palette[1] = float(e1);
+	weights[0] = 0.f;
+	weights[1] = 1.f;
+	uint32_t paletteSize;
+	if (e0>e1 || (!sixValue && e0==e1))
+	{
+		for (uint32_t i=2u; i<8u; i++)
+		{
+			weights[i] = float(i-1u)/7.f;
+			palette[i] = (float(8u-i)*e0+float(i-1u)*e1)/7.f;
+		}
+		paletteSize = e0==e1 ? 1u:8u;
+	}
+	else
+	{
+		for (uint32_t i=2u; i<6u; i++)
+		{
+			weights[i] = float(i-1u)/5.f;
+			palette[i] = (float(6u-i)*e0+float(i-1u)*e1)/5.f;
+		}
+		// the explicit extremes don't depend on the endpoints, they shouldn't pull on them either
+		palette[6] = MinValue;
+		palette[7] = MaxValue;
+		weights[6] = weights[7] = -1.f;
+		paletteSize = 8u;
+	}
+
+	SChannelResult<Signed> result = {0.f,uint64_t(uint8_t(e0))|(uint64_t(uint8_t(e1))<<8u)};
+	for (uint32_t i=0u; i<16u; i++)
+	{
+		uint32_t best = 0u;
+		float bestError = FLT_MAX;
+		for (uint32_t p=0u; p<paletteSize; p++)
+		{
+			const float d = values[i]-palette[p];
+			if (d*d<bestError)
+			{
+				bestError = d*d;
+				best = p;
+			}
+		}
+		result.error += bestError;
+		result.bits |= uint64_t(best)<<(16u+i*3u);
+		texelWeights[i] = weights[best];
+	}
+	return result;
+}
+
+template<bool Signed>
+uint64_t encodeChannelBlock(const float values[16], const preset_t preset)
+{
+	constexpr float MinValue = Signed ? -127.f:0.f;
+	constexpr float MaxValue = Signed ? 127.f:255.f;
+	float lo = FLT_MAX, hi = -FLT_MAX;
+	for (uint32_t i=0u; i<16u; i++)
+	{
+		lo = core::min(lo,values[i]);
+		hi = core::max(hi,values[i]);
+	}
+
+	auto refine = [&values](SChannelResult<Signed> best, float texelWeights[16], const bool sixValue, const uint32_t rounds) -> SChannelResult<Signed>
+	{
+		for (uint32_t r=0u; r<rounds && best.error>0.f; r++)
+		{
+			float aa = 0.f, ab = 0.f, bb = 0.f, ax = 0.f, bx = 0.f;
+			for (uint32_t i=0u; i<16u; i++)
+			if (texelWeights[i]>=0.f)
+			{
+				const float b = texelWeights[i];
+				const float a = 1.f-b;
+				aa += a*a;
+				ab += a*b;
+				bb += b*b;
+				ax += a*values[i];
+				bx += b*values[i];
+			}
+			const float det = aa*bb-ab*ab;
+			if (std::abs(det)<=1e-6f)
+				break;
+			float nextWeights[16];
+			const auto candidate = fitChannelIndices<Signed>(values,(bb*ax-ab*bx)/det,(aa*bx-ab*ax)/det,sixValue,nextWeights);
+			if (candidate.error>=best.error)
+				break;
+			best = candidate;
+			std::copy_n(nextWeights,16u,texelWeights);
+		}
+		return best;
+	};
+
+	const uint32_t refinements = preset==CBlockCompressionImageFilterBase::EP_FAST ? 0u:(preset==CBlockCompressionImageFilterBase::EP_BALANCED ? 1u:4u);
+	float texelWeights[16];
+	auto best = refine(fitChannelIndices<Signed>(values,hi,lo,false,texelWeights),texelWeights,false,refinements);
+	// blocks touching the ends of the range can spend the whole 6 value palette on the rest
+	if (preset==CBlockCompressionImageFilterBase::EP_BEST && (lo<=MinValue || hi>=MaxValue) && best.error>0.f)
+	{
+		float innerLo = FLT_MAX, innerHi = -FLT_MAX;
+		for (uint32_t i=0u; i<16u; i++)
+		if (values[i]>MinValue && values[i]<MaxValue)
+		{
+			innerLo = core::min(innerLo,values[i]);
+			innerHi = core::max(innerHi,values[i]);
+		}
+		if (innerLo>innerHi)
+			innerLo = innerHi = MinValue;
+		const auto candidate = refine(fitChannelIndices<Signed>(values,innerLo,innerHi,true,texelWeights),texelWeights,true,refinements);
+		if (candidate.error<best.error)
+			best = candidate;
+	}
+	return best.bits;
+}
+
+/*
+	BC7, always mode 6: one subset, 7777 RGBA endpoints with a p-bit each and 4 bit indices.
+	It is the mode with the most index and endpoint precision, which makes it the best single mode for most content.
+*/
+constexpr uint32_t BC7Weights4[16] = {0u,4u,9u,13u,17u,21u,26u,30u,34u,38u,43u,47u,51u,55u,60u,64u};
+
+struct SBC7Endpoints
+{
+	uint32_t q[2][4]; // 7 bit
+	uint32_t p[2];
+};
+
+inline uint32_t quantizeBC7(const float value, const uint32_t pbit)
+{
+	return static_cast<uint32_t>(core::clamp(std::round((value-float(pbit))*0.5f),0.f,127.f));
+}
+
+inline __m128 dequantizeBC7(const SBC7Endpoints& endpoints, const uint32_t e)
+{
+	auto channel = [&](const uint32_t c) -> float {return float((endpoints.q[e][c]<<1u)|endpoints.p[e]);};
+	return _mm_setr_ps(channel(0u),channel(1u),channel(2u),channel(3u));
+}
+
+inline SBC7Endpoints quantizeBC7Endpoints(const float e0[4], const float e1[4], const int32_t forcedPbits)
+{
+	SBC7Endpoints retval;
+	const float* ends[2] = {e0,e1};
+	for (uint32_t e=0u; e<2u; e++)
+	{
+		uint32_t bestP = 0u;
+		if (forcedPbits>=0)
+			bestP = (forcedPbits>>e)&0x1u;
+		else
+		{
+			float bestError = FLT_MAX;
+			for (uint32_t p=0u; p<2u; p++)
+			{
+				float error = 0.f;
+				for (uint32_t c=0u; c<4u; c++)
+				{
+					const float d = float((quantizeBC7(ends[e][c],p)<<1u)|p)-ends[e][c];
+					error += d*d;
+				}
+				if (error<bestError)
+				{
+					bestError = error;
+					bestP = p;
+				}
+			}
+		}
+		retval.p[e] = bestP;
+		for (uint32_t c=0u; c<4u; c++)
+			retval.q[e][c] = quantizeBC7(ends[e][c],bestP);
+	}
+	return retval;
+}
+
+float fitBC7Indices(const SBlock& block, const SBC7Endpoints& endpoints, uint8_t indices[16], float texelWeights[16])
+{
+	const __m128 end0 = dequantizeBC7(endpoints,0u);
+	const __m128 end1 = dequantizeBC7(endpoints,1u);
+	__m128 palette[16];
+	for (uint32_t i=0u; i<16u; i++)
+	{
+		const __m128 w = _mm_set1_ps(float(BC7Weights4[i]));
+		// ((64-w)*e0+w*e1+32)>>6 is exact in floats, the floor is the shift
+		palette[i] = _mm_floor_ps(_mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_set1_ps(64.f),w),end0),_mm_mul_ps(w,end1)),_mm_set1_ps(32.f)),_mm_set1_ps(1.f/64.f)));
+	}
+	float total = 0.f;
+	for (uint32_t i=0u; i<16u; i++)
+	{
+		const __m128 texel = _mm_load_ps(block.texels[i]);
+		uint32_t best = 0u;
+		float bestError = FLT_MAX;
+		for (uint32_t p=0u; p<16u; p++)
+		{
+			const __m128 d = _mm_sub_ps(texel,palette[p]);
+			const float error = dot4(d,d);
+			if (error<bestError)
+			{
+				bestError = error;
+				best = p;
+			}
+		}
+		indices[i] = best;
+		texelWeights[i] = float(BC7Weights4[best])/64.f;
+		total += bestError;
+	}
+	return total;
+}
+
+void encodeBC7(const SBlock& block, void* out, const preset_t preset)
+{
+	constexpr uint32_t AllTexels = 0xffffu;
+	float mean[4], axis[4], lo[4], hi[4];
+	principalAxis<4u>(block,AllTexels,mean,axis);
+	axisEndpoints<4u>(block,AllTexels,mean,axis,lo,hi);
+
+	struct SCandidate
+	{
+		SBC7Endpoints endpoints;
+		uint8_t indices[16];
+		float texelWeights[16];
+		float error = FLT_MAX;
+	} best;
+	auto tryEndpoints = [&](const float e0[4], const float e1[4], const int32_t forcedPbits) -> bool
+	{
+		SCandidate candidate;
+		candidate.endpoints = quantizeBC7Endpoints(e0,e1,forcedPbits);
+		candidate.error = fitBC7Indices(block,candidate.endpoints,candidate.indices,candidate.texelWeights);
+		if (candidate.error>=best.error)
+			return false;
+		best = candidate;
+		return true;
+	};
+
+	const uint32_t refinements = preset==CBlockCompressionImageFilterBase::EP_FAST ? 0u:(preset==CBlockCompressionImageFilterBase::EP_BALANCED ? 1u:4u);
+	if (preset==CBlockCompressionImageFilterBase::EP_BEST)
+	{
+		for (int32_t pbits=0; pbits<4; pbits++)
+			tryEndpoints(lo,hi,pbits);
+	}
+	else
+		tryEndpoints(lo,hi,-1);
+	for (uint32_t r=0u; r<refinements && best.error>0.f; r++)
+	{
+		float e0[4], e1[4];
+		if (!refineEndpoints<4u>(block,AllTexels,best.texelWeights,e0,e1))
+			break;
+		if (!tryEndpoints(e0,e1,-1))
+			break;
+	}
+
+	// the top index bit of the first texel is implied zero
+	if (best.indices[0]&0x8u)
+	{
+		std::swap(best.endpoints.q[0],best.endpoints.q[1]);
+		std::swap(best.endpoints.p[0],best.endpoints.p[1]);
+		for (auto& index : best.indices)
+			index = 15u-index;
+	}
+
+	SBitWriter writer;
+	writer.write(0x1u<<6u,7u);
+	for (uint32_t c=0u; c<4u; c++)
+	for (uint32_t e=0u; e<2u; e++)
+		writer.write(best.endpoints.q[e][c],7u);
+	writer.write(best.endpoints.p[0],1u);
+	writer.write(best.endpoints.p[1],1u);
+	writer.write(best.indices[0],3u);
+	for (uint32_t i=1u; i<16u; i++)
+		writer.write(best.indices[i],4u);
+	assert(writer.pos==128u);
+	memcpy(out,writer.data,16u);
+}
+
+/*
+	BC6H unsigned, always mode 11: one region with plain 10 bit endpoints and 4 bit indices.
+	The block is worked on in the interpolation space of the decoder (F16 bits times 64/31), which is close enough to logarithmic for the error to be sensible.
+*/
+inline uint32_t unquantizeBC6H(const uint32_t q)
+{
+	if (q==0u)
+		return 0u;
+	if (q==1023u)
+		return 0xffffu;
+	return ((q<<16u)+0x8000u)>>10u;
+}
+inline uint32_t quantizeBC6H(const float value)
+{
+	const int32_t guess = static_cast<int32_t>((value-32.f)/64.f);
+	uint32_t best = 0u;
+	float bestError = FLT_MAX;
+	for (int32_t q=guess-1; q<=guess+1; q++)
+	{
+		const uint32_t candidate = core::clamp(q,0,1023);
+		const float error = std::abs(float(unquantizeBC6H(candidate))-value);
+		if (error<bestError)
+		{
+			bestError = error;
+			best = candidate;
+		}
+	}
+	return best;
+}
+
+void encodeBC6H(const SBlock& block, void* out, const preset_t preset)
+{
+	constexpr uint32_t AllTexels = 0xffffu;
+	float mean[4], axis[4], lo[4], hi[4];
+	principalAxis<3u>(block,AllTexels,mean,axis);
+	axisEndpoints<3u>(block,AllTexels,mean,axis,lo,hi);
+
+	struct SCandidate
+	{
+		uint32_t q[2][3];
+		uint8_t indices[16];
+		float texelWeights[16];
+		float error = FLT_MAX;
+	} best;
+	auto tryEndpoints = [&](const float e0[4], const float e1[4]) -> bool
+	{
+		SCandidate candidate;
+		int32_t end0[3], end1[3];
+		for (uint32_t c=0u; c<3u; c++)
+		{
+			candidate.q[0][c] = quantizeBC6H(e0[c]);
+			candidate.q[1][c] = quantizeBC6H(e1[c]);
+			end0[c] = unquantizeBC6H(candidate.q[0][c]);
+			end1[c] = unquantizeBC6H(candidate.q[1][c]);
+		}
+		// decoded palette, compared against the input in the same stretched space
+		__m128 palette[16];
+		for (uint32_t i=0u; i<16u; i++)
+		{
+			const int32_t w = BC7Weights4[i];
+			float channels[4] = {0.f,0.f,0.f,0.f};
+			for (uint32_t c=0u; c<3u; c++)
+				channels[c] = float(((((64-w)*end0[c]+w*end1[c]+32)>>6)*31)>>6)*(64.f/31.f);
+			palette[i] = _mm_loadu_ps(channels);
+		}
+		candidate.error = 0.f;
+		for (uint32_t i=0u; i<16u; i++)
+		{
+			const __m128 texel = _mm_load_ps(block.texels[i]);
+			uint32_t bestIx = 0u;
+			float bestError = FLT_MAX;
+			for (uint32_t p=0u; p<16u; p++)
+			{
+				const __m128 d = _mm_sub_ps(texel,palette[p]);
+				const float error = dot4(d,d);
+				if (error<bestError)
+				{
+					bestError = error;
+					bestIx = p;
+				}
+			}
+			candidate.indices[i] = bestIx;
+			candidate.texelWeights[i] = float(BC7Weights4[bestIx])/64.f;
+			candidate.error += bestError;
+		}
+		if (candidate.error>=best.error)
+			return false;
+		best = candidate;
+		return true;
+	};
+
+	tryEndpoints(lo,hi);
+	const uint32_t refinements = preset==CBlockCompressionImageFilterBase::EP_FAST ? 0u:(preset==CBlockCompressionImageFilterBase::EP_BALANCED ? 1u:4u);
+	for (uint32_t r=0u; r<refinements && best.error>0.f; r++)
+	{
+		float e0[4], e1[4];
+		if (!refineEndpoints<3u>(block,AllTexels,best.texelWeights,e0,e1))
+			break;
+		if (!tryEndpoints(e0,e1))
+			break;
+	}
+
+	if (best.indices[0]&0x8u)
+	{
+		std::swap(best.q[0],best.q[1]);
+		for (auto& index : best.indices)
+			index = 15u-index;
+	}
+
+	SBitWriter writer;
+	writer.write(0x03u,5u);
+	for (uint32_t e=0u; e<2u; e++)
+	for (uint32_t c=0u; c<3u; c++)
+		writer.write(best.q[e][c],10u);
+	writer.write(best.indices[0],3u);
+	for (uint32_t i=1u; i<16u; i++)
+		writer.write(best.indices[i],4u);
+	assert(writer.pos==128u);
+	memcpy(out,writer.data,16u);
+}
+}
+
+bool CBlockCompressionImageFilterBase::isSupportedFormat(const E_FORMAT format)
+{
+	switch (format)
+	{
+		case EF_BC1_RGB_UNORM_BLOCK:
+		case EF_BC1_RGB_SRGB_BLOCK:
+		case EF_BC1_RGBA_UNORM_BLOCK:
+		case EF_BC1_RGBA_SRGB_BLOCK:
+		case EF_BC2_UNORM_BLOCK:
+		case EF_BC2_SRGB_BLOCK:
+		case EF_BC3_UNORM_BLOCK:
+		case EF_BC3_SRGB_BLOCK:
+		case EF_BC4_UNORM_BLOCK:
+		case EF_BC4_SNORM_BLOCK:
+		case EF_BC5_UNORM_BLOCK:
+		case EF_BC5_SNORM_BLOCK:
+		case EF_BC6H_UFLOAT_BLOCK:
+		case EF_BC7_UNORM_BLOCK:
+		case EF_BC7_SRGB_BLOCK:
+			return true;
+		default:
+			break;
+	}
+	return false;
+}
+
+void CBlockCompressionImageFilterBase::encodeBlock(const E_FORMAT format, const double texels[16][4], void* out, const E_PRESET preset)
+{
+	assert(isSupportedFormat(format));
+
+	SBlock block;
+	if (format==EF_BC6H_UFLOAT_BLOCK)
+	{
+		for (uint32_t i=0u; i<16u; i++)
+		{
+			for (uint32_t c=0u; c<3u; c++)
+			{
+				// negatives and NaNs become 0, anything past the largest finite half gets clamped to it
+				const double value = texels[i][c]>0.0 ? texels[i][c]:0.0;
+				const uint32_t bits = core::min<uint32_t>(core::Float16Compressor::compress(static_cast<float>(value)),0x7bffu);
+				block.texels[i][c] = float(bits)*(64.f/31.f);
+			}
+			block.texels[i][3] = 0.f;
+		}
+		encodeBC6H(block,out,preset);
+		return;
+	}
+
+	const bool snorm = format==EF_BC4_SNORM_BLOCK || format==EF_BC5_SNORM_BLOCK;
+	const bool srgb = isSRGBFormat(format);
+	for (uint32_t i=0u; i<16u; i++)
+	for (uint32_t c=0u; c<4u; c++)
+	{
+		double value = texels[i][c];
+		if (snorm)
+			value = core::clamp(value,-1.0,1.0)*127.0;
+		else
+		{
+			// written as a negated comparison so NaN ends up at 0
+			value = !(value>0.0) ? 0.0:core::min(value,1.0);
+			if (srgb && c<3u)
+				value = core::lin2srgb(value);
+			value *= 255.0;
+		}
+		block.texels[i][c] = static_cast<float>(value);
+	}
+
+	uint64_t* const out64 = reinterpret_cast<uint64_t*>(out);
+	switch (format)
+	{
+		case EF_BC1_RGB_UNORM_BLOCK:
+		case EF_BC1_RGB_SRGB_BLOCK:
+			out64[0] = encodeColorBlock(block,0xffffu,false,preset);
+			break;
+		case EF_BC1_RGBA_UNORM_BLOCK:
+		case EF_BC1_RGBA_SRGB_BLOCK:
+		{
+			uint32_t opaqueMask = 0u;
+			for (uint32_t i=0u; i<16u; i++)
+			if (block.texels[i][3]>=127.5f)
+				opaqueMask |= 0x1u<<i;
+			out64[0] = encodeColorBlock(block,opaqueMask,opaqueMask!=0xffffu,preset);
+			break;
+		}
+		case EF_BC2_UNORM_BLOCK:
+		case EF_BC2_SRGB_BLOCK:
+		{
+			uint64_t alpha = 0ull;
+			for (uint32_t i=0u; i<16u; i++)
+				alpha |= uint64_t(std::round(block.texels[i][3]*(15.f/255.f)))<<(i*4u);
+			out64[0] = alpha;
+			out64[1] = encodeColorBlock(block,0xffffu,false,preset);
+			break;
+		}
+		case EF_BC3_UNORM_BLOCK:
+		case EF_BC3_SRGB_BLOCK:
+		{
+			float alpha[16];
+			for (uint32_t i=0u; i<16u; i++)
+				alpha[i] = block.texels[i][3];
+			out64[0] = encodeChannelBlock<false>(alpha,preset);
+			out64[1] = encodeColorBlock(block,0xffffu,false,preset);
+			break;
+		}
+		case EF_BC4_UNORM_BLOCK:
+		case EF_BC4_SNORM_BLOCK:
+		case EF_BC5_UNORM_BLOCK:
+		case EF_BC5_SNORM_BLOCK:
+		{
+			const uint32_t channels = format==EF_BC5_UNORM_BLOCK || format==EF_BC5_SNORM_BLOCK ? 2u:1u;
+			for (uint32_t c=0u; c<channels; c++)
+			{
+				float values[16];
+				for (uint32_t i=0u; i<16u; i++)
+					values[i] = block.texels[i][c];
+				out64[c] = snorm ? encodeChannelBlock<true>(values,preset):encodeChannelBlock<false>(values,preset);
+			}
+			break;
+		}
+		case EF_BC7_UNORM_BLOCK:
+		case EF_BC7_SRGB_BLOCK:
+			encodeBC7(block,out,preset);
+			break;
+		default:
+			assert(false);
+			break;
+	}
+}
@@ -156,22 +156,44 @@ using namespace nbl::asset;
 				return {};
 
 			core::vector<core::smart_refctd_ptr<ICPUBuffer>> cpuBuffers;
-			for (auto& glTFBuffer : glTF.buffers)
 			{
 				// FarFuture TODO: handle buffer embedded in glTF
-				auto buffer_bundle = interm_getAssetInHierarchy(assetManager,glTFBuffer.uri.value(),context.loadContext.params,_hierarchyLevel+ICPUMesh::BUFFER_HIERARCHYLEVELS_BELOW,_override);
-				if (buffer_bundle.getContents().empty())
-					return {};
+				core::vector<std::string> bufferURIs;
+				bufferURIs.reserve(glTF.buffers.size());
+				for (auto& glTFBuffer : glTF.buffers)
+					bufferURIs.push_back(glTFBuffer.uri.value());
+				// all buffers load in parallel
+				const auto bufferBundles = interm_getAssetsInHierarchy(assetManager,bufferURIs,context.loadContext.params,_hierarchyLevel+ICPUMesh::BUFFER_HIERARCHYLEVELS_BELOW,_override);
+				for (const auto& buffer_bundle : bufferBundles)
+				{
+					if (buffer_bundle.getContents().empty())
+						return {};
 
-				auto cpuBuffer = core::smart_refctd_ptr_static_cast<ICPUBuffer>(buffer_bundle.getContents().begin()[0]);
-				cpuBuffers.emplace_back() = core::smart_refctd_ptr<ICPUBuffer>(cpuBuffer);
+					auto cpuBuffer = core::smart_refctd_ptr_static_cast<ICPUBuffer>(buffer_bundle.getContents().begin()[0]);
+					cpuBuffers.emplace_back() = core::smart_refctd_ptr<ICPUBuffer>(cpuBuffer);
+				}
 			}
 
 			const auto imageViewHierarchyLevel = _hierarchyLevel+ICPUMesh::IMAGEVIEW_HIERARCHYLEVELS_BELOW;
 			core::vector<core::smart_refctd_ptr<ICPUImageView>> cpuImageViews;
 			{
+				// load every image which isn't cached yet in parallel up-front
+				core::vector<std::string> missingImageURIs;
+				core::vector<uint32_t> imageBundleIx(glTF.images.size(),~0u);
+				for (uint32_t i=0u; i<glTF.images.size(); i++)
+				{
+					const auto& uri = glTF.images[i].uri;
+					if (uri.has_value() && !_override->findDefaultAsset<ICPUImageView>(getImageViewCacheKey(uri.value()),context.loadContext,imageViewHierarchyLevel).first)
+					{
+						imageBundleIx[i] = missingImageURIs.size();
+						missingImageURIs.push_back(uri.value());
+					}
+				}
+				const auto imageBundles = interm_getAssetsInHierarchy(assetManager,missingImageURIs,context.loadContext.params,imageViewHierarchyLevel,_override);
+
 				for (auto& glTFImage : glTF.images)
 				{
+					const uint32_t imageIx = cpuImageViews.size();
 					auto& cpuImageView = cpuImageViews.emplace_back();
 
 					// FarFuture TODO: handle image embedded in glTF 
@@ -184,7 +206,7 @@ using namespace nbl::asset;
 						cpuImageView = _override->findDefaultAsset<ICPUImageView>(cpuImageViewCacheKey,context.loadContext,imageViewHierarchyLevel).first;
 						if (!cpuImageView)
 						{
-							auto image_bundle = interm_getAssetInHierarchy(assetManager,glTFImage.uri.value(),context.loadContext.params,imageViewHierarchyLevel,_override);
+							auto image_bundle = imageBundleIx[imageIx]!=~0u ? imageBundles[imageBundleIx[imageIx]]:interm_getAssetInHierarchy(assetManager,glTFImage.uri.value(),context.loadContext.params,imageViewHierarchyLevel,_override);
 							if (image_bundle.getContents().empty())
 								return {};
 
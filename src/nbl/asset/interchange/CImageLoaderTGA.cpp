@@ -9,7 +9,7 @@
 
 #include "nbl/system/IFile.h"
 
-#include "nbl/asset/format/convertColor.h"
+#include "nbl/asset/format/convertPixelRow.h"
 #include "nbl/asset/ICPUImage.h"
 
 #include "nbl/asset/interchange/IImageAssetHandlerBase.h"
@@ -27,17 +27,10 @@ namespace asset
 	template<E_FORMAT inputFormat, E_FORMAT outputFormat>
 	static inline core::smart_refctd_ptr<ICPUBuffer> createSingleRowBufferFromRawData(core::smart_refctd_ptr<asset::ICPUBuffer> inputBuffer)
 	{
-		auto inputTexelOrBlockByteSize = inputBuffer->getSize();
-		const uint32_t texelOrBlockLength = inputTexelOrBlockByteSize / asset::getTexelOrBlockBytesize(inputFormat);
+		const uint32_t texelOrBlockLength = inputBuffer->getSize() / asset::getTexelOrBlockBytesize(inputFormat);
 
 		auto outputBuffer = core::make_smart_refctd_ptr<asset::ICPUBuffer>(texelOrBlockLength * asset::getTexelOrBlockBytesize(outputFormat));
-		auto outputTexelOrBlockByteSize = outputBuffer->getSize();
-
-		for (auto i = 0ull; i < texelOrBlockLength; ++i)
-		{
-			const void* srcPix[] = { reinterpret_cast<const uint8_t*>(inputBuffer->getPointer()) + i * inputTexelOrBlockByteSize, nullptr, nullptr, nullptr };
-			asset::convertColor<inputFormat, outputFormat>(srcPix, reinterpret_cast<uint8_t*>(outputBuffer->getPointer()) + i * outputTexelOrBlockByteSize, 0, 0);
-		}
+		asset::convertPixelRow(inputFormat, outputFormat, inputBuffer->getPointer(), outputBuffer->getPointer(), texelOrBlockLength);
 
 		return outputBuffer;
 	}
@@ -19,6 +19,7 @@
 #include "COBJMeshFileLoader.h"
 
 #include <filesystem>
+#include <charconv>
 
 namespace nbl
 {
@@ -31,6 +32,42 @@ namespace asset
 
 static const uint32_t WORD_BUFFER_LENGTH = 512;
 
+//! Deduplication key for the vertices, compares bitwise so that the NaN UVs of vertices without texcoords still match
+struct SObjVertexKey
+{
+	inline bool operator==(const SObjVertexKey& other) const
+	{
+		return memcmp(this,&other,sizeof(SObjVertexKey))==0;
+	}
+
+	SObjVertex vertex;
+	uint32_t smoothingGroup;
+};
+static_assert(sizeof(SObjVertexKey)==sizeof(SObjVertex)+sizeof(uint32_t));
+struct SObjVertexKeyHash
+{
+	inline size_t operator()(const SObjVertexKey& key) const
+	{
+		uint32_t words[sizeof(SObjVertexKey)/sizeof(uint32_t)];
+		memcpy(words,&key,sizeof(SObjVertexKey));
+		uint64_t h = 0xcbf29ce484222325ull;
+		for (const auto word : words)
+			h = (h^word)*0x100000001b3ull;
+		return static_cast<size_t>(h^(h>>32u));
+	}
+};
+
+//! Parses a float without any locale or null-termination requirements, returns `begin` if nothing could be parsed
+static inline const char* parseFloat(const char* begin, const char* const end, float& out)
+{
+	// `from_chars` does not accept an explicit plus sign but `sscanf` used to
+	const char* numBegin = begin!=end && *begin=='+' ? (begin+1):begin;
+	const auto result = std::from_chars(numBegin,end,out);
+	if (result.ec!=std::errc())
+		return begin;
+	return result.ptr;
+}
+
 constexpr uint32_t POSITION = 0u;
 constexpr uint32_t UV = 2u;
 constexpr uint32_t NORMAL = 3u;
@@ -100,15 +137,18 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(system::IFile* _file, const as
 	};
     core::unordered_multiset<pipeline_meta_pair_t,hash_t,key_equal_t> pipelines;
 
-	// TODO: map the file whenever possible
-    std::string fileContents;
-    fileContents.resize(filesize);
-	char* const buf = fileContents.data();
-
-	system::IFile::success_t success;
-	_file->read(success, buf, 0, filesize);
-	if (!success)
-		return {};
+	// parse straight from the mapping whenever possible, only copy when we have to
+	core::vector<char> fileContents;
+	const char* buf = reinterpret_cast<const char*>(static_cast<const system::IFile*>(_file)->getMappedPointer());
+	if (!buf)
+	{
+		fileContents.resize(filesize);
+		system::IFile::success_t success;
+		_file->read(success, fileContents.data(), 0, filesize);
+		if (!success)
+			return {};
+		buf = fileContents.data();
+	}
 
 	const char* const bufEnd = buf+filesize;
 	// Process obj information
@@ -132,12 +172,17 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(system::IFile* _file, const as
     };
     core::vector<vec3> vertexBuffer;
     core::vector<vec3> normalsBuffer;
+    // filled in batches, whenever a face references a normal which isn't quantized yet
+    core::vector<CQuantNormalCache::value_type_t<EF_A2B10G10R10_SNORM_PACK32>> quantizedNormals;
     core::vector<vec2> textureCoordBuffer;
 
     core::vector<core::smart_refctd_ptr<ICPUMeshBuffer>> submeshes;
     core::vector<core::vector<uint32_t>> indices;
     core::vector<SObjVertex> vertices;
-    core::map<SObjVertex, uint32_t> map_vtx2ix;
+    // open addressing, keyed on the smoothing group too so vertices get deduplicated within each group
+    core::unordered_map<SObjVertexKey,uint32_t,SObjVertexKeyHash> map_vtx2ix;
+    core::vector<uint32_t> faceCorners;
+    faceCorners.reserve(32ull);
     core::vector<bool> recalcNormals;
     core::vector<bool> submeshWasLoadedFromCache;
     core::vector<std::string> submeshCacheKeys;
@@ -276,30 +321,36 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(system::IFile* _file, const as
 				submeshMaterialNames.push_back(NO_MATERIAL_MTL_NAME);
 			}
 
-			SObjVertex v;
-
-			// get all vertices data in this face (current line of obj _file)
-			const std::string wordBuffer = copyLine(bufPtr, bufEnd);
-			const char* linePtr = wordBuffer.c_str();
-			const char* const endPtr = linePtr + wordBuffer.size();
+			SObjVertexKey key;
+			key.smoothingGroup = smoothingGroup;
+			SObjVertex& v = key.vertex;
 
-			core::vector<uint32_t> faceCorners;
-			faceCorners.reserve(32ull);
+			// get all vertices data in this face (current line of obj _file), parsed in place
+			const char* const endPtr = goLineEnd(bufPtr, bufEnd);
+			faceCorners.clear();
 
 			// read in all vertices
-			linePtr = goNextWord(linePtr, endPtr);
-			while (0 != linePtr[0])
+			const char* linePtr = goNextWord(bufPtr, endPtr, false);
+			while (linePtr != endPtr)
 			{
+				const char* wordEnd = linePtr;
+				while (wordEnd != endPtr && !core::isspace(*wordEnd))
+					++wordEnd;
+
 				// Array to communicate with retrieveVertexIndices()
 				// sends the buffer sizes and gets the actual indices
 				// if index not set returns -1
 				int32_t Idx[3];
-				Idx[1] = Idx[2] = -1;
-
-				// read in next vertex's data
-				uint32_t wlength = copyWord(tmpbuf, linePtr, WORD_BUFFER_LENGTH, endPtr);
 				// this function will also convert obj's 1-based index to c++'s 0-based index
-				retrieveVertexIndices(tmpbuf, Idx, tmpbuf+wlength+1, vertexBuffer.size(), textureCoordBuffer.size(), normalsBuffer.size());
+				const bool validCorner = retrieveVertexIndices(linePtr, wordEnd, Idx, vertexBuffer.size(), textureCoordBuffer.size(), normalsBuffer.size());
+				// go to next vertex
+				linePtr = goFirstWord(wordEnd, endPtr, false);
+				if (!validCorner)
+				{
+					_params.logger.log("Invalid face corner in OBJ file %s, skipping.", system::ILogger::ELL_WARNING, _file->getFileName().string().c_str());
+					continue;
+				}
+
 				v.pos[0] = vertexBuffer[Idx[0]].data[0];
 				v.pos[1] = vertexBuffer[Idx[0]].data[1];
 				v.pos[2] = vertexBuffer[Idx[0]].data[2];
@@ -317,10 +368,17 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(system::IFile* _file, const as
                 //set normal
 				if ( -1 != Idx[2] )
                 {
-					core::vectorSIMDf simdNormal;
-					simdNormal.set(normalsBuffer[Idx[2]].data);
-                    simdNormal.makeSafe3D();
-					v.normal32bit = quantNormalCache->quantize<EF_A2B10G10R10_SNORM_PACK32>(simdNormal);
+					if (static_cast<size_t>(Idx[2])>=quantizedNormals.size())
+					{
+						const size_t first = quantizedNormals.size();
+						core::vector<core::vectorSIMDf> unquantized;
+						unquantized.reserve(normalsBuffer.size()-first);
+						for (size_t i=first; i<normalsBuffer.size(); i++)
+							unquantized.emplace_back(normalsBuffer[i].data[0],normalsBuffer[i].data[1],normalsBuffer[i].data[2],0.f);
+						quantizedNormals.resize(normalsBuffer.size());
+						quantNormalCache->quantize<EF_A2B10G10R10_SNORM_PACK32>(unquantized.data(),quantizedNormals.data()+first,unquantized.size());
+					}
+					v.normal32bit = quantizedNormals[Idx[2]];
                 }
 				else
 				{
@@ -328,26 +386,19 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(system::IFile* _file, const as
                     recalcNormals.back() = true;
 				}
 
-				uint32_t ix;
-				auto vtx_ix = map_vtx2ix.find(v);
-				if (vtx_ix != map_vtx2ix.end() && smoothingGroup==vtxSmoothGrp[vtx_ix->second])
-					ix = vtx_ix->second;
-				else
+				const auto inserted = map_vtx2ix.try_emplace(key,static_cast<uint32_t>(vertices.size()));
+				if (inserted.second)
 				{
-					ix = vertices.size();
 					vertices.push_back(v);
                     vtxSmoothGrp.push_back(smoothingGroup);
-					map_vtx2ix.insert({v, ix});
 				}
 
-				faceCorners.push_back(ix);
-
-				// go to next vertex
-				linePtr = goNextWord(linePtr, endPtr);
+				faceCorners.push_back(inserted.first->second);
 			}
+			bufPtr = endPtr;
 
             // triangulate the face
-            for (uint32_t i = 1u; i < faceCorners.size()-1u; ++i)
+            for (uint32_t i = 1u; i+1u < faceCorners.size(); ++i)
             {
                 // Add a triangle
                 performActionBasedOnOrientationSystem
@@ -531,15 +582,13 @@ asset::SAssetBundle COBJMeshFileLoader::loadAsset(system::IFile* _file, const as
 //! Read 3d vector of floats
 const char* COBJMeshFileLoader::readVec3(const char* bufPtr, float vec[3], const char* const bufEnd)
 {
-	const uint32_t WORD_BUFFER_LENGTH = 256;
-	char wordBuffer[WORD_BUFFER_LENGTH];
-
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",vec);
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",vec+1);
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",vec+2);
+	for (uint32_t i=0u; i<3u; i++)
+	{
+		bufPtr = goNextWord(bufPtr, bufEnd, false);
+		// missing components stay 0 like they did with `sscanf`
+		vec[i] = 0.f;
+		parseFloat(bufPtr, bufEnd, vec[i]);
+	}
 
     vec[0] = -vec[0]; // change handedness
 	return bufPtr;
@@ -549,13 +598,12 @@ const char* COBJMeshFileLoader::readVec3(const char* bufPtr, float vec[3], const
 //! Read 2d vector of floats
 const char* COBJMeshFileLoader::readUV(const char* bufPtr, float vec[2], const char* const bufEnd)
 {
-	const uint32_t WORD_BUFFER_LENGTH = 256;
-	char wordBuffer[WORD_BUFFER_LENGTH];
-
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",vec);
-	bufPtr = goAndCopyNextWord(wordBuffer, bufPtr, WORD_BUFFER_LENGTH, bufEnd);
-	sscanf(wordBuffer,"%f",vec+1);
+	for (uint32_t i=0u; i<2u; i++)
+	{
+		bufPtr = goNextWord(bufPtr, bufEnd, false);
+		vec[i] = 0.f;
+		parseFloat(bufPtr, bufEnd, vec[i]);
+	}
 
 	vec[1] = 1.f-vec[1]; // change handedness
 	return bufPtr;
@@ -624,10 +672,11 @@ uint32_t COBJMeshFileLoader::copyWord(char* outBuf, const char* const inBuf, uin
 		return 0;
 	}
 
+	// check the end first, the buffer might be a mapping without a null terminator
 	uint32_t i = 0;
-	while(inBuf[i])
+	while(&(inBuf[i]) != bufEnd && inBuf[i])
 	{
-		if (core::isspace(inBuf[i]) || &(inBuf[i]) == bufEnd)
+		if (core::isspace(inBuf[i]))
 			break;
 		++i;
 	}
@@ -641,20 +690,11 @@ uint32_t COBJMeshFileLoader::copyWord(char* outBuf, const char* const inBuf, uin
 }
 
 
-std::string COBJMeshFileLoader::copyLine(const char* inBuf, const char* bufEnd)
+const char* COBJMeshFileLoader::goLineEnd(const char* buf, const char* const bufEnd)
 {
-	if (!inBuf)
-		return std::string();
-
-	const char* ptr = inBuf;
-	while (ptr<bufEnd)
-	{
-		if (*ptr=='\n' || *ptr=='\r')
-			break;
-		++ptr;
-	}
-	// we must avoid the +1 in case the array is used up
-	return std::string(inBuf, (uint32_t)(ptr-inBuf+((ptr < bufEnd) ? 1 : 0)));
+	while (buf != bufEnd && *buf != '\n' && *buf != '\r')
+		++buf;
+	return buf;
 }
 
 
@@ -666,72 +706,41 @@ const char* COBJMeshFileLoader::goAndCopyNextWord(char* outBuf, const char* inBu
 }
 
 
-bool COBJMeshFileLoader::retrieveVertexIndices(char* vertexData, int32_t* idx, const char* bufEnd, uint32_t vbsize, uint32_t vtsize, uint32_t vnsize)
+bool COBJMeshFileLoader::retrieveVertexIndices(const char* wordBegin, const char* const wordEnd, int32_t* idx, uint32_t vbsize, uint32_t vtsize, uint32_t vnsize)
 {
-	char word[16] = "";
-	const char* p = goFirstWord(vertexData, bufEnd);
-	uint32_t idxType = 0;	// 0 = posIdx, 1 = texcoordIdx, 2 = normalIdx
+	const uint32_t sizes[3] = {vbsize,vtsize,vnsize};
 
-	uint32_t i = 0;
-	while ( p != bufEnd )
+	const char* p = wordBegin;
+	for (uint32_t idxType=0u; idxType<3u; idxType++) // 0 = posIdx, 1 = texcoordIdx, 2 = normalIdx
 	{
-		if ( ( core::isdigit(*p)) || (*p == '-') )
+		idx[idxType] = -1;
+		if (p == wordEnd)
+			continue;
+
+		// an empty slot like the texcoord in `v//vn` stays disabled
+		if (*p != '/')
 		{
-			// build up the number
-			word[i++] = *p;
+			int32_t value = 0;
+			const auto result = std::from_chars(p, wordEnd, value);
+			if (result.ec != std::errc() || value == 0)
+				return false;
+			p = result.ptr;
+			// negative indices are relative to the end of the lists read so far
+			const int64_t absolute = value<0 ? (int64_t(sizes[idxType])+value):(int64_t(value)-1);
+			if (absolute<0 || absolute>=int64_t(sizes[idxType]))
+				return false;
+			idx[idxType] = static_cast<int32_t>(absolute);
 		}
-		else if ( *p == '/' || *p == ' ' || *p == '\0' )
+		// skip the separator
+		if (p != wordEnd)
 		{
-			// number is completed. Convert and store it
-			word[i] = '\0';
-			// if no number was found index will become 0 and later on -1 by decrement
-			sscanf(word,"%d",idx+idxType);
-			if (idx[idxType]<0)
-			{
-				switch (idxType)
-				{
-					case 0:
-						idx[idxType] += vbsize;
-						break;
-					case 1:
-						idx[idxType] += vtsize;
-						break;
-					case 2:
-						idx[idxType] += vnsize;
-						break;
-				}
-			}
-			else
-				idx[idxType]-=1;
-
-			// reset the word
-			word[0] = '\0';
-			i = 0;
-
-			// go to the next kind of index type
-			if (*p == '/')
-			{
-				if ( ++idxType > 2 )
-				{
-					// error checking, shouldn't reach here unless file is wrong
-					idxType = 0;
-				}
-			}
-			else
-			{
-				// set all missing values to disable (=-1)
-				while (++idxType < 3)
-					idx[idxType]=-1;
-				++p;
-				break; // while
-			}
+			if (*p != '/')
+				return false;
+			++p;
 		}
-
-		// go to the next char
-		++p;
 	}
 
-	return true;
+	return idx[0] != -1;
 }
 
 std::string COBJMeshFileLoader::genKeyForMeshBuf(const SContext& _ctx, const std::string& _baseKey, const std::string& _mtlName, const std::string& _grpName) const
@@ -102,10 +102,10 @@ private:
 	const char* goNextWord(const char* buf, const char* const bufEnd, bool acrossNewlines=true);
 	// returns a pointer to the next printable character after the first line break
 	const char* goNextLine(const char* buf, const char* const bufEnd);
+	// returns a pointer to the first line break (or the end of buffer)
+	const char* goLineEnd(const char* buf, const char* const bufEnd);
 	// copies the current word from the inBuf to the outBuf
 	uint32_t copyWord(char* outBuf, const char* inBuf, uint32_t outBufLength, const char* const pBufEnd);
-	// copies the current line from the inBuf to the outBuf
-	std::string copyLine(const char* inBuf, const char* const bufEnd);
 
 	// combination of goNextWord followed by copyWord
 	const char* goAndCopyNextWord(char* outBuf, const char* inBuf, uint32_t outBufLength, const char* const pBufEnd);
@@ -117,10 +117,11 @@ private:
 	//! Read boolean value represented as 'on' or 'off'
 	const char* readBool(const char* bufPtr, bool& tf, const char* const bufEnd);
 
-	// reads and convert to integer the vertex indices in a line of obj file's face statement
+	// reads and convert to integer the vertex indices of one corner `[wordBegin,wordEnd)` in a line of obj file's face statement
 	// -1 for the index if it doesn't exist
 	// indices are changed to 0-based index instead of 1-based from the obj file
-	bool retrieveVertexIndices(char* vertexData, int32_t* idx, const char* bufEnd, uint32_t vbsize, uint32_t vtsize, uint32_t vnsize);
+	// returns false if the position index is missing or any index is out of range
+	bool retrieveVertexIndices(const char* wordBegin, const char* const wordEnd, int32_t* idx, uint32_t vbsize, uint32_t vtsize, uint32_t vnsize);
 
     std::string genKeyForMeshBuf(const SContext& _ctx, const std::string& _baseKey, const std::string& _mtlName, const std::string& _grpName) const;
 
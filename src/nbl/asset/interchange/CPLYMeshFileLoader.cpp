@@ -8,7 +8,9 @@
 #ifdef _NBL_COMPILE_WITH_PLY_LOADER_
 
 #include <numeric>
+#include <charconv>
 
+#include "nbl/core/execution.h"
 #include "nbl/asset/IAssetManager.h"
 #include "nbl/system/ISystem.h"
 #include "nbl/system/IFile.h"
@@ -19,6 +21,177 @@ namespace nbl
 namespace asset
 {
 
+// elements handled by a single task
+constexpr uint32_t ELEMENT_CHUNK_SIZE = 0x1u<<12u;
+// ASCII bodies get split into ranges of at least this many bytes at line boundaries
+constexpr size_t ASCII_RANGE_SIZE = 0x1ull<<20u;
+
+template<typename F>
+static void parallelForChunks(const uint32_t count, const uint32_t chunkSize, F&& f)
+{
+	core::vector<uint32_t> chunks((count+chunkSize-1u)/chunkSize);
+	std::iota(chunks.begin(),chunks.end(),0u);
+	std::for_each(core::execution::par_unseq,chunks.begin(),chunks.end(),[&f,count,chunkSize](const uint32_t chunk) -> void
+	{
+		const uint32_t begin = chunk*chunkSize;
+		f(begin,core::min(begin+chunkSize,count));
+	});
+}
+
+//! Reverses the bytes of every element of a tightly packed column, 16 bytes at a time
+template<typename T>
+static inline void byteswapColumn(T* column, const uint32_t count)
+{
+	if constexpr (sizeof(T)>1u)
+	{
+		__m128i mask;
+		if constexpr (sizeof(T)==2u)
+			mask = _mm_set_epi8(14,15,12,13,10,11,8,9,6,7,4,5,2,3,0,1);
+		else if constexpr (sizeof(T)==4u)
+			mask = _mm_set_epi8(12,13,14,15,8,9,10,11,4,5,6,7,0,1,2,3);
+		else
+			mask = _mm_set_epi8(8,9,10,11,12,13,14,15,0,1,2,3,4,5,6,7);
+
+		constexpr uint32_t PerRegister = 16u/sizeof(T);
+		uint32_t i = 0u;
+		for (; i+PerRegister<=count; i+=PerRegister)
+		{
+			auto* ptr = reinterpret_cast<__m128i*>(column+i);
+			_mm_storeu_si128(ptr,_mm_shuffle_epi8(_mm_loadu_si128(ptr),mask));
+		}
+		for (; i<count; i++)
+		{
+			auto* bytes = reinterpret_cast<uint8_t*>(column+i);
+			std::reverse(bytes,bytes+sizeof(T));
+		}
+	}
+}
+
+//! Gathers one property of `count` fixed stride elements into a column, swaps it if needed, then converts and scatters it
+template<typename T>
+static void unpackColumn(const uint8_t* src, const size_t srcStride, const uint32_t count, const bool swapEndian, const float scale, float* dst, const uint32_t dstStride)
+{
+	constexpr uint32_t BatchSize = 256u;
+	T column[BatchSize];
+	for (uint32_t batchBegin=0u; batchBegin<count; batchBegin+=BatchSize)
+	{
+		const uint32_t batch = core::min(BatchSize,count-batchBegin);
+		const uint8_t* batchSrc = src+srcStride*batchBegin;
+		for (uint32_t i=0u; i<batch; i++)
+			memcpy(column+i,batchSrc+srcStride*i,sizeof(T));
+		if (swapEndian)
+			byteswapColumn(column,batch);
+		float* batchDst = dst+size_t(dstStride)*batchBegin;
+		for (uint32_t i=0u; i<batch; i++)
+			batchDst[size_t(dstStride)*i] = static_cast<float>(column[i])*scale;
+	}
+}
+
+using unpack_column_t = void(*)(const uint8_t*,size_t,uint32_t,bool,float,float*,uint32_t);
+static unpack_column_t getColumnUnpacker(const E_PLY_PROPERTY_TYPE type, const bool isUnsigned)
+{
+	switch (type)
+	{
+		case EPLYPT_INT8:
+			return isUnsigned ? unpackColumn<uint8_t>:unpackColumn<int8_t>;
+		case EPLYPT_INT16:
+			return isUnsigned ? unpackColumn<uint16_t>:unpackColumn<int16_t>;
+		case EPLYPT_INT32:
+			return isUnsigned ? unpackColumn<uint32_t>:unpackColumn<int32_t>;
+		case EPLYPT_FLOAT32:
+			return unpackColumn<float>;
+		case EPLYPT_FLOAT64:
+			return unpackColumn<double>;
+		default:
+			return nullptr;
+	}
+}
+
+template<typename T>
+static inline double readBinaryScalar(const uint8_t*& ptr, const bool swapEndian)
+{
+	T value;
+	memcpy(&value,ptr,sizeof(T));
+	if (swapEndian)
+		byteswapColumn(&value,1u);
+	ptr += sizeof(T);
+	return static_cast<double>(value);
+}
+//! For elements which aren't fixed width, caller must make sure there's enough bytes left
+static double readBinaryScalar(const uint8_t*& ptr, const E_PLY_PROPERTY_TYPE type, const bool swapEndian, const bool isUnsigned)
+{
+	switch (type)
+	{
+		case EPLYPT_INT8:
+			return isUnsigned ? readBinaryScalar<uint8_t>(ptr,swapEndian):readBinaryScalar<int8_t>(ptr,swapEndian);
+		case EPLYPT_INT16:
+			return isUnsigned ? readBinaryScalar<uint16_t>(ptr,swapEndian):readBinaryScalar<int16_t>(ptr,swapEndian);
+		case EPLYPT_INT32:
+			return isUnsigned ? readBinaryScalar<uint32_t>(ptr,swapEndian):readBinaryScalar<int32_t>(ptr,swapEndian);
+		case EPLYPT_FLOAT32:
+			return readBinaryScalar<float>(ptr,swapEndian);
+		case EPLYPT_FLOAT64:
+			return readBinaryScalar<double>(ptr,swapEndian);
+		default:
+			return 0.0;
+	}
+}
+
+static inline bool isAsciiSpace(const char c)
+{
+	return c==' ' || c=='\t' || c=='\r';
+}
+//! Parses the next whitespace separated number of a line, malformed tokens are skipped and read as 0
+static inline const char* parseAsciiValue(const char* ptr, const char* lineEnd, double& value)
+{
+	while (ptr<lineEnd && isAsciiSpace(*ptr))
+		ptr++;
+	if (ptr<lineEnd && *ptr=='+')
+		ptr++;
+	const auto result = std::from_chars(ptr,lineEnd,value);
+	if (result.ec==std::errc())
+		return result.ptr;
+	value = 0.0;
+	while (ptr<lineEnd && !isAsciiSpace(*ptr))
+		ptr++;
+	return ptr;
+}
+
+static inline bool isVertexIndexList(const std::string& name)
+{
+	return name=="vertex_indices" || name=="vertex_index";
+}
+
+//! Fan triangulation with the winding the loader always used, returns how many indices a polygon produces
+static inline uint32_t triangulatedIndexCount(const uint32_t polygonSize)
+{
+	return polygonSize>=3u ? (polygonSize-2u)*3u:0u;
+}
+template<typename F>
+static inline void triangulatePolygon(const uint32_t polygonSize, F&& nextIndex, uint32_t* out)
+{
+	if (polygonSize<3u)
+	{
+		for (uint32_t j=0u; j<polygonSize; j++)
+			nextIndex();
+		return;
+	}
+	const uint32_t a = nextIndex();
+	uint32_t b = nextIndex();
+	uint32_t c = nextIndex();
+	*(out++) = a;
+	*(out++) = b;
+	*(out++) = c;
+	for (uint32_t j=3u; j<polygonSize; j++)
+	{
+		b = c;
+		c = nextIndex();
+		*(out++) = a;
+		*(out++) = c;
+		*(out++) = b;
+	}
+}
+
 CPLYMeshFileLoader::CPLYMeshFileLoader(IAssetManager* _am) 
 	: IRenderpassIndependentPipelineLoader(_am)
 {
@@ -354,9 +527,9 @@ asset::SAssetBundle CPLYMeshFileLoader::loadAsset(system::IFile* _file, const as
 			asset::SBufferBinding<asset::ICPUBuffer> attributes[4];
 			core::vector<uint32_t> indices;
 
-			bool hasNormals = true;
+			uint32_t vertexCount = 0u;
 
-			// loop through each of the elements
+			// allocate the attributes, the body gets decoded in one go after
 			for (uint32_t i=0; i<ctx.ElementList.size(); ++i)
 			{
 				// do we want this element type?
@@ -402,24 +575,39 @@ asset::SAssetBundle CPLYMeshFileLoader::loadAsset(system::IFile* _file, const as
 						}			
 					}
 
-					// loop through vertex properties
-					for (uint32_t j=0; j<ctx.ElementList[i]->Count; ++j)
-						hasNormals &= readVertex(ctx, plyVertexElement, attributes, j, _params);
+					if (!vertexCount)
+						vertexCount = plyVertexElement.Count;
 				}
-				else if (ctx.ElementList[i]->Name == "face")
-				{
-					const size_t indicesCount = ctx.ElementList[i]->Count;
+			}
 
-					// read faces
-					for (uint32_t j=0; j < indicesCount; ++j)
-						readFace(ctx, *ctx.ElementList[i], indices);
-				}
+			// the header went through the small line buffer, but the body gets decoded from memory in parallel
+			{
+				const size_t bodyOffset = ctx.fileOffset - size_t(ctx.EndPointer - (ctx.LineEndPointer + 1));
+				const size_t bodySize = _file->getSize() - core::min(bodyOffset, _file->getSize());
+
+				const system::IFileBase* constFile = _file;
+				const auto* body = reinterpret_cast<const uint8_t*>(constFile->getMappedPointer());
+				core::vector<uint8_t> bodyStorage;
+				if (body)
+					body += bodyOffset;
 				else
 				{
-					// skip these elements
-					for (uint32_t j=0; j < ctx.ElementList[i]->Count; ++j)
-						skipElement(ctx, *ctx.ElementList[i]);
+					bodyStorage.resize(bodySize);
+					system::IFile::success_t success;
+					_file->read(success, bodyStorage.data(), bodyOffset, bodySize);
+					if (!success)
+					{
+						_params.logger.log("Failed to read the body of PLY file %s", system::ILogger::ELL_ERROR, _file->getFileName().string().c_str());
+						return {};
+					}
+					body = bodyStorage.data();
 				}
+
+				const bool bodyRead = ctx.IsBinaryFile ?
+					readBinaryBody(ctx, body, body + bodySize, attributes, vertexCount, indices):
+					readAsciiBody(ctx, reinterpret_cast<const char*>(body), reinterpret_cast<const char*>(body) + bodySize, attributes, vertexCount, indices);
+				if (!bodyRead)
+					return {};
 			}
 
 			mb->setPositionAttributeIx(0);
@@ -461,245 +649,351 @@ asset::SAssetBundle CPLYMeshFileLoader::loadAsset(system::IFile* _file, const as
 	return SAssetBundle(std::move(meta),{ std::move(mesh) });
 }
 
-static void performActionBasedOnOrientationSystem(const asset::IAssetLoader::SAssetLoadParams& _params, std::function<void()> performOnRightHanded, std::function<void()> performOnLeftHanded)
+core::vector<CPLYMeshFileLoader::SVertexTarget> CPLYMeshFileLoader::compileVertexTargets(const SPLYElement& _element, const asset::SBufferBinding<asset::ICPUBuffer> _attributes[4], const uint32_t _vertexCount, const IAssetLoader::SAssetLoadParams& _params) const
 {
-	if (_params.loaderFlags & IAssetLoader::ELPF_RIGHT_HANDED_MESHES)
-		performOnRightHanded();
-	else
-		performOnLeftHanded();
-}
-  
-bool CPLYMeshFileLoader::readVertex(SContext& _ctx, const SPLYElement& Element, asset::SBufferBinding<asset::ICPUBuffer> outAttributes[4], const uint32_t& currentVertexIndex, const asset::IAssetLoader::SAssetLoadParams& _params)
-{
-	if (!_ctx.IsBinaryFile)
-		getNextLine(_ctx);
-
-	std::pair<bool, core::vectorSIMDf> attribs[4];
-	attribs[ET_COL].second.W = 1.f;
-	attribs[ET_NORM].second.Y = 1.f;
-
-	constexpr auto ET_POS_BYTESIZE = asset::getTexelOrBlockBytesize<EF_R32G32B32_SFLOAT>();
-	constexpr auto ET_NORM_BYTESIZE = asset::getTexelOrBlockBytesize<EF_R32G32B32_SFLOAT>();
-	constexpr auto ET_UV_BYTESIZE = asset::getTexelOrBlockBytesize<EF_R32G32_SFLOAT>();
-	constexpr auto ET_COL_BYTESIZE = asset::getTexelOrBlockBytesize<EF_R32G32B32A32_SFLOAT>();
+	const bool rightHanded = _params.loaderFlags & E_LOADER_PARAMETER_FLAGS::ELPF_RIGHT_HANDED_MESHES;
+
+	// indexed by E_TYPE
+	constexpr uint32_t componentCounts[4] = { 3u, 4u, 2u, 3u };
+	constexpr float defaults[4][4] = {
+		{ 0.f, 0.f, 0.f, 0.f },
+		{ 0.f, 0.f, 0.f, 1.f },
+		{ 0.f, 0.f, 0.f, 0.f },
+		{ 0.f, 1.f, 0.f, 0.f }
+	};
+	bool provided[4][4] = {};
 
-	bool result = false;
-	for (uint32_t i = 0; i < Element.Properties.size(); ++i)
+	core::vector<SVertexTarget> targets(_element.Properties.size());
+	for (size_t i = 0u; i < targets.size(); ++i)
 	{
-		E_PLY_PROPERTY_TYPE t = Element.Properties[i].Type;
-
-		if (Element.Properties[i].Name == "x")
-		{
-			auto& value = attribs[ET_POS].second.X = getFloat(_ctx, t);
-			attribs[ET_POS].first = true;
+		const auto& property = _element.Properties[i];
+		if (property.Type == EPLYPT_LIST)
+			continue;
 
-			if (_params.loaderFlags & E_LOADER_PARAMETER_FLAGS::ELPF_RIGHT_HANDED_MESHES)
-				performActionBasedOnOrientationSystem<float>(value, [](float& varToFlip) { varToFlip = -varToFlip; });
-
-			const size_t propertyOffset = ET_POS_BYTESIZE * currentVertexIndex;
-			uint8_t* data = reinterpret_cast<uint8_t*>(outAttributes[ET_POS].buffer->getPointer()) + propertyOffset;
-
-			reinterpret_cast<float*>(data)[0] = value;
-		}
-		else if (Element.Properties[i].Name == "y")
+		auto setTarget = [&](const E_TYPE type, const uint32_t component, const bool flip = false) -> void
 		{
-			auto& value = attribs[ET_POS].second.Y = getFloat(_ctx, t);
-			attribs[ET_POS].first = true;
-
-			const size_t propertyOffset = ET_POS_BYTESIZE * currentVertexIndex;
-			uint8_t* data = reinterpret_cast<uint8_t*>(outAttributes[ET_POS].buffer->getPointer()) + propertyOffset;
+			if (!_attributes[type].buffer)
+				return;
+			auto& target = targets[i];
+			target.data = reinterpret_cast<float*>(_attributes[type].buffer->getPointer()) + component;
+			target.componentCount = componentCounts[type];
+			if (flip && rightHanded)
+				target.scale = -1.f;
+			provided[type][component] = true;
+		};
 
-			reinterpret_cast<float*>(data)[1] = value;
-		}
-		else if (Element.Properties[i].Name == "z")
+		const auto& name = property.Name;
+		if (name == "x")
+			setTarget(ET_POS, 0u, true);
+		else if (name == "y")
+			setTarget(ET_POS, 1u);
+		else if (name == "z")
+			setTarget(ET_POS, 2u);
+		else if (name == "nx")
+			setTarget(ET_NORM, 0u, true);
+		else if (name == "ny")
+			setTarget(ET_NORM, 1u);
+		else if (name == "nz")
+			setTarget(ET_NORM, 2u);
+		// there isn't a single convention for the UV, some softwares like Blender or Assimp use "st" instead of "uv"
+		else if (name == "u" || name == "s")
+			setTarget(ET_UV, 0u);
+		else if (name == "v" || name == "t")
+			setTarget(ET_UV, 1u);
+		else if (name == "red" || name == "green" || name == "blue" || name == "alpha")
 		{
-			auto& value = attribs[ET_POS].second.Z = getFloat(_ctx, t);
-			attribs[ET_POS].first = true;
-
-			const size_t propertyOffset = ET_POS_BYTESIZE * currentVertexIndex;
-			uint8_t* data = reinterpret_cast<uint8_t*>(outAttributes[ET_POS].buffer->getPointer()) + propertyOffset;
-
-			reinterpret_cast<float*>(data)[2] = value;
+			setTarget(ET_COL, name == "red" ? 0u : name == "green" ? 1u : name == "blue" ? 2u : 3u);
+			if (!property.isFloat())
+			{
+				targets[i].scale = 1.f / 255.f;
+				targets[i].isUnsigned = true;
+			}
 		}
-		else if (Element.Properties[i].Name == "nx")
-		{
-			auto& value = attribs[ET_NORM].second.X = getFloat(_ctx, t);
-			attribs[ET_NORM].first = result = true;
-
-			if (_params.loaderFlags & E_LOADER_PARAMETER_FLAGS::ELPF_RIGHT_HANDED_MESHES)
-				performActionBasedOnOrientationSystem<float>(attribs[ET_NORM].second.X, [](float& varToFlip) { varToFlip = -varToFlip; });
-
-			const size_t propertyOffset = ET_NORM_BYTESIZE * currentVertexIndex;
-			uint8_t* data = reinterpret_cast<uint8_t*>(outAttributes[ET_NORM].buffer->getPointer()) + propertyOffset;
+	}
 
-			reinterpret_cast<float*>(data)[0] = value;
-		}
-		else if (Element.Properties[i].Name == "ny")
+	// components the file doesn't provide would be left uninitialized otherwise, this is mostly about a missing alpha
+	for (uint32_t type = 0u; type < 4u; ++type)
+	for (uint32_t component = 0u; component < componentCounts[type]; ++component)
+	if (_attributes[type].buffer && !provided[type][component])
+	{
+		float* const data = reinterpret_cast<float*>(_attributes[type].buffer->getPointer()) + component;
+		const uint32_t stride = componentCounts[type];
+		const float value = defaults[type][component];
+		parallelForChunks(_vertexCount, ELEMENT_CHUNK_SIZE, [&](const uint32_t begin, const uint32_t end) -> void
 		{
-			auto& value = attribs[ET_NORM].second.Y = getFloat(_ctx, t);
-			attribs[ET_NORM].first = result = true;
+			for (uint32_t i = begin; i < end; ++i)
+				data[size_t(stride) * i] = value;
+		});
+	}
 
-			const size_t propertyOffset = ET_NORM_BYTESIZE * currentVertexIndex;
-			uint8_t* data = reinterpret_cast<uint8_t*>(outAttributes[ET_NORM].buffer->getPointer()) + propertyOffset;
+	return targets;
+}
 
-			reinterpret_cast<float*>(data)[1] = value;
-		}
-		else if (Element.Properties[i].Name == "nz")
-		{
-			auto& value = attribs[ET_NORM].second.Z = getFloat(_ctx, t);
-			attribs[ET_NORM].first = result = true;
+bool CPLYMeshFileLoader::readBinaryBody(SContext& _ctx, const uint8_t* _body, const uint8_t* _bodyEnd, const asset::SBufferBinding<asset::ICPUBuffer> _attributes[4], const uint32_t _vertexCount, core::vector<uint32_t>& _outIndices) const
+{
+	const auto& params = _ctx.inner.params;
+	const bool swapEndian = _ctx.IsWrongEndian;
 
-			const size_t propertyOffset = ET_NORM_BYTESIZE * currentVertexIndex;
-			uint8_t* data = reinterpret_cast<uint8_t*>(outAttributes[ET_NORM].buffer->getPointer()) + propertyOffset;
+	const uint8_t* ptr = _body;
+	auto bytesLeft = [&]() -> size_t { return size_t(_bodyEnd - ptr); };
+	for (const auto& elementPtr : _ctx.ElementList)
+	{
+		const SPLYElement& element = *elementPtr;
+		const bool isVertex = element.Name == "vertex";
+		const bool isFace = element.Name == "face";
+		// only the first vertex element's count got allocated
+		const uint32_t vertexCount = isVertex ? core::min(element.Count, _vertexCount) : 0u;
 
-			reinterpret_cast<float*>(data)[2] = value;
-		}
-		// there isn't a single convention for the UV, some softwares like Blender or Assimp use "st" instead of "uv"
-		else if (Element.Properties[i].Name == "u" || Element.Properties[i].Name == "s")
+		if (element.IsFixedWidth)
 		{
-			auto& value = attribs[ET_UV].second.X = getFloat(_ctx, t);
-			attribs[ET_UV].first = true;
+			const size_t stride = element.KnownSize;
+			if (bytesLeft() < stride * element.Count)
+			{
+				params.logger.log("PLY element %s is truncated", system::ILogger::ELL_ERROR, element.Name.c_str());
+				return false;
+			}
 
-			const size_t propertyOffset = ET_UV_BYTESIZE * currentVertexIndex;
-			uint8_t* data = reinterpret_cast<uint8_t*>(outAttributes[ET_UV].buffer->getPointer()) + propertyOffset;
+			if (isVertex)
+			{
+				// the element's layout compiles down to one column unpacker per loaded property
+				struct SColumn
+				{
+					unpack_column_t unpack;
+					uint32_t offset;
+					SVertexTarget target;
+				};
+				core::vector<SColumn> columns;
+				{
+					const auto targets = compileVertexTargets(element, _attributes, _vertexCount, params);
+					uint32_t offset = 0u;
+					for (size_t i = 0u; i < targets.size(); ++i)
+					{
+						const auto& property = element.Properties[i];
+						if (targets[i].data)
+						if (auto unpack = getColumnUnpacker(property.Type, targets[i].isUnsigned))
+							columns.push_back({ unpack, offset, targets[i] });
+						offset += property.size();
+					}
+				}
 
-			reinterpret_cast<float*>(data)[0] = value;
+				parallelForChunks(vertexCount, ELEMENT_CHUNK_SIZE, [&](const uint32_t begin, const uint32_t end) -> void
+				{
+					const uint8_t* src = ptr + stride * begin;
+					for (const auto& column : columns)
+						column.unpack(src + column.offset, stride, end - begin, swapEndian, column.target.scale, column.target.data + size_t(column.target.componentCount) * begin, column.target.componentCount);
+				});
+			}
+			// a fixed width face element has no index list, so there's nothing to load from it
+			ptr += stride * element.Count;
+			continue;
 		}
-		else if (Element.Properties[i].Name == "v" || Element.Properties[i].Name == "t")
-		{
-			auto& value = attribs[ET_UV].second.Y = getFloat(_ctx, t);
-			attribs[ET_UV].first = true;
 
-			const size_t propertyOffset = ET_UV_BYTESIZE * currentVertexIndex;
-			uint8_t* data = reinterpret_cast<uint8_t*>(outAttributes[ET_UV].buffer->getPointer()) + propertyOffset;
-
-			reinterpret_cast<float*>(data)[1] = value;
-		}
-		else if (Element.Properties[i].Name == "red")
+		// variable width elements need a serial pass to find where every chunk starts, and how many indices the faces will produce
+		const uint32_t chunkCount = (element.Count + ELEMENT_CHUNK_SIZE - 1u) / ELEMENT_CHUNK_SIZE;
+		core::vector<const uint8_t*> chunkBegins(chunkCount);
+		core::vector<size_t> chunkIndexOffsets(chunkCount + 1u, 0ull);
+		size_t indexCount = 0ull;
+		for (uint32_t i = 0u; i < element.Count; ++i)
 		{
-			float value = Element.Properties[i].isFloat() ? getFloat(_ctx, t) : float(getInt(_ctx, t)) / 255.f;
-			attribs[ET_COL].second.X = value;
-			attribs[ET_COL].first = true;
-
-			const size_t propertyOffset = ET_COL_BYTESIZE * currentVertexIndex;
-			uint8_t* data = reinterpret_cast<uint8_t*>(outAttributes[ET_COL].buffer->getPointer()) + propertyOffset;
+			if (i % ELEMENT_CHUNK_SIZE == 0u)
+			{
+				chunkBegins[i / ELEMENT_CHUNK_SIZE] = ptr;
+				chunkIndexOffsets[i / ELEMENT_CHUNK_SIZE] = indexCount;
+			}
 
-			reinterpret_cast<float*>(data)[0] = value;
+			for (const auto& property : element.Properties)
+			{
+				size_t propertySize = property.size();
+				if (property.Type == EPLYPT_LIST)
+				{
+					if (bytesLeft() < SPLYProperty::typeSize(property.Data.List.CountType))
+						propertySize = ~0ull;
+					else
+					{
+						const auto listSize = static_cast<uint32_t>(readBinaryScalar(ptr, property.Data.List.CountType, swapEndian, true));
+						propertySize = size_t(listSize) * SPLYProperty::typeSize(property.Data.List.ItemType);
+						if (isFace && isVertexIndexList(property.Name))
+							indexCount += triangulatedIndexCount(listSize);
+					}
+				}
+				if (bytesLeft() < propertySize)
+				{
+					params.logger.log("PLY element %s is truncated", system::ILogger::ELL_ERROR, element.Name.c_str());
+					return false;
+				}
+				ptr += propertySize;
+			}
 		}
-		else if (Element.Properties[i].Name == "green")
-		{
-			float value = Element.Properties[i].isFloat() ? getFloat(_ctx, t) : float(getInt(_ctx, t)) / 255.f;
-			attribs[ET_COL].second.Y = value;
-			attribs[ET_COL].first = true;
+		chunkIndexOffsets[chunkCount] = indexCount;
 
-			const size_t propertyOffset = ET_COL_BYTESIZE * currentVertexIndex;
-			uint8_t* data = reinterpret_cast<uint8_t*>(outAttributes[ET_COL].buffer->getPointer()) + propertyOffset;
-
-			reinterpret_cast<float*>(data)[1] = value;
-		}
-		else if (Element.Properties[i].Name == "blue")
+		if (isFace)
 		{
-			float value = Element.Properties[i].isFloat() ? getFloat(_ctx, t) : float(getInt(_ctx, t)) / 255.f;
-			attribs[ET_COL].second.Z = value;
-			attribs[ET_COL].first = true;
+			const size_t firstIndex = _outIndices.size();
+			_outIndices.resize(firstIndex + indexCount);
+			uint32_t* const indices = _outIndices.data() + firstIndex;
 
-			const size_t propertyOffset = ET_COL_BYTESIZE * currentVertexIndex;
-			uint8_t* data = reinterpret_cast<uint8_t*>(outAttributes[ET_COL].buffer->getPointer()) + propertyOffset;
+			parallelForChunks(element.Count, ELEMENT_CHUNK_SIZE, [&](const uint32_t begin, const uint32_t end) -> void
+			{
+				const uint8_t* src = chunkBegins[begin / ELEMENT_CHUNK_SIZE];
+				uint32_t* out = indices + chunkIndexOffsets[begin / ELEMENT_CHUNK_SIZE];
+				for (uint32_t i = begin; i < end; ++i)
+				for (const auto& property : element.Properties)
+				{
+					if (property.Type != EPLYPT_LIST)
+					{
+						src += property.size();
+						continue;
+					}
 
-			reinterpret_cast<float*>(data)[2] = value;
+					const auto listSize = static_cast<uint32_t>(readBinaryScalar(src, property.Data.List.CountType, swapEndian, true));
+					if (isVertexIndexList(property.Name))
+					{
+						const auto itemType = property.Data.List.ItemType;
+						triangulatePolygon(listSize, [&]() -> uint32_t {return static_cast<uint32_t>(readBinaryScalar(src, itemType, swapEndian, true));}, out);
+						out += triangulatedIndexCount(listSize);
+					}
+					else
+						src += size_t(listSize) * SPLYProperty::typeSize(property.Data.List.ItemType);
+				}
+			});
 		}
-		else if (Element.Properties[i].Name == "alpha")
+		else if (isVertex)
 		{
-			float value = Element.Properties[i].isFloat() ? getFloat(_ctx, t) : float(getInt(_ctx, t)) / 255.f;
-			attribs[ET_COL].second.W = value;
-			attribs[ET_COL].first = true;
-
-			const size_t propertyOffset = ET_COL_BYTESIZE * currentVertexIndex;
-			uint8_t* data = reinterpret_cast<uint8_t*>(outAttributes[ET_COL].buffer->getPointer()) + propertyOffset;
-
-			reinterpret_cast<float*>(data)[3] = value;
+			const auto targets = compileVertexTargets(element, _attributes, _vertexCount, params);
+			parallelForChunks(vertexCount, ELEMENT_CHUNK_SIZE, [&](const uint32_t begin, const uint32_t end) -> void
+			{
+				const uint8_t* src = chunkBegins[begin / ELEMENT_CHUNK_SIZE];
+				for (uint32_t i = begin; i < end; ++i)
+				for (size_t j = 0u; j < targets.size(); ++j)
+				{
+					const auto& property = element.Properties[j];
+					const auto& target = targets[j];
+					if (property.Type == EPLYPT_LIST)
+					{
+						const auto listSize = static_cast<uint32_t>(readBinaryScalar(src, property.Data.List.CountType, swapEndian, true));
+						src += size_t(listSize) * SPLYProperty::typeSize(property.Data.List.ItemType);
+					}
+					else if (target.data)
+						target.data[size_t(target.componentCount) * i] = static_cast<float>(readBinaryScalar(src, property.Type, swapEndian, target.isUnsigned)) * target.scale;
+					else
+						src += property.size();
+				}
+			});
 		}
-		else
-			skipProperty(_ctx, Element.Properties[i]);
 	}
-
-	return result;
+	return true;
 }
 
-
-bool CPLYMeshFileLoader::readFace(SContext& _ctx, const SPLYElement& Element, core::vector<uint32_t>& _outIndices)
+bool CPLYMeshFileLoader::readAsciiBody(SContext& _ctx, const char* _body, const char* _bodyEnd, const asset::SBufferBinding<asset::ICPUBuffer> _attributes[4], const uint32_t _vertexCount, core::vector<uint32_t>& _outIndices) const
 {
-	if (!_ctx.IsBinaryFile)
-		getNextLine(_ctx);
+	const auto& params = _ctx.inner.params;
+
+	// every element is exactly one line, so the body can be split into ranges at any line boundary
+	const size_t bodySize = size_t(_bodyEnd - _body);
+	const uint32_t rangeCount = static_cast<uint32_t>(core::max<size_t>(bodySize / ASCII_RANGE_SIZE, 1ull));
+	core::vector<const char*> rangeBegins(rangeCount + 1u);
+	rangeBegins[0] = _body;
+	for (uint32_t i = 1u; i < rangeCount; ++i)
+	{
+		const char* nominal = core::max(_body + bodySize / rangeCount * i, rangeBegins[i - 1u]);
+		const auto* newline = reinterpret_cast<const char*>(memchr(nominal, '\n', size_t(_bodyEnd - nominal)));
+		rangeBegins[i] = newline ? (newline + 1) : _bodyEnd;
+	}
+	rangeBegins[rangeCount] = _bodyEnd;
 
-	for (uint32_t i = 0; i < Element.Properties.size(); ++i)
+	// find out which line every range starts at
+	core::vector<uint64_t> rangeFirstLines(rangeCount + 1u, 0ull);
+	parallelForChunks(rangeCount, 1u, [&](const uint32_t range, const uint32_t) -> void
 	{
-		if ((Element.Properties[i].Name == "vertex_indices" ||
-			Element.Properties[i].Name == "vertex_index") && Element.Properties[i].Type == EPLYPT_LIST)
-		{
-			int32_t count = getInt(_ctx, Element.Properties[i].Data.List.CountType);
-			//_NBL_DEBUG_BREAK_IF(count != 3)
+		const char* begin = rangeBegins[range];
+		const char* end = rangeBegins[range + 1u];
+		uint64_t lineCount = std::count(begin, end, '\n');
+		// last line might not be terminated
+		if (end == _bodyEnd && end != begin && end[-1] != '\n')
+			lineCount++;
+		rangeFirstLines[range + 1u] = lineCount;
+	});
+	std::partial_sum(rangeFirstLines.begin(), rangeFirstLines.end(), rangeFirstLines.begin());
+
+	const size_t elementCount = _ctx.ElementList.size();
+	core::vector<uint64_t> elementEndLines(elementCount);
+	core::vector<core::vector<SVertexTarget>> vertexTargets(elementCount);
+	for (size_t i = 0u; i < elementCount; ++i)
+	{
+		const auto& element = *_ctx.ElementList[i];
+		elementEndLines[i] = (i ? elementEndLines[i - 1u] : 0ull) + element.Count;
+		if (element.Name == "vertex")
+			vertexTargets[i] = compileVertexTargets(element, _attributes, _vertexCount, params);
+	}
+	if (elementCount && rangeFirstLines.back() < elementEndLines.back())
+	{
+		params.logger.log("PLY body has fewer lines than declared elements", system::ILogger::ELL_ERROR);
+		return false;
+	}
 
-			uint32_t a = getInt(_ctx, Element.Properties[i].Data.List.ItemType),
-				b = getInt(_ctx, Element.Properties[i].Data.List.ItemType),
-				c = getInt(_ctx, Element.Properties[i].Data.List.ItemType);
-			int32_t j = 3;
+	// faces of every range get triangulated separately and concatenated in order afterwards
+	core::vector<core::vector<uint32_t>> rangeIndices(rangeCount);
+	parallelForChunks(rangeCount, 1u, [&](const uint32_t range, const uint32_t) -> void
+	{
+		const char* const rangeEnd = rangeBegins[range + 1u];
+		uint64_t line = rangeFirstLines[range];
+		size_t elementIx = std::upper_bound(elementEndLines.begin(), elementEndLines.end(), line) - elementEndLines.begin();
+		auto& indices = rangeIndices[range];
+		for (const char* ptr = rangeBegins[range]; ptr < rangeEnd; ++line)
+		{
+			const auto* newline = reinterpret_cast<const char*>(memchr(ptr, '\n', size_t(rangeEnd - ptr)));
+			const char* lineEnd = newline ? newline : rangeEnd;
 
-			_outIndices.push_back(a);
-			_outIndices.push_back(b);
-			_outIndices.push_back(c);
+			while (elementIx < elementCount && line >= elementEndLines[elementIx])
+				elementIx++;
+			if (elementIx >= elementCount)
+				break;
 
-			for (; j < count; ++j)
+			const auto& element = *_ctx.ElementList[elementIx];
+			const uint64_t ix = line - (elementIx ? elementEndLines[elementIx - 1u] : 0ull);
+			const bool isVertex = element.Name == "vertex";
+			if ((isVertex && ix < _vertexCount) || element.Name == "face")
 			{
-				b = c;
-				c = getInt(_ctx, Element.Properties[i].Data.List.ItemType);
-				_outIndices.push_back(a);
-				_outIndices.push_back(c);
-				_outIndices.push_back(b);
+				const char* word = ptr;
+				for (size_t j = 0u; j < element.Properties.size(); ++j)
+				{
+					const auto& property = element.Properties[j];
+					double value;
+					word = parseAsciiValue(word, lineEnd, value);
+					if (property.Type == EPLYPT_LIST)
+					{
+						// every list item needs at least one character and a separator
+						const auto listSize = static_cast<uint32_t>(core::min<double>(core::max(value, 0.0), double(lineEnd - word + 1) / 2.0));
+						if (!isVertex && isVertexIndexList(property.Name))
+						{
+							const size_t firstIndex = indices.size();
+							indices.resize(firstIndex + triangulatedIndexCount(listSize));
+							triangulatePolygon(listSize, [&]() -> uint32_t {word = parseAsciiValue(word, lineEnd, value); return static_cast<uint32_t>(value);}, indices.data() + firstIndex);
+						}
+						else
+						for (uint32_t k = 0u; k < listSize; ++k)
+							word = parseAsciiValue(word, lineEnd, value);
+					}
+					else if (isVertex)
+					{
+						const auto& target = vertexTargets[elementIx][j];
+						if (target.data)
+							target.data[size_t(target.componentCount) * ix] = static_cast<float>(value) * target.scale;
+					}
+				}
 			}
+			ptr = lineEnd + 1;
 		}
-		else if (Element.Properties[i].Name == "intensity")
-		{
-			// todo: face intensity
-			skipProperty(_ctx, Element.Properties[i]);
-		}
-		else
-			skipProperty(_ctx, Element.Properties[i]);
-	}
-	return true;
-}
+	});
 
+	size_t indexCount = _outIndices.size();
+	for (const auto& indices : rangeIndices)
+		indexCount += indices.size();
+	_outIndices.reserve(indexCount);
+	for (const auto& indices : rangeIndices)
+		_outIndices.insert(_outIndices.end(), indices.begin(), indices.end());
 
-// skips an element and all properties. return false on EOF
-void CPLYMeshFileLoader::skipElement(SContext& _ctx, const SPLYElement& Element)
-{
-	if (_ctx.IsBinaryFile)
-		if (Element.IsFixedWidth)
-			moveForward(_ctx, Element.KnownSize);
-		else
-			for (uint32_t i = 0; i < Element.Properties.size(); ++i)
-				skipProperty(_ctx, Element.Properties[i]);
-	else
-		getNextLine(_ctx);
-}
-
-
-void CPLYMeshFileLoader::skipProperty(SContext& _ctx, const SPLYProperty &Property)
-{
-	if (Property.Type == EPLYPT_LIST)
-	{
-		int32_t count = getInt(_ctx, Property.Data.List.CountType);
-
-		for (int32_t i=0; i < count; ++i)
-			getInt(_ctx, Property.Data.List.CountType);
-	}
-	else
-	{
-		if (_ctx.IsBinaryFile)
-			moveForward(_ctx, Property.size());
-		else
-			getNextWord(_ctx);
-	}
+	return true;
 }
 
 
@@ -775,17 +1069,6 @@ void CPLYMeshFileLoader::fillBuffer(SContext& _ctx)
 }
 
 
-// skips x bytes in the file, getting more data if required
-void CPLYMeshFileLoader::moveForward(SContext& _ctx, uint32_t bytes)
-{
-	if (_ctx.StartPointer + bytes >= _ctx.EndPointer)
-		fillBuffer(_ctx);
-	if (_ctx.StartPointer + bytes < _ctx.EndPointer)
-		_ctx.StartPointer += bytes;
-	else
-		_ctx.StartPointer = _ctx.EndPointer;
-}
-
 bool CPLYMeshFileLoader::genVertBuffersForMBuffer(
 	asset::ICPUMeshBuffer* _mbuf,
 	const asset::SBufferBinding<asset::ICPUBuffer> attributes[4],
@@ -998,167 +1281,6 @@ char* CPLYMeshFileLoader::getNextWord(SContext& _ctx)
 }
 
 
-// read the next float from the file and move the start pointer along
-float CPLYMeshFileLoader::getFloat(SContext& _ctx, E_PLY_PROPERTY_TYPE t)
-{
-	float retVal = 0.0f;
-
-	if (_ctx.IsBinaryFile)
-	{
-		if (_ctx.EndPointer - _ctx.StartPointer < 8)
-			fillBuffer(_ctx);
-
-		if (_ctx.EndPointer - _ctx.StartPointer > 0)
-		{
-			switch (t)
-			{
-			case EPLYPT_INT8:
-				retVal = *_ctx.StartPointer;
-				_ctx.StartPointer++;
-				break;
-			case EPLYPT_INT16:
-				if (_ctx.IsWrongEndian)
-					retVal = core::Byteswap::byteswap(*(reinterpret_cast<int16_t*>(_ctx.StartPointer)));
-				else
-					retVal = *(reinterpret_cast<int16_t*>(_ctx.StartPointer));
-				_ctx.StartPointer += 2;
-				break;
-			case EPLYPT_INT32:
-				if (_ctx.IsWrongEndian)
-					retVal = float(core::Byteswap::byteswap(*(reinterpret_cast<int32_t*>(_ctx.StartPointer))));
-				else
-					retVal = float(*(reinterpret_cast<int32_t*>(_ctx.StartPointer)));
-				_ctx.StartPointer += 4;
-				break;
-			case EPLYPT_FLOAT32:
-				if (_ctx.IsWrongEndian)
-					retVal = core::Byteswap::byteswap(*(reinterpret_cast<float*>(_ctx.StartPointer)));
-				else
-					retVal = *(reinterpret_cast<float*>(_ctx.StartPointer));
-				_ctx.StartPointer += 4;
-				break;
-			case EPLYPT_FLOAT64:
-				char tmp[8];
-				memcpy(tmp, _ctx.StartPointer, 8);
-				if (_ctx.IsWrongEndian)
-					for (size_t i = 0u; i < 4u; ++i)
-						std::swap(tmp[i], tmp[7u - i]);
-				retVal = float(*(reinterpret_cast<double*>(tmp)));
-				_ctx.StartPointer += 8;
-				break;
-			case EPLYPT_LIST:
-			case EPLYPT_UNKNOWN:
-			default:
-				retVal = 0.0f;
-				_ctx.StartPointer++; // ouch!
-			}
-		}
-		else
-			retVal = 0.0f;
-	}
-	else
-	{
-		char* word = getNextWord(_ctx);
-		switch (t)
-		{
-		case EPLYPT_INT8:
-		case EPLYPT_INT16:
-		case EPLYPT_INT32:
-			retVal = float(atoi(word));
-			break;
-		case EPLYPT_FLOAT32:
-		case EPLYPT_FLOAT64:
-			retVal = float(atof(word));
-			break;
-		case EPLYPT_LIST:
-		case EPLYPT_UNKNOWN:
-		default:
-			retVal = 0.0f;
-		}
-	}
-
-	return retVal;
-}
-
-
-// read the next int from the file and move the start pointer along
-uint32_t CPLYMeshFileLoader::getInt(SContext& _ctx, E_PLY_PROPERTY_TYPE t)
-{
-	uint32_t retVal = 0;
-
-	if (_ctx.IsBinaryFile)
-	{
-		if (!_ctx.EndOfFile && _ctx.EndPointer - _ctx.StartPointer < 8)
-			fillBuffer(_ctx);
-
-		if (_ctx.EndPointer - _ctx.StartPointer)
-		{
-			switch (t)
-			{
-			case EPLYPT_INT8:
-				retVal = *_ctx.StartPointer;
-				_ctx.StartPointer++;
-				break;
-			case EPLYPT_INT16:
-				if (_ctx.IsWrongEndian)
-					retVal = core::Byteswap::byteswap(*(reinterpret_cast<uint16_t*>(_ctx.StartPointer)));
-				else
-					retVal = *(reinterpret_cast<uint16_t*>(_ctx.StartPointer));
-				_ctx.StartPointer += 2;
-				break;
-			case EPLYPT_INT32:
-				if (_ctx.IsWrongEndian)
-					retVal = core::Byteswap::byteswap(*(reinterpret_cast<int32_t*>(_ctx.StartPointer)));
-				else
-					retVal = *(reinterpret_cast<int32_t*>(_ctx.StartPointer));
-				_ctx.StartPointer += 4;
-				break;
-			case EPLYPT_FLOAT32:
-				if (_ctx.IsWrongEndian)
-					retVal = (uint32_t)core::Byteswap::byteswap(*(reinterpret_cast<float*>(_ctx.StartPointer)));
-				else
-					retVal = (uint32_t)(*(reinterpret_cast<float*>(_ctx.StartPointer)));
-				_ctx.StartPointer += 4;
-				break;
-			case EPLYPT_FLOAT64:
-				// todo: byteswap 64-bit
-				retVal = (uint32_t)(*(reinterpret_cast<double*>(_ctx.StartPointer)));
-				_ctx.StartPointer += 8;
-				break;
-			case EPLYPT_LIST:
-			case EPLYPT_UNKNOWN:
-			default:
-				retVal = 0;
-				_ctx.StartPointer++; // ouch!
-			}
-		}
-		else
-			retVal = 0;
-	}
-	else
-	{
-		char* word = getNextWord(_ctx);
-		switch (t)
-		{
-		case EPLYPT_INT8:
-		case EPLYPT_INT16:
-		case EPLYPT_INT32:
-			retVal = atoi(word);
-			break;
-		case EPLYPT_FLOAT32:
-		case EPLYPT_FLOAT64:
-			retVal = uint32_t(atof(word));
-			break;
-		case EPLYPT_LIST:
-		case EPLYPT_UNKNOWN:
-		default:
-			retVal = 0;
-		}
-	}
-	return retVal;
-}
-
-
 } // end namespace scene
 } // end namespace nbl
 
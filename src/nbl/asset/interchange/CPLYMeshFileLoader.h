@@ -110,9 +110,9 @@ private:
 		} Data PACK_STRUCT;
 		#include "nbl/nblunpack.h"
 
-		inline uint32_t size() const
+		static inline uint32_t typeSize(const E_PLY_PROPERTY_TYPE type)
 		{
-			switch(Type)
+			switch(type)
 			{
 			case EPLYPT_INT8:
 				return 1;
@@ -130,6 +130,11 @@ private:
 			}
 		}
 
+		inline uint32_t size() const
+		{
+			return typeSize(Type);
+		}
+
 		inline bool isFloat() const
 		{
 			switch(Type)
@@ -188,20 +193,29 @@ private:
 		size_t fileOffset = {};
     };
 
+	// only used for the header, the body gets decoded from memory in one go
 	bool allocateBuffer(SContext& _ctx);
 	char* getNextLine(SContext& _ctx);
 	char* getNextWord(SContext& _ctx);
 	void fillBuffer(SContext& _ctx);
 	E_PLY_PROPERTY_TYPE getPropertyType(const char* typeString) const;
 
- 	bool readVertex(SContext& _ctx, const SPLYElement &Element, asset::SBufferBinding<asset::ICPUBuffer> outAttributes[4], const uint32_t& currentVertexIndex, const IAssetLoader::SAssetLoadParams& _params);
-	bool readFace(SContext& _ctx, const SPLYElement &Element, core::vector<uint32_t>& _outIndices);
+	//! Where a property of a vertex element gets written, compiled once per element from the header
+	struct SVertexTarget
+	{
+		// first element's component, nullptr if the property is not loaded
+		float* data = nullptr;
+		// stride between elements in floats
+		uint32_t componentCount = 0u;
+		// applies the handedness flip and the normalization of integer colors
+		float scale = 1.f;
+		bool isUnsigned = false;
+	};
+	core::vector<SVertexTarget> compileVertexTargets(const SPLYElement& _element, const asset::SBufferBinding<asset::ICPUBuffer> _attributes[4], const uint32_t _vertexCount, const IAssetLoader::SAssetLoadParams& _params) const;
 
-	void skipElement(SContext& _ctx, const SPLYElement &Element);
-	void skipProperty(SContext& _ctx, const SPLYProperty &Property);
-	float getFloat(SContext& _ctx, E_PLY_PROPERTY_TYPE t);
-	uint32_t getInt(SContext& _ctx, E_PLY_PROPERTY_TYPE t);
-	void moveForward(SContext& _ctx, uint32_t bytes);
+	//! Both return false if the body is truncated or malformed
+	bool readBinaryBody(SContext& _ctx, const uint8_t* _body, const uint8_t* _bodyEnd, const asset::SBufferBinding<asset::ICPUBuffer> _attributes[4], const uint32_t _vertexCount, core::vector<uint32_t>& _outIndices) const;
+	bool readAsciiBody(SContext& _ctx, const char* _body, const char* _bodyEnd, const asset::SBufferBinding<asset::ICPUBuffer> _attributes[4], const uint32_t _vertexCount, core::vector<uint32_t>& _outIndices) const;
 
 	bool genVertBuffersForMBuffer(
 		ICPUMeshBuffer* _mbuf,
@@ -15,6 +15,11 @@
 #include "nbl/system/ISystem.h"
 #include "nbl/system/IFile.h"
 
+#include "nbl/core/execution.h"
+#include "nbl/core/algorithm/radix_sort.h"
+
+#include <optional>
+
 using namespace nbl;
 using namespace nbl::asset;
 
@@ -23,6 +28,256 @@ constexpr auto COLOR_ATTRIBUTE = 1;
 constexpr auto UV_ATTRIBUTE = 2;
 constexpr auto NORMAL_ATTRIBUTE = 3;
 
+// binary STL is an 80 byte header and a triangle count followed by packed 50 byte records of 12 floats and a 16bit attribute
+constexpr size_t BINARY_HEADER_SIZE = 84ull;
+constexpr size_t BINARY_TRIANGLE_SIZE = 50ull;
+// triangles processed by a single task
+constexpr uint32_t TRIANGLE_CHUNK_SIZE = 0x1u<<12u;
+// triangles read at once when the file is not mapped
+constexpr uint32_t READ_CHUNK_SIZE = 0x1u<<18u;
+// binary files get decoded to position+normal+color, the color gets dropped afterwards if not every triangle had one
+constexpr size_t DECODE_VERTEX_SIZE = 3ull*sizeof(float)+4ull+4ull;
+
+using quant_normal_t = CQuantNormalCache::value_type_t<EF_A2B10G10R10_SNORM_PACK32>;
+static_assert(sizeof(quant_normal_t)==4ull);
+
+template<typename F>
+static void parallelForChunks(const uint32_t count, const uint32_t chunkSize, F&& f)
+{
+	core::vector<uint32_t> chunks((count+chunkSize-1u)/chunkSize);
+	std::iota(chunks.begin(),chunks.end(),0u);
+	std::for_each(core::execution::par_unseq,chunks.begin(),chunks.end(),[&f,count,chunkSize](const uint32_t chunk) -> void
+	{
+		const uint32_t begin = chunk*chunkSize;
+		f(begin,core::min(begin+chunkSize,count));
+	});
+}
+
+//! Decodes `count` packed binary records into `DECODE_VERTEX_SIZE` strided vertices.
+//! Quantizing normals goes through a cache which isn't threadsafe, so the raw normal gets stashed one component per vertex in the normal slots.
+//! Returns whether every triangle had the VisCam/SolidView color bit set.
+static bool decodeBinaryTriangles(const uint8_t* records, const uint32_t count, uint8_t* vertices, const bool rightHanded)
+{
+	// X is mirrored for the left handed default, right handed meshes keep it as is
+	const __m128 flipMask = rightHanded ? _mm_setzero_ps():_mm_castsi128_ps(_mm_set_epi32(0,0,0,0x80000000));
+	const __m128 xyzMask = _mm_castsi128_ps(_mm_set_epi32(0,-1,-1,-1));
+
+	std::atomic_bool allColored = true;
+	parallelForChunks(count,TRIANGLE_CHUNK_SIZE,[&](const uint32_t begin, const uint32_t end) -> void
+	{
+		bool chunkColored = true;
+		for (uint32_t i=begin; i<end; i++)
+		{
+			const uint8_t* record = records+BINARY_TRIANGLE_SIZE*i;
+			// the 12 floats are exactly three unaligned loads: [n.xyz p0.x] [p0.yz p1.xy] [p1.z p2.xyz]
+			const __m128 a = _mm_loadu_ps(reinterpret_cast<const float*>(record));
+			const __m128 b = _mm_loadu_ps(reinterpret_cast<const float*>(record)+4);
+			const __m128 c = _mm_loadu_ps(reinterpret_cast<const float*>(record)+8);
+			const __m128 ab = _mm_shuffle_ps(a,b,_MM_SHUFFLE(1,0,3,3));
+			const core::vectorSIMDf p[3] = {
+				_mm_and_ps(_mm_xor_ps(_mm_shuffle_ps(ab,ab,_MM_SHUFFLE(3,3,2,1)),flipMask),xyzMask),
+				_mm_and_ps(_mm_xor_ps(_mm_shuffle_ps(b,c,_MM_SHUFFLE(0,0,3,2)),flipMask),xyzMask),
+				_mm_and_ps(_mm_xor_ps(_mm_shuffle_ps(c,c,_MM_SHUFFLE(3,3,2,1)),flipMask),xyzMask)
+			};
+			core::vectorSIMDf n = _mm_and_ps(_mm_xor_ps(a,flipMask),xyzMask);
+			if ((n==core::vectorSIMDf()).all())
+				n = core::plane3dSIMDf(p[2],p[1],p[0]).getNormal();
+			else
+				n = core::normalize(n);
+
+			uint16_t attrib;
+			memcpy(&attrib,record+12u*sizeof(float),sizeof(attrib));
+			uint32_t color = 0u;
+			if (attrib&0x8000u) // assuming VisCam/SolidView non-standard trick to store color in 2 bytes of extra attribute
+			{
+				const void* srcColor[1]{ &attrib };
+				convertColor<EF_A1R5G5B5_UNORM_PACK16,EF_B8G8R8A8_UNORM>(srcColor,&color,0u,0u);
+			}
+			else
+				chunkColored = false;
+
+			uint8_t* out = vertices+DECODE_VERTEX_SIZE*3ull*i;
+			for (uint32_t j=0u; j<3u; j++,out+=DECODE_VERTEX_SIZE) // seems like in STL format vertices are ordered in clockwise manner...
+			{
+				memcpy(out,p[2u-j].pointer,3ull*sizeof(float));
+				memcpy(out+12,n.pointer+j,sizeof(float));
+				memcpy(out+16,&color,sizeof(color));
+			}
+		}
+		if (!chunkColored)
+			allColored.store(false,std::memory_order_relaxed);
+	});
+	return allColored.load();
+}
+
+//! Returns `DECODE_VERTEX_SIZE` strided vertices with normals still stashed (see above), or nullptr if reading failed
+static core::smart_refctd_ptr<ICPUBuffer> loadBinaryVertices(system::IFile* file, const uint32_t triangleCount, const bool rightHanded, bool& allColored)
+{
+	auto vertexBuf = core::make_smart_refctd_ptr<ICPUBuffer>(DECODE_VERTEX_SIZE*3ull*triangleCount);
+	auto* const vertices = reinterpret_cast<uint8_t*>(vertexBuf->getPointer());
+
+	allColored = true;
+	if (triangleCount==0u)
+		return vertexBuf;
+
+	const system::IFileBase* constFile = file;
+	if (const auto* mapped=reinterpret_cast<const uint8_t*>(constFile->getMappedPointer()))
+	{
+		allColored = decodeBinaryTriangles(mapped+BINARY_HEADER_SIZE,triangleCount,vertices,rightHanded);
+		return vertexBuf;
+	}
+
+	// double buffered, the next chunk gets read while the current one decodes
+	const uint32_t chunkSize = core::min(triangleCount,READ_CHUNK_SIZE);
+	core::vector<uint8_t> staging[2] = {
+		core::vector<uint8_t>(BINARY_TRIANGLE_SIZE*chunkSize),
+		core::vector<uint8_t>(BINARY_TRIANGLE_SIZE*chunkSize)
+	};
+	// declared after the staging so pending reads get waited on before their buffers go away
+	std::optional<system::IFile::success_t> reads[2];
+	auto issueRead = [&](const uint32_t firstTriangle, const uint32_t slot) -> void
+	{
+		const uint32_t triangles = core::min(chunkSize,triangleCount-firstTriangle);
+		reads[slot].emplace();
+		file->read(*reads[slot],staging[slot].data(),BINARY_HEADER_SIZE+BINARY_TRIANGLE_SIZE*firstTriangle,BINARY_TRIANGLE_SIZE*triangles);
+	};
+
+	issueRead(0u,0u);
+	for (uint32_t firstTriangle=0u,slot=0u; firstTriangle<triangleCount; firstTriangle+=chunkSize,slot^=1u)
+	{
+		const uint32_t nextTriangle = firstTriangle+chunkSize;
+		if (nextTriangle<triangleCount)
+			issueRead(nextTriangle,slot^1u);
+
+		if (!*reads[slot])
+			return nullptr;
+		const uint32_t triangles = core::min(chunkSize,triangleCount-firstTriangle);
+		if (!decodeBinaryTriangles(staging[slot].data(),triangles,vertices+DECODE_VERTEX_SIZE*3ull*firstTriangle,rightHanded))
+			allColored = false;
+	}
+	return vertexBuf;
+}
+
+//! Turns the normals stashed by `decodeBinaryTriangles` into the quantized per-vertex normals
+static void quantizeStashedNormals(uint8_t* vertices, const uint32_t triangleCount, CQuantNormalCache* quantNormalCache)
+{
+	for (uint32_t i=0u; i<triangleCount; i++,vertices+=DECODE_VERTEX_SIZE*3ull)
+	{
+		core::vectorSIMDf n;
+		for (uint32_t j=0u; j<3u; j++)
+			memcpy(n.pointer+j,vertices+DECODE_VERTEX_SIZE*j+12,sizeof(float));
+		const quant_normal_t normal = quantNormalCache->quantize<EF_A2B10G10R10_SNORM_PACK32>(n);
+		for (uint32_t j=0u; j<3u; j++)
+			memcpy(vertices+DECODE_VERTEX_SIZE*j+12,&normal,sizeof(normal));
+	}
+}
+
+//! Copies the first `dstStride` bytes of every vertex into a tightly packed buffer
+static core::smart_refctd_ptr<ICPUBuffer> repackVertices(const uint8_t* src, const size_t srcStride, const size_t dstStride, const uint32_t count)
+{
+	auto vertexBuf = core::make_smart_refctd_ptr<ICPUBuffer>(dstStride*count);
+	auto* const dst = reinterpret_cast<uint8_t*>(vertexBuf->getPointer());
+	parallelForChunks(count,TRIANGLE_CHUNK_SIZE,[&](const uint32_t begin, const uint32_t end) -> void
+	{
+		for (uint32_t i=begin; i<end; i++)
+			memcpy(dst+dstStride*i,src+srcStride*i,dstStride);
+	});
+	return vertexBuf;
+}
+
+static inline uint32_t hashVertex(const uint8_t* vertex, const size_t size)
+{
+	// every attribute we emit is a multiple of 4 bytes
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (size_t i=0ull; i<size; i+=sizeof(uint32_t))
+	{
+		uint32_t word;
+		memcpy(&word,vertex+i,sizeof(word));
+		hash = (hash^word)*0x100000001b3ull;
+	}
+	return static_cast<uint32_t>(hash^(hash>>32u));
+}
+
+//! Merges vertices whose first `dstStride` bytes are bitwise identical, unique vertices keep the order of their first occurrence.
+//! Vertices get sorted by hash, so only the rare hash collisions need more than one comparison.
+static void deduplicateVertices(const uint8_t* src, const size_t srcStride, const size_t dstStride, const uint32_t count, core::smart_refctd_ptr<ICPUBuffer>& outVertices, core::smart_refctd_ptr<ICPUBuffer>& outIndices)
+{
+	// second halves are radix sort scratch
+	core::vector<uint32_t> hashes(2ull*count);
+	core::vector<uint32_t> order(2ull*count);
+	parallelForChunks(count,TRIANGLE_CHUNK_SIZE,[&](const uint32_t begin, const uint32_t end) -> void
+	{
+		for (uint32_t i=begin; i<end; i++)
+		{
+			hashes[i] = hashVertex(src+srcStride*i,dstStride);
+			order[i] = i;
+		}
+	});
+	// stable, so within a run of equal hashes the vertices stay in ascending order
+	const auto sorted = core::radix_sort_by_key(core::execution::par_unseq,hashes.data(),hashes.data()+count,order.data(),order.data()+count,count);
+	const uint32_t* const sortedHashes = sorted.first;
+	const uint32_t* const sortedOrder = sorted.second;
+
+	// every vertex gets redirected to the first occurrence of its value
+	core::vector<uint32_t> redirect(count);
+	parallelForChunks(count,TRIANGLE_CHUNK_SIZE,[&](uint32_t begin, const uint32_t end) -> void
+	{
+		// runs straddling a chunk boundary belong to the chunk they start in
+		while (begin<end && begin!=0u && sortedHashes[begin]==sortedHashes[begin-1u])
+			begin++;
+		for (uint32_t runBegin=begin,runEnd; runBegin<end; runBegin=runEnd)
+		{
+			for (runEnd=runBegin+1u; runEnd<count && sortedHashes[runEnd]==sortedHashes[runBegin]; runEnd++) {}
+			for (uint32_t i=runBegin; i<runEnd; i++)
+			{
+				const uint32_t vertex = sortedOrder[i];
+				redirect[vertex] = vertex;
+				for (uint32_t j=runBegin; j<i; j++)
+				if (memcmp(src+srcStride*sortedOrder[j],src+srcStride*vertex,dstStride)==0)
+				{
+					redirect[vertex] = redirect[sortedOrder[j]];
+					break;
+				}
+			}
+		}
+	});
+
+	// compact in parallel, count uniques per chunk then scan the counts to get each chunk's output offset
+	const uint32_t chunkCount = (count+TRIANGLE_CHUNK_SIZE-1u)/TRIANGLE_CHUNK_SIZE;
+	core::vector<uint32_t> chunkOffsets(chunkCount+1u,0u);
+	parallelForChunks(count,TRIANGLE_CHUNK_SIZE,[&](const uint32_t begin, const uint32_t end) -> void
+	{
+		uint32_t uniqueCount = 0u;
+		for (uint32_t i=begin; i<end; i++)
+		if (redirect[i]==i)
+			uniqueCount++;
+		chunkOffsets[begin/TRIANGLE_CHUNK_SIZE+1u] = uniqueCount;
+	});
+	std::partial_sum(chunkOffsets.begin(),chunkOffsets.end(),chunkOffsets.begin());
+
+	outVertices = core::make_smart_refctd_ptr<ICPUBuffer>(dstStride*chunkOffsets.back());
+	outIndices = core::make_smart_refctd_ptr<ICPUBuffer>(sizeof(uint32_t)*count);
+	auto* const dst = reinterpret_cast<uint8_t*>(outVertices->getPointer());
+	auto* const indices = reinterpret_cast<uint32_t*>(outIndices->getPointer());
+	parallelForChunks(count,TRIANGLE_CHUNK_SIZE,[&](const uint32_t begin, const uint32_t end) -> void
+	{
+		uint32_t outIx = chunkOffsets[begin/TRIANGLE_CHUNK_SIZE];
+		for (uint32_t i=begin; i<end; i++)
+		if (redirect[i]==i)
+		{
+			memcpy(dst+dstStride*outIx,src+srcStride*i,dstStride);
+			indices[i] = outIx++;
+		}
+	});
+	// duplicates always come after their first occurrence, but it may live in another chunk
+	parallelForChunks(count,TRIANGLE_CHUNK_SIZE,[&](const uint32_t begin, const uint32_t end) -> void
+	{
+		for (uint32_t i=begin; i<end; i++)
+		if (redirect[i]!=i)
+			indices[i] = indices[redirect[i]];
+	});
+}
+
 CSTLMeshFileLoader::CSTLMeshFileLoader(asset::IAssetManager* _m_assetMgr)
 	: IRenderpassIndependentPipelineLoader(_m_assetMgr), m_assetMgr(_m_assetMgr)
 {
@@ -156,41 +411,48 @@ SAssetBundle CSTLMeshFileLoader::loadAsset(system::IFile* _file, const IAssetLoa
 	meshbuffer->setPositionAttributeIx(POSITION_ATTRIBUTE);
 	meshbuffer->setNormalAttributeIx(NORMAL_ATTRIBUTE);
 
+	const bool rightHanded = _params.loaderFlags & E_LOADER_PARAMETER_FLAGS::ELPF_RIGHT_HANDED_MESHES;
+
 	bool binary = false;
 	std::string token;
 	if (getNextToken(&context, token) != "solid")
 		binary = hasColor = true;
 
-	core::vector<core::vectorSIMDf> positions, normals;
-	core::vector<uint32_t> colors;
+	// vertices in `vertexData` are `vertexStride` apart, but only the first `vtxSize` bytes make it into the final buffer
+	core::smart_refctd_ptr<asset::ICPUBuffer> vertexData;
+	size_t vertexStride;
+	uint32_t vertexCount;
 	if (binary)
 	{
-		if (_file->getSize() < 80)
+		if (filesize < BINARY_HEADER_SIZE)
 			return {};
 
-		constexpr size_t headerOffset = 80; 
-		context.fileOffset = headerOffset; //! skip header
-
-		uint32_t vertexCount = 0u;
-
-		system::IFile::success_t success;
-		context.inner.mainFile->read(success, &vertexCount, context.fileOffset, sizeof(vertexCount));
-		if (!success)
+		uint32_t triangleCount = 0u;
+		{
+			system::IFile::success_t success;
+			context.inner.mainFile->read(success, &triangleCount, BINARY_HEADER_SIZE-sizeof(triangleCount), sizeof(triangleCount));
+			if (!success)
+				return {};
+		}
+		// don't trust the header over the actual file size
+		triangleCount = static_cast<uint32_t>(core::min<size_t>(triangleCount, (filesize-BINARY_HEADER_SIZE)/BINARY_TRIANGLE_SIZE));
+		if (triangleCount > std::numeric_limits<uint32_t>::max()/3u)
 			return {};
-		context.fileOffset += sizeof(vertexCount);
 
-		positions.reserve(3 * vertexCount);
-		normals.reserve(vertexCount);
-		colors.reserve(vertexCount);
+		vertexData = loadBinaryVertices(context.inner.mainFile, triangleCount, rightHanded, hasColor);
+		if (!vertexData)
+			return {};
+		quantizeStashedNormals(reinterpret_cast<uint8_t*>(vertexData->getPointer()), triangleCount, quantNormalCache);
+		vertexStride = DECODE_VERTEX_SIZE;
+		vertexCount = 3u*triangleCount;
 	}
 	else
+	{
 		goNextLine(&context); // skip header
 
-	uint16_t attrib = 0u;
-	token.reserve(32);
-	while (context.fileOffset < filesize) // TODO: check it
-	{
-		if (!binary)
+		core::vector<core::vectorSIMDf> positions, normals;
+		token.reserve(32);
+		while (context.fileOffset < filesize) // TODO: check it
 		{
 			if (getNextToken(&context, token) != "facet")
 			{
@@ -202,95 +464,71 @@ SAssetBundle CSTLMeshFileLoader::loadAsset(system::IFile* _file, const IAssetLoa
 			{
 				return {};
 			}
-		}
 
-		{
-			core::vectorSIMDf n;
-			getNextVector(&context, n, binary);
-			if(_params.loaderFlags & E_LOADER_PARAMETER_FLAGS::ELPF_RIGHT_HANDED_MESHES)
-				performActionBasedOnOrientationSystem<float>(n.x, [](float& varToFlip) {varToFlip = -varToFlip;});
-			normals.push_back(core::normalize(n));
-		}
+			{
+				core::vectorSIMDf n;
+				getNextVector(&context, n);
+				if (rightHanded)
+					performActionBasedOnOrientationSystem<float>(n.x, [](float& varToFlip) {varToFlip = -varToFlip;});
+				normals.push_back(core::normalize(n));
+			}
 
-		if (!binary)
-		{
 			if (getNextToken(&context, token) != "outer" || getNextToken(&context, token) != "loop")
 				return {};
-		}
 
-		{
-			core::vectorSIMDf p[3];
-			for (uint32_t i = 0u; i < 3u; ++i)
 			{
-				if (!binary)
+				core::vectorSIMDf p[3];
+				for (uint32_t i = 0u; i < 3u; ++i)
 				{
 					if (getNextToken(&context, token) != "vertex")
 						return {};
+					getNextVector(&context, p[i]);
+					if (rightHanded)
+						performActionBasedOnOrientationSystem<float>(p[i].x, [](float& varToFlip){varToFlip = -varToFlip; });
 				}
-				getNextVector(&context, p[i], binary);
-				if (_params.loaderFlags & E_LOADER_PARAMETER_FLAGS::ELPF_RIGHT_HANDED_MESHES)
-					performActionBasedOnOrientationSystem<float>(p[i].x, [](float& varToFlip){varToFlip = -varToFlip; });
+				for (uint32_t i = 0u; i < 3u; ++i) // seems like in STL format vertices are ordered in clockwise manner...
+					positions.push_back(p[2u - i]);
 			}
-			for (uint32_t i = 0u; i < 3u; ++i) // seems like in STL format vertices are ordered in clockwise manner...
-				positions.push_back(p[2u - i]);
-		}
 
-		if (!binary)
-		{
 			if (getNextToken(&context, token) != "endloop" || getNextToken(&context, token) != "endfacet")
 				return {};
-		}
-		else
-		{
-			system::IFile::success_t success;
-			context.inner.mainFile->read(success, &attrib, context.fileOffset, sizeof(attrib));
-			if (!success)
-				return {};
-			context.fileOffset += sizeof(attrib);
-		}
 
-		if (hasColor && (attrib & 0x8000u)) // assuming VisCam/SolidView non-standard trick to store color in 2 bytes of extra attribute
-		{
-			const void* srcColor[1]{ &attrib };
-			uint32_t color{};
-			convertColor<EF_A1R5G5B5_UNORM_PACK16, EF_B8G8R8A8_UNORM>(srcColor, &color, 0u, 0u);
-			colors.push_back(color);
-		}
-		else
-		{
-			hasColor = false;
-			colors.clear();
-		}
+			if ((normals.back() == core::vectorSIMDf()).all())
+			{
+				normals.back().set(
+					core::plane3dSIMDf(
+						*(positions.rbegin() + 2),
+						*(positions.rbegin() + 1),
+						*(positions.rbegin() + 0)).getNormal()
+				);
+			}
+		} // end while (_file->getPos() < filesize)
+
+		vertexStride = 3 * sizeof(float) + 4;
+		vertexCount = positions.size();
+		vertexData = core::make_smart_refctd_ptr<asset::ICPUBuffer>(vertexStride * vertexCount);
 
-		if ((normals.back() == core::vectorSIMDf()).all())
+		quant_normal_t normal;
+		for (size_t i = 0u; i < positions.size(); ++i)
 		{
-			normals.back().set(
-				core::plane3dSIMDf(
-					*(positions.rbegin() + 2),
-					*(positions.rbegin() + 1),
-					*(positions.rbegin() + 0)).getNormal()
-			);
+			if (i % 3 == 0)
+				normal = quantNormalCache->quantize<EF_A2B10G10R10_SNORM_PACK32>(normals[i / 3]);
+			uint8_t* ptr = ((uint8_t*)(vertexData->getPointer())) + i * vertexStride;
+			memcpy(ptr, positions[i].pointer, 3 * 4);
+
+			*reinterpret_cast<quant_normal_t*>(ptr + 12) = normal;
 		}
-	} // end while (_file->getPos() < filesize)
+	}
 
 	const size_t vtxSize = hasColor ? (3 * sizeof(float) + 4 + 4) : (3 * sizeof(float) + 4);
-	auto vertexBuf = core::make_smart_refctd_ptr<asset::ICPUBuffer>(vtxSize * positions.size());
-
-	using quant_normal_t = CQuantNormalCache::value_type_t<EF_A2B10G10R10_SNORM_PACK32>;
-
-	quant_normal_t normal;
-	for (size_t i = 0u; i < positions.size(); ++i)
-	{
-		if (i % 3 == 0)
-			normal = quantNormalCache->quantize<EF_A2B10G10R10_SNORM_PACK32>(normals[i / 3]);
-		uint8_t* ptr = ((uint8_t*)(vertexBuf->getPointer())) + i * vtxSize;
-		memcpy(ptr, positions[i].pointer, 3 * 4);
-
-		*reinterpret_cast<quant_normal_t*>(ptr + 12) = normal;
-
-		if (hasColor)
-			memcpy(ptr + 16, colors.data() + i / 3, 4);
-	}
+	const auto* const vertexSrc = reinterpret_cast<const uint8_t*>(vertexData->getPointer());
+	core::smart_refctd_ptr<asset::ICPUBuffer> vertexBuf, indexBuf;
+	if (_params.loaderFlags & E_LOADER_PARAMETER_FLAGS::ELPF_DEDUPLICATE_VERTICES)
+		deduplicateVertices(vertexSrc, vertexStride, vtxSize, vertexCount, vertexBuf, indexBuf);
+	else if (vertexStride != vtxSize)
+		vertexBuf = repackVertices(vertexSrc, vertexStride, vtxSize, vertexCount);
+	else
+		vertexBuf = std::move(vertexData);
 
 	const IAssetLoader::SAssetLoadContext fakeContext(IAssetLoader::SAssetLoadParams{}, nullptr);
 	const asset::IAsset::E_TYPE types[]{ asset::IAsset::ET_RENDERPASS_INDEPENDENT_PIPELINE, (asset::IAsset::E_TYPE)0u };
@@ -306,8 +544,14 @@ SAssetBundle CSTLMeshFileLoader::loadAsset(system::IFile* _file, const IAssetLoa
 	meta->placeMeta(0u, mbPipeline.get());
 
 	meshbuffer->setPipeline(std::move(mbPipeline));
-	meshbuffer->setIndexCount(positions.size());
-	meshbuffer->setIndexType(asset::EIT_UNKNOWN);
+	meshbuffer->setIndexCount(vertexCount);
+	if (indexBuf)
+	{
+		meshbuffer->setIndexType(asset::EIT_32BIT);
+		meshbuffer->setIndexBufferBinding({ 0ul, std::move(indexBuf) });
+	}
+	else
+		meshbuffer->setIndexType(asset::EIT_UNKNOWN);
 
 	meshbuffer->setVertexBufferBinding({ 0ul, vertexBuf }, 0);
 	mesh->getMeshBufferVector().emplace_back(std::move(meshbuffer));
@@ -349,40 +593,17 @@ bool CSTLMeshFileLoader::isALoadableFileFormat(system::IFile* _file, const syste
 }
 
 //! Read 3d vector of floats
-void CSTLMeshFileLoader::getNextVector(SContext* context, core::vectorSIMDf& vec, bool binary) const
+void CSTLMeshFileLoader::getNextVector(SContext* context, core::vectorSIMDf& vec) const
 {
-	if (binary)
-	{
-		{
-			system::IFile::success_t success;
-			context->inner.mainFile->read(success, &vec.X, context->fileOffset, 4);
-			context->fileOffset += success.getBytesProcessed();
-		}
-		
-		{
-			system::IFile::success_t success;
-			context->inner.mainFile->read(success, &vec.Y, context->fileOffset, 4);
-			context->fileOffset += success.getBytesProcessed();
-		}
-
-		{
-			system::IFile::success_t success;
-			context->inner.mainFile->read(success, &vec.Z, context->fileOffset, 4);
-			context->fileOffset += success.getBytesProcessed();
-		}
-	}
-	else
-	{
-		goNextWord(context);
-		std::string tmp;
-
-		getNextToken(context, tmp);
-		sscanf(tmp.c_str(), "%f", &vec.X);
-		getNextToken(context, tmp);
-		sscanf(tmp.c_str(), "%f", &vec.Y);
-		getNextToken(context, tmp);
-		sscanf(tmp.c_str(), "%f", &vec.Z);
-	}
+	goNextWord(context);
+	std::string tmp;
+
+	getNextToken(context, tmp);
+	sscanf(tmp.c_str(), "%f", &vec.X);
+	getNextToken(context, tmp);
+	sscanf(tmp.c_str(), "%f", &vec.Y);
+	getNextToken(context, tmp);
+	sscanf(tmp.c_str(), "%f", &vec.Z);
 	vec.X = -vec.X;
 }
 
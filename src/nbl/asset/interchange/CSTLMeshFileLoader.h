@@ -58,8 +58,8 @@ class CSTLMeshFileLoader final : public IRenderpassIndependentPipelineLoader
 		const std::string& getNextToken(SContext* context, std::string& token) const;
 		// skip to next printable character after the first line break
 		void goNextLine(SContext* context) const;
-		//! Read 3d vector of floats
-		void getNextVector(SContext* context, core::vectorSIMDf& vec, bool binary) const;
+		//! Read 3d vector of floats from an ASCII file
+		void getNextVector(SContext* context, core::vectorSIMDf& vec) const;
 
 		template<typename aType>
 		static inline void performActionBasedOnOrientationSystem(aType& varToHandle, void (*performOnCertainOrientation)(aType& varToHandle))
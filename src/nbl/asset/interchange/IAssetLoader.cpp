@@ -109,6 +109,21 @@ SAssetBundle IAssetLoader::interm_getAssetInHierarchyWholeBundleRestore(IAssetMa
     return _mgr->getAssetInHierarchyWholeBundleRestore(_filename, _params, _hierarchyLevel);
 }
 
+core::vector<SAssetBundle> IAssetLoader::interm_getAssetsInHierarchy(IAssetManager* _mgr, std::span<const std::string> _filenames, const IAssetLoader::SAssetLoadParams& _params, uint32_t _hierarchyLevel, IAssetLoader::IAssetLoaderOverride* _override)
+{
+    return _mgr->getAssetsInHierarchy(_filenames, _params, _hierarchyLevel, _override);
+}
+
+system::CWorkStealingThreadPool* IAssetLoader::interm_getLoadPool(IAssetManager* _mgr)
+{
+    return _mgr->getLoadPool();
+}
+
+void IAssetLoader::interm_waitForLoadTasks(IAssetManager* _mgr, const system::CWorkStealingThreadPool::CTaskGroup& _group)
+{
+    _mgr->waitForLoadTasks(_group);
+}
+
 void IAssetLoader::interm_setAssetMutability(const IAssetManager* _mgr, IAsset* _asset, IAsset::E_MUTABILITY _val)
 {
     _mgr->setAssetMutability(_asset, _val);
@@ -7,8 +7,9 @@
 #include "nbl/builtin/CArchive.h"
 #endif // NBL_EMBED_BUILTIN_RESOURCES
 
+#include <glslang/build_info.h>
+
 #include <sstream>
-#include <regex>
 #include <iterator>
 
 using namespace nbl;
@@ -19,23 +20,87 @@ static constexpr const char* PREPROC_GL__ENABLER = PREPROC_GL__DISABLER;
 static constexpr const char* PREPROC_LINE_CONTINUATION_DISABLER = "_this_is_a_line_continuation_\n";
 static constexpr const char* PREPROC_LINE_CONTINUATION_ENABLER = "_this_is_a_line_continuation_";
 
+static inline bool isWhitespace(const char c)
+{
+    return c==' '||c=='\t'||c=='\r'||c=='\n'||c=='\v'||c=='\f';
+}
+
+// whitespace followed by `GL_` becomes `PREPROC_GL__DISABLER` (eating the whitespace), then a backslash followed by whitespace
+// containing a newline becomes `PREPROC_LINE_CONTINUATION_DISABLER` (eating everything up to the last of those newlines)
 static void disableGlDirectives(std::string& _code)
 {
-    std::regex glMacro("[ \t\r\n\v\f]GL_");
-    auto result = std::regex_replace(_code, glMacro, PREPROC_GL__DISABLER);
-    std::regex lineContinuation("\\\\[ \t\r\n\v\f]*\n");
-    _code = std::regex_replace(result, lineContinuation, PREPROC_LINE_CONTINUATION_DISABLER);
+    const std::string_view code(_code);
+    auto glPrefixAt = [&code](const size_t i) -> bool
+    {
+        return isWhitespace(code[i]) && code.substr(i+1u,3u)=="GL_";
+    };
+
+    std::string result;
+    result.reserve(code.size()+code.size()/16u);
+    for (size_t i=0u; i<code.size();)
+    {
+        if (glPrefixAt(i))
+        {
+            result.append(PREPROC_GL__DISABLER);
+            i += 4u;
+        }
+        else if (code[i]=='\\')
+        {
+            // whitespace right before a `GL_` already went into that replacement, so it ends the continuation
+            size_t lastNewline = std::string_view::npos;
+            for (size_t j=i+1u; j<code.size() && isWhitespace(code[j]) && !glPrefixAt(j); j++)
+            if (code[j]=='\n')
+                lastNewline = j;
+
+            if (lastNewline!=std::string_view::npos)
+            {
+                result.append(PREPROC_LINE_CONTINUATION_DISABLER);
+                i = lastNewline+1u;
+            }
+            else
+                result.push_back(code[i++]);
+        }
+        else
+            result.push_back(code[i++]);
+    }
+    _code = std::move(result);
 }
 
 static void reenableGlDirectives(std::string& _code)
 {
-    std::regex lineContinuation(PREPROC_LINE_CONTINUATION_ENABLER);
-    auto result = std::regex_replace(_code, lineContinuation, " \\");
-    std::regex glMacro(PREPROC_GL__ENABLER);
-    _code = std::regex_replace(result, glMacro, " GL_");
+    const std::string_view lineContinuation(PREPROC_LINE_CONTINUATION_ENABLER);
+    const std::string_view glMacro(PREPROC_GL__ENABLER);
+    // both markers start the same way, so only that gets searched for
+    constexpr std::string_view commonPrefix = "_this_is_a_";
+
+    const std::string_view code(_code);
+    std::string result;
+    result.reserve(code.size());
+    size_t copiedUpTo = 0u;
+    for (size_t found=code.find(commonPrefix); found!=std::string_view::npos; found=code.find(commonPrefix,copiedUpTo))
+    {
+        const auto rest = code.substr(found);
+        result.append(code,copiedUpTo,found-copiedUpTo);
+        if (rest.starts_with(lineContinuation))
+        {
+            result.append(" \\");
+            copiedUpTo = found+lineContinuation.size();
+        }
+        else if (rest.starts_with(glMacro))
+        {
+            result.append(" GL_");
+            copiedUpTo = found+glMacro.size();
+        }
+        else
+        {
+            result.push_back(code[found]);
+            copiedUpTo = found+1u;
+        }
+    }
+    result.append(code,copiedUpTo);
+    _code = std::move(result);
 }
 
-
 namespace nbl::asset::impl
 {
     class Includer : public shaderc::CompileOptions::IncluderInterface
@@ -43,9 +108,11 @@ namespace nbl::asset::impl
         const IShaderCompiler::CIncludeFinder* m_defaultIncludeFinder;
         const system::ISystem* m_system;
         const uint32_t m_maxInclCnt;
+        core::vector<IShaderCompiler::SDependency>* m_dependencies;
 
     public:
-        Includer(const IShaderCompiler::CIncludeFinder* _inclFinder, const system::ISystem* _fs, uint32_t _maxInclCnt) : m_defaultIncludeFinder(_inclFinder), m_system(_fs), m_maxInclCnt{ _maxInclCnt } {}
+        Includer(const IShaderCompiler::CIncludeFinder* _inclFinder, const system::ISystem* _fs, uint32_t _maxInclCnt, core::vector<IShaderCompiler::SDependency>* _dependencies)
+            : m_defaultIncludeFinder(_inclFinder), m_system(_fs), m_maxInclCnt{ _maxInclCnt }, m_dependencies(_dependencies) {}
 
         //_requesting_source in top level #include's is what shaderc::Compiler's compiling functions get as `input_file_name` parameter
         //so in order for properly working relative #include's (""-type) `input_file_name` has to be path to file from which the GLSL source really come from
@@ -77,15 +144,7 @@ namespace nbl::asset::impl
             if (std::filesystem::exists(name) && !reqBuiltin)
                 name = std::filesystem::absolute(name);
 
-            IShaderCompiler::IIncludeLoader::found_t result;
-            if (_type == shaderc_include_type_relative)
-            {
-                result = m_defaultIncludeFinder->getIncludeRelative(relDir, _requested_source);
-            }
-            else //shaderc_include_type_standard
-            {
-                result = m_defaultIncludeFinder->getIncludeStandard(relDir, _requested_source);
-            }
+            auto result = m_defaultIncludeFinder->getInclude(relDir, _requested_source, _type == shaderc_include_type_standard, m_dependencies);
 
             if (!result)
             {
@@ -131,6 +190,16 @@ CGLSLCompiler::CGLSLCompiler(core::smart_refctd_ptr<system::ISystem>&& system)
 {
 }
 
+std::string_view CGLSLCompiler::getCompilerVersion() const
+{
+    // glslang gets linked in statically, what it was built from can't change at runtime
+    #define NBL_STRINGIFY(X) #X
+    #define NBL_GLSLANG_VERSION(MAJOR,MINOR,PATCH) "glslang " NBL_STRINGIFY(MAJOR) "." NBL_STRINGIFY(MINOR) "." NBL_STRINGIFY(PATCH) GLSLANG_VERSION_FLAVOR
+    return NBL_GLSLANG_VERSION(GLSLANG_VERSION_MAJOR,GLSLANG_VERSION_MINOR,GLSLANG_VERSION_PATCH);
+    #undef NBL_GLSLANG_VERSION
+    #undef NBL_STRINGIFY
+}
+
 
 
 std::string CGLSLCompiler::preprocessShader(std::string&& code, IShader::E_SHADER_STAGE& stage, const SPreprocessorOptions& preprocessOptions) const
@@ -150,7 +219,7 @@ std::string CGLSLCompiler::preprocessShader(std::string&& code, IShader::E_SHADE
 
     if (preprocessOptions.includeFinder != nullptr)
     {
-        options.SetIncluder(std::make_unique<impl::Includer>(preprocessOptions.includeFinder, m_system.get(), /*maxSelfInclusionCount*/5));//custom #include handler
+        options.SetIncluder(std::make_unique<impl::Includer>(preprocessOptions.includeFinder, m_system.get(), /*maxSelfInclusionCount*/5, preprocessOptions.dependencies));//custom #include handler
     }
     const shaderc_shader_kind scstage = stage == IShader::ESS_UNKNOWN ? shaderc_glsl_infer_from_source : ESStoShadercEnum(stage);
     auto res = comp.PreprocessGlsl(code, scstage, preprocessOptions.sourceIdentifier.data(), options);
@@ -166,9 +235,10 @@ std::string CGLSLCompiler::preprocessShader(std::string&& code, IShader::E_SHADE
     return resolvedString;
 }
 
-core::smart_refctd_ptr<ICPUShader> CGLSLCompiler::compileToSPIRV(const char* code, const IShaderCompiler::SCompilerOptions& options) const
+core::smart_refctd_ptr<ICPUShader> CGLSLCompiler::compileToSPIRV_impl(const char* code, const IShaderCompiler::SCompilerOptions& options, core::vector<SDependency>* dependencies) const
 {
     auto glslOptions = option_cast(options);
+    glslOptions.preprocessorOptions.dependencies = dependencies;
 
     if (!code)
     {
@@ -17,6 +17,7 @@
 #include <dxc/dxcapi.h>
 
 #include <sstream>
+#include <mutex>
 #include <regex>
 #include <iterator>
 #include <codecvt>
@@ -33,26 +34,76 @@ namespace nbl::asset::impl
 {
 struct DXC 
 {
-    ComPtr<IDxcUtils> m_dxcUtils;
-    ComPtr<IDxcCompiler3> m_dxcCompiler;
+    struct SInstance
+    {
+        ComPtr<IDxcUtils> m_dxcUtils;
+        ComPtr<IDxcCompiler3> m_dxcCompiler;
+    };
+
+    static std::unique_ptr<SInstance> createInstance()
+    {
+        auto instance = std::make_unique<SInstance>();
+        auto res = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(instance->m_dxcUtils.GetAddressOf()));
+        assert(SUCCEEDED(res));
+        res = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(instance->m_dxcCompiler.GetAddressOf()));
+        assert(SUCCEEDED(res));
+        return instance;
+    }
+
+    // DXC objects can't be used by several threads at once, so every compilation in flight takes one for itself
+    // and puts it back when done, which ends up with as many instances as there were threads compiling at the same time
+    std::unique_ptr<SInstance> acquire()
+    {
+        {
+            std::lock_guard lock(m_lock);
+            if (!m_idle.empty())
+            {
+                auto instance = std::move(m_idle.back());
+                m_idle.pop_back();
+                return instance;
+            }
+        }
+        return createInstance();
+    }
+    void release(std::unique_ptr<SInstance>&& instance)
+    {
+        std::lock_guard lock(m_lock);
+        m_idle.push_back(std::move(instance));
+    }
+
+    std::mutex m_lock;
+    core::vector<std::unique_ptr<SInstance>> m_idle;
 };
 }
 
 CHLSLCompiler::CHLSLCompiler(core::smart_refctd_ptr<system::ISystem>&& system)
     : IShaderCompiler(std::move(system))
 {
-    ComPtr<IDxcUtils> utils;
-    auto res = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(utils.GetAddressOf()));
-    assert(SUCCEEDED(res));
+    m_dxcCompilerTypes = new impl::DXC();
+    // create the first instance up front, most compilers never see concurrent use
+    auto instance = impl::DXC::createInstance();
 
-    ComPtr<IDxcCompiler3> compiler;
-    res = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(compiler.GetAddressOf()));
-    assert(SUCCEEDED(res));
+    m_compilerVersion = "DXC";
+    ComPtr<IDxcVersionInfo> versionInfo;
+    if (SUCCEEDED(instance->m_dxcCompiler.As(&versionInfo)))
+    {
+        UINT32 major = 0u, minor = 0u;
+        if (SUCCEEDED(versionInfo->GetVersion(&major,&minor)))
+            m_compilerVersion += " "+std::to_string(major)+"."+std::to_string(minor);
+    }
+    ComPtr<IDxcVersionInfo2> commitInfo;
+    if (SUCCEEDED(instance->m_dxcCompiler.As(&commitInfo)))
+    {
+        UINT32 commitCount = 0u;
+        char* commitHash = nullptr;
+        if (SUCCEEDED(commitInfo->GetCommitInfo(&commitCount,&commitHash)))
+        {
+            m_compilerVersion += " ("+std::to_string(commitCount)+" "+commitHash+")";
+            CoTaskMemFree(commitHash);
+        }
+    }
 
-    m_dxcCompilerTypes = new impl::DXC{
-        utils,
-        compiler
-    };
+    m_dxcCompilerTypes->release(std::move(instance));
 }
 
 CHLSLCompiler::~CHLSLCompiler()
@@ -73,7 +124,7 @@ struct DxcCompilationResult
     }
 };
 
-DxcCompilationResult dxcCompile(const CHLSLCompiler* compiler, nbl::asset::impl::DXC* dxc, std::string& source, LPCWSTR* args, uint32_t argCount, const CHLSLCompiler::SOptions& options)
+DxcCompilationResult dxcCompile(const CHLSLCompiler* compiler, nbl::asset::impl::DXC::SInstance* dxc, std::string& source, LPCWSTR* args, uint32_t argCount, const CHLSLCompiler::SOptions& options)
 {
     // Append Commandline options into source only if debugInfoFlags will emit source
     auto sourceEmittingFlags =
@@ -180,10 +231,11 @@ std::string CHLSLCompiler::preprocessShader(std::string&& code, IShader::E_SHADE
     }
     
     // for debugging cause MSVC doesn't like to show more than 21k LoC in TextVisualizer
-    if constexpr (true)
+    if (m_dumpPreprocessedSource)
     {
+        const system::path sourcePath(preprocessOptions.sourceIdentifier);
         system::ISystem::future_t<core::smart_refctd_ptr<system::IFile>> future;
-        m_system->createFile(future,system::path(preprocessOptions.sourceIdentifier).parent_path()/"preprocessed.hlsl",system::IFileBase::ECF_WRITE);
+        m_system->createFile(future,sourcePath.parent_path()/(sourcePath.filename().string()+".preprocessed.hlsl"),system::IFileBase::ECF_WRITE);
         if (auto file=future.acquire(); file&&bool(*file))
         {
             system::IFile::success_t succ;
@@ -199,9 +251,10 @@ std::string CHLSLCompiler::preprocessShader(std::string&& code, IShader::E_SHADE
 }
 
 
-core::smart_refctd_ptr<ICPUShader> CHLSLCompiler::compileToSPIRV(const char* code, const IShaderCompiler::SCompilerOptions& options) const
+core::smart_refctd_ptr<ICPUShader> CHLSLCompiler::compileToSPIRV_impl(const char* code, const IShaderCompiler::SCompilerOptions& options, core::vector<SDependency>* dependencies) const
 {
     auto hlslOptions = option_cast(options);
+    hlslOptions.preprocessorOptions.dependencies = dependencies;
 
     if (!code)
     {
@@ -292,14 +345,16 @@ core::smart_refctd_ptr<ICPUShader> CHLSLCompiler::compileToSPIRV(const char* cod
     if (hlslOptions.debugInfoFlags.hasFlags(E_DEBUG_INFO_FLAGS::EDIF_NON_SEMANTIC_BIT))
         arguments.push_back(L"-fspv-debug=vulkan-with-source");
 
+    auto dxc = m_dxcCompilerTypes->acquire();
     auto compileResult = dxcCompile(
         this, 
-        m_dxcCompilerTypes, 
+        dxc.get(), 
         newCode,
         &arguments[0],
         arguments.size(),
         hlslOptions
     );
+    m_dxcCompilerTypes->release(std::move(dxc));
 
     if (!compileResult.objectBlob)
     {
@@ -8,8 +8,11 @@
 #include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
+#include <bit>
 
 
+#include "nbl/core/execution.h"
+
 #include "nbl/asset/asset.h"
 #include "nbl/asset/IRenderpassIndependentPipeline.h"
 #include "nbl/asset/utils/CMeshManipulator.h"
@@ -478,6 +481,169 @@ static bool cmpVertices(ICPUMeshBuffer* _inbuf, const void* _va, const void* _vb
     return true;
 }
 
+// Used by createMeshBufferWelded only, runs `_f(begin,end)` over sub-ranges of `[0,_count)` in parallel
+static constexpr uint32_t VertexChunkSize = 4096u;
+template<typename F>
+static void parallelForVertexChunks(const uint32_t _count, F&& _f)
+{
+    constexpr uint32_t ChunkSize = VertexChunkSize;
+    core::vector<uint32_t> chunks((_count+ChunkSize-1u)/ChunkSize);
+    std::iota(chunks.begin(),chunks.end(),0u);
+    std::for_each(core::execution::par_unseq,chunks.begin(),chunks.end(),[&_f,_count](const uint32_t chunk) -> void
+    {
+        const uint32_t begin = chunk*ChunkSize;
+        _f(begin,core::min(begin+ChunkSize,_count));
+    });
+}
+
+// Used by createMeshBufferWelded only
+// Finds the same redirect (lowest other vertex index passing `cmpVertices`) as a brute force search would, but only tests vertices
+// in neighbouring cells of a grid with cells at least as large as the position tolerance.
+// Returns false when the position attribute or its error metric does not allow that (then the caller must brute force).
+static bool weldRedirectsSpatialHash(ICPUMeshBuffer* _inbuf, const uint8_t* _vertices, const size_t _vsize, const uint32_t _vcount, const IMeshManipulator::SErrorMetric* _errMetrics, uint32_t* _redirects)
+{
+    constexpr uint32_t MAX_ATTRIBS = ICPUMeshBuffer::MAX_VERTEX_ATTRIB_COUNT;
+
+    const uint32_t posAttrIx = _inbuf->getPositionAttributeIx();
+    if (posAttrIx>=MAX_ATTRIBS || !_inbuf->isAttributeEnabled(posAttrIx))
+        return false;
+
+    const auto posFormat = _inbuf->getAttribFormat(posAttrIx);
+    const uint32_t cpa = core::min(getFormatChannelCount(posFormat),3u);
+    // integer positions are compared bit-exactly
+    const bool exactCompare = isIntegerFormat(posFormat) || isScaledFormat(posFormat);
+    float cellSize = 0.f;
+    if (!exactCompare)
+    {
+        const auto& metric = _errMetrics[posAttrIx];
+        if (metric.method!=IMeshManipulator::EEM_POSITIONS)
+            return false;
+        for (uint32_t c=0u; c<cpa; c++)
+        {
+            // negative or NaN epsilons make the comparison degenerate
+            if (!(metric.epsilon.pointer[c]>=0.f) || !std::isfinite(metric.epsilon.pointer[c]))
+                return false;
+            cellSize = core::max(cellSize,metric.epsilon.pointer[c]);
+        }
+        // slightly enlarge so rounding in the division can never put two matching vertices more than one cell apart
+        cellSize *= 1.001f;
+    }
+    // with zero tolerance only the exact same position can match, so only look in own cell
+    const bool ownCellOnly = exactCompare || cellSize==0.f;
+
+    size_t posOffset = 0ull;
+    for (uint32_t k=0u; k<posAttrIx; k++)
+    if (_inbuf->isAttributeEnabled(k))
+        posOffset += getTexelOrBlockBytesize(_inbuf->getAttribFormat(k));
+
+    using cell_t = std::array<int64_t,3u>;
+    auto hashCell = [](const cell_t& cell) -> uint64_t
+    {
+        uint64_t h = static_cast<uint64_t>(cell[0])*0x9E3779B97F4A7C15ull;
+        h ^= static_cast<uint64_t>(cell[1])*0xC2B2AE3D27D4EB4Full;
+        h ^= static_cast<uint64_t>(cell[2])*0x165667B19E3779F9ull;
+        return h^(h>>29u);
+    };
+
+    // quantize
+    core::vector<cell_t> cells(_vcount);
+    core::vector<std::pair<uint64_t,uint32_t>> grid(_vcount);
+    core::vector<uint8_t> chunkInvalid((_vcount+VertexChunkSize-1u)/VertexChunkSize,0u);
+    parallelForVertexChunks(_vcount,[&](const uint32_t begin, const uint32_t end) -> void
+    {
+        for (uint32_t i=begin; i<end; i++)
+        {
+            const uint8_t* posPtr = _vertices+_vsize*i+posOffset;
+            cell_t& cell = cells[i];
+            cell = {0,0,0};
+            if (exactCompare)
+            {
+                uint32_t attr[4];
+                ICPUMeshBuffer::getAttribute(attr,posPtr,posFormat);
+                for (uint32_t c=0u; c<cpa; c++)
+                    cell[c] = attr[c];
+            }
+            else
+            {
+                core::vectorSIMDf pos;
+                ICPUMeshBuffer::getAttribute(pos,posPtr,posFormat);
+                for (uint32_t c=0u; c<cpa; c++)
+                {
+                    const float p = pos.pointer[c];
+                    // NaNs and infinities don't obey the triangle inequality, cannot bucket them
+                    if (!std::isfinite(p))
+                    {
+                        chunkInvalid[begin/VertexChunkSize] = 1u;
+                        continue;
+                    }
+                    if (ownCellOnly)
+                    {
+                        const float noNegZero = p==0.f ? 0.f:p;
+                        cell[c] = std::bit_cast<uint32_t>(noNegZero);
+                    }
+                    else
+                    {
+                        // a tiny epsilon next to huge coordinates would overflow the cast, such vertices just share the outermost cell
+                        // (their neighbours stay representable) and still get compared exactly
+                        constexpr double MaxCell = static_cast<double>(1ull<<62);
+                        const double quotient = std::floor(static_cast<double>(p)/static_cast<double>(cellSize));
+                        cell[c] = static_cast<int64_t>(quotient<-MaxCell ? -MaxCell:(quotient>MaxCell ? MaxCell:quotient));
+                    }
+                }
+            }
+            grid[i] = {hashCell(cell),i};
+        }
+    });
+    if (std::find(chunkInvalid.begin(),chunkInvalid.end(),1u)!=chunkInvalid.end())
+        return false;
+
+    // bucketize, within a cell the vertices stay sorted by index so we can stop at the first match
+    std::sort(core::execution::par_unseq,grid.begin(),grid.end());
+    core::unordered_map<uint64_t,std::pair<uint32_t,uint32_t>> cellRanges;
+    cellRanges.reserve(_vcount);
+    for (uint32_t begin=0u; begin<_vcount; )
+    {
+        uint32_t end = begin+1u;
+        while (end<_vcount && grid[end].first==grid[begin].first)
+            end++;
+        cellRanges.emplace(grid[begin].first,std::pair<uint32_t,uint32_t>(begin,end));
+        begin = end;
+    }
+
+    const int64_t radius = ownCellOnly ? 0:1;
+    parallelForVertexChunks(_vcount,[&](const uint32_t begin, const uint32_t end) -> void
+    {
+        for (uint32_t i=begin; i<end; i++)
+        {
+            const uint8_t* vertex = _vertices+_vsize*i;
+            uint32_t redir = ~0u;
+            for (int64_t dz=-radius; dz<=radius; dz++)
+            for (int64_t dy=-radius; dy<=radius; dy++)
+            for (int64_t dx=-radius; dx<=radius; dx++)
+            {
+                const cell_t neighbour = {cells[i][0]+dx,cells[i][1]+dy,cells[i][2]+dz};
+                const auto found = cellRanges.find(hashCell(neighbour));
+                if (found==cellRanges.end())
+                    continue;
+                // hash collisions only add extra candidates, the real comparison weeds them out
+                for (uint32_t e=found->second.first; e<found->second.second; e++)
+                {
+                    const uint32_t j = grid[e].second;
+                    if (j>=redir)
+                        break;
+                    if (j!=i && cmpVertices(_inbuf,vertex,_vertices+_vsize*j,_vsize,_errMetrics))
+                    {
+                        redir = j;
+                        break;
+                    }
+                }
+            }
+            _redirects[i] = redir!=~0u ? redir:i;
+        }
+    });
+    return true;
+}
+
 //! Creates a copy of a mesh, which will have identical vertices welded together
 core::smart_refctd_ptr<ICPUMeshBuffer> IMeshManipulator::createMeshBufferWelded(ICPUMeshBuffer *inbuffer, const SErrorMetric* _errMetrics, const bool& optimIndexType, const bool& makeNewMesh)
 {
@@ -518,41 +684,47 @@ core::smart_refctd_ptr<ICPUMeshBuffer> IMeshManipulator::createMeshBufferWelded(
     uint32_t maxRedirect = 0;
 
     uint8_t* epicData = (uint8_t*)_NBL_ALIGNED_MALLOC(vertexSize*vertexCount,_NBL_SIMD_ALIGNMENT);
-    for (auto i=0u; i<vertexCount; i++)
+    parallelForVertexChunks(vertexCount,[&](const uint32_t begin, const uint32_t end) -> void
     {
-        uint8_t* currentVertexPtr = epicData+i*vertexSize;
-        for (size_t k=0; k<MAX_ATTRIBS; k++)
+        for (auto i=begin; i<end; i++)
         {
-            if (!bufferPresent[k])
-                continue;
+            uint8_t* currentVertexPtr = epicData+i*vertexSize;
+            for (size_t k=0; k<MAX_ATTRIBS; k++)
+            {
+                if (!bufferPresent[k])
+                    continue;
 
-            size_t stride = inbuffer->getAttribStride(k);
-            uint8_t* sourcePtr = inbuffer->getAttribPointer(k) + i*stride;
-            memcpy(currentVertexPtr,sourcePtr,vertexAttrSize[k]);
-            currentVertexPtr += vertexAttrSize[k];
+                size_t stride = inbuffer->getAttribStride(k);
+                uint8_t* sourcePtr = inbuffer->getAttribPointer(k) + i*stride;
+                memcpy(currentVertexPtr,sourcePtr,vertexAttrSize[k]);
+                currentVertexPtr += vertexAttrSize[k];
+            }
         }
-    }
+    });
 
-    for (auto i=0u; i<vertexCount; i++)
+    if (!weldRedirectsSpatialHash(inbuffer,epicData,vertexSize,vertexCount,_errMetrics,redirects))
+    parallelForVertexChunks(vertexCount,[&](const uint32_t begin, const uint32_t end) -> void
     {
-        uint32_t redir = i;
-        for (auto j=0u; j<vertexCount; ++j) // TODO: Use spatial hash for this like in the smooth normal computation @Przemog
+        for (auto i=begin; i<end; i++)
         {
-            if (i == j)
-                continue;
-            if (cmpfunc(epicData+vertexSize*i, epicData+vertexSize*j))
+            uint32_t redir = i;
+            for (auto j=0u; j<vertexCount; ++j)
             {
-                redir = j;
-                break;
+                if (i == j)
+                    continue;
+                if (cmpfunc(epicData+vertexSize*i, epicData+vertexSize*j))
+                {
+                    redir = j;
+                    break;
+                }
             }
+            redirects[i] = redir;
         }
-
-        redirects[i] = redir;
-        if (redir>maxRedirect)
-            maxRedirect = redir;
-    }
+    });
     _NBL_ALIGNED_FREE(epicData);
 
+    maxRedirect = *std::max_element(redirects,redirects+vertexCount);
+
     void* oldIndices = inbuffer->getIndices();
     core::smart_refctd_ptr<ICPUMeshBuffer> clone;
     if (makeNewMesh)
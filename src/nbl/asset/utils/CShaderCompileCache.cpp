@@ -0,0 +1,339 @@
+// Copyright (C) 2018-2022 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+#include "nbl/asset/utils/CShaderCompileCache.h"
+
+#include "nbl/core/xxHash256.h"
+
+using namespace nbl;
+using namespace nbl::asset;
+
+namespace
+{
+using hash_t = CShaderCompileCache::hash_t;
+
+constexpr uint32_t FileMagic = 0x4343534eu; // "NSCC"
+constexpr uint32_t FileVersion = 2u;
+
+struct SFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	// SPIRV-Tools legalize and validate the output of every compiler, when they change nothing in the file is worth keeping
+	hash_t toolsVersion;
+	uint64_t entryCount;
+};
+
+hash_t getToolsVersionHash()
+{
+	const std::string_view version = ISPIRVOptimizer::getToolsVersion();
+	hash_t retval;
+	core::XXHash_256(version.data(),version.size(),retval.data());
+	return retval;
+}
+// sorted by key, follows the header
+struct SIndexEntry
+{
+	hash_t key;
+	uint64_t offset;
+	uint64_t size;
+};
+// every entry starts with this, then come the dependencies, then the SPIR-V
+struct SEntryHeader
+{
+	uint32_t dependencyCount;
+	uint32_t stage;
+	uint64_t spirvSize;
+};
+// followed by the requesting directory and the identifier, not null terminated
+struct SDependencyHeader
+{
+	hash_t hash;
+	uint32_t dirLength;
+	uint32_t identifierLength;
+	uint32_t standardInclude;
+	uint32_t padding;
+};
+
+template<typename T>
+inline bool readPOD(T& out, const uint8_t*& it, const uint8_t* const end)
+{
+	if (static_cast<size_t>(end-it)<sizeof(T))
+		return false;
+	memcpy(&out,it,sizeof(T));
+	it += sizeof(T);
+	return true;
+}
+template<typename T>
+inline void writePOD(const T& in, uint8_t*& it)
+{
+	memcpy(it,&in,sizeof(T));
+	it += sizeof(T);
+}
+
+core::smart_refctd_ptr<ICPUBuffer> serializeEntry(const core::vector<IShaderCompiler::SDependency>& dependencies, const ICPUShader* spirv)
+{
+	const auto* content = spirv->getContent();
+
+	size_t size = sizeof(SEntryHeader)+content->getSize();
+	for (const auto& dep : dependencies)
+		size += sizeof(SDependencyHeader)+dep.requestingSourceDir.string().size()+dep.identifier.size();
+
+	auto retval = core::make_smart_refctd_ptr<ICPUBuffer>(size);
+	auto* out = reinterpret_cast<uint8_t*>(retval->getPointer());
+	writePOD(SEntryHeader{static_cast<uint32_t>(dependencies.size()),static_cast<uint32_t>(spirv->getStage()),content->getSize()},out);
+	for (const auto& dep : dependencies)
+	{
+		const auto dir = dep.requestingSourceDir.string();
+		writePOD(SDependencyHeader{dep.hash,static_cast<uint32_t>(dir.size()),static_cast<uint32_t>(dep.identifier.size()),dep.standardInclude,0u},out);
+		memcpy(out,dir.data(),dir.size());
+		out += dir.size();
+		memcpy(out,dep.identifier.data(),dep.identifier.size());
+		out += dep.identifier.size();
+	}
+	memcpy(out,content->getPointer(),content->getSize());
+	return retval;
+}
+
+core::smart_refctd_ptr<ICPUShader> deserializeEntry(const uint8_t* data, const size_t size, const IShaderCompiler::CIncludeFinder* includeFinder, std::string&& filepathHint)
+{
+	const uint8_t* it = data;
+	const uint8_t* const end = data+size;
+
+	SEntryHeader header;
+	if (!readPOD(header,it,end))
+		return nullptr;
+	if (header.dependencyCount && !includeFinder)
+		return nullptr;
+
+	core::vector<IShaderCompiler::SDependency> resolved;
+	for (uint32_t i=0u; i<header.dependencyCount; i++)
+	{
+		SDependencyHeader dep;
+		if (!readPOD(dep,it,end) || static_cast<size_t>(end-it)<size_t(dep.dirLength)+dep.identifierLength)
+			return nullptr;
+		const std::string dir(reinterpret_cast<const char*>(it),dep.dirLength);
+		it += dep.dirLength;
+		const std::string identifier(reinterpret_cast<const char*>(it),dep.identifierLength);
+		it += dep.identifierLength;
+
+		resolved.clear();
+		if (!includeFinder->getInclude(dir,identifier,dep.standardInclude,&resolved) || resolved.back().hash!=dep.hash)
+			return nullptr;
+	}
+
+	if (static_cast<size_t>(end-it)!=header.spirvSize)
+		return nullptr;
+	auto spirv = core::make_smart_refctd_ptr<ICPUBuffer>(header.spirvSize);
+	memcpy(spirv->getPointer(),it,header.spirvSize);
+	return core::make_smart_refctd_ptr<ICPUShader>(std::move(spirv),static_cast<IShader::E_SHADER_STAGE>(header.stage),IShader::E_CONTENT_TYPE::ECT_SPIRV,std::move(filepathHint));
+}
+}
+
+core::smart_refctd_ptr<CShaderCompileCache> CShaderCompileCache::create(core::smart_refctd_ptr<system::ISystem>&& system, system::path&& path, system::logger_opt_smart_ptr&& logger)
+{
+	if (!system || path.empty())
+		return nullptr;
+
+	auto retval = core::smart_refctd_ptr<CShaderCompileCache>(new CShaderCompileCache(std::move(system),std::move(path),std::move(logger)),core::dont_grab);
+	retval->m_snapshot = retval->load();
+	return retval;
+}
+
+CShaderCompileCache::~CShaderCompileCache()
+{
+	flush();
+}
+
+auto CShaderCompileCache::load() const -> SSnapshot
+{
+	core::smart_refctd_ptr<system::IFile> file;
+	{
+		system::ISystem::future_t<core::smart_refctd_ptr<system::IFile>> future;
+		m_system->createFile(future,m_path,core::bitflag<system::IFileBase::E_CREATE_FLAGS>(system::IFileBase::ECF_READ)|system::IFileBase::ECF_MAPPABLE);
+		if (!future.wait())
+			return {};
+		future.acquire().move_into(file);
+	}
+	if (!file)
+		return {};
+
+	SSnapshot retval;
+	retval.size = file->getSize();
+	if (const auto* mapped=reinterpret_cast<const uint8_t*>(static_cast<const system::IFile*>(file.get())->getMappedPointer()))
+	{
+		retval.data = mapped;
+		retval.file = std::move(file);
+	}
+	else
+	{
+		auto contents = core::make_smart_refctd_ptr<ICPUBuffer>(retval.size);
+		system::IFile::success_t succ;
+		file->read(succ,contents->getPointer(),0,retval.size);
+		if (!succ)
+		{
+			m_logger.log("Could not read Shader Compile Cache \"%s\", starting with an empty one.",system::ILogger::ELL_WARNING,m_path.string().c_str());
+			return {};
+		}
+		retval.data = reinterpret_cast<const uint8_t*>(contents->getPointer());
+		retval.buffer = std::move(contents);
+	}
+
+	SFileHeader header;
+	const uint8_t* it = retval.data;
+	if (!readPOD(header,it,retval.data+retval.size) || header.magic!=FileMagic || header.version!=FileVersion || header.toolsVersion!=getToolsVersionHash() ||
+		(retval.size-sizeof(SFileHeader))/sizeof(SIndexEntry)<header.entryCount)
+	{
+		m_logger.log("Shader Compile Cache \"%s\" is corrupt or from a different version of Nabla or SPIRV-Tools, starting with an empty one.",system::ILogger::ELL_WARNING,m_path.string().c_str());
+		return {};
+	}
+	return retval;
+}
+
+namespace
+{
+std::span<const SIndexEntry> getIndex(const uint8_t* data)
+{
+	if (!data)
+		return {};
+	return {reinterpret_cast<const SIndexEntry*>(data+sizeof(SFileHeader)),reinterpret_cast<const SFileHeader*>(data)->entryCount};
+}
+}
+
+core::smart_refctd_ptr<ICPUShader> CShaderCompileCache::find(const hash_t& key, const IShaderCompiler::CIncludeFinder* includeFinder, std::string&& filepathHint) const
+{
+	// grab references under the lock, but do the slow part (resolving includes) without it
+	core::smart_refctd_ptr<ICPUBuffer> inserted;
+	SSnapshot snapshot;
+	{
+		std::lock_guard lock(m_lock);
+		if (auto found=m_inserted.find(key); found!=m_inserted.end())
+			inserted = found->second;
+		else
+			snapshot = m_snapshot;
+	}
+	if (inserted)
+		return deserializeEntry(reinterpret_cast<const uint8_t*>(inserted->getPointer()),inserted->getSize(),includeFinder,std::move(filepathHint));
+
+	const auto index = getIndex(snapshot.data);
+	auto found = std::lower_bound(index.begin(),index.end(),key,[](const SIndexEntry& entry, const hash_t& _key)->bool{return entry.key<_key;});
+	if (found==index.end() || found->key!=key || found->offset>snapshot.size || snapshot.size-found->offset<found->size)
+		return nullptr;
+	return deserializeEntry(snapshot.data+found->offset,found->size,includeFinder,std::move(filepathHint));
+}
+
+void CShaderCompileCache::insert(const hash_t& key, core::vector<IShaderCompiler::SDependency>&& dependencies, const ICPUShader* spirv)
+{
+	if (!spirv || spirv->getContentType()!=IShader::E_CONTENT_TYPE::ECT_SPIRV)
+		return;
+
+	// headers with include guards get resolved every time they're included, one check on lookup is enough
+	auto comp = [](const IShaderCompiler::SDependency& lhs, const IShaderCompiler::SDependency& rhs)
+	{
+		return std::tie(lhs.standardInclude,lhs.requestingSourceDir,lhs.identifier)<std::tie(rhs.standardInclude,rhs.requestingSourceDir,rhs.identifier);
+	};
+	std::sort(dependencies.begin(),dependencies.end(),comp);
+	dependencies.erase(std::unique(dependencies.begin(),dependencies.end(),[&comp](const auto& lhs, const auto& rhs){return !comp(lhs,rhs)&&!comp(rhs,lhs);}),dependencies.end());
+
+	auto entry = serializeEntry(dependencies,spirv);
+	std::lock_guard lock(m_lock);
+	m_inserted[key] = std::move(entry);
+}
+
+bool CShaderCompileCache::flush()
+{
+	// one flush at a time, otherwise they'd race each other to replace the file and each could drop what the other wrote
+	std::lock_guard flushLock(m_flushLock);
+	decltype(m_inserted) inserted;
+	SSnapshot snapshot;
+	{
+		std::lock_guard lock(m_lock);
+		if (m_inserted.empty())
+			return true;
+		inserted = m_inserted;
+		snapshot = m_snapshot;
+	}
+
+	// merge the old and new entries, new ones win
+	struct SEntry
+	{
+		hash_t key;
+		const uint8_t* data;
+		size_t size;
+	};
+	core::vector<SEntry> entries;
+	entries.reserve(inserted.size()+getIndex(snapshot.data).size());
+	for (const auto& entry : getIndex(snapshot.data))
+	if (!inserted.contains(entry.key) && entry.offset<=snapshot.size && snapshot.size-entry.offset>=entry.size)
+		entries.push_back({entry.key,snapshot.data+entry.offset,entry.size});
+	for (const auto& entry : inserted)
+		entries.push_back({entry.first,reinterpret_cast<const uint8_t*>(entry.second->getPointer()),entry.second->getSize()});
+	std::sort(entries.begin(),entries.end(),[](const SEntry& lhs, const SEntry& rhs)->bool{return lhs.key<rhs.key;});
+
+	size_t size = sizeof(SFileHeader)+sizeof(SIndexEntry)*entries.size();
+	for (const auto& entry : entries)
+		size += entry.size;
+	core::vector<uint8_t> contents(size);
+	{
+		uint8_t* out = contents.data();
+		writePOD(SFileHeader{FileMagic,FileVersion,getToolsVersionHash(),entries.size()},out);
+		uint64_t offset = sizeof(SFileHeader)+sizeof(SIndexEntry)*entries.size();
+		for (const auto& entry : entries)
+		{
+			writePOD(SIndexEntry{entry.key,offset,entry.size},out);
+			offset += entry.size;
+		}
+		for (const auto& entry : entries)
+		{
+			memcpy(out,entry.data,entry.size);
+			out += entry.size;
+		}
+	}
+	entries.clear();
+	// can't replace a file which is still mapped on some platforms
+	snapshot = {};
+
+	const system::path tmpPath = system::ISystem::getUniqueTemporaryPath(m_path);
+	auto removeTmp = [&tmpPath]() -> void
+	{
+		std::error_code error;
+		std::filesystem::remove(tmpPath,error);
+	};
+	{
+		core::smart_refctd_ptr<system::IFile> file;
+		{
+			system::ISystem::future_t<core::smart_refctd_ptr<system::IFile>> future;
+			m_system->createFile(future,tmpPath,system::IFileBase::ECF_WRITE);
+			if (future.wait())
+				future.acquire().move_into(file);
+		}
+		system::IFile::success_t succ;
+		if (file)
+			file->write(succ,contents.data(),0,contents.size());
+		if (!file || !succ)
+		{
+			m_logger.log("Could not write Shader Compile Cache to \"%s\".",system::ILogger::ELL_ERROR,tmpPath.string().c_str());
+			file = nullptr;
+			removeTmp();
+			return false;
+		}
+	}
+
+	std::lock_guard lock(m_lock);
+	m_snapshot = {};
+	const auto error = m_system->moveFileOrDirectory(tmpPath,m_path);
+	if (error)
+	{
+		m_logger.log("Could not replace Shader Compile Cache \"%s\": %s",system::ILogger::ELL_ERROR,m_path.string().c_str(),error.message().c_str());
+		removeTmp();
+	}
+	else for (const auto& entry : inserted)
+	{
+		// leave anything inserted or replaced while we were writing for the next flush
+		auto found = m_inserted.find(entry.first);
+		if (found!=m_inserted.end() && found->second==entry.second)
+			m_inserted.erase(found);
+	}
+	m_snapshot = load();
+	return !error;
+}
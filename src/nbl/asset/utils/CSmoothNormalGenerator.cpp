@@ -3,32 +3,38 @@
 // For conditions of distribution and use, see copyright notice in nabla.h
 
 #include "nbl/core/declarations.h"
+#include "nbl/core/execution.h"
 
 #include "CSmoothNormalGenerator.h"
 
 #include <iostream>
 #include <algorithm>
 #include <array>
+#include <numeric>
+#include <atomic>
 
 namespace nbl
 {
 namespace asset
 {
 
-static inline bool operator<(uint32_t lhs, const IMeshManipulator::SSNGVertexData& rhs)
+namespace
 {
-	return lhs < rhs.hash;
-}
+constexpr uint32_t TriangleChunkSize = 4096u;
+constexpr uint32_t VertexChunkSize = 4096u;
 
-static inline bool operator<(const IMeshManipulator::SSNGVertexData& lhs, uint32_t rhs)
+// runs `f(begin,end)` over consecutive ranges of `count` in parallel
+template<typename F>
+inline void parallelForChunks(const uint32_t count, const uint32_t chunkSize, F&& f)
 {
-	return lhs.hash < rhs;
+	core::vector<uint32_t> chunks((count+chunkSize-1u)/chunkSize);
+	std::iota(chunks.begin(),chunks.end(),0u);
+	std::for_each(core::execution::par_unseq,chunks.begin(),chunks.end(),[&f,count,chunkSize](const uint32_t chunk) -> void
+	{
+		const uint32_t begin = chunk*chunkSize;
+		f(begin,core::min(begin+chunkSize,count));
+	});
 }
-
-static inline bool compareVertexPosition(const core::vectorSIMDf& a, const core::vectorSIMDf& b, float epsilon)
-{
-	const core::vectorSIMDf difference = core::abs(b - a);
-	return (difference.x <= epsilon && difference.y <= epsilon && difference.z <= epsilon);
 }
 
 static inline core::vector3df_SIMD getAngleWeight(const core::vector3df_SIMD & v1,
@@ -54,108 +60,91 @@ static inline core::vector3df_SIMD getAngleWeight(const core::vector3df_SIMD & v
 core::smart_refctd_ptr<asset::ICPUMeshBuffer> nbl::asset::CSmoothNormalGenerator::calculateNormals(asset::ICPUMeshBuffer * buffer, float epsilon, uint32_t normalAttrID, IMeshManipulator::VxCmpFunction vxcmp)
 {
 	VertexHashMap vertexArray = setupData(buffer, epsilon);
-	processConnectedVertices(buffer, vertexArray, epsilon, normalAttrID, vxcmp);
+	processConnectedVertices(buffer, vertexArray, normalAttrID, vxcmp);
 
 	return core::smart_refctd_ptr<asset::ICPUMeshBuffer>(buffer);
 }
 
-CSmoothNormalGenerator::VertexHashMap::VertexHashMap(size_t _vertexCount, uint32_t _hashTableMaxSize, float _cellSize)
+CSmoothNormalGenerator::VertexHashMap::VertexHashMap(size_t _vertexCount, uint32_t _hashTableMaxSize, float _epsilon)
 	:hashTableMaxSize(_hashTableMaxSize),
-	cellSize(_cellSize)
+	epsilon(_epsilon),
+	cellSize(_epsilon == 0.0f ? 0.00001f : _epsilon * 2.00002f)
 {
 	assert((core::isPoT(hashTableMaxSize)));
 
-	vertices.reserve(_vertexCount);
-	buckets.reserve(_hashTableMaxSize + 1);
+	vertices.resize(_vertexCount);
 }
 
-uint32_t CSmoothNormalGenerator::VertexHashMap::hash(const IMeshManipulator::SSNGVertexData & vertex) const
+uint32_t CSmoothNormalGenerator::VertexHashMap::hash(const cell_t& cell) const
 {
 	static constexpr uint32_t primeNumber1 = 73856093;
 	static constexpr uint32_t primeNumber2 = 19349663;
 	static constexpr uint32_t primeNumber3 = 83492791;
 
-	const core::vector3df_SIMD position = vertex.position / cellSize;
-
-	return	((static_cast<uint32_t>(position.x) * primeNumber1) ^
-		(static_cast<uint32_t>(position.y) * primeNumber2) ^
-		(static_cast<uint32_t>(position.z) * primeNumber3))& (hashTableMaxSize - 1);
-}
-
-uint32_t CSmoothNormalGenerator::VertexHashMap::hash(const core::vector3du32_SIMD & position) const
-{
-	static constexpr uint32_t primeNumber1 = 73856093;
-	static constexpr uint32_t primeNumber2 = 19349663;
-	static constexpr uint32_t primeNumber3 = 83492791;
-
-	return	((position.x * primeNumber1) ^
-		(position.y * primeNumber2) ^
-		(position.z * primeNumber3))& (hashTableMaxSize - 1);
-}
-
-void CSmoothNormalGenerator::VertexHashMap::add(IMeshManipulator::SSNGVertexData && vertex)
-{
-	vertex.hash = hash(vertex);
-	vertices.push_back(vertex);
+	return	((static_cast<uint32_t>(cell[0]) * primeNumber1) ^
+		(static_cast<uint32_t>(cell[1]) * primeNumber2) ^
+		(static_cast<uint32_t>(cell[2]) * primeNumber3))& (hashTableMaxSize - 1);
 }
 
-CSmoothNormalGenerator::VertexHashMap::BucketBounds CSmoothNormalGenerator::VertexHashMap::getBucketBoundsByHash(uint32_t hash)
+void CSmoothNormalGenerator::VertexHashMap::validate()
 {
-	if (hash == invalidHash)
-		return { vertices.end(), vertices.end() };
+	const uint32_t vertexCount = getVertexCount();
 
-	core::vector<IMeshManipulator::SSNGVertexData>::iterator begin = std::lower_bound(vertices.begin(), vertices.end(), hash);
-	core::vector<IMeshManipulator::SSNGVertexData>::iterator end = std::upper_bound(vertices.begin(), vertices.end(), hash);
+	// counting sort, histogram
+	core::vector<std::atomic_uint32_t> cursors(hashTableMaxSize);
+	parallelForChunks(vertexCount, VertexChunkSize, [&](const uint32_t begin, const uint32_t end) -> void
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			vertices[i].hash = hash(getCell(vertices[i].position));
+			cursors[vertices[i].hash].fetch_add(1u, std::memory_order_relaxed);
+		}
+	});
+	bucketBegin.resize(hashTableMaxSize + 1u);
+	bucketBegin[0] = 0u;
+	for (uint32_t b = 0u; b < hashTableMaxSize; b++)
+	{
+		bucketBegin[b + 1u] = bucketBegin[b] + cursors[b].load(std::memory_order_relaxed);
+		cursors[b].store(bucketBegin[b], std::memory_order_relaxed);
+	}
 
-	//bucket missing
-	if (begin == vertices.end())
-		return { vertices.end(), vertices.end() };
+	// scatter
+	sortedIndices.resize(vertexCount);
+	parallelForChunks(vertexCount, VertexChunkSize, [&](const uint32_t begin, const uint32_t end) -> void
+	{
+		for (uint32_t i = begin; i < end; i++)
+			sortedIndices[cursors[vertices[i].hash].fetch_add(1u, std::memory_order_relaxed)] = i;
+	});
 
-	//bucket missing
-	if (begin->hash != hash)
-		return { vertices.end(), vertices.end() };
+	// the scatter order within a bucket depends on thread timing, restore the order of vertices so normals come out the same every time
+	parallelForChunks(hashTableMaxSize, VertexChunkSize, [&](const uint32_t begin, const uint32_t end) -> void
+	{
+		for (uint32_t b = begin; b < end; b++)
+			std::sort(sortedIndices.begin() + bucketBegin[b], sortedIndices.begin() + bucketBegin[b + 1u]);
+	});
 
-	return { begin, end };
+	for (auto& component : positions)
+		component.resize(vertexCount + 3u, 0.f);
+	parallelForChunks(vertexCount, VertexChunkSize, [&](const uint32_t begin, const uint32_t end) -> void
+	{
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const auto& position = vertices[sortedIndices[i]].position;
+			for (uint32_t c = 0u; c < 3u; c++)
+				positions[c][i] = position[c];
+		}
+	});
 }
 
-struct KeyAccessor
+uint32_t CSmoothNormalGenerator::VertexHashMap::matchPositions4(const core::vectorSIMDf& position, uint32_t first) const
 {
-	_NBL_STATIC_INLINE_CONSTEXPR size_t key_bit_count = 32ull;
-
-	template<auto bit_offset, auto radix_mask>
-	inline decltype(radix_mask) operator()(const IMeshManipulator::SSNGVertexData& item) const
+	const core::vectorSIMDf eps(epsilon);
+	auto matchComponent = [&](const uint32_t c) -> core::vector4db_SIMD
 	{
-		return static_cast<decltype(radix_mask)>(item.hash>>static_cast<uint32_t>(bit_offset))&radix_mask;
-	}
-};
-void CSmoothNormalGenerator::VertexHashMap::validate()
-{
-	const auto oldSize = vertices.size();
-	vertices.resize(oldSize*2u);
-	// TODO: maybe use counting sort (or big radix) and use the histogram directly for the buckets
-	auto finalSortedOutput = core::radix_sort(vertices.data(),vertices.data()+oldSize,oldSize,KeyAccessor());
-	// TODO: optimize out the erase
-	if (finalSortedOutput!=vertices.data())
-		vertices.erase(vertices.begin(),vertices.begin()+oldSize);
-	else
-		vertices.erase(vertices.begin()+oldSize,vertices.end());
-
-	// TODO: are `buckets` even begin USED!?
-	uint16_t prevHash = vertices[0].hash;
-	core::vector<IMeshManipulator::SSNGVertexData>::iterator prevBegin = vertices.begin();
-	buckets.push_back(prevBegin);
-
-	while (true)
-	{
-		core::vector<IMeshManipulator::SSNGVertexData>::iterator next = std::upper_bound(prevBegin, vertices.end(), prevHash);
-		buckets.push_back(next);
-
-		if (next == vertices.end())
-			break;
-
-		prevBegin = next;
-		prevHash = next->hash;
-	}
+		return core::abs(core::vectorSIMDf(positions[c].data() + first) - core::vectorSIMDf(position[c])) <= eps;
+	};
+	const core::vector4db_SIMD match = matchComponent(0u) & matchComponent(1u) & matchComponent(2u);
+	return static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(match.getAsRegister())));
 }
 
 CSmoothNormalGenerator::VertexHashMap CSmoothNormalGenerator::setupData(const asset::ICPUMeshBuffer* buffer, float epsilon)
@@ -163,116 +152,99 @@ CSmoothNormalGenerator::VertexHashMap CSmoothNormalGenerator::setupData(const as
 	const size_t idxCount = buffer->getIndexCount();
 	_NBL_DEBUG_BREAK_IF((idxCount % 3));
 
-	VertexHashMap vertices(idxCount, std::min(16u * 1024u, core::roundUpToPoT<unsigned int>(idxCount * 1.0f / 32.0f)), epsilon == 0.0f ? 0.00001f : epsilon * 1.00001f);
-
-	core::vector3df_SIMD faceNormal;
+	// aim for less than one distinct position per bucket, a position is usually shared by around 6 triangles
+	VertexHashMap vertices(idxCount, core::min(0x1u << 24u, core::roundUpToPoT<uint32_t>(core::max<uint32_t>(idxCount / 4u, 1u))), epsilon);
 
-	for (uint32_t i = 0; i < idxCount; i += 3)
+	auto& vertexData = vertices.getVertices();
+	parallelForChunks(idxCount / 3u, TriangleChunkSize, [&](const uint32_t begin, const uint32_t end) -> void
 	{
-		const uint32_t ix[3]{
-			buffer->getIndexValue(i),
-			buffer->getIndexValue(i + 1),
-			buffer->getIndexValue(i + 2)
-		};
-		//calculate face normal of parent triangle
-		core::vectorSIMDf v1 = buffer->getPosition(ix[0]);
-		core::vectorSIMDf v2 = buffer->getPosition(ix[1]);
-		core::vectorSIMDf v3 = buffer->getPosition(ix[2]);
-
-		faceNormal = core::cross(v2 - v1, v3 - v1);
-		faceNormal = core::normalize(faceNormal);
-
-		//set data for vertices
-		core::vector3df_SIMD angleWages = getAngleWeight(v1, v2, v3);
-
-		vertices.add({ i,		0,	angleWages.x,	v1,		faceNormal });
-		vertices.add({ i + 1,	0,	angleWages.y,	v2,		faceNormal });
-		vertices.add({ i + 2,	0,	angleWages.z,	v3,		faceNormal });
-	}
+		for (uint32_t i = begin * 3u; i < end * 3u; i += 3)
+		{
+			const uint32_t ix[3]{
+				buffer->getIndexValue(i),
+				buffer->getIndexValue(i + 1),
+				buffer->getIndexValue(i + 2)
+			};
+			//calculate face normal of parent triangle
+			core::vectorSIMDf v1 = buffer->getPosition(ix[0]);
+			core::vectorSIMDf v2 = buffer->getPosition(ix[1]);
+			core::vectorSIMDf v3 = buffer->getPosition(ix[2]);
+
+			core::vector3df_SIMD faceNormal = core::cross(v2 - v1, v3 - v1);
+			faceNormal = core::normalize(faceNormal);
+
+			//set data for vertices
+			core::vector3df_SIMD angleWages = getAngleWeight(v1, v2, v3);
+
+			vertexData[i] = { i,		0,	angleWages.x,	v1,		faceNormal };
+			vertexData[i + 1] = { i + 1,	0,	angleWages.y,	v2,		faceNormal };
+			vertexData[i + 2] = { i + 2,	0,	angleWages.z,	v3,		faceNormal };
+		}
+	});
 
 	vertices.validate();
 
 	return vertices;
 }
 
-void CSmoothNormalGenerator::processConnectedVertices(asset::ICPUMeshBuffer * buffer, VertexHashMap & vertexHashMap, float epsilon, uint32_t normalAttrID, IMeshManipulator::VxCmpFunction vxcmp)
+void CSmoothNormalGenerator::processConnectedVertices(asset::ICPUMeshBuffer * buffer, const VertexHashMap & vertexHashMap, uint32_t normalAttrID, const IMeshManipulator::VxCmpFunction& vxcmp)
 {
-	for (uint32_t cell = 0; cell < vertexHashMap.getBucketCount() - 1; cell++)
+	// every vertex gathers its own normal, so nothing gets written from two threads (the mesh has unique primitives)
+	parallelForChunks(vertexHashMap.getVertexCount(), VertexChunkSize, [&](const uint32_t begin, const uint32_t end) -> void
 	{
-		VertexHashMap::BucketBounds processedBucket = vertexHashMap.getBucketBoundsById(cell);
-
-		for (core::vector<IMeshManipulator::SSNGVertexData>::iterator processedVertex = processedBucket.begin; processedVertex != processedBucket.end; processedVertex++)
+		for (uint32_t processed = begin; processed < end; processed++)
 		{
-			std::array<uint32_t, 8> neighboringCells = vertexHashMap.getNeighboringCellHashes(*processedVertex);
-			core::vector3df_SIMD normal = processedVertex->parentTriangleFaceNormal * processedVertex->wage;
+			const IMeshManipulator::SSNGVertexData& processedVertex = vertexHashMap.getSortedVertex(processed);
+			const std::array<uint32_t, 8> neighboringCells = vertexHashMap.getNeighboringCellHashes(processedVertex);
+			core::vector3df_SIMD normal = processedVertex.parentTriangleFaceNormal * processedVertex.wage;
 
 			//iterate among all neighboring cells
 			for (int i = 0; i < 8; i++)
 			{
-				VertexHashMap::BucketBounds bounds = vertexHashMap.getBucketBoundsByHash(neighboringCells[i]);
-				for (; bounds.begin != bounds.end; bounds.begin++)
+				const auto bounds = vertexHashMap.getBucketBoundsByHash(neighboringCells[i]);
+				for (uint32_t first = bounds.first; first < bounds.second; first += 4u)
 				{
-					if (processedVertex != bounds.begin)
-						if (compareVertexPosition(processedVertex->position, bounds.begin->position, epsilon) &&
-							vxcmp(*processedVertex, *bounds.begin, buffer))
+					uint32_t matches = vertexHashMap.matchPositions4(processedVertex.position, first);
+					if (bounds.second - first < 4u)
+						matches &= (0x1u << (bounds.second - first)) - 1u;
+					if (processed - first < 4u)
+						matches &= ~(0x1u << (processed - first));
+					while (matches)
+					{
+						const uint32_t other = first + static_cast<uint32_t>(core::findLSB(matches));
+						matches &= matches - 1u;
+
+						const IMeshManipulator::SSNGVertexData& otherVertex = vertexHashMap.getSortedVertex(other);
+						if (vxcmp(processedVertex, otherVertex, buffer))
 						{
 							//TODO: better mean calculation algorithm
-							normal += bounds.begin->parentTriangleFaceNormal * bounds.begin->wage;
+							normal += otherVertex.parentTriangleFaceNormal * otherVertex.wage;
 						}
+					}
 				}
 			}
 
-
 			normal = core::normalize(core::vectorSIMDf(normal));
-			buffer->setAttribute(normal, normalAttrID, buffer->getIndexValue(processedVertex->indexOffset));
+			buffer->setAttribute(normal, normalAttrID, buffer->getIndexValue(processedVertex.indexOffset));
 		}
-	}
-
-
+	});
 }
 
-std::array<uint32_t, 8> CSmoothNormalGenerator::VertexHashMap::getNeighboringCellHashes(const IMeshManipulator::SSNGVertexData & vertex)
+std::array<uint32_t, 8> CSmoothNormalGenerator::VertexHashMap::getNeighboringCellHashes(const IMeshManipulator::SSNGVertexData & vertex) const
 {
 	std::array<uint32_t, 8> neighbourhood;
 
-	core::vectorSIMDf cellFloatCoord = vertex.position / cellSize - core::vectorSIMDf(0.5f);
-	core::vector3du32_SIMD neighbor = core::vector3du32_SIMD(static_cast<uint32_t>(cellFloatCoord.x), static_cast<uint32_t>(cellFloatCoord.y), static_cast<uint32_t>(cellFloatCoord.z));
-
-	//left bottom near
-	neighbourhood[0] = hash(neighbor);
-
-	//right bottom near
-	neighbor = neighbor + core::vector3du32_SIMD(1, 0, 0);
-	neighbourhood[1] = hash(neighbor);
-
-	//right bottom far
-	neighbor = neighbor + core::vector3du32_SIMD(0, 0, 1);
-	neighbourhood[2] = hash(neighbor);
-
-	//left bottom far
-	neighbor = neighbor - core::vector3du32_SIMD(1, 0, 0);
-	neighbourhood[3] = hash(neighbor);
-
-	//left top far
-	neighbor = neighbor + core::vector3du32_SIMD(0, 1, 0);
-	neighbourhood[4] = hash(neighbor);
-
-	//right top far
-	neighbor = neighbor + core::vector3du32_SIMD(1, 0, 0);
-	neighbourhood[5] = hash(neighbor);
-
-	//righ top near
-	neighbor = neighbor - core::vector3du32_SIMD(0, 0, 1);
-	neighbourhood[6] = hash(neighbor);
-
-	//left top near
-	neighbor = neighbor - core::vector3du32_SIMD(1, 0, 0);
-	neighbourhood[7] = hash(neighbor);
+	// the 2x2x2 cells closest to the vertex, they cover everything within half a cell of it
+	const cell_t base = getCell(vertex.position - core::vectorSIMDf(cellSize * 0.5f));
+	for (uint32_t i = 0; i < 8; i++)
+		neighbourhood[i] = hash({ base[0] + (i & 0x1u),base[1] + ((i >> 1u) & 0x1u),base[2] + (i >> 2u) });
 
 	//erase duplicated hashes
 	for (int i = 0; i < 8; i++)
 	{
 		uint32_t currHash = neighbourhood[i];
+		if (currHash == invalidHash)
+			continue;
 		for (int j = i + 1; j < 8; j++)
 		{
 			if (neighbourhood[j] == currHash)
@@ -283,4 +255,4 @@ std::array<uint32_t, 8> CSmoothNormalGenerator::VertexHashMap::getNeighboringCel
 }
 
 }
-}
\ No newline at end of file
+}
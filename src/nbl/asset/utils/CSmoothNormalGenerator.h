@@ -23,6 +23,7 @@ namespace asset
 class CSmoothNormalGenerator
 {
 public:
+	//! `function` gets called from many threads at once, and only for pairs of vertices which are within `epsilon` of each other
 	static core::smart_refctd_ptr<asset::ICPUMeshBuffer> calculateNormals(asset::ICPUMeshBuffer* buffer, float epsilon, uint32_t normalAttrID, IMeshManipulator::VxCmpFunction function);
 
 	CSmoothNormalGenerator() = delete;
@@ -32,51 +33,71 @@ private:
 	class VertexHashMap
 	{
 	public:
-		struct BucketBounds
-		{
-			core::vector<IMeshManipulator::SSNGVertexData>::iterator begin;
-			core::vector<IMeshManipulator::SSNGVertexData>::iterator end;
-		};
+		//! cells are twice the `epsilon` wide so all vertices close enough to a vertex are in the 2x2x2 cells nearest to it
+		VertexHashMap(size_t _vertexCount, uint32_t _hashTableMaxSize, float _epsilon);
 
-	public:
-		VertexHashMap(size_t _vertexCount, uint32_t _hashTableMaxSize, float _cellSize);
+		//! vertices need to have been written to `getVertices()` before this, counting sorts them into buckets in parallel
+		void validate();
 
-		//inserts vertex into hash table
-		void add(IMeshManipulator::SSNGVertexData&& vertex);
+		//! neighbouring cells which hash to the same bucket only appear once, the rest of the array is `invalidHash`
+		std::array<uint32_t, 8> getNeighboringCellHashes(const IMeshManipulator::SSNGVertexData& vertex) const;
 
-		//sorts hashtable and sets iterators at beginnings of bucktes
-		void validate();
+		inline core::vector<IMeshManipulator::SSNGVertexData>& getVertices() { return vertices; }
+		inline const core::vector<IMeshManipulator::SSNGVertexData>& getVertices() const { return vertices; }
+		inline uint32_t getVertexCount() const { return vertices.size(); }
 
-		//
-		std::array<uint32_t, 8> getNeighboringCellHashes(const IMeshManipulator::SSNGVertexData& vertex);
+		//! `i`-th vertex in bucket order
+		inline const IMeshManipulator::SSNGVertexData& getSortedVertex(uint32_t i) const { return vertices[sortedIndices[i]]; }
+		//! range of bucket order indices
+		inline std::pair<uint32_t, uint32_t> getBucketBoundsByHash(uint32_t hash) const
+		{
+			if (hash == invalidHash)
+				return { 0u,0u };
+			return { bucketBegin[hash],bucketBegin[hash+1] };
+		}
 
-		inline uint32_t getBucketCount() const { return buckets.size(); }
-		inline BucketBounds getBucketBoundsById(uint32_t index) { return { buckets[index], buckets[index + 1] }; }
-		BucketBounds getBucketBoundsByHash(uint32_t hash);
+		//! bitmask of which of the 4 vertices (in bucket order) starting at `first` are within `epsilon` of `position` in all dimensions, beyond the end of their bucket they're garbage
+		uint32_t matchPositions4(const core::vectorSIMDf& position, uint32_t first) const;
 
-	private:
 		static constexpr uint32_t invalidHash = 0xFFFFFFFF;
 
 	private:
-		//holds iterators pointing to beginning of each bucket, last iterator points to vertices.end()
-		core::vector<core::vector<IMeshManipulator::SSNGVertexData>::iterator> buckets;
+		using cell_t = std::array<int64_t,3>;
+
+		inline cell_t getCell(const core::vectorSIMDf& position) const
+		{
+			const core::vectorSIMDf cellCoord = position / cellSize;
+			// huge coordinates over a tiny epsilon (or infinities) would overflow the cast, clamping puts them in the outermost cells
+			// where they still get compared exactly, NaNs fail both comparisons and end up in the lowest one
+			auto toCell = [](const float coord) -> int64_t
+			{
+				constexpr float MaxCell = static_cast<float>(1ull<<62);
+				const float clamped = coord>=-MaxCell ? (coord<=MaxCell ? std::floor(coord):MaxCell):-MaxCell;
+				return static_cast<int64_t>(clamped);
+			};
+			return { toCell(cellCoord.x),toCell(cellCoord.y),toCell(cellCoord.z) };
+		}
+		uint32_t hash(const cell_t& cell) const;
+
 		core::vector<IMeshManipulator::SSNGVertexData> vertices;
+		//! indices into `vertices` sorted by bucket, and by index within a bucket
+		core::vector<uint32_t> sortedIndices;
+		//! `bucketBegin[hash]` is the first bucket order index of a bucket, has one extra element
+		core::vector<uint32_t> bucketBegin;
+		//! SoA positions in bucket order, padded to be able to always read 4
+		core::vector<float> positions[3];
 		const uint32_t hashTableMaxSize;
+		const float epsilon;
 		const float cellSize;
-
-	private:
-		uint32_t hash(const IMeshManipulator::SSNGVertexData& vertex) const;
-		uint32_t hash(const core::vector3du32_SIMD& position) const;
-
 	};
 
 private:
 	static VertexHashMap setupData(const asset::ICPUMeshBuffer* buffer, float epsilon);
-	static void processConnectedVertices(asset::ICPUMeshBuffer* buffer, VertexHashMap& vertices, float epsilon, uint32_t normalAttrID, IMeshManipulator::VxCmpFunction vxcmp);
+	static void processConnectedVertices(asset::ICPUMeshBuffer* buffer, const VertexHashMap& vertices, uint32_t normalAttrID, const IMeshManipulator::VxCmpFunction& vxcmp);
 
 };
 
 }
 }
 
-#endif
\ No newline at end of file
+#endif
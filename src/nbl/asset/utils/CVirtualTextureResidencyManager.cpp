@@ -0,0 +1,340 @@
+// Copyright (C) 2018-2023 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+#include "nbl/asset/utils/CVirtualTextureResidencyManager.h"
+
+using namespace nbl;
+using namespace nbl::asset;
+
+CVirtualTextureResidencyManager::CVirtualTextureResidencyManager(SCreationParams&& params) :
+	m_virtualTexture(std::move(params.virtualTexture)), m_threadPool(std::move(params.threadPool)),
+	m_maxPagesPerRequest(params.maxPagesPerRequest), m_mipChains(core::max(params.mipChainCacheSize,2u))
+{
+	assert(m_virtualTexture);
+	if (!m_threadPool)
+		m_threadPool = core::make_smart_refctd_ptr<system::CWorkStealingThreadPool>();
+}
+
+CVirtualTextureResidencyManager::~CVirtualTextureResidencyManager()
+{
+	flush();
+	core::vector<texture_id_t> textures;
+	textures.reserve(m_textures.size());
+	for (const auto& texture : m_textures)
+		textures.push_back(texture.first);
+	for (const auto id : textures)
+		unregisterTexture(id);
+}
+
+auto CVirtualTextureResidencyManager::registerTexture(const ICPUVirtualTexture::SMasterTextureData& _addr, core::smart_refctd_ptr<const ICPUImage>&& _img, const IImage::SSubresourceRange& _subres, ISampler::E_TEXTURE_CLAMP _uwrap, ISampler::E_TEXTURE_CLAMP _vwrap, ISampler::E_TEXTURE_BORDER_COLOR _borderColor) -> texture_id_t
+{
+	auto* const vt = m_virtualTexture.get();
+	if (ICPUVirtualTexture::SMasterTextureData::is_invalid(_addr) || !_img || !vt->validateCommit(_addr,_subres,_uwrap,_vwrap))
+		return invalid_texture_id;
+
+	const E_FORMAT format = vt->getFormatInLayer(_addr.pgTab_layer);
+	auto* const storage = static_cast<storage_t*>(vt->getStorageForFormatClass(getFormatClass(format)));
+	if (!storage || !storage->image)
+		return invalid_texture_id;
+
+	const VkExtent3D extent = {static_cast<uint32_t>(_addr.origsize_x),static_cast<uint32_t>(_addr.origsize_y),1u};
+	STexture texture(_addr);
+	texture.image = std::move(_img);
+	texture.subresource = _subres;
+	texture.wrap[0] = _uwrap;
+	texture.wrap[1] = _vwrap;
+	texture.borderColor = _borderColor;
+	texture.storage = storage;
+	texture.pageTableExtent_log2 = core::findLSB(vt->computeSquareSz(extent.width,extent.height));
+	texture.levelsTakingAtLeastOnePage = vt->countLevelsTakingAtLeastOnePage(extent);
+	texture.levelsToPack = std::min<uint32_t>(_subres.levelCount,vt->m_pageTable->getCreationParameters().mipLevels+vt->m_pgSzxy_log2);
+
+	const texture_id_t id = m_nextTextureID++;
+	m_pageTableOrigins[pageTableOriginKey(_addr.pgTab_x,_addr.pgTab_y,_addr.pgTab_layer)] = id;
+	m_textures.emplace(id,std::move(texture));
+	return id;
+}
+
+bool CVirtualTextureResidencyManager::unregisterTexture(const texture_id_t id)
+{
+	auto found = m_textures.find(id);
+	if (found==m_textures.end())
+		return false;
+	if (found->second.pendingPages)
+		flush();
+
+	const STexture& texture = found->second;
+	const auto addr = texture.addr;
+	auto& pages = getStoragePages(texture.storage);
+	const uint32_t levelCount = core::max(texture.levelsTakingAtLeastOnePage,1u);
+	for (uint32_t level=0u; level<levelCount; level++)
+	{
+		const uint32_t w = m_virtualTexture->neededPageCountForSide(addr.origsize_x,level);
+		const uint32_t h = m_virtualTexture->neededPageCountForSide(addr.origsize_y,level);
+		for (uint32_t y=0u; y<h; y++)
+		for (uint32_t x=0u; x<w; x++)
+			pages.residentPages->erase(packKey((addr.pgTab_x>>level)+x,(addr.pgTab_y>>level)+y,addr.pgTab_layer,level));
+	}
+
+	m_mipChains.erase(id);
+	m_pageTableOrigins.erase(pageTableOriginKey(addr.pgTab_x,addr.pgTab_y,addr.pgTab_layer));
+	m_textures.erase(found);
+	// the page table entries are all invalid by now, so the plain page table space release is enough
+	return m_virtualTexture->IVirtualTexture<ICPUImageView,ICPUSampler>::free(addr);
+}
+
+uint32_t CVirtualTextureResidencyManager::requestPages(const core::SRange<const SPageRequest>& requests)
+{
+	m_frame++;
+
+	struct SMiss
+	{
+		page_key_t key;
+		texture_id_t texture;
+		uint32_t level, x, y;
+	};
+	core::vector<SMiss> misses;
+	core::unordered_set<page_key_t> missed;
+	for (const auto& request : requests)
+	{
+		const texture_id_t id = findTexture(request);
+		if (id==invalid_texture_id)
+			continue;
+		const STexture& texture = m_textures.find(id)->second;
+		auto& pages = getStoragePages(texture.storage);
+
+		// walk up to the coarsest level so that the ancestors end up more recently used than the page itself
+		const uint32_t levelCount = core::max(texture.levelsTakingAtLeastOnePage,1u);
+		uint32_t x = request.x-(texture.addr.pgTab_x>>request.mipLevel);
+		uint32_t y = request.y-(texture.addr.pgTab_y>>request.mipLevel);
+		for (uint32_t level=request.mipLevel; level<levelCount; level++,x>>=1u,y>>=1u)
+		{
+			const page_key_t key = packKey((texture.addr.pgTab_x>>level)+x,(texture.addr.pgTab_y>>level)+y,texture.addr.pgTab_layer,level);
+			if (auto* page=pages.residentPages->get(key))
+			{
+				// an earlier request already went through here and all of the ancestors
+				if (page->lastRequestFrame==m_frame)
+					break;
+				page->lastRequestFrame = m_frame;
+			}
+			else if (!m_pendingPages.count(key))
+			{
+				if (!missed.insert(key).second)
+					break;
+				misses.push_back({key,id,level,x,y});
+			}
+		}
+	}
+
+	// coarse pages first, if the tiles run out the shader still has something to fall back to
+	std::stable_sort(misses.begin(),misses.end(),[](const SMiss& lhs, const SMiss& rhs)->bool{return lhs.level>rhs.level;});
+
+	constexpr uint32_t InvalidTile = tile_alctr_t::invalid_address;
+	core::unordered_map<texture_id_t,core::vector<SPageJob>> batches;
+	uint32_t scheduled = 0u;
+	for (const auto& miss : misses)
+	{
+		if (scheduled>=m_maxPagesPerRequest)
+			break;
+		const STexture& texture = m_textures.find(miss.texture)->second;
+		// the mip chain is still being built by an earlier batch, the page will get requested again
+		if (texture.mipChainPending)
+			continue;
+
+		auto& pages = getStoragePages(texture.storage);
+		const uint32_t levelsTakingAtLeastOnePage = texture.levelsTakingAtLeastOnePage;
+		const bool needsMiptail = levelsTakingAtLeastOnePage==0u || (miss.level==levelsTakingAtLeastOnePage-1u && levelsTakingAtLeastOnePage<texture.subresource.levelCount);
+		uint32_t tile = InvalidTile;
+		if (levelsTakingAtLeastOnePage && (tile=allocTile(pages))==InvalidTile)
+			break;
+		uint32_t miptailTile = InvalidTile;
+		if (needsMiptail && (miptailTile=allocTile(pages))==InvalidTile)
+		{
+			freeTiles(texture.storage,tile,InvalidTile);
+			break;
+		}
+
+		batches[miss.texture].push_back({miss.key,miss.level,miss.x,miss.y,tile,miptailTile});
+		m_pendingPages.insert(miss.key);
+		scheduled++;
+	}
+
+	auto* const vt = m_virtualTexture.get();
+	for (auto& batch : batches)
+	{
+		const texture_id_t id = batch.first;
+		STexture& texture = m_textures.find(id)->second;
+		core::smart_refctd_ptr<ICPUImage> mipChain;
+		if (auto* cached=m_mipChains.get(id))
+			mipChain = *cached;
+		else
+			texture.mipChainPending = true;
+		texture.pendingPages += batch.second.size();
+
+		m_threadPool->submit(m_taskGroup,[this,vt,id,mipChain,jobs=std::move(batch.second),texture]() mutable -> void
+		{
+			SFinishedBatch finished = {id,nullptr,false,std::move(jobs),true};
+			if (!mipChain)
+			{
+				mipChain = ICPUVirtualTexture::createPoTPaddedSquareImageWithMipLevels(texture.image.get(),texture.wrap[0],texture.wrap[1],texture.borderColor).first;
+				finished.mipChain = mipChain;
+				finished.builtMipChain = true;
+			}
+			if (mipChain)
+			{
+				const VkExtent3D extent = {static_cast<uint32_t>(texture.addr.origsize_x),static_cast<uint32_t>(texture.addr.origsize_y),1u};
+				auto copyPage = [&](const uint32_t tile, const uint32_t level, const uint32_t x, const uint32_t y) -> bool
+				{
+					const uint32_t w = vt->neededPageCountForSide(extent.width,level);
+					const uint32_t h = vt->neededPageCountForSide(extent.height,level);
+					return vt->copyToPhysicalPage(core::execution::seq,texture.storage,texture.storage->encodePageAddress(tile),mipChain.get(),texture.subresource,extent,level,x,y,w,h,texture.levelsTakingAtLeastOnePage,texture.wrap[0],texture.wrap[1],texture.borderColor);
+				};
+				for (const auto& job : finished.jobs)
+				{
+					if (job.tile!=InvalidTile)
+						finished.success &= copyPage(job.tile,job.level,job.x,job.y);
+					if (job.miptailTile!=InvalidTile)
+					for (uint32_t level=texture.levelsTakingAtLeastOnePage; level<texture.levelsToPack; level++)
+						finished.success &= copyPage(job.miptailTile,level,0u,0u);
+				}
+			}
+			else
+				finished.success = false;
+
+			std::lock_guard<std::mutex> lock(m_finishedLock);
+			m_finished.push_back(std::move(finished));
+		});
+	}
+	return scheduled;
+}
+
+uint32_t CVirtualTextureResidencyManager::update()
+{
+	core::vector<SFinishedBatch> finished;
+	{
+		std::lock_guard<std::mutex> lock(m_finishedLock);
+		finished.swap(m_finished);
+	}
+
+	constexpr uint32_t InvalidTile = tile_alctr_t::invalid_address;
+	using phys_pg_offset_t = ICPUVirtualTexture::SPhysPgOffset;
+	uint32_t published = 0u;
+	for (auto& batch : finished)
+	{
+		STexture& texture = m_textures.find(batch.texture)->second;
+		texture.pendingPages -= batch.jobs.size();
+		if (batch.builtMipChain)
+		{
+			texture.mipChainPending = false;
+			if (batch.mipChain)
+				m_mipChains.insert(batch.texture,std::move(batch.mipChain));
+		}
+
+		auto& pages = getStoragePages(texture.storage);
+		for (const auto& job : batch.jobs)
+		{
+			m_pendingPages.erase(job.key);
+			if (!batch.success)
+			{
+				freeTiles(texture.storage,job.tile,job.miptailTile);
+				continue;
+			}
+
+			uint32_t physAddr = job.tile!=InvalidTile ? texture.storage->encodePageAddress(job.tile):phys_pg_offset_t::invalid_addr;
+			physAddr |= (job.miptailTile!=InvalidTile ? texture.storage->encodePageAddress(job.miptailTile):phys_pg_offset_t::invalid_addr)<<phys_pg_offset_t::PAGE_ADDR_BITLENGTH;
+			m_virtualTexture->writePageTableEntry(job.level,job.key&0xffu,(job.key>>8u)&0xffu,texture.addr.pgTab_layer,physAddr);
+
+			pages.residentPages->insert(job.key,SResidentPage{batch.texture,m_frame,job.tile,job.miptailTile});
+			m_residentPageCount++;
+			published++;
+
+			// misses get scheduled coarsest first so the pages just inserted would leave their ancestors less recently used,
+			// touch them again so eviction keeps taking the finest pages before what the shader falls back to
+			const uint32_t levelCount = core::max(texture.levelsTakingAtLeastOnePage,1u);
+			for (uint32_t level=job.level+1u,x=job.x>>1u,y=job.y>>1u; level<levelCount; level++,x>>=1u,y>>=1u)
+				pages.residentPages->get(packKey((texture.addr.pgTab_x>>level)+x,(texture.addr.pgTab_y>>level)+y,texture.addr.pgTab_layer,level));
+		}
+	}
+	return published;
+}
+
+uint32_t CVirtualTextureResidencyManager::flush()
+{
+	m_threadPool->wait(m_taskGroup);
+	return update();
+}
+
+auto CVirtualTextureResidencyManager::findTexture(const SPageRequest& request) const -> texture_id_t
+{
+	// textures own power of two squares of the page table aligned to their size, so try every possible size
+	const uint32_t x = request.x<<request.mipLevel;
+	const uint32_t y = request.y<<request.mipLevel;
+	for (uint32_t extent_log2=0u; extent_log2<=ICPUVirtualTexture::MAX_PAGE_TABLE_EXTENT_LOG2; extent_log2++)
+	{
+		const uint32_t mask = ~((1u<<extent_log2)-1u);
+		auto found = m_pageTableOrigins.find(pageTableOriginKey(x&mask,y&mask,request.layer));
+		if (found==m_pageTableOrigins.end())
+			continue;
+		const STexture& texture = m_textures.find(found->second)->second;
+		if (texture.pageTableExtent_log2!=extent_log2)
+			continue;
+
+		if (request.mipLevel>=core::max(texture.levelsTakingAtLeastOnePage,1u))
+			return invalid_texture_id;
+		const uint32_t pageX = request.x-(texture.addr.pgTab_x>>request.mipLevel);
+		const uint32_t pageY = request.y-(texture.addr.pgTab_y>>request.mipLevel);
+		if (pageX>=m_virtualTexture->neededPageCountForSide(texture.addr.origsize_x,request.mipLevel) || pageY>=m_virtualTexture->neededPageCountForSide(texture.addr.origsize_y,request.mipLevel))
+			return invalid_texture_id;
+		return found->second;
+	}
+	return invalid_texture_id;
+}
+
+auto CVirtualTextureResidencyManager::getStoragePages(storage_t* storage) -> SStoragePages&
+{
+	auto found = m_storagePages.find(storage);
+	if (found!=m_storagePages.end())
+		return found->second;
+
+	// every resident page takes at least one tile, so the cache can never overflow
+	const uint32_t capacity = core::max<uint32_t>(storage->tileAlctr.get_total_size(),2u);
+	SStoragePages pages = {storage,std::make_unique<page_cache_t>(capacity,[this,storage](page_cache_t::assoc_t& entry)->void{evict(storage,entry.first,entry.second);})};
+	return m_storagePages.emplace(storage,std::move(pages)).first->second;
+}
+
+uint32_t CVirtualTextureResidencyManager::allocTile(SStoragePages& pages)
+{
+	const uint32_t szAndAlignment = 1u;
+	uint32_t tile = tile_alctr_t::invalid_address;
+	for (;;)
+	{
+		core::address_allocator_traits<tile_alctr_t>::multi_alloc_addr(pages.storage->tileAlctr,1u,&tile,&szAndAlignment,&szAndAlignment,nullptr);
+		if (tile!=tile_alctr_t::invalid_address)
+			return tile;
+
+		const auto* victim = pages.residentPages->peekLeastRecentlyUsed();
+		if (!victim || victim->second.lastRequestFrame==m_frame)
+			return tile_alctr_t::invalid_address;
+		const page_key_t key = victim->first;
+		pages.residentPages->erase(key);
+	}
+}
+
+void CVirtualTextureResidencyManager::freeTiles(storage_t* storage, const uint32_t tile, const uint32_t miptailTile)
+{
+	uint32_t tiles[2];
+	uint32_t count = 0u;
+	if (tile!=tile_alctr_t::invalid_address)
+		tiles[count++] = tile;
+	if (miptailTile!=tile_alctr_t::invalid_address)
+		tiles[count++] = miptailTile;
+	const uint32_t sizes[2] = {1u,1u};
+	core::address_allocator_traits<tile_alctr_t>::multi_free_addr(storage->tileAlctr,count,tiles,sizes);
+}
+
+void CVirtualTextureResidencyManager::evict(storage_t* storage, const page_key_t key, const SResidentPage& page)
+{
+	m_virtualTexture->writePageTableEntry(key>>24u,key&0xffu,(key>>8u)&0xffu,(key>>16u)&0xffu,~0u);
+	freeTiles(storage,page.tile,page.miptailTile);
+	m_residentPageCount--;
+}
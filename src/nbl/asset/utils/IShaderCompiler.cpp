@@ -2,12 +2,16 @@
 // This file is part of the "Nabla Engine".
 // For conditions of distribution and use, see copyright notice in nabla.h
 #include "nbl/asset/utils/IShaderCompiler.h"
+#include "nbl/asset/utils/CShaderCompileCache.h"
 #include "nbl/asset/utils/shadercUtils.h"
 #include "nbl/asset/utils/CGLSLVirtualTexturingBuiltinIncludeGenerator.h"
 
 #include <sstream>
 #include <regex>
 #include <iterator>
+#include <algorithm>
+
+#include "nbl/core/xxHash256.h"
 
 using namespace nbl;
 using namespace nbl::asset;
@@ -30,15 +34,57 @@ std::string IShaderCompiler::escapeFilename(std::string&& code)
 void IShaderCompiler::disableAllDirectivesExceptIncludes(std::string& _code)
 {
     // TODO: replace this with a proper-ish proprocessor and includer one day
-    std::regex directive("#(?!(( |\t|\r|\v|\f)*(include|version|pragma shader_stage)))");//all # not followed by "include" nor "version" nor "pragma shader_stage"
     //`#pragma shader_stage(...)` is needed for determining shader stage when `_stage` param of IShaderCompiler functions is set to ESS_UNKNOWN
-    _code = std::regex_replace(_code, directive, IShaderCompiler::PREPROC_DIRECTIVE_DISABLER);
+    constexpr std::string_view keptDirectives[] = {"include","version","pragma shader_stage"};
+    // whitespace allowed between the `#` and the directive name, newlines end the directive
+    auto isBlank = [](const char c) -> bool {return c==' '||c=='\t'||c=='\r'||c=='\v'||c=='\f';};
+
+    const std::string_view code(_code);
+    std::string result;
+    size_t copiedUpTo = 0u;
+    for (size_t hash=code.find('#'); hash!=std::string_view::npos; hash=code.find('#',hash+1u))
+    {
+        size_t name = hash+1u;
+        while (name<code.size() && isBlank(code[name]))
+            name++;
+        const auto rest = code.substr(name);
+        if (std::any_of(std::begin(keptDirectives),std::end(keptDirectives),[&rest](const std::string_view& directive)->bool{return rest.starts_with(directive);}))
+            continue;
+
+        if (result.empty())
+            result.reserve(code.size()+code.size()/8u);
+        result.append(code,copiedUpTo,hash-copiedUpTo);
+        result.append(IShaderCompiler::PREPROC_DIRECTIVE_DISABLER);
+        copiedUpTo = hash+1u;
+    }
+    if (copiedUpTo==0u)
+        return;
+    result.append(code,copiedUpTo);
+    _code = std::move(result);
 }
 
 void IShaderCompiler::reenableDirectives(std::string& _code)
 {
-    std::regex directive(IShaderCompiler::PREPROC_DIRECTIVE_ENABLER);
-    _code = std::regex_replace(_code, directive, "#");
+    const std::string_view disabler(IShaderCompiler::PREPROC_DIRECTIVE_ENABLER);
+    size_t found = _code.find(disabler);
+    if (found==std::string::npos)
+        return;
+
+    // compact in place, the replacement is always shorter
+    size_t out = found;
+    for (size_t in=found; in<_code.size();)
+    {
+        found = _code.find(disabler,in);
+        const size_t runEnd = found==std::string::npos ? _code.size():found;
+        if (out!=in)
+            std::copy(_code.begin()+in,_code.begin()+runEnd,_code.begin()+out);
+        out += runEnd-in;
+        if (found==std::string::npos)
+            break;
+        _code[out++] = '#';
+        in = found+disabler.size();
+    }
+    _code.resize(out);
 }
 
 std::string IShaderCompiler::encloseWithinExtraInclGuards(std::string&& _code, uint32_t _maxInclusions, const char* _identifier)
@@ -104,6 +150,93 @@ IShaderCompiler::IShaderCompiler(core::smart_refctd_ptr<system::ISystem>&& syste
     m_defaultIncludeFinder->getIncludeStandard("", "nbl/builtin/glsl/utils/common.glsl");
 }
 
+core::smart_refctd_ptr<ICPUShader> IShaderCompiler::compileToSPIRV(const char* code, const SCompilerOptions& options) const
+{
+    auto* const cache = options.compileCache;
+    if (!cache || !code)
+        return compileToSPIRV_impl(code,options,nullptr);
+
+    // Everything which changes the output except for the contents of the includes, those get checked on lookup.
+    // Same result as keying on the preprocessed source, without having to preprocess on a hit.
+    CShaderCompileCache::hash_t key;
+    {
+        constexpr uint32_t KeyVersion = 2u;
+        std::string keySource;
+        auto append = [&keySource](const void* data, const size_t size) -> void
+        {
+            const uint64_t size64 = size;
+            keySource.append(reinterpret_cast<const char*>(&size64),sizeof(size64));
+            keySource.append(reinterpret_cast<const char*>(data),size);
+        };
+        auto appendString = [&append](const std::string_view str) -> void {append(str.data(),str.size());};
+        auto appendPOD = [&append](const auto& val) -> void {append(&val,sizeof(val));};
+
+        appendPOD(KeyVersion);
+        appendPOD(getCodeContentType());
+        appendString(getCompilerVersion());
+        appendString(ISPIRVOptimizer::getToolsVersion());
+        appendPOD(options.stage);
+        appendPOD(options.targetSpirvVersion);
+        appendPOD(options.debugInfoFlags.value);
+        if (options.spirvOptimizer)
+        {
+            const auto passes = options.spirvOptimizer->getPasses();
+            append(passes.data(),passes.size_bytes());
+        }
+        else
+            appendPOD(~0ull);
+        appendString(options.preprocessorOptions.sourceIdentifier);
+        for (const auto& define : options.preprocessorOptions.extraDefines)
+        {
+            appendString(define.identifier);
+            appendString(define.definition);
+        }
+        appendString(code);
+
+        core::XXHash_256(keySource.data(),keySource.size(),key.data());
+    }
+
+    if (auto cached=cache->find(key,options.preprocessorOptions.includeFinder,std::string(options.preprocessorOptions.sourceIdentifier)))
+        return cached;
+
+    core::vector<SDependency> dependencies;
+    auto retval = compileToSPIRV_impl(code,options,&dependencies);
+    if (retval)
+        cache->insert(key,std::move(dependencies),retval.get());
+    return retval;
+}
+
+auto IShaderCompiler::compileToSPIRV(std::span<const SCompileRequest> requests, system::CWorkStealingThreadPool* threadPool) const -> core::vector<compile_future_t>
+{
+    if (!threadPool)
+    {
+        std::call_once(m_defaultThreadPoolCreated,[this]()->void{m_defaultThreadPool = core::make_smart_refctd_ptr<system::CWorkStealingThreadPool>();});
+        threadPool = m_defaultThreadPool.get();
+    }
+
+    core::vector<compile_future_t> futures;
+    futures.reserve(requests.size());
+    // nobody waits on the group, it only needs to outlive the tasks, the futures are what signals completion
+    auto group = std::make_shared<system::CWorkStealingThreadPool::CTaskGroup>();
+    for (const auto& request : requests)
+    {
+        auto promise = std::make_shared<std::promise<core::smart_refctd_ptr<ICPUShader>>>();
+        futures.push_back(promise->get_future());
+        threadPool->submit(*group,[this,group,request,promise]() -> void
+        {
+            try
+            {
+                promise->set_value(compileToSPIRV(request.code,*request.options));
+            }
+            catch (...)
+            {
+                promise->set_exception(std::current_exception());
+            }
+        });
+    }
+    return futures;
+}
+
 std::string IShaderCompiler::preprocessShader(
     system::IFile* sourcefile,
     IShader::E_SHADER_STAGE stage,
@@ -121,9 +254,9 @@ std::string IShaderCompiler::preprocessShader(
 
 auto IShaderCompiler::IIncludeGenerator::getInclude(const std::string& includeName) const -> IIncludeLoader::found_t
 {
-    core::vector<std::pair<std::regex, HandleFunc_t>> builtinNames = getBuiltinNamesToFunctionMapping();
+    std::call_once(m_builtinNamesCreated,[this]()->void{m_builtinNames = getBuiltinNamesToFunctionMapping();});
 
-    for (const auto& pattern : builtinNames)
+    for (const auto& pattern : m_builtinNames)
     if (std::regex_match(includeName,pattern.first))
     {
         if (auto contents=pattern.second(includeName); !contents.empty())
@@ -154,29 +287,90 @@ IShaderCompiler::CFileSystemIncludeLoader::CFileSystemIncludeLoader(core::smart_
 
 auto IShaderCompiler::CFileSystemIncludeLoader::getInclude(const system::path& searchPath, const std::string& includeName) const -> found_t
 {
-    system::path path = searchPath / includeName;
-    if (std::filesystem::exists(path))
+    const system::path requestedPath = searchPath / includeName;
+    const std::string key = requestedPath.string();
+
+    std::shared_ptr<const SCachedFile> file;
+    {
+        std::shared_lock lock(m_cacheLock);
+        if (auto found=m_requestedPaths.find(key); found!=m_requestedPaths.end())
+            file = found->second;
+    }
+    // a stat or two instead of canonicalizing, opening and reading the file again
+    if (file && file->onDisk)
+    {
+        std::error_code ec;
+        const auto lastWriteTime = std::filesystem::last_write_time(file->diskPath,ec);
+        if (ec || lastWriteTime!=file->lastWriteTime || std::filesystem::file_size(file->diskPath,ec)!=file->size)
+            file = nullptr;
+    }
+
+    if (!file)
+    {
+        file = load(requestedPath);
+
+        std::unique_lock lock(m_cacheLock);
+        if (!file)
+        {
+            m_requestedPaths.erase(key);
+            return {};
+        }
+        // share the contents with whoever loaded the same version of the file through a different path
+        auto& interned = m_files[file->absolutePath.string()];
+        if (interned && interned->onDisk==file->onDisk && interned->lastWriteTime==file->lastWriteTime && interned->size==file->size)
+            file = interned;
+        else
+            interned = file;
+        m_requestedPaths[key] = file;
+    }
+    return {file->absolutePath,file->contents};
+}
+
+void IShaderCompiler::CFileSystemIncludeLoader::clearCache()
+{
+    std::unique_lock lock(m_cacheLock);
+    m_requestedPaths.clear();
+    m_files.clear();
+}
+
+auto IShaderCompiler::CFileSystemIncludeLoader::load(const system::path& requestedPath) const -> std::shared_ptr<const SCachedFile>
+{
+    auto retval = std::make_shared<SCachedFile>();
+
+    std::error_code ec;
+    system::path path = requestedPath;
+    // anything not on disk can still come from an archive mounted in the system
+    retval->onDisk = std::filesystem::exists(path,ec);
+    if (retval->onDisk)
+    {
         path = std::filesystem::canonical(path);
+        retval->diskPath = path;
+        // taken before reading, so a modification racing with it gets noticed by the next lookup
+        retval->lastWriteTime = std::filesystem::last_write_time(path,ec);
+        retval->onDisk = !ec;
+    }
 
     core::smart_refctd_ptr<system::IFile> f;
     {
         system::ISystem::future_t<core::smart_refctd_ptr<system::IFile>> future;
         m_system->createFile(future, path.c_str(), system::IFile::ECF_READ);
         if (!future.wait())
-            return {};
+            return nullptr;
         future.acquire().move_into(f);
     }
     if (!f)
-        return {};
+        return nullptr;
     const size_t size = f->getSize();
 
-    std::string contents(size, '\0');
+    retval->contents.resize(size);
     system::IFile::success_t succ;
-    f->read(succ, contents.data(), 0, size);
+    f->read(succ, retval->contents.data(), 0, size);
     const bool success = bool(succ);
     assert(success);
 
-    return {f->getFileName(),std::move(contents)};
+    retval->absolutePath = f->getFileName();
+    retval->size = size;
+    return retval;
 }
 
 IShaderCompiler::CIncludeFinder::CIncludeFinder(core::smart_refctd_ptr<system::ISystem>&& system) 
@@ -207,6 +401,17 @@ auto IShaderCompiler::CIncludeFinder::getIncludeRelative(const system::path& req
     return trySearchPaths(includeName);
 }
 
+auto IShaderCompiler::CIncludeFinder::getInclude(const system::path& requestingSourceDir, const std::string& includeName, const bool standard, core::vector<SDependency>* dependencies) const -> IIncludeLoader::found_t
+{
+    auto retval = standard ? getIncludeStandard(requestingSourceDir,includeName):getIncludeRelative(requestingSourceDir,includeName);
+    if (retval && dependencies)
+    {
+        auto& dep = dependencies->emplace_back(SDependency{requestingSourceDir,includeName,standard});
+        core::XXHash_256(retval.contents.data(),retval.contents.size(),dep.hash.data());
+    }
+    return retval;
+}
+
 void IShaderCompiler::CIncludeFinder::addSearchPath(const std::string& searchPath, const core::smart_refctd_ptr<IIncludeLoader>& loader)
 {
     if (!loader)
@@ -47,7 +47,7 @@ struct load_to_string final
 struct preprocessing_hooks final : public boost::wave::context_policies::default_preprocessing_hooks
 {
     preprocessing_hooks(const IShaderCompiler::SPreprocessorOptions& _preprocessOptions) 
-        : m_includeFinder(_preprocessOptions.includeFinder), m_logger(_preprocessOptions.logger), m_pragmaStage(IShader::ESS_UNKNOWN) {}
+        : m_includeFinder(_preprocessOptions.includeFinder), m_dependencies(_preprocessOptions.dependencies), m_logger(_preprocessOptions.logger), m_pragmaStage(IShader::ESS_UNKNOWN) {}
 
     template <typename ContextT>
     bool locate_include_file(ContextT& ctx, std::string& file_path, bool is_system, char const* current_name, std::string& dir_path, std::string& native_name)
@@ -112,6 +112,7 @@ struct preprocessing_hooks final : public boost::wave::context_policies::default
 
 
     const IShaderCompiler::CIncludeFinder* m_includeFinder;
+    core::vector<IShaderCompiler::SDependency>* m_dependencies;
     system::logger_opt_ptr m_logger;
     IShader::E_SHADER_STAGE m_pragmaStage;
 };
@@ -448,12 +449,7 @@ template<> inline bool boost::wave::impl::pp_iterator_functor<nbl::wave::context
     IShaderCompiler::IIncludeLoader::found_t result;
     auto* includeFinder = ctx.get_hooks().m_includeFinder;
     if (includeFinder)
-    {
-        if (is_system)
-            result = includeFinder->getIncludeStandard(ctx.get_current_directory(),file_path);
-        else
-            result = includeFinder->getIncludeRelative(ctx.get_current_directory(),file_path);
-    }
+        result = includeFinder->getInclude(ctx.get_current_directory(),file_path,is_system,ctx.get_hooks().m_dependencies);
 
     if (!result)
     {
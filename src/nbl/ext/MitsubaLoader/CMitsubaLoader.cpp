@@ -408,7 +408,7 @@ core::smart_refctd_ptr<asset::ICPUPipelineLayout> CMitsubaLoader::createPipeline
 	return core::make_smart_refctd_ptr<asset::ICPUPipelineLayout>(nullptr, nullptr, std::move(ds0layout), std::move(ds1layout), nullptr, nullptr);
 }
 
-CMitsubaLoader::CMitsubaLoader(asset::IAssetManager* _manager, system::ISystem* _system) : asset::IRenderpassIndependentPipelineLoader(_manager), m_system(_system)
+CMitsubaLoader::CMitsubaLoader(asset::IAssetManager* _manager, system::ISystem* _system) : asset::IRenderpassIndependentPipelineLoader(_manager), m_system(_system), m_serializedLoader(core::make_smart_refctd_ptr<CSerializedLoader>(_manager))
 {
 #ifdef _NBL_DEBUG
 	setDebugName("CMitsubaLoader");
@@ -418,6 +418,7 @@ CMitsubaLoader::CMitsubaLoader(asset::IAssetManager* _manager, system::ISystem*
 void CMitsubaLoader::initialize()
 {
 	IRenderpassIndependentPipelineLoader::initialize();
+	m_serializedLoader->initialize();
 
 	auto* glslc = m_assetMgr->getGLSLCompiler();
 
@@ -509,6 +510,9 @@ asset::SAssetBundle CMitsubaLoader::loadAsset(system::IFile* _file, const asset:
 			createAndCacheVertexShader(m_assetMgr, DUMMY_VERTEX_SHADER);
 		}
 
+		// only the instancing has to happen in order, it builds the material IR
+		prepareShapes(ctx, _hierarchyLevel, parserManager.shapegroups, _params.logger);
+
 		core::map<core::smart_refctd_ptr<asset::ICPUMesh>,std::pair<std::string,CElementShape::Type>> meshes;
 		for (auto& shapepair : parserManager.shapegroups)
 		{
@@ -633,34 +637,164 @@ core::vector<SContext::shape_ass_type> CMitsubaLoader::getMesh(SContext& ctx, ui
 
 core::vector<SContext::shape_ass_type> CMitsubaLoader::loadShapeGroup(SContext& ctx, uint32_t hierarchyLevel, const CElementShape::ShapeGroup* shapegroup, const core::matrix3x4SIMD& relTform, const system::logger_opt_ptr& logger)
 {
-	// @Crisspl why no group cache?
-	// find group
-	//auto found = ctx.groupCache.find(shapegroup);
-	//if (found != ctx.groupCache.end())
-	//	return found->second;
-
-	const auto children = shapegroup->children;
+	// every child's mesh is in the shape cache after the first instance, so this only adds the instances
+	const auto& children = flattenShapeGroup(ctx, shapegroup);
 
 	core::vector<SContext::shape_ass_type> meshes;
+	meshes.reserve(children.size());
+	for (auto* child : children)
+		meshes.push_back(loadBasicShape(ctx, hierarchyLevel, child, relTform, logger));
+	return meshes;
+}
+
+const SContext::group_ass_type& CMitsubaLoader::flattenShapeGroup(SContext& ctx, const CElementShape::ShapeGroup* shapegroup)
+{
+	auto found = ctx.groupCache.find(shapegroup);
+	if (found != ctx.groupCache.end())
+		return found->second;
+
+	SContext::group_ass_type children;
 	for (auto i=0u; i<shapegroup->childCount; i++)
 	{
-		auto child = children[i];
+		auto child = shapegroup->children[i];
 		if (!child)
 			continue;
 
 		assert(child->type!=CElementShape::Type::INSTANCE);
-		if (child->type != CElementShape::Type::SHAPEGROUP) {
-			auto lowermesh = loadBasicShape(ctx, hierarchyLevel, child, relTform, logger);
-			meshes.push_back(std::move(lowermesh));
+		if (child->type != CElementShape::Type::SHAPEGROUP)
+			children.push_back(child);
+		else
+		{
+			const auto& lowerchildren = flattenShapeGroup(ctx, &child->shapegroup);
+			children.insert(children.end(), lowerchildren.begin(), lowerchildren.end());
 		}
-		else {
-			auto lowermeshes = loadShapeGroup(ctx, hierarchyLevel, &child->shapegroup, relTform, logger);
-			meshes.insert(meshes.begin(), std::make_move_iterator(lowermeshes.begin()), std::make_move_iterator(lowermeshes.end()));
+	}
+	return ctx.groupCache.emplace(shapegroup,std::move(children)).first->second;
+}
+
+static const SPropertyElementData* getModelFilename(const CElementShape* shape)
+{
+	switch (shape->type)
+	{
+		case CElementShape::Type::OBJ:
+			return &shape->obj.filename;
+		case CElementShape::Type::PLY:
+			return &shape->ply.filename;
+		case CElementShape::Type::SERIALIZED:
+			return &shape->serialized.filename;
+		default:
+			break;
+	}
+	return nullptr;
+}
+
+static IAssetLoader::SAssetLoadParams getModelLoadParams(const SContext& ctx)
+{
+	auto loadParams = ctx.inner.params;
+	loadParams.loaderFlags = static_cast<IAssetLoader::E_LOADER_PARAMETER_FLAGS>(loadParams.loaderFlags | IAssetLoader::ELPF_RIGHT_HANDED_MESHES);
+	return loadParams;
+}
+
+void CMitsubaLoader::prepareShapes(SContext& ctx, uint32_t hierarchyLevel, const core::vector<std::pair<CElementShape*,std::string>>& shapes, const system::logger_opt_ptr& logger)
+{
+	// every shape which will go through `loadBasicShape`, once
+	core::vector<CElementShape*> basicShapes;
+	{
+		core::unordered_set<const CElementShape*> seen;
+		auto addShape = [&](CElementShape* shape) -> void
+		{
+			if (seen.insert(shape).second)
+				basicShapes.push_back(shape);
+		};
+		for (const auto& shapepair : shapes)
+		{
+			auto* shape = shapepair.first;
+			if (!shape || shape->type==CElementShape::Type::SHAPEGROUP)
+				continue;
+			if (shape->type!=CElementShape::Type::INSTANCE)
+				addShape(shape);
+			else if (const CElementShape* parent=shape->instance.parent)
+			{
+				for (auto* child : flattenShapeGroup(ctx,&parent->shapegroup))
+					addShape(child);
+			}
 		}
 	}
 
-	//ctx.groupCache.insert({shapegroup,meshes});
-	return meshes;
+	// many shapes (e.g. all the sub-meshes of a serialized file) share a file
+	core::vector<std::string> modelFilenames;
+	core::unordered_map<std::string,core::vector<uint32_t>> serializedMeshes;
+	for (const auto* shape : basicShapes)
+	if (const auto* filename=getModelFilename(shape))
+	{
+		assert(filename->type==SPropertyElementData::Type::STRING);
+		if (shape->type==CElementShape::Type::SERIALIZED)
+			serializedMeshes[filename->svalue].push_back(static_cast<uint32_t>(core::max(shape->serialized.shapeIndex,0)));
+		else if (ctx.modelCache.emplace(filename->svalue,SAssetBundle{}).second)
+			modelFilenames.push_back(filename->svalue);
+	}
+	// serialized files only get the referenced meshes inflated, which makes the bundles partial so they stay out of the asset cache
+	for (const auto& file : serializedMeshes)
+		ctx.modelCache.emplace(file.first,SAssetBundle{});
+	auto* pool = interm_getLoadPool(m_assetMgr);
+	{
+		system::CWorkStealingThreadPool::CTaskGroup group;
+		for (const auto& file : serializedMeshes)
+		{
+			auto* bundle = &ctx.modelCache[file.first];
+			pool->submit(group,[this,&ctx,hierarchyLevel,&file,bundle]()->void{*bundle = loadSerializedMeshes(ctx,hierarchyLevel,file.first,file.second);});
+		}
+		auto bundles = interm_getAssetsInHierarchy(m_assetMgr,modelFilenames,getModelLoadParams(ctx),hierarchyLevel/*+ICPUScene::MESH_HIERARCHY_LEVELS_BELOW*/,ctx.override_);
+		for (size_t i=0u; i<modelFilenames.size(); i++)
+			ctx.modelCache[modelFilenames[i]] = std::move(bundles[i]);
+		interm_waitForLoadTasks(m_assetMgr,group);
+	}
+
+	// all entries up front, the table must not rehash while tasks write into it
+	for (auto* shape : basicShapes)
+		ctx.preparedShapes.emplace(shape,nullptr);
+	// the geometry creator shares one normal quantization cache, so only models go on the pool while the primitives get made here
+	system::CWorkStealingThreadPool::CTaskGroup group;
+	for (auto* shape : basicShapes)
+	{
+		auto* prepared = &ctx.preparedShapes[shape];
+		if (getModelFilename(shape))
+			pool->submit(group,[this,&ctx,&logger,hierarchyLevel,shape,prepared]()->void{*prepared = createShapeMesh(ctx,hierarchyLevel,shape,logger);});
+		else
+			*prepared = createShapeMesh(ctx,hierarchyLevel,shape,logger);
+	}
+	interm_waitForLoadTasks(m_assetMgr,group);
+}
+
+SAssetBundle CMitsubaLoader::loadSerializedMeshes(SContext& ctx, uint32_t hierarchyLevel, const std::string& filename, std::span<const uint32_t> meshIndices)
+{
+	auto loadParams = getModelLoadParams(ctx);
+	if (!loadParams.meshManipulatorOverride)
+		loadParams.meshManipulatorOverride = m_assetMgr->getMeshManipulator();
+
+	// resolve the path the same way the asset manager would
+	const IAssetLoader::SAssetLoadContext loadCtx(loadParams,nullptr);
+	system::path filePath = filename;
+	ctx.override_->getLoadFilename(filePath,m_system,loadCtx,hierarchyLevel);
+	if (!m_system->exists(filePath,system::IFile::ECF_READ))
+	{
+		filePath = loadParams.workingDirectory/filePath;
+		ctx.override_->getLoadFilename(filePath,m_system,loadCtx,hierarchyLevel);
+	}
+
+	core::smart_refctd_ptr<system::IFile> file;
+	{
+		system::ISystem::future_t<core::smart_refctd_ptr<system::IFile>> future;
+		m_system->createFile(future,filePath,core::bitflag<system::IFileBase::E_CREATE_FLAGS>(system::IFileBase::ECF_READ)|system::IFileBase::ECF_MAPPABLE);
+		if (future.wait())
+			future.acquire().move_into(file);
+	}
+	if (!file || !m_serializedLoader->isALoadableFileFormat(file.get(),loadParams.logger))
+	{
+		loadParams.logger.log("Could not open serialized file %s",system::ILogger::ELL_ERROR,filePath.string().c_str());
+		return {};
+	}
+	return m_serializedLoader->loadMeshes(file.get(),meshIndices,loadParams,ctx.override_,hierarchyLevel/*+ICPUScene::MESH_HIERARCHY_LEVELS_BELOW*/);
 }
 
 static core::smart_refctd_ptr<ICPUMesh> createMeshFromGeomCreatorReturnType(IGeometryCreator::return_type&& _data, asset::IAssetManager* _manager)
@@ -693,8 +827,6 @@ static core::smart_refctd_ptr<ICPUMesh> createMeshFromGeomCreatorReturnType(IGeo
 
 SContext::shape_ass_type CMitsubaLoader::loadBasicShape(SContext& ctx, uint32_t hierarchyLevel, CElementShape* shape, const core::matrix3x4SIMD& relTform, const system::logger_opt_ptr& logger)
 {
-	constexpr uint32_t UV_ATTRIB_ID = 2u;
-
 	auto addInstance = [shape,&ctx,&relTform,&logger,this](SContext::shape_ass_type& mesh)
 	{
 		auto bsdf = getBSDFtreeTraversal(ctx, shape->bsdf, logger);
@@ -718,26 +850,50 @@ SContext::shape_ass_type CMitsubaLoader::loadBasicShape(SContext& ctx, uint32_t
 		return found->second;
 	}
 
+	SContext::shape_ass_type mesh;
+	if (auto prepared=ctx.preparedShapes.find(shape); prepared!=ctx.preparedShapes.end())
+		mesh = prepared->second;
+	else
+		mesh = createShapeMesh(ctx, hierarchyLevel, shape, logger);
+	if (!mesh)
+		return nullptr;
+
+	addInstance(mesh);
+	// cache and return
+	ctx.shapeCache.insert({ shape,mesh });
+	return mesh;
+}
+
+SContext::shape_ass_type CMitsubaLoader::createShapeMesh(SContext& ctx, uint32_t hierarchyLevel, CElementShape* shape, const system::logger_opt_ptr& logger)
+{
+	constexpr uint32_t UV_ATTRIB_ID = 2u;
+
 	auto loadModel = [&](const ext::MitsubaLoader::SPropertyElementData& filename, int64_t index=-1) -> core::smart_refctd_ptr<asset::ICPUMesh>
 	{
 		assert(filename.type==ext::MitsubaLoader::SPropertyElementData::Type::STRING);
-		auto loadParams = ctx.inner.params;
-		loadParams.loaderFlags = static_cast<IAssetLoader::E_LOADER_PARAMETER_FLAGS>(loadParams.loaderFlags | IAssetLoader::ELPF_RIGHT_HANDED_MESHES);
-		auto retval = interm_getAssetInHierarchy(m_assetMgr, filename.svalue, loadParams, hierarchyLevel/*+ICPUScene::MESH_HIERARCHY_LEVELS_BELOW*/, ctx.override_);
-		if (retval.getAssetType()!=asset::IAsset::ET_MESH)
+		SAssetBundle retval;
+		if (auto cached=ctx.modelCache.find(filename.svalue); cached!=ctx.modelCache.end())
+			retval = cached->second;
+		else
+			retval = interm_getAssetInHierarchy(m_assetMgr, filename.svalue, getModelLoadParams(ctx), hierarchyLevel/*+ICPUScene::MESH_HIERARCHY_LEVELS_BELOW*/, ctx.override_);
+		if (retval.getContents().empty() || retval.getAssetType()!=asset::IAsset::ET_MESH)
 			return nullptr;
 		auto contentRange = retval.getContents();
-		auto serializedMeta = retval.getMetadata()->selfCast<CMitsubaSerializedMetadata>();
+		auto serializedMeta = retval.getMetadata() ? retval.getMetadata()->selfCast<CMitsubaSerializedMetadata>():nullptr;
 		//
 		uint32_t actualIndex = 0;
 		if (index>=0ll && serializedMeta)
-		for (auto it=contentRange.begin(); it!=contentRange.end(); it++)
 		{
-			auto meshMeta = static_cast<const CMitsubaSerializedMetadata::CMesh*>(serializedMeta->getAssetSpecificMetadata(IAsset::castDown<ICPUMesh>(*it).get()));
-			if (meshMeta->m_id!=static_cast<uint32_t>(index))
-				continue;
-			actualIndex = it-contentRange.begin();
-			break;
+			// serialized files only hold the meshes which loaded, don't fall back to a different one
+			actualIndex = contentRange.size();
+			for (auto it=contentRange.begin(); it!=contentRange.end(); it++)
+			{
+				auto meshMeta = static_cast<const CMitsubaSerializedMetadata::CMesh*>(serializedMeta->getAssetSpecificMetadata(IAsset::castDown<ICPUMesh>(*it).get()));
+				if (meshMeta->m_id!=static_cast<uint32_t>(index))
+					continue;
+				actualIndex = it-contentRange.begin();
+				break;
+			}
 		}
 		//
 		if (contentRange.begin()+actualIndex < contentRange.end())
@@ -814,7 +970,7 @@ SContext::shape_ass_type CMitsubaLoader::loadBasicShape(SContext& ctx, uint32_t
 			if (mesh && shape->obj.flipTexCoords)
 			{
 				newMesh = core::smart_refctd_ptr_static_cast<asset::ICPUMesh> (mesh->clone(1u));
-				for (auto& meshbuffer : mesh->getMeshBufferVector())
+				for (auto& meshbuffer : newMesh->getMeshBufferVector())
 				{
 					auto binding = meshbuffer->getVertexBufferBindings()[UV_ATTRIB_ID];
 					if (binding.buffer)
@@ -852,7 +1008,7 @@ SContext::shape_ass_type CMitsubaLoader::loadBasicShape(SContext& ctx, uint32_t
 					constexpr uint32_t COLOR_BUF_BINDING = 15u;
 					uint32_t* newRGB = reinterpret_cast<uint32_t*>(newRGBbuff->getPointer());
 					uint32_t offset = 0u;
-					for (auto& meshbuffer : mesh->getMeshBufferVector())
+					for (auto& meshbuffer : newMesh->getMeshBufferVector())
 					{
 						core::vectorSIMDf rgb;
 						for (uint32_t i=0u; meshbuffer->getAttribute(rgb,COLOR_ATTR,i); i++,offset++)
@@ -900,7 +1056,7 @@ SContext::shape_ass_type CMitsubaLoader::loadBasicShape(SContext& ctx, uint32_t
 	// flip normals if necessary
 	if (flipNormals)
 	{
-		for (auto& meshbuffer : mesh->getMeshBufferVector())
+		for (auto& meshbuffer : newMesh->getMeshBufferVector())
 		{
 			auto binding = meshbuffer->getIndexBufferBinding();
 			binding.buffer = core::smart_refctd_ptr_static_cast<ICPUBuffer>(binding.buffer->clone(0u));
@@ -910,7 +1066,7 @@ SContext::shape_ass_type CMitsubaLoader::loadBasicShape(SContext& ctx, uint32_t
 	}
 	// recompute normalis if necessary
 	if (faceNormals || !std::isnan(maxSmoothAngle))
-	for (auto& meshbuffer : mesh->getMeshBufferVector())
+	for (auto& meshbuffer : newMesh->getMeshBufferVector())
 	{
 		const float smoothAngleCos = cos(core::radians(maxSmoothAngle));
 
@@ -928,12 +1084,7 @@ SContext::shape_ass_type CMitsubaLoader::loadBasicShape(SContext& ctx, uint32_t
 		meshbuffer = std::move(newMeshBuffer);
 	}
 	IMeshManipulator::recalculateBoundingBox(newMesh.get());
-	mesh = std::move(newMesh);
-
-	addInstance(mesh);
-	// cache and return
-	ctx.shapeCache.insert({ shape,mesh });
-	return mesh;
+	return newMesh;
 }
 
 void CMitsubaLoader::cacheTexture(SContext& ctx, uint32_t hierarchyLevel, const CElementTexture* tex, const CMitsubaMaterialCompilerFrontend::E_IMAGE_VIEW_SEMANTIC semantic)
@@ -12,6 +12,8 @@
 #endif
 #include "zlib/zlib.h"
 
+#include <numeric>
+
 namespace nbl
 {
 
@@ -38,15 +40,6 @@ constexpr auto COLOR_ATTRIBUTE = 1;
 constexpr auto UV_ATTRIBUTE = 2;
 constexpr auto NORMAL_ATTRIBUTE = 3;
 
-// maybe move to core
-#define PAGE_SIZE 4096
-struct alignas(PAGE_SIZE) Page_t
-{
-	uint8_t data[PAGE_SIZE];
-};
-#undef PAGE_SIZE
-
-
 template<typename T, size_t N>
 struct alignas(T) unaligned_gvecN
 {
@@ -59,9 +52,253 @@ using unaligned_vec3 = unaligned_gvecN<float,3ull>;
 using unaligned_dvec2 = unaligned_gvecN<double,2ull>;
 using unaligned_dvec3 = unaligned_gvecN<double,3ull>;
 
+namespace
+{
+// reads the stream of one mesh piece by piece, straight into wherever the data has to end up
+class CInflater
+{
+	public:
+		CInflater(const uint8_t* data, const size_t size)
+		{
+			memset(&m_stream,0,sizeof(m_stream));
+			m_stream.next_in = const_cast<Bytef*>(data);
+			m_stream.avail_in = static_cast<uInt>(size);
+			m_initialized = inflateInit(&m_stream)==Z_OK;
+		}
+		~CInflater()
+		{
+			if (m_initialized)
+				inflateEnd(&m_stream);
+		}
+
+		//! fails if the stream ends or is corrupt before `size` bytes came out
+		inline bool read(void* dst, size_t size)
+		{
+			if (!m_initialized)
+				return false;
+			m_stream.next_out = reinterpret_cast<Bytef*>(dst);
+			while (size)
+			{
+				const uInt chunk = static_cast<uInt>(core::min<size_t>(size,std::numeric_limits<uInt>::max()));
+				m_stream.avail_out = chunk;
+				while (m_stream.avail_out)
+				{
+					const int32_t err = inflate(&m_stream,Z_SYNC_FLUSH);
+					if (err==Z_STREAM_END && m_stream.avail_out==0u)
+						break;
+					if (err!=Z_OK)
+						return false;
+				}
+				size -= chunk;
+			}
+			return true;
+		}
+		template<typename T>
+		inline bool read(T& out) {return read(&out,sizeof(T));}
+
+	private:
+		z_stream m_stream;
+		bool m_initialized;
+};
+
+// everything about a mesh which can be made without touching the asset manager
+struct SDecodedMesh
+{
+	core::smart_refctd_ptr<ICPUMeshBuffer> meshBuffer;
+	SVertexInputParams inputParams;
+	std::string name;
+	uint32_t flags = 0u;
+};
+
+bool decodeMesh(SDecodedMesh& out, const uint8_t* data, const size_t size, CQuantNormalCache* const quantNormalCache)
+{
+	CInflater inflater(data,size);
+
+	uint32_t flags;
+	if (!inflater.read(flags))
+		return false;
+	size_t typeSize;
+	if (flags & MF_SINGLE_FLOAT)
+		typeSize = sizeof(float);
+	else if (flags & MF_DOUBLE_FLOAT)
+		typeSize = sizeof(double);
+	else
+		return false;
+	const bool sourceIsDoubles = typeSize==sizeof(double);
+	const bool requiresNormals = (flags&MF_PER_VERTEX_NORMALS) || (flags&MF_FACE_NORMALS);
+	const bool hasUVs = flags&MF_TEXTURE_COORDINATES;
+	const bool hasColors = flags&MF_VERTEX_COLORS;
+
+	for (char c; inflater.read(c) && c;)
+		out.name += c;
+
+	uint64_t vertexCount,triangleCount;
+	if (!inflater.read(vertexCount) || !inflater.read(triangleCount))
+		return false;
+	if (vertexCount<3ull || vertexCount>0xFFFFFFFFull || triangleCount<1ull)
+		return false;
+
+	auto meshBuffer = core::make_smart_refctd_ptr<ICPUMeshBuffer>();
+	auto& inputParams = out.inputParams;
+	auto enableAttribute = [&meshBuffer,&inputParams](uint16_t attrId, E_FORMAT format, core::smart_refctd_ptr<ICPUBuffer>&& buf) -> void
+	{
+		inputParams.enabledBindingFlags |= core::createBitmask({ attrId });
+		inputParams.bindings[attrId].inputRate = EVIR_PER_VERTEX;
+		inputParams.bindings[attrId].stride = getTexelOrBlockBytesize(format);
+		inputParams.enabledAttribFlags |= core::createBitmask({ attrId });
+		inputParams.attributes[attrId].binding = attrId;
+		inputParams.attributes[attrId].format = format;
+		meshBuffer->setVertexBufferBinding({0,std::move(buf)},attrId);
+	};
+	// streams which need converting get inflated here first
+	core::vector<uint8_t> scratch;
+	auto readScratch = [&](const size_t components) -> const uint8_t*
+	{
+		scratch.resize(vertexCount*components*typeSize);
+		return inflater.read(scratch.data(),scratch.size()) ? scratch.data():nullptr;
+	};
+
+	// positions keep their precision, so they get inflated in place
+	auto posbuf = core::make_smart_refctd_ptr<ICPUBuffer>(vertexCount*typeSize*3ull);
+	if (!inflater.read(posbuf->getPointer(),posbuf->getSize()))
+		return false;
+	{
+		core::aabbox3df aabb;
+		auto addPositions = [&aabb](const auto* positions, const uint64_t count) -> void
+		{
+			aabb.reset(positions[0].pointer[0],positions[0].pointer[1],positions[0].pointer[2]);
+			for (uint64_t i=1ull; i<count; i++)
+				aabb.addInternalPoint(positions[i].pointer[0],positions[i].pointer[1],positions[i].pointer[2]);
+		};
+		if (sourceIsDoubles)
+			addPositions(reinterpret_cast<const unaligned_dvec3*>(posbuf->getPointer()),vertexCount);
+		else
+			addPositions(reinterpret_cast<const unaligned_vec3*>(posbuf->getPointer()),vertexCount);
+		meshBuffer->setBoundingBox(aabb);
+	}
+	const void* const positions = posbuf->getPointer();
+	meshBuffer->setPositionAttributeIx(POSITION_ATTRIBUTE);
+	enableAttribute(POSITION_ATTRIBUTE,sourceIsDoubles ? EF_R64G64B64_SFLOAT:EF_R32G32B32_SFLOAT,std::move(posbuf));
+
+	using normal_t = CQuantNormalCache::value_type_t<EF_A2B10G10R10_SNORM_PACK32>;
+	normal_t* normalPtr = nullptr;
+	if (requiresNormals)
+	{
+		auto normalbuf = core::make_smart_refctd_ptr<ICPUBuffer>(sizeof(normal_t)*vertexCount);
+		normalPtr = reinterpret_cast<normal_t*>(normalbuf->getPointer());
+		// face normals come with no data, they're computed from the indices below
+		if (flags & MF_PER_VERTEX_NORMALS)
+		{
+			const uint8_t* normals = readScratch(3ull);
+			if (!normals)
+				return false;
+			auto quantizeNormals = [quantNormalCache,normalPtr](const auto* nml, const uint64_t count) -> void
+			{
+				core::vector<core::vectorSIMDf> unquantized(count);
+				for (uint64_t i=0ull; i<count; i++)
+					unquantized[i].set(nml[i].pointer[0],nml[i].pointer[1],nml[i].pointer[2]);
+				quantNormalCache->quantize<EF_A2B10G10R10_SNORM_PACK32>(unquantized.data(),normalPtr,count);
+			};
+			if (sourceIsDoubles)
+				quantizeNormals(reinterpret_cast<const unaligned_dvec3*>(normals),vertexCount);
+			else
+				quantizeNormals(reinterpret_cast<const unaligned_vec3*>(normals),vertexCount);
+		}
+		enableAttribute(NORMAL_ATTRIBUTE,EF_A2B10G10R10_SNORM_PACK32,std::move(normalbuf));
+		meshBuffer->setNormalAttributeIx(NORMAL_ATTRIBUTE);
+	}
+	if (hasUVs)
+	{
+		// TODO: UV quantization and optimization (maybe lets just always use half floats?)
+		auto uvbuf = core::make_smart_refctd_ptr<ICPUBuffer>(sizeof(unaligned_vec2)*vertexCount);
+		if (sourceIsDoubles)
+		{
+			const auto* uvs = reinterpret_cast<const unaligned_dvec2*>(readScratch(2ull));
+			if (!uvs)
+				return false;
+			auto* uvPtr = reinterpret_cast<unaligned_vec2*>(uvbuf->getPointer());
+			for (uint64_t i=0ull; i<vertexCount; i++)
+			for (auto k=0u; k<2u; k++)
+				uvPtr[i].pointer[k] = uvs[i].pointer[k];
+		}
+		else if (!inflater.read(uvbuf->getPointer(),uvbuf->getSize()))
+			return false;
+		enableAttribute(UV_ATTRIBUTE,EF_R32G32_SFLOAT,std::move(uvbuf));
+	}
+	if (hasColors)
+	{
+		auto colorbuf = core::make_smart_refctd_ptr<ICPUBuffer>(sizeof(uint32_t)*vertexCount);
+		const uint8_t* colors = readScratch(3ull);
+		if (!colors)
+			return false;
+		auto encodeColors = [colorPtr=reinterpret_cast<uint32_t*>(colorbuf->getPointer())](const auto* color, const uint64_t count) -> void
+		{
+			for (uint64_t i=0ull; i<count; i++)
+			{
+				const double decoded[3] = {color[i].pointer[0],color[i].pointer[1],color[i].pointer[2]};
+				encodePixels<EF_B10G11R11_UFLOAT_PACK32,double>(colorPtr+i,decoded);
+			}
+		};
+		if (sourceIsDoubles)
+			encodeColors(reinterpret_cast<const unaligned_dvec3*>(colors),vertexCount);
+		else
+			encodeColors(reinterpret_cast<const unaligned_vec3*>(colors),vertexCount);
+		enableAttribute(COLOR_ATTRIBUTE,EF_B10G11R11_UFLOAT_PACK32,std::move(colorbuf));
+	}
+
+	auto indexbuf = core::make_smart_refctd_ptr<ICPUBuffer>(sizeof(uint32_t)*3ull*triangleCount);
+	if (!inflater.read(indexbuf->getPointer(),indexbuf->getSize()))
+		return false;
+	{
+		const uint32_t* indexPtr = reinterpret_cast<const uint32_t*>(indexbuf->getPointer());
+		if (std::any_of(indexPtr,indexPtr+triangleCount*3ull,[vertexCount](const uint32_t ix){return ix>=vertexCount;}))
+			return false;
+		// per-face normals, a vertex shared between faces ends up with the last one
+		if (flags & MF_FACE_NORMALS)
+		{
+			auto computeFaceNormals = [quantNormalCache,normalPtr,indexPtr,triangleCount](const auto* pos) -> void
+			{
+				core::vector<core::vectorSIMDf> unquantized(triangleCount);
+				for (uint64_t j=0ull; j<triangleCount; j++)
+				{
+					const uint32_t* triangleIndices = indexPtr+j*3ull;
+					core::vectorSIMDf corners[3];
+					for (uint64_t k=0ull; k<3ull; k++)
+					{
+						const auto& p = pos[triangleIndices[k]].pointer;
+						corners[k].set(p[0],p[1],p[2]);
+					}
+					unquantized[j] = core::cross(corners[1]-corners[0],corners[2]-corners[0]);
+				}
+				core::vector<normal_t> quantized(triangleCount);
+				quantNormalCache->quantize<EF_A2B10G10R10_SNORM_PACK32>(unquantized.data(),quantized.data(),triangleCount);
+				for (uint64_t j=0ull; j<triangleCount; j++)
+				for (uint64_t k=0ull; k<3ull; k++)
+					normalPtr[indexPtr[j*3ull+k]] = quantized[j];
+			};
+			if (sourceIsDoubles)
+				computeFaceNormals(reinterpret_cast<const unaligned_dvec3*>(positions));
+			else
+				computeFaceNormals(reinterpret_cast<const unaligned_vec3*>(positions));
+		}
+	}
+	meshBuffer->setIndexBufferBinding({0u,std::move(indexbuf)});
+	meshBuffer->setIndexCount(triangleCount*3u);
+	meshBuffer->setIndexType(EIT_32BIT);
+
+	out.meshBuffer = std::move(meshBuffer);
+	out.flags = flags;
+	return true;
+}
+}
 
 //! creates/loads an animated mesh from the file.
 asset::SAssetBundle CSerializedLoader::loadAsset(system::IFile* _file, const asset::IAssetLoader::SAssetLoadParams& _params, asset::IAssetLoader::IAssetLoaderOverride* _override, uint32_t _hierarchyLevel)
+{
+	return loadMeshes(_file,{},_params,_override,_hierarchyLevel);
+}
+
+asset::SAssetBundle CSerializedLoader::loadMeshes(system::IFile* _file, std::span<const uint32_t> meshIndices, const asset::IAssetLoader::SAssetLoadParams& _params, asset::IAssetLoader::IAssetLoaderOverride* _override, uint32_t _hierarchyLevel)
 {
 	if (!_file)
         return {};
@@ -79,7 +316,7 @@ asset::SAssetBundle CSerializedLoader::loadAsset(system::IFile* _file, const ass
 	}
 	CQuantNormalCache* const quantNormalCache = _params.meshManipulatorOverride->getQuantNormalCache();
 
-	size_t maxSize = 0u;
+	const size_t fileSize = ctx.inner.mainFile->getSize();
 	{
 		FileHeader header;
 		system::future<size_t> future;
@@ -91,163 +328,131 @@ asset::SAssetBundle CSerializedLoader::loadAsset(system::IFile* _file, const ass
 			return {};
 		}
 
-		size_t backPos = ctx.inner.mainFile->getSize() - sizeof(uint32_t);
+		size_t backPos = fileSize - sizeof(uint32_t);
 		ctx.inner.mainFile->read(future,&ctx.meshCount,backPos,sizeof(uint32_t));
 		future.get();
-		if (ctx.meshCount==0u)
+		if (ctx.meshCount==0u || backPos<sizeof(uint64_t)*ctx.meshCount)
 			return {};
 
 		ctx.meshOffsets = core::make_refctd_dynamic_array<core::smart_refctd_dynamic_array<uint64_t> >(ctx.meshCount*2u);
 		backPos -= sizeof(uint64_t)*ctx.meshCount;
 		ctx.inner.mainFile->read(future, ctx.meshOffsets->data(),backPos,sizeof(uint64_t)*ctx.meshCount);
 		future.get();
+		// every mesh starts with its own copy of the file header, the compressed stream runs until the next mesh or the offset table
 		for (uint32_t i=0; i<ctx.meshCount; i++)
 		{
-			size_t localSize;
-			if (i == ctx.meshCount-1u)
-				localSize = backPos;
-			else
-				localSize = ctx.meshOffsets->operator[](i+1u);
-			localSize -= ctx.meshOffsets->operator[](i);
-			ctx.meshOffsets->operator[](i+ctx.meshCount) = localSize;
-			if (localSize > maxSize)
-				maxSize = localSize;
+			const uint64_t end = i==ctx.meshCount-1u ? backPos:core::min<uint64_t>(ctx.meshOffsets->operator[](i+1u),backPos);
+			uint64_t& offset = ctx.meshOffsets->operator[](i);
+			offset += sizeof(FileHeader);
+			ctx.meshOffsets->operator[](i+ctx.meshCount) = end>offset ? (end-offset):0ull;
 		}
 	}
-	if (maxSize==0u)
-		return {};
 
-	auto meta = core::make_smart_refctd_ptr<CMitsubaSerializedMetadata>(ctx.meshCount,core::smart_refctd_ptr(IRenderpassIndependentPipelineLoader::m_basicViewParamsSemantics));
-	core::vector<core::smart_refctd_ptr<ICPUMesh>> meshes; meshes.reserve(ctx.meshCount);
+	// sorted and deduplicated, out of range indices are dropped
+	core::vector<uint32_t> selected;
+	if (meshIndices.empty())
+	{
+		selected.resize(ctx.meshCount);
+		std::iota(selected.begin(),selected.end(),0u);
+	}
+	else
+	{
+		for (const auto ix : meshIndices)
+		if (ix<ctx.meshCount)
+			selected.push_back(ix);
+		std::sort(selected.begin(),selected.end());
+		selected.erase(std::unique(selected.begin(),selected.end()),selected.end());
+	}
+	if (selected.empty())
+		return {};
 
-	uint8_t* data = reinterpret_cast<uint8_t*>(_NBL_ALIGNED_MALLOC(maxSize,alignof(double)));
-	constexpr size_t CHUNK = 256ull*1024ull;
-	core::vector<Page_t> decompressed(CHUNK/sizeof(Page_t));
-	system::future<size_t> future;
-	for (uint32_t i=0; i<ctx.meshCount; i++)
+	// all compressed streams share one arena, unless the file is already mapped
+	const uint8_t* const mapped = reinterpret_cast<const uint8_t*>(static_cast<const system::IFile*>(ctx.inner.mainFile)->getMappedPointer());
+	core::vector<const uint8_t*> compressed(selected.size(),nullptr);
+	core::vector<uint8_t> arena;
+	if (mapped)
 	{
-		auto localSize = ctx.meshOffsets->operator[](i+ctx.meshCount);
-		ctx.inner.mainFile->read(future,data,sizeof(FileHeader)+ctx.meshOffsets->operator[](i),localSize);
-		// decompress
-		size_t decompressSize;
+		for (size_t i=0u; i<selected.size(); i++)
+			compressed[i] = mapped+ctx.meshOffsets->operator[](selected[i]);
+	}
+	else
+	{
+		// meshes next to each other in the file get read together, along with the header sitting between them
+		auto joinsPrevious = [&](const size_t j) -> bool
 		{
-			// Setup the inflate stream.
-			z_stream stream;
-			stream.next_in = (Bytef*)data;
-			stream.avail_in = (uInt)localSize;
-			stream.total_in = 0;
-			stream.next_out = (Bytef*)decompressed.data();
-			stream.avail_out = CHUNK;
-			stream.total_out = 0u;
-			stream.zalloc = (alloc_func)0;
-			stream.zfree = (free_func)0;
-
-			int32_t err = inflateInit(&stream, -MAX_WBITS);
-			if (err == Z_OK)
+			if (j==0u || selected[j]!=selected[j-1u]+1u)
+				return false;
+			const uint64_t prevEnd = ctx.meshOffsets->operator[](selected[j-1u])+ctx.meshOffsets->operator[](selected[j-1u]+ctx.meshCount);
+			return ctx.meshOffsets->operator[](selected[j])==prevEnd+sizeof(FileHeader);
+		};
+		size_t arenaSize = 0u;
+		for (size_t j=0u; j<selected.size(); j++)
+		{
+			if (joinsPrevious(j))
+				arenaSize += sizeof(FileHeader);
+			arenaSize += ctx.meshOffsets->operator[](selected[j]+ctx.meshCount);
+		}
+		arena.resize(arenaSize);
+		system::future<size_t> future;
+		size_t arenaOffset = 0u;
+		for (size_t i=0u; i<selected.size();)
+		{
+			const uint64_t runOffset = ctx.meshOffsets->operator[](selected[i]);
+			size_t runSize = 0u;
+			size_t j = i;
+			for (; j<selected.size(); j++)
 			{
-				while (err == Z_OK && err != Z_STREAM_END)
+				if (j!=i)
 				{
-					err = inflate(&stream, Z_SYNC_FLUSH);
-					if (err!=Z_OK || err==Z_STREAM_END || stream.avail_out)
-						continue;
-
-					if (stream.total_out+CHUNK>decompressed.size()*sizeof(Page_t))
-						decompressed.resize(decompressed.size()+CHUNK/sizeof(Page_t));
-					stream.next_out = reinterpret_cast<Bytef*>(decompressed.data())+stream.total_out;
-					stream.avail_out = CHUNK;
+					if (!joinsPrevious(j))
+						break;
+					runSize += sizeof(FileHeader);
 				}
+				compressed[j] = arena.data()+arenaOffset+runSize;
+				runSize += ctx.meshOffsets->operator[](selected[j]+ctx.meshCount);
 			}
-			decompressSize = stream.total_out;
-			int32_t err2 = inflateEnd(&stream);
-
-			if (err == Z_OK || err == Z_STREAM_END)
-				err = err2;
-			if (err != Z_OK)
-			{
-				std::string msg("Error decompressing mesh ix ");
-				msg += std::to_string(i);
-				_params.logger.log(msg, system::ILogger::E_LOG_LEVEL::ELL_ERROR);
-				continue;
-			}
-		}
-		// too small to hold anything
-		if (decompressSize < sizeof(uint8_t)+sizeof(uint64_t)*2ull)
-			continue;
-
-		// some tracking
-		uint8_t* ptr = reinterpret_cast<uint8_t*>(decompressed.data());
-		uint8_t* streamEnd = ptr+decompressSize;
-		// vertex size determination
-		auto flags = *(reinterpret_cast<uint32_t*&>(ptr)++);
-		size_t typeSize;
-		{
-			if (flags & MF_SINGLE_FLOAT)
-				typeSize = sizeof(float);
-			else if (flags & MF_DOUBLE_FLOAT)
-				typeSize = sizeof(double);
-			else
-				continue;
+			assert(arenaOffset+runSize<=arena.size());
+			ctx.inner.mainFile->read(future,arena.data()+arenaOffset,runOffset,runSize);
+			future.get();
+			arenaOffset += runSize;
+			i = j;
 		}
-		const bool sourceIsDoubles = typeSize==sizeof(double);
-		const bool requiresNormals = (flags&MF_PER_VERTEX_NORMALS) || (flags&MF_FACE_NORMALS);
-		const bool hasUVs = flags&MF_TEXTURE_COORDINATES;
-		const bool hasColors = flags&MF_VERTEX_COLORS;
-
-		// get name
-		char* stringPtr = reinterpret_cast<char*>(ptr);
-		while (ptr < streamEnd)
-		if (! *(ptr++))
-				break;
-		// name too long
-		const size_t stringLen = reinterpret_cast<char*>(ptr)-stringPtr;
-		if (ptr+sizeof(uint64_t)*2ull > streamEnd)
-			continue;
+	}
 
-		// 
-		const uint64_t vertexCount = *(reinterpret_cast<uint64_t*&>(ptr)++);
-		if (vertexCount<3ull || vertexCount>0xFFFFFFFFull)
-			continue;
-		const uint64_t triangleCount = *(reinterpret_cast<uint64_t*&>(ptr)++);
-		if (triangleCount<1ull)
-			continue;
-		const size_t indexDataSize = sizeof(uint32_t)*3ull*triangleCount;
+	core::vector<SDecodedMesh> decoded(selected.size());
+	{
+		auto* pool = interm_getLoadPool(m_assetMgr);
+		system::CWorkStealingThreadPool::CTaskGroup group;
+		for (size_t i=0u; i<selected.size(); i++)
 		{
-			size_t vertexDataSize = 3ull;
-			if (requiresNormals)
-				vertexDataSize += 3ull;
-			if (hasUVs)
-				vertexDataSize += 2ull;
-			if (hasColors)
-				vertexDataSize += 3ull;
-			vertexDataSize *= typeSize*vertexCount;
-			if (ptr+vertexDataSize > streamEnd)
-				continue;
-			size_t totalDataSize = vertexDataSize+indexDataSize;
-			if (ptr+totalDataSize > streamEnd)
+			const uint64_t compressedSize = ctx.meshOffsets->operator[](selected[i]+ctx.meshCount);
+			if (!compressedSize)
 				continue;
+			pool->submit(group,[&_params,quantNormalCache,out=&decoded[i],data=compressed[i],compressedSize,ix=selected[i]]()->void
+			{
+				if (!decodeMesh(*out,data,compressedSize,quantNormalCache))
+				{
+					_params.logger.log("Error decompressing mesh ix %u", system::ILogger::E_LOG_LEVEL::ELL_ERROR, ix);
+					out->meshBuffer = nullptr;
+				}
+			});
 		}
+		interm_waitForLoadTasks(m_assetMgr,group);
+	}
 
-		auto indexbuf = core::make_smart_refctd_ptr<asset::ICPUBuffer>(indexDataSize);
-		const uint32_t posAttrSize = typeSize*3u;
-		auto posbuf = core::make_smart_refctd_ptr<asset::ICPUBuffer>(vertexCount*posAttrSize);
-		core::smart_refctd_ptr<asset::ICPUBuffer> normalbuf,uvbuf,colorbuf;
-		if (requiresNormals)
-			normalbuf = core::make_smart_refctd_ptr<asset::ICPUBuffer>(sizeof(uint32_t)*vertexCount);
-		// TODO: UV quantization and optimization (maybe lets just always use half floats?)
-		constexpr size_t uvAttrSize = sizeof(float)*2u;
-		if (hasUVs)
-			uvbuf = core::make_smart_refctd_ptr<asset::ICPUBuffer>(uvAttrSize*vertexCount);
-		if (hasColors)
-			colorbuf = core::make_smart_refctd_ptr<asset::ICPUBuffer>(sizeof(uint32_t)*vertexCount);
-
-		void* posPtr = posbuf->getPointer();
-		CQuantNormalCache::value_type_t<EF_A2B10G10R10_SNORM_PACK32>* normalPtr = !normalbuf ? nullptr:reinterpret_cast<CQuantNormalCache::value_type_t<EF_A2B10G10R10_SNORM_PACK32>*>(normalbuf->getPointer());
-		unaligned_vec2* uvPtr = !uvbuf ? nullptr:reinterpret_cast<unaligned_vec2*>(uvbuf->getPointer());
-		uint32_t* colorPtr = !colorbuf ? nullptr:reinterpret_cast<uint32_t*>(colorbuf->getPointer());
-
+	auto meta = core::make_smart_refctd_ptr<CMitsubaSerializedMetadata>(selected.size(),core::smart_refctd_ptr(IRenderpassIndependentPipelineLoader::m_basicViewParamsSemantics));
+	core::vector<core::smart_refctd_ptr<ICPUMesh>> meshes; meshes.reserve(selected.size());
 
-		auto meshBuffer = core::make_smart_refctd_ptr<asset::ICPUMeshBuffer>();
-		meshBuffer->setPositionAttributeIx(POSITION_ATTRIBUTE);
+	core::smart_refctd_ptr<ICPUPipelineLayout> mbPipelineLayout;
+	core::unordered_map<std::string,std::pair<core::smart_refctd_ptr<ICPUSpecializedShader>,core::smart_refctd_ptr<ICPUSpecializedShader>>> shaders;
+	for (size_t i=0u; i<selected.size(); i++)
+	{
+		auto& mesh = decoded[i];
+		if (!mesh.meshBuffer)
+			continue;
+		const bool requiresNormals = (mesh.flags&MF_PER_VERTEX_NORMALS) || (mesh.flags&MF_FACE_NORMALS);
+		const bool hasUVs = mesh.flags&MF_TEXTURE_COORDINATES;
+		const bool hasColors = mesh.flags&MF_VERTEX_COLORS;
 
 		auto chooseShaderPath = [&]() -> std::string
 		{
@@ -261,191 +466,44 @@ asset::SAssetBundle CSerializedLoader::loadAsset(system::IFile* _file, const ass
 			return "nbl/builtin/material/debug/vertex_color/specialized_shader"; // if only positions are present, shaders with debug vertex colors are assumed
 		};
 		
-		core::smart_refctd_ptr<ICPUSpecializedShader> mbVertexShader;
-		core::smart_refctd_ptr<ICPUSpecializedShader> mbFragmentShader;
+		const std::string basepath = chooseShaderPath();
+		auto found = shaders.find(basepath);
+		if (found==shaders.end())
 		{
 			const IAsset::E_TYPE types[]{ IAsset::E_TYPE::ET_SPECIALIZED_SHADER, IAsset::E_TYPE::ET_SPECIALIZED_SHADER, static_cast<IAsset::E_TYPE>(0u) };
-			const std::string basepath = chooseShaderPath();
-
-			auto bundle = m_assetMgr->findAssets(basepath+".vert", types);
-			mbVertexShader = core::smart_refctd_ptr_static_cast<ICPUSpecializedShader>(bundle->begin()->getContents().begin()[0]);
-			bundle = m_assetMgr->findAssets(basepath+".frag", types);
-			mbFragmentShader = core::smart_refctd_ptr_static_cast<ICPUSpecializedShader>(bundle->begin()->getContents().begin()[0]);
+			auto vertBundle = m_assetMgr->findAssets(basepath+".vert", types);
+			auto fragBundle = m_assetMgr->findAssets(basepath+".frag", types);
+			found = shaders.emplace(basepath,std::make_pair(
+				core::smart_refctd_ptr_static_cast<ICPUSpecializedShader>(vertBundle->begin()->getContents().begin()[0]),
+				core::smart_refctd_ptr_static_cast<ICPUSpecializedShader>(fragBundle->begin()->getContents().begin()[0])
+			)).first;
 		}
-		auto mbPipelineLayout = _override->findDefaultAsset<ICPUPipelineLayout>("nbl/builtin/material/lambertian/no_texture/pipeline_layout",ctx.inner,_hierarchyLevel+ICPUMesh::PIPELINE_LAYOUT_HIERARCHYLEVELS_BELOW).first;
-
+		if (!mbPipelineLayout)
+			mbPipelineLayout = _override->findDefaultAsset<ICPUPipelineLayout>("nbl/builtin/material/lambertian/no_texture/pipeline_layout",ctx.inner,_hierarchyLevel+ICPUMesh::PIPELINE_LAYOUT_HIERARCHYLEVELS_BELOW).first;
 
 		asset::SBlendParams blendParams;
 		asset::SRasterizationParams rastarizationParams;
 		asset::SPrimitiveAssemblyParams primitiveAssemblyParams;
 		primitiveAssemblyParams.primitiveType = asset::EPT_TRIANGLE_LIST;
 
-		asset::SVertexInputParams inputParams;
-		auto enableAttribute = [&meshBuffer,&inputParams](uint16_t attrId, asset::E_FORMAT format, const core::smart_refctd_ptr<asset::ICPUBuffer>& buf) -> void
-		{
-			inputParams.enabledBindingFlags |= core::createBitmask({ attrId });
-			inputParams.bindings[attrId].inputRate = asset::EVIR_PER_VERTEX;
-			inputParams.bindings[attrId].stride = asset::getTexelOrBlockBytesize(format);
-			inputParams.enabledAttribFlags |= core::createBitmask({ attrId });
-			inputParams.attributes[attrId].binding = attrId;
-			inputParams.attributes[attrId].format = format;
-			meshBuffer->setVertexBufferBinding({0,buf},attrId);
-		};
-
-		meshBuffer->setPositionAttributeIx(POSITION_ATTRIBUTE);
-		enableAttribute(POSITION_ATTRIBUTE,sourceIsDoubles ? asset::EF_R64G64B64_SFLOAT:asset::EF_R32G32B32_SFLOAT,posbuf);
-		{
-			core::aabbox3df aabb;
-			auto readPositions = [&aabb,ptr,posPtr](const auto& pos) -> void
-			{
-				size_t vertexIx = std::distance(reinterpret_cast<decltype(&pos)>(ptr),&pos);
-				const auto* coords = pos.pointer;
-				if (vertexIx)
-					aabb.addInternalPoint(coords[0],coords[1],coords[2]);
-				else
-					aabb.reset(coords[0],coords[1],coords[2]);
-				reinterpret_cast<std::remove_const_t<std::remove_reference_t<decltype(pos)>>*>(posPtr)[vertexIx] = pos;
-			};
-			if (sourceIsDoubles)
-			{
-				auto*& typedPtr = reinterpret_cast<unaligned_dvec3*&>(ptr);
-				std::for_each_n(core::execution::seq,typedPtr,vertexCount,readPositions);
-				typedPtr += vertexCount;
-			}
-			else
-			{
-				auto*& typedPtr = reinterpret_cast<unaligned_vec3*&>(ptr);
-				std::for_each_n(core::execution::seq,typedPtr,vertexCount,readPositions);
-				typedPtr += vertexCount;
-			}
-			meshBuffer->setBoundingBox(aabb);
-		}
-		if (requiresNormals)
-		{
-			enableAttribute(NORMAL_ATTRIBUTE,asset::EF_A2B10G10R10_SNORM_PACK32,normalbuf);
-			auto readNormals = [quantNormalCache,ptr,normalPtr](const auto& nml) -> void
-			{
-				size_t vertexIx = std::distance(reinterpret_cast<decltype(&nml)>(ptr),&nml);
-				core::vectorSIMDf simdNormal(nml.pointer[0],nml.pointer[1],nml.pointer[2]);
-				normalPtr[vertexIx] = quantNormalCache->quantize<EF_A2B10G10R10_SNORM_PACK32>(simdNormal);
-			};
-			const bool read = flags&MF_PER_VERTEX_NORMALS;
-			if (sourceIsDoubles)
-			{
-				auto*& typedPtr = reinterpret_cast<unaligned_dvec3*&>(ptr);
-				if (read)
-					std::for_each_n(core::execution::seq,typedPtr,vertexCount,readNormals);
-				typedPtr += vertexCount;
-			}
-			else
-			{
-				auto*& typedPtr = reinterpret_cast<unaligned_vec3*&>(ptr);
-				if (read)
-					std::for_each_n(core::execution::seq,typedPtr,vertexCount,readNormals);
-				typedPtr += vertexCount;
-			}
-			meshBuffer->setNormalAttributeIx(NORMAL_ATTRIBUTE);
-		}
-		if (hasUVs)
-		{
-			enableAttribute(UV_ATTRIBUTE,asset::EF_R32G32_SFLOAT,uvbuf);
-			auto readUVs = [ptr,uvPtr](const auto& uv) -> void
-			{
-				size_t vertexIx = std::distance(reinterpret_cast<decltype(&uv)>(ptr),&uv);
-				for (auto k=0u; k<2u; k++)
-					uvPtr[vertexIx].pointer[k] = uv.pointer[k];
-			};
-			if (sourceIsDoubles)
-			{
-				auto*& typedPtr = reinterpret_cast<unaligned_dvec2*&>(ptr);
-				std::for_each_n(core::execution::seq,typedPtr,vertexCount,readUVs);
-				typedPtr += vertexCount;
-			}
-			else
-			{
-				auto*& typedPtr = reinterpret_cast<unaligned_vec2*&>(ptr);
-				std::for_each_n(core::execution::seq,typedPtr,vertexCount,readUVs);
-				typedPtr += vertexCount;
-			}
-		}
-		if (hasColors)
-		{
-			enableAttribute(COLOR_ATTRIBUTE,asset::EF_B10G11R11_UFLOAT_PACK32,colorbuf);
-			auto readColors = [ptr,colorPtr](const auto& color) -> void
-			{
-				size_t vertexIx = std::distance(reinterpret_cast<decltype(&color)>(ptr),&color);
-				const double colors[3] = {color.pointer[0],color.pointer[1],color.pointer[2]};
-				asset::encodePixels<asset::EF_B10G11R11_UFLOAT_PACK32,double>(colorPtr+vertexIx,colors);
-			};
-			if (sourceIsDoubles)
-			{
-				auto*& typedPtr = reinterpret_cast<unaligned_dvec3*&>(ptr);
-				std::for_each_n(core::execution::seq,typedPtr,vertexCount,readColors);
-				typedPtr += vertexCount;
-			}
-			else
-			{
-				auto*& typedPtr = reinterpret_cast<unaligned_vec3*&>(ptr);
-				std::for_each_n(core::execution::seq,typedPtr,vertexCount,readColors);
-				typedPtr += vertexCount;
-			}
-		}
-
-		auto mbPipeline = core::make_smart_refctd_ptr<asset::ICPURenderpassIndependentPipeline>(std::move(mbPipelineLayout), nullptr, nullptr, inputParams, blendParams, primitiveAssemblyParams, rastarizationParams);
-		mbPipeline->setShaderAtStage(asset::ISpecializedShader::E_SHADER_STAGE::ESS_VERTEX, mbVertexShader.get());
-		mbPipeline->setShaderAtStage(asset::ISpecializedShader::E_SHADER_STAGE::ESS_FRAGMENT, mbFragmentShader.get());
-
-		meshBuffer->setIndexBufferBinding({0u,indexbuf});
-		meshBuffer->setIndexCount(triangleCount * 3u);
-		meshBuffer->setIndexType(asset::EIT_32BIT);
-
-		// read indices and possibly create per-face normals
-		auto readIndices = [&]() -> bool
-		{
-			uint32_t* indexPtr = reinterpret_cast<uint32_t*>(indexbuf->getPointer());
-			for (uint64_t j=0ull; j<triangleCount; j++)
-			{
-				uint32_t* triangleIndices = indexPtr;
-				for (uint64_t k=0ull; k<3ull; k++)
-				{
-					triangleIndices[k] = *(reinterpret_cast<uint32_t*&>(ptr)++);
-					if (triangleIndices[k] >= static_cast<uint32_t>(vertexCount))
-						return false;
-				}
-				indexPtr += 3u;
-
-				if (flags & MF_FACE_NORMALS)
-				{
-					core::vectorSIMDf pos[3];
-					for (uint64_t k=0ull; k<3ull; k++)
-						pos[k] = meshBuffer->getPosition(triangleIndices[k]);
-					auto normal = core::cross(pos[1]-pos[0],pos[2]-pos[0]);
-					for (uint64_t k=0ull; k<3ull; k++)
-						meshBuffer->setAttribute(normal,NORMAL_ATTRIBUTE,k);
-				}
-			}
-			return true;
-		};
-		if (!readIndices())
-			continue;
+		auto mbPipeline = core::make_smart_refctd_ptr<asset::ICPURenderpassIndependentPipeline>(core::smart_refctd_ptr(mbPipelineLayout), nullptr, nullptr, mesh.inputParams, blendParams, primitiveAssemblyParams, rastarizationParams);
+		mbPipeline->setShaderAtStage(asset::ISpecializedShader::E_SHADER_STAGE::ESS_VERTEX, found->second.first.get());
+		mbPipeline->setShaderAtStage(asset::ISpecializedShader::E_SHADER_STAGE::ESS_FRAGMENT, found->second.second.get());
 
+		auto cpumesh = core::make_smart_refctd_ptr<asset::ICPUMesh>();
 
-		auto mesh = core::make_smart_refctd_ptr<asset::ICPUMesh>();
+		meta->placeMeta(meshes.size(),mbPipeline.get(),cpumesh.get(),{std::move(mesh.name),selected[i]});
 
-		meta->placeMeta(meshes.size(),mbPipeline.get(),mesh.get(),{std::string(stringPtr,stringLen),i});
+		mesh.meshBuffer->setPipeline(std::move(mbPipeline));
 
-		meshBuffer->setPipeline(std::move(mbPipeline));
-
-		mesh->setBoundingBox(meshBuffer->getBoundingBox());
-		mesh->getMeshBufferVector().emplace_back(std::move(meshBuffer));
-		meshes.push_back(std::move(mesh));
+		cpumesh->setBoundingBox(mesh.meshBuffer->getBoundingBox());
+		cpumesh->getMeshBufferVector().emplace_back(std::move(mesh.meshBuffer));
+		meshes.push_back(std::move(cpumesh));
 	}
-	_NBL_ALIGNED_FREE(data);
 
 	return SAssetBundle(std::move(meta),std::move(meshes));
 }
 
-
 }
 }
 }
@@ -9,10 +9,14 @@
 
 #include <bzip2/bzlib.h>
 
+#include <mutex>
+
 
 #include "nbl/nblpack.h"
 struct SZIPFileCentralDirFileHeader
 {
+	static inline constexpr uint32_t ExpectedSig = 0x02014b50u;
+
 	uint32_t Sig;	// 'PK0102' (0x02014b50)
 	uint16_t VersionMadeBy;
 	uint16_t VersionToExtract;
@@ -50,6 +54,31 @@ struct SZIPFileCentralDirEnd
 	uint16_t CommentLength;	// zipfile comment length
 	// zipfile comment (variable size)
 } PACK_STRUCT;
+struct SZIP64CentralDirEndLocator
+{
+	static inline constexpr uint32_t ExpectedSig = 0x07064b50u;
+
+	uint32_t Sig;			// 'PK0607'
+	uint32_t NumberStart;	// number of the disk with the start of the zip64 end of central directory
+	uint64_t Offset;		// offset of the zip64 end of central directory record
+	uint32_t TotalDisks;
+} PACK_STRUCT;
+struct SZIP64CentralDirEnd
+{
+	static inline constexpr uint32_t ExpectedSig = 0x06064b50u;
+
+	uint32_t Sig;			// 'PK0606'
+	uint64_t RecordSize;	// size of the remaining record, not counting the first 12 bytes
+	uint16_t VersionMadeBy;
+	uint16_t VersionToExtract;
+	uint32_t NumberDisk;
+	uint32_t NumberStart;
+	uint64_t TotalDisk;
+	uint64_t TotalEntries;
+	uint64_t Size;
+	uint64_t Offset;
+	// zip64 extensible data sector (variable size)
+} PACK_STRUCT;
 struct SZipFileAESExtraData
 {
 	int16_t Version;
@@ -87,12 +116,419 @@ constexpr int16_t ZIP_FILE_ENCRYPTED = 0x0001;
 // the fields crc-32, compressed size and uncompressed size are set to
 // zero in the local header
 constexpr int16_t ZIP_INFO_IN_DATA_DESCRIPTOR = 0x0008;
+// extra field IDs
+constexpr uint16_t ZIP_EXTRA_ZIP64 = 0x0001u;
+constexpr uint16_t ZIP_EXTRA_AES = 0x9901u;
+// 32bit fields of the central directory saturate to this when the real value is in the zip64 extra field
+constexpr uint32_t ZIP64_SATURATED = 0xffffffffu;
 
 
 using namespace nbl;
 using namespace nbl::system;
 
 
+namespace
+{
+
+//! Returns `size` bytes at `offset` straight out of the mapping if there is one, otherwise reads them into `storage`
+const uint8_t* readRange(IFile* file, const size_t offset, const size_t size, core::vector<uint8_t>& storage)
+{
+	const size_t fileSize = file->getSize();
+	if (offset>fileSize || fileSize-offset<size)
+		return nullptr;
+
+	const IFile* cFile = file;
+	if (const auto* mapped=reinterpret_cast<const uint8_t*>(cFile->getMappedPointer()))
+		return mapped+offset;
+
+	storage.resize(size);
+	IFile::success_t success;
+	file->read(success,storage.data(),offset,size);
+	return success ? storage.data():nullptr;
+}
+
+using entry_t = IFileArchive::SFileList::SEntry;
+using metadata_t = CArchiveLoaderZip::SEntryMetadata;
+
+//! Indexes the archive from its central directory, which is a single contiguous read and (unlike local headers) always has the right sizes.
+//! Returns false if there is no valid central directory, in which case the caller has to walk the local headers instead.
+bool readCentralDirectory(IFile* file, core::vector<entry_t>& items, core::vector<metadata_t>& itemsMetadata)
+{
+	const size_t fileSize = file->getSize();
+	if (fileSize<sizeof(SZIPFileCentralDirEnd))
+		return false;
+
+	// the end record can only be followed by a comment of at most 64kb, so we can find it with one read
+	const size_t tailSize = core::min<size_t>(fileSize,sizeof(SZIPFileCentralDirEnd)+0xffffull);
+	core::vector<uint8_t> tailStorage;
+	const uint8_t* const tail = readRange(file,fileSize-tailSize,tailSize,tailStorage);
+	if (!tail)
+		return false;
+
+	size_t dirEndPos = tailSize-sizeof(SZIPFileCentralDirEnd);
+	while (true)
+	{
+		uint32_t sig;
+		memcpy(&sig,tail+dirEndPos,sizeof(sig));
+		if (sig==SZIPFileCentralDirEnd::ExpectedSig)
+			break;
+		if (dirEndPos==0ull)
+			return false;
+		dirEndPos--;
+	}
+	SZIPFileCentralDirEnd dirEnd;
+	memcpy(&dirEnd,tail+dirEndPos,sizeof(dirEnd));
+
+	uint64_t entryCount = dirEnd.TotalEntries;
+	uint64_t dirSize = dirEnd.Size;
+	uint64_t dirOffset = dirEnd.Offset;
+	// ZIP64 archives put a locator of the real end record right in front of the regular one
+	if (dirEndPos>=sizeof(SZIP64CentralDirEndLocator))
+	{
+		SZIP64CentralDirEndLocator locator;
+		memcpy(&locator,tail+dirEndPos-sizeof(locator),sizeof(locator));
+		if (locator.Sig==SZIP64CentralDirEndLocator::ExpectedSig)
+		{
+			core::vector<uint8_t> storage;
+			const uint8_t* const ptr = readRange(file,locator.Offset,sizeof(SZIP64CentralDirEnd),storage);
+			if (!ptr)
+				return false;
+			SZIP64CentralDirEnd dirEnd64;
+			memcpy(&dirEnd64,ptr,sizeof(dirEnd64));
+			if (dirEnd64.Sig!=SZIP64CentralDirEnd::ExpectedSig)
+				return false;
+			entryCount = dirEnd64.TotalEntries;
+			dirSize = dirEnd64.Size;
+			dirOffset = dirEnd64.Offset;
+		}
+	}
+	// every entry takes at least a fixed header, don't let a corrupt count make us reserve the world
+	if (entryCount>dirSize/sizeof(SZIPFileCentralDirFileHeader))
+		return false;
+
+	core::vector<uint8_t> dirStorage;
+	const uint8_t* dir = readRange(file,dirOffset,dirSize,dirStorage);
+	if (!dir)
+		return false;
+	const uint8_t* const dirEndPtr = dir+dirSize;
+
+	items.reserve(entryCount);
+	itemsMetadata.reserve(entryCount);
+	for (uint64_t i=0ull; i<entryCount; i++)
+	{
+		SZIPFileCentralDirFileHeader entry;
+		if (size_t(dirEndPtr-dir)<sizeof(entry))
+			return false;
+		memcpy(&entry,dir,sizeof(entry));
+		if (entry.Sig!=SZIPFileCentralDirFileHeader::ExpectedSig)
+			return false;
+
+		const char* const name = reinterpret_cast<const char*>(dir+sizeof(entry));
+		const uint8_t* const extra = dir+sizeof(entry)+entry.FilenameLength;
+		const uint8_t* const extraEnd = extra+entry.ExtraFieldLength;
+		const uint8_t* const next = extraEnd+entry.FileCommentLength;
+		if (next>dirEndPtr)
+			return false;
+		dir = next;
+
+		metadata_t meta = {};
+		meta.CompressedSize = entry.CompressedSize;
+		meta.LocalHeaderOffset = entry.RelativeOffsetOfLocalHeader;
+		meta.CRC32 = entry.CRC32;
+		meta.GeneralBitFlag = entry.GeneralBitFlag;
+		meta.CompressionMethod = entry.CompressionMethod;
+		uint64_t size = entry.UncompressedSize;
+
+		bool skip = false;
+		for (const uint8_t* field=extra; field+sizeof(SZipFileExtraHeader)<=extraEnd; )
+		{
+			SZipFileExtraHeader extraHeader;
+			memcpy(&extraHeader,field,sizeof(extraHeader));
+			const uint8_t* data = field+sizeof(extraHeader);
+			const uint8_t* const dataEnd = data+uint16_t(extraHeader.Size);
+			if (dataEnd>extraEnd)
+				break;
+			field = dataEnd;
+
+			if (extraHeader.ID==ZIP_EXTRA_ZIP64)
+			{
+				// only the fields which overflowed are present, always in this order
+				auto read64 = [&data,dataEnd](uint64_t& value) -> void
+				{
+					if (data+sizeof(value)>dataEnd)
+						return;
+					memcpy(&value,data,sizeof(value));
+					data += sizeof(value);
+				};
+				if (entry.UncompressedSize==ZIP64_SATURATED)
+					read64(size);
+				if (entry.CompressedSize==ZIP64_SATURATED)
+					read64(meta.CompressedSize);
+				if (entry.RelativeOffsetOfLocalHeader==ZIP64_SATURATED)
+					read64(meta.LocalHeaderOffset);
+			}
+			else if (extraHeader.ID==ZIP_EXTRA_AES && size_t(dataEnd-data)>=sizeof(SZipFileAESExtraData))
+			{
+				SZipFileAESExtraData aes;
+				memcpy(&aes,data,sizeof(aes));
+				if (aes.Vendor[0]=='A' && aes.Vendor[1]=='E')
+				{
+					#ifdef _NBL_COMPILE_WITH_ZIP_ENCRYPTION_
+					// AE-Version | Strength | ActualMode
+					meta.AESInfo = ((aes.Version&0xff)<<24)|(uint32_t(aes.EncryptionStrength)<<16)|uint16_t(aes.CompressionMode);
+					#else
+					skip = true; // no support, can't decrypt
+					#endif
+				}
+			}
+		}
+		// we need to have a filename or we skip
+		if (skip || entry.FilenameLength==0u)
+			continue;
+
+		auto& item = items.emplace_back();
+		item.pathRelativeToArchive = std::string(name,entry.FilenameLength);
+		item.size = size;
+		item.offset = meta.LocalHeaderOffset;
+		item.ID = itemsMetadata.size();
+		if (name[entry.FilenameLength-1u]=='/')
+			item.allocatorType = IFileArchive::EAT_NONE;
+		else
+			item.allocatorType = meta.CompressionMethod ? IFileArchive::EAT_VIRTUAL_ALLOC:IFileArchive::EAT_NULL;
+		itemsMetadata.push_back(meta);
+	}
+	return true;
+}
+
+#ifdef _NBL_COMPILE_WITH_ZLIB_
+// deflated entries at least this big get inflated on demand instead of up-front
+constexpr size_t LazyInflateThreshold = 256ull<<10u;
+#endif
+
+//! An entry which is read straight out of the archive (stored) or decompressed on demand (deflate), instead of all at once on open.
+//! Decompressed data is kept in a small LRU of windows and the inflate state gets snapshotted every `CheckpointSpacing` bytes,
+//! so random access costs at most one checkpoint's worth of decompression.
+class CZipEntryFile final : public IFile
+{
+	public:
+		enum class E_MODE : uint8_t
+		{
+			STORED,
+			DEFLATED
+		};
+
+		inline CZipEntryFile(path&& _filename, const core::bitflag<E_CREATE_FLAGS> _flags, core::smart_refctd_ptr<IFile>&& _archive,
+			const size_t _dataOffset, const size_t _compressedSize, const size_t _size, const E_MODE _mode
+		) : IFile(std::move(_filename),_flags), m_archive(std::move(_archive)), m_dataOffset(_dataOffset), m_compressedSize(_compressedSize), m_size(_size), m_mode(_mode)
+		{
+		}
+
+		inline size_t getSize() const override {return m_size;}
+
+	protected:
+		inline ~CZipEntryFile()
+		{
+			#ifdef _NBL_COMPILE_WITH_ZLIB_
+			if (m_streamReady)
+				inflateEnd(&m_stream);
+			for (auto& checkpoint : m_checkpoints)
+				inflateEnd(&checkpoint.stream);
+			#endif
+		}
+
+		inline void* getMappedPointer_impl() override {return nullptr;}
+		inline const void* getMappedPointer_impl() const override {return nullptr;}
+
+		inline void unmappedRead(ISystem::future_t<size_t>& fut, void* buffer, size_t offset, size_t sizeToRead) override
+		{
+			if (offset>=m_size)
+			{
+				set_result(fut,0ull);
+				return;
+			}
+			sizeToRead = core::min(sizeToRead,m_size-offset);
+			if (m_mode==E_MODE::STORED)
+			{
+				m_archive->read(fut,buffer,m_dataOffset+offset,sizeToRead);
+				return;
+			}
+
+			size_t done = 0ull;
+			#ifdef _NBL_COMPILE_WITH_ZLIB_
+			std::lock_guard lock(m_mutex);
+			auto* out = reinterpret_cast<uint8_t*>(buffer);
+			while (done<sizeToRead)
+			{
+				const size_t pos = offset+done;
+				const SWindow* window = getWindow(pos/WindowSize);
+				if (!window)
+					break;
+				const size_t inWindow = pos%WindowSize;
+				const size_t count = core::min(sizeToRead-done,window->size-inWindow);
+				memcpy(out+done,window->data.data()+inWindow,count);
+				done += count;
+			}
+			#endif
+			set_result(fut,done);
+		}
+
+	private:
+		#ifdef _NBL_COMPILE_WITH_ZLIB_
+		constexpr static inline size_t WindowSize = 64ull<<10u;
+		constexpr static inline uint32_t MaxWindows = 8u;
+		constexpr static inline size_t InputChunkSize = 64ull<<10u;
+		constexpr static inline size_t CheckpointSpacing = 1ull<<20u;
+		static_assert(CheckpointSpacing%WindowSize==0ull);
+
+		struct SWindow
+		{
+			size_t index;
+			size_t size;
+			uint64_t lastUse;
+			core::vector<uint8_t> data;
+		};
+		struct SCheckpoint
+		{
+			z_stream stream;
+			// compressed bytes consumed by `stream`
+			size_t inputOffset;
+		};
+
+		inline const SWindow* getWindow(const size_t index)
+		{
+			for (auto& window : m_windows)
+			if (window.index==index)
+			{
+				window.lastUse = ++m_useCounter;
+				return &window;
+			}
+
+			SWindow* slot;
+			if (m_windows.size()<MaxWindows)
+			{
+				slot = &m_windows.emplace_back();
+				slot->data.resize(WindowSize);
+			}
+			else
+				slot = &*std::min_element(m_windows.begin(),m_windows.end(),[](const SWindow& lhs, const SWindow& rhs){return lhs.lastUse<rhs.lastUse;});
+			slot->index = ~0ull;
+
+			if (!seek(index*WindowSize,slot->data.data()))
+				return nullptr;
+			const size_t size = core::min(WindowSize,m_size-index*WindowSize);
+			if (!inflateWindow(slot->data.data(),size))
+				return nullptr;
+			slot->index = index;
+			slot->size = size;
+			slot->lastUse = ++m_useCounter;
+			return slot;
+		}
+
+		//! Gets the stream to output position `target`, using `scratch` to throw away the decompressed bytes in between
+		inline bool seek(const size_t target, uint8_t* scratch)
+		{
+			if (!m_streamReady)
+			{
+				m_stream = {};
+				if (inflateInit2(&m_stream,-MAX_WBITS)!=Z_OK)
+					return false;
+				m_streamReady = true;
+			}
+
+			const size_t checkpoint = core::min<size_t>(target/CheckpointSpacing,m_checkpoints.size());
+			if (target<m_outputOffset || checkpoint*CheckpointSpacing>m_outputOffset)
+			{
+				if (checkpoint)
+				{
+					auto& src = m_checkpoints[checkpoint-1u];
+					inflateEnd(&m_stream);
+					if (inflateCopy(&m_stream,&src.stream)!=Z_OK)
+					{
+						m_streamReady = false;
+						return false;
+					}
+					m_inputOffset = src.inputOffset;
+				}
+				else
+				{
+					inflateReset(&m_stream);
+					m_inputOffset = 0ull;
+				}
+				m_stream.avail_in = 0u;
+				m_outputOffset = checkpoint*CheckpointSpacing;
+			}
+
+			while (m_outputOffset<target)
+			if (!inflateWindow(scratch,WindowSize))
+				return false;
+			return true;
+		}
+
+		//! Decompresses exactly `size` bytes at the current position, snapshots the stream when it crosses a checkpoint boundary
+		inline bool inflateWindow(uint8_t* dst, const size_t size)
+		{
+			m_stream.next_out = dst;
+			m_stream.avail_out = size;
+			while (m_stream.avail_out)
+			{
+				if (m_stream.avail_in==0u && m_inputOffset<m_compressedSize)
+				{
+					const size_t count = core::min(InputChunkSize,m_compressedSize-m_inputOffset);
+					m_input.resize(InputChunkSize);
+					IFile::success_t success;
+					m_archive->read(success,m_input.data(),m_dataOffset+m_inputOffset,count);
+					if (!success)
+						return false;
+					m_inputOffset += count;
+					m_stream.next_in = m_input.data();
+					m_stream.avail_in = count;
+				}
+
+				const int err = inflate(&m_stream,Z_NO_FLUSH);
+				if (err==Z_STREAM_END)
+					break;
+				if (err!=Z_OK && !(err==Z_BUF_ERROR && m_inputOffset<m_compressedSize))
+					return false;
+			}
+			const size_t produced = size-m_stream.avail_out;
+			m_outputOffset += produced;
+			if (produced!=size)
+				return false;
+
+			if (m_outputOffset%CheckpointSpacing==0ull && m_outputOffset/CheckpointSpacing==m_checkpoints.size()+1u)
+			{
+				auto& checkpoint = m_checkpoints.emplace_back();
+				if (inflateCopy(&checkpoint.stream,&m_stream)!=Z_OK)
+					m_checkpoints.pop_back();
+				else
+					checkpoint.inputOffset = m_inputOffset-m_stream.avail_in;
+			}
+			return true;
+		}
+		#endif
+
+		core::smart_refctd_ptr<IFile> m_archive;
+		const size_t m_dataOffset;
+		const size_t m_compressedSize;
+		const size_t m_size;
+		const E_MODE m_mode;
+
+		#ifdef _NBL_COMPILE_WITH_ZLIB_
+		std::mutex m_mutex;
+		z_stream m_stream;
+		bool m_streamReady = false;
+		size_t m_inputOffset = 0ull;
+		size_t m_outputOffset = 0ull;
+		core::vector<uint8_t> m_input;
+		core::vector<SWindow> m_windows;
+		uint64_t m_useCounter = 0ull;
+		// `z_stream` must not move after `inflateCopy`, hence a deque
+		core::deque<SCheckpoint> m_checkpoints;
+		#endif
+};
+
+}
+
 core::smart_refctd_ptr<IFileArchive> CArchiveLoaderZip::createArchive_impl(core::smart_refctd_ptr<system::IFile>&& file, const std::string_view& password) const
 {
 	if (!file)
@@ -107,13 +543,13 @@ core::smart_refctd_ptr<IFileArchive> CArchiveLoaderZip::createArchive_impl(core:
 	}
 
 	std::shared_ptr<core::vector<IFileArchive::SFileList::SEntry>> items = std::make_shared<core::vector<IFileArchive::SFileList::SEntry>>();
-	core::vector<SZIPFileHeader> itemsMetadata;
+	core::vector<SEntryMetadata> itemsMetadata;
 	// load file entries
 	{
 		const bool isGZip = sig==0x8b1fu;
 
 		//
-		auto addItem = [&items,&itemsMetadata](const std::string& _path, const size_t offset, const SZIPFileHeader& meta) -> void
+		auto addItem = [&items,&itemsMetadata](const std::string& _path, const size_t size, const size_t offset, const SEntryMetadata& meta) -> void
 		{
 			// we need to have a filename or we skip
 			if (_path.empty())
@@ -121,7 +557,7 @@ core::smart_refctd_ptr<IFileArchive> CArchiveLoaderZip::createArchive_impl(core:
 
 			auto& item = items->emplace_back();
 			item.pathRelativeToArchive = _path;
-			item.size = meta.DataDescriptor.UncompressedSize;
+			item.size = size;
 			item.offset = offset;
 			item.ID = itemsMetadata.size();
 			item.allocatorType = meta.CompressionMethod ? IFileArchive::EAT_VIRTUAL_ALLOC:IFileArchive::EAT_NULL;
@@ -132,20 +568,27 @@ core::smart_refctd_ptr<IFileArchive> CArchiveLoaderZip::createArchive_impl(core:
 		size_t offset = 0ull;
 		auto readStringFromFile = [&file,&offset](auto charCallback) -> bool
 		{
-			char c = 0x45; // make sure we start with non-zero char
-			while (c)
+			// read in chunks, not a request per character
+			char chunk[256];
+			while (offset<file->getSize())
 			{
+				const size_t count = core::min<size_t>(sizeof(chunk),file->getSize()-offset);
 				IFile::success_t success;
-				file->read(success,&c,offset,sizeof(c));
+				file->read(success,chunk,offset,count);
 				if (!success)
 					return false;
-				offset += success.getBytesToProcess();
-				charCallback(c);
+				for (size_t i=0ull; i<count; i++)
+				{
+					offset++;
+					if (!chunk[i])
+						return true;
+					charCallback(chunk[i]);
+				}
 			}
 			// if string is not null terminated, something went wrong reading the file
-			return !c;
+			return false;
 		};
-		
+
 		//
 		std::string filename;
 		filename.reserve(ISystem::MAX_FILENAME_LENGTH);
@@ -164,7 +607,7 @@ core::smart_refctd_ptr<IFileArchive> CArchiveLoaderZip::createArchive_impl(core:
 			//! TODO: But OLD Irrlicht Impl doesn't honor it!?
 			if (gzipHeader.sig!=0x8b1fu)
 				return nullptr;
-			
+
 			// now get the file info
 			if (gzipHeader.flags&EGZF_EXTRA_FIELDS)
 			{
@@ -195,38 +638,36 @@ core::smart_refctd_ptr<IFileArchive> CArchiveLoaderZip::createArchive_impl(core:
 			if (gzipHeader.flags&EGZF_CRC16)
 				offset += 2;
 
+			if (file->getSize()<offset+sizeof(uint64_t))
+				return nullptr;
 
-			SZIPFileHeader header;
-			memset(&header,0,sizeof(SZIPFileHeader));
-			header.FilenameLength = filename.length();
-			header.CompressionMethod = gzipHeader.compressionMethod;
-			header.DataDescriptor.CompressedSize = file->getSize()-(offset+sizeof(uint64_t));
+			SEntryMetadata meta = {};
+			meta.LocalHeaderOffset = SEntryMetadata::NoLocalHeader;
+			meta.CompressionMethod = gzipHeader.compressionMethod;
+			meta.CompressedSize = file->getSize()-(offset+sizeof(uint64_t));
 
 			const size_t itemOffset = offset;
-			
-			offset += header.DataDescriptor.CompressedSize;
-			// read CRC
-			{
-				IFile::success_t success;
-				file->read(success,&header.DataDescriptor.CRC32,offset,sizeof(header.DataDescriptor.CRC32));
-				if (!success)
-					return nullptr;
-				offset += success.getBytesToProcess();
-			}
-			// read uncompressed size
+
+			offset += meta.CompressedSize;
+			// CRC and uncompressed size trail the data
+			uint32_t trailer[2];
 			{
 				IFile::success_t success;
-				file->read(success,&header.DataDescriptor.UncompressedSize,offset,sizeof(header.DataDescriptor.UncompressedSize));
+				file->read(success,trailer,offset,sizeof(trailer));
 				if (!success)
 					return nullptr;
 				offset += success.getBytesToProcess();
 			}
+			meta.CRC32 = trailer[0];
 
 			//
-			addItem(filename,itemOffset,header);
+			addItem(filename,trailer[1],itemOffset,meta);
 		}
-		else
+		else if (!readCentralDirectory(file.get(),*items,itemsMetadata))
 		{
+			// no (valid) central directory, so walk the local headers
+			items->clear();
+			itemsMetadata.clear();
 			while (true)
 			{
 				SZIPFileHeader zipHeader;
@@ -250,6 +691,13 @@ core::smart_refctd_ptr<IFileArchive> CArchiveLoaderZip::createArchive_impl(core:
 					offset += success.getBytesToProcess();
 				}
 
+				SEntryMetadata meta = {};
+				meta.CompressedSize = zipHeader.DataDescriptor.CompressedSize;
+				meta.LocalHeaderOffset = SEntryMetadata::NoLocalHeader;
+				meta.CRC32 = zipHeader.DataDescriptor.CRC32;
+				meta.GeneralBitFlag = zipHeader.GeneralBitFlag;
+				meta.CompressionMethod = zipHeader.CompressionMethod;
+
 				// AES encryption
 				if ((zipHeader.GeneralBitFlag&ZIP_FILE_ENCRYPTED) && (zipHeader.CompressionMethod==99))
 				{
@@ -270,8 +718,11 @@ core::smart_refctd_ptr<IFileArchive> CArchiveLoaderZip::createArchive_impl(core:
 								break;
 						}
 
-						if (extraHeader.ID!=0x9901u)
+						if (extraHeader.ID!=ZIP_EXTRA_AES)
+						{
+							localOffset += uint16_t(extraHeader.Size);
 							continue;
+						}
 
 						{
 							IFile::success_t success;
@@ -285,50 +736,31 @@ core::smart_refctd_ptr<IFileArchive> CArchiveLoaderZip::createArchive_impl(core:
 						if (data.Vendor[0]=='A' && data.Vendor[1]=='E')
 						{
 							#ifdef _NBL_COMPILE_WITH_ZIP_ENCRYPTION_
-							// encode values into Sig
 							// AE-Version | Strength | ActualMode
-							zipHeader.Sig =
+							meta.AESInfo =
 								((data.Version & 0xff) << 24) |
-								(data.EncryptionStrength << 16) |
-								(data.CompressionMode);
-							break;
+								(uint32_t(data.EncryptionStrength) << 16) |
+								uint16_t(data.CompressionMode);
 							#else
 							filename.clear(); // no support, can't decrypt
 							#endif
 						}
+						break;
 					}
 				}
 				else
 					offset += zipHeader.ExtraFieldLength;
 
-				// if bit 3 was set, use CentralDirectory for setup
+				// if bit 3 was set the sizes are only in the central directory, which we already failed to read
 				if (zipHeader.GeneralBitFlag&ZIP_INFO_IN_DATA_DESCRIPTOR)
 				{
-					SZIPFileCentralDirEnd dirEnd;
-					dirEnd.Sig = 0u;
-
-					// First place where the end record could be stored
-					offset = file->getSize()-sizeof(SZIPFileCentralDirEnd)+1ull;
-					while (dirEnd.Sig!=SZIPFileCentralDirEnd::ExpectedSig)
-					{
-						IFile::success_t success;
-						file->read(success,&dirEnd,--offset,sizeof(dirEnd));
-						if (!success)
-							return nullptr;
-					}
-					items->reserve(dirEnd.TotalEntries);
-					itemsMetadata.reserve(dirEnd.TotalEntries);
-					offset = dirEnd.Offset;
-					#if 0
-					while (scanCentralDirectoryHeader(offset)) {}
-					#endif
-					assert(false); // if you ever hit this, msg @devsh
+					m_logger.log("ZIP Archive %s has entries without sizes in their local headers and no readable central directory.",ILogger::ELL_ERROR,file->getFileName().string().c_str());
 					break;
 				}
-			
-				addItem(filename,offset,zipHeader);
+
+				addItem(filename,zipHeader.DataDescriptor.UncompressedSize,offset,meta);
 				// move forward length of data
-				offset += zipHeader.DataDescriptor.CompressedSize;
+				offset += meta.CompressedSize;
 			}
 		}
 	}
@@ -340,32 +772,56 @@ core::smart_refctd_ptr<IFileArchive> CArchiveLoaderZip::createArchive_impl(core:
 	return core::make_smart_refctd_ptr<CArchive>(std::move(file),core::smart_refctd_ptr(m_logger.get()), items, std::move(itemsMetadata));
 }
 
-#if 0
-bool CFileArchiveZip::scanCentralDirectoryHeader(size_t& offset)
+size_t CArchiveLoaderZip::CArchive::getDataOffset(const IFileArchive::SFileList::found_t& item) const
+{
+	const auto& meta = m_itemsMetadata[item->ID];
+	if (meta.LocalHeaderOffset==SEntryMetadata::NoLocalHeader)
+		return item->offset;
+
+	SZIPFileHeader header;
+	IFile::success_t success;
+	m_file->read(success,&header,meta.LocalHeaderOffset,sizeof(header));
+	if (!success || header.Sig!=0x04034b50u)
+		return ~0ull;
+	return meta.LocalHeaderOffset+sizeof(header)+uint16_t(header.FilenameLength)+uint16_t(header.ExtraFieldLength);
+}
+
+core::smart_refctd_ptr<IFile> CArchiveLoaderZip::CArchive::getFile_impl(const SFileList::found_t& found, const core::bitflag<IFileBase::E_CREATE_FLAGS> flags, const std::string_view& password)
 {
-	std::filesystem::path ZipFileName = "";
-	SZIPFileCentralDirFileHeader entry;
+	if (found->allocatorType==EAT_NONE)
+		return nullptr;
+
+	const auto& meta = m_itemsMetadata[found->ID];
+	if (!(meta.GeneralBitFlag&ZIP_FILE_ENCRYPTED))
 	{
-		system::future<size_t> fut;
-		m_file->read(fut, &entry, offset, sizeof(SZIPFileCentralDirFileHeader));
-		fut.get();
-		offset += sizeof(SZIPFileCentralDirFileHeader);
+		const IFile* cFile = m_file.get();
+		std::optional<CZipEntryFile::E_MODE> mode;
+		// stored entries only need the mapping to be pointed into, without one we read through to the archive
+		if (meta.CompressionMethod==0u && !cFile->getMappedPointer())
+			mode = CZipEntryFile::E_MODE::STORED;
+		#ifdef _NBL_COMPILE_WITH_ZLIB_
+		else if (meta.CompressionMethod==8u && found->size>=LazyInflateThreshold)
+			mode = CZipEntryFile::E_MODE::DEFLATED;
+		#endif
+		if (mode)
+		{
+			const size_t dataOffset = getDataOffset(found);
+			if (dataOffset==~0ull)
+			{
+				m_logger.log("Broken local header for %s in ZIP Archive.",ILogger::ELL_ERROR,found->pathRelativeToArchive.string().c_str());
+				return nullptr;
+			}
+			// mapping is just a hint for archived files, these can't provide one
+			auto lazyFlags = flags;
+			lazyFlags &= ~core::bitflag<IFileBase::E_CREATE_FLAGS>(IFileBase::ECF_COHERENT);
+			return core::make_smart_refctd_ptr<CZipEntryFile>(
+				getDefaultAbsolutePath()/found->pathRelativeToArchive,lazyFlags,
+				core::smart_refctd_ptr(m_file),dataOffset,meta.CompressedSize,found->size,mode.value()
+			);
+		}
 	}
-
-	if (entry.Sig != 0x02014b50)
-		return false; // central dir headers end here.
-
-	const long pos = offset;
-	offset = entry.RelativeOffsetOfLocalHeader;
-	scanZipHeader(offset, true);
-	offset = pos + entry.FilenameLength + entry.ExtraFieldLength + entry.FileCommentLength;
-	m_fileInfo.back().header.DataDescriptor.CompressedSize = entry.CompressedSize;
-	m_fileInfo.back().header.DataDescriptor.UncompressedSize = entry.UncompressedSize;
-	m_fileInfo.back().header.DataDescriptor.CRC32 = entry.CRC32;
-	m_files.back().size = entry.UncompressedSize;
-	return true;
+	return CFileArchive::getFile_impl(found,flags,password);
 }
-#endif
 
 CFileArchive::file_buffer_t CArchiveLoaderZip::CArchive::getFileBuffer(const IFileArchive::SFileList::found_t& item)
 {
@@ -393,7 +849,7 @@ CFileArchive::file_buffer_t CArchiveLoaderZip::CArchive::getFileBuffer(const IFi
 	CFileArchive::file_buffer_t retval = { nullptr,item->size,nullptr };
 	//
 	void* decrypted = nullptr;
-	size_t decryptedSize = header.DataDescriptor.CompressedSize;
+	size_t decryptedSize = header.CompressedSize;
 	auto freeOnFail = core::makeRAIIExiter([&actualCompressionMethod,&retval,&decrypted,&decryptedSize](){
 		if (decrypted && retval.buffer!=decrypted)
 		{
@@ -410,19 +866,49 @@ CFileArchive::file_buffer_t CArchiveLoaderZip::CArchive::getFileBuffer(const IFi
 			VirtualMemoryAllocator(nullptr).dealloc(decompressed,item->size);
 	});
 
+	// only AES gets decrypted, traditional PKWARE encryption ("ZipCrypto") would hand out the ciphertext, or for stored entries
+	// of unmapped archives a pointer into the read buffer below which dies with this function
+	if ((header.GeneralBitFlag&ZIP_FILE_ENCRYPTED) && header.CompressionMethod!=99)
+	{
+		m_logger.log("%s in ZIP Archive uses unsupported encryption, only AES is supported.",ILogger::ELL_ERROR,item->pathRelativeToArchive.string().c_str());
+		return retval;
+	}
+
+	const size_t dataOffset = getDataOffset(item);
+	if (dataOffset==~0ull)
+	{
+		m_logger.log("Broken local header for %s in ZIP Archive.",ILogger::ELL_ERROR,item->pathRelativeToArchive.string().c_str());
+		return retval;
+	}
 	const auto* const cFile = m_file.get();
 	void* const filePtr = const_cast<void*>(cFile->getMappedPointer());
-	std::byte* mmapPtr = reinterpret_cast<std::byte*>(filePtr)+item->offset;
+	std::byte* mmapPtr;
+	// without a mapping the compressed data has to be brought in first, in one go
+	core::vector<std::byte> compressed;
+	if (filePtr)
+		mmapPtr = reinterpret_cast<std::byte*>(filePtr)+dataOffset;
+	else
+	{
+		compressed.resize(header.CompressedSize);
+		IFile::success_t success;
+		m_file->read(success,compressed.data(),dataOffset,compressed.size());
+		if (!success)
+		{
+			m_logger.log("Could not read %s from ZIP Archive.",ILogger::ELL_ERROR,item->pathRelativeToArchive.string().c_str());
+			return retval;
+		}
+		mmapPtr = compressed.data();
+	}
 
 	// decrypt
 	if ((header.GeneralBitFlag&ZIP_FILE_ENCRYPTED) && (header.CompressionMethod==99))
 	{
 		const uint8_t* salt = reinterpret_cast<uint8_t*>(mmapPtr);
 	#ifdef _NBL_COMPILE_WITH_ZIP_ENCRYPTION_
-		const uint16_t saltSize = ((header.Sig>>14u)&0x3fcu)+4u;
+		const uint16_t saltSize = ((header.AESInfo>>14u)&0x3fcu)+4u;
 		{
 			const size_t reduction = saltSize+12u;
-			if (header.DataDescriptor.CompressedSize<=reduction)
+			if (header.CompressedSize<=reduction)
 				return retval;
 			decryptedSize -= reduction;
 		}
@@ -433,7 +919,7 @@ CFileArchive::file_buffer_t CArchiveLoaderZip::CArchive::getFileBuffer(const IFi
 
 		fcrypt_ctx zctx; // the encryption context
 		int rc = fcrypt_init(
-			(header.Sig>>16u)&0xffu,
+			(header.AESInfo>>16u)&0xffu,
 			(const unsigned char*)m_password.c_str(), // the password
 			m_password.size(), // number of bytes in password
 			salt, // the salt
@@ -483,7 +969,7 @@ CFileArchive::file_buffer_t CArchiveLoaderZip::CArchive::getFileBuffer(const IFi
 			return retval;
 		}
 
-		actualCompressionMethod = (header.Sig & 0xffff);
+		actualCompressionMethod = (header.AESInfo & 0xffff);
 	#endif
 	}
 	//
@@ -499,6 +985,8 @@ CFileArchive::file_buffer_t CArchiveLoaderZip::CArchive::getFileBuffer(const IFi
 	switch (actualCompressionMethod)
 	{
 		case 0: // no compression
+			// without a mapping only decrypted data has an allocation of its own which can outlive `compressed`
+			assert(decrypted || filePtr);
 			if (decrypted)
 				retval.buffer = decrypted;
 			else
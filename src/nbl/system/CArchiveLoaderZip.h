@@ -33,6 +33,21 @@ class CArchiveLoaderZip final : public IArchiveLoader
 			// extra field (variable size )
 		} PACK_STRUCT;
 		#include "nbl/nblunpack.h"
+		//! What we keep around per entry, filled from the central directory (or local headers if there's none)
+		struct SEntryMetadata
+		{
+			static inline constexpr uint64_t NoLocalHeader = ~0ull;
+
+			uint64_t CompressedSize;
+			// local header's name and extra field lengths can differ from the central directory's, so the data offset gets resolved on open,
+			// `NoLocalHeader` means the entry's offset already points at the data
+			uint64_t LocalHeaderOffset;
+			uint32_t CRC32;
+			// AE-Version | Strength | ActualMode, for AES encrypted entries
+			uint32_t AESInfo;
+			uint16_t GeneralBitFlag;
+			uint16_t CompressionMethod;
+		};
 		class CArchive final : public CFileArchive
 		{
 			public:
@@ -40,16 +55,22 @@ class CArchiveLoaderZip final : public IArchiveLoader
 					core::smart_refctd_ptr<IFile>&& _file,
 					system::logger_opt_smart_ptr&& logger,
 					std::shared_ptr<core::vector<IFileArchive::SFileList::SEntry>> _items,
-					core::vector<SZIPFileHeader>&& _itemsMetadata
+					core::vector<SEntryMetadata>&& _itemsMetadata
 				) : CFileArchive(path(_file->getFileName()),std::move(logger),_items),
 					m_file(std::move(_file)), m_itemsMetadata(std::move(_itemsMetadata)), m_password("")
 				{}
 
+			protected:
+				//! Big deflated entries (and any stored entries of an archive which isn't mapped) are opened as files which decompress on demand
+				core::smart_refctd_ptr<IFile> getFile_impl(const SFileList::found_t& found, const core::bitflag<IFileBase::E_CREATE_FLAGS> flags, const std::string_view& password) override;
+
 			private:
 				file_buffer_t getFileBuffer(const IFileArchive::SFileList::found_t& item) override;
+				//! returns `~0ull` if the local header is broken
+				size_t getDataOffset(const IFileArchive::SFileList::found_t& item) const;
 
 				core::smart_refctd_ptr<IFile> m_file;
-				core::vector<SZIPFileHeader> m_itemsMetadata;
+				core::vector<SEntryMetadata> m_itemsMetadata;
 				const std::string m_password; // TODO password
 		};
 
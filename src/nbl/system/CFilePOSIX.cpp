@@ -26,15 +26,16 @@ CFilePOSIX::~CFilePOSIX()
 	close(m_native);
 }
 
+// positional I/O so that reads issued from multiple threads don't race on the file offset
 size_t CFilePOSIX::asyncRead(void* buffer, size_t offset, size_t sizeToRead)
 {
-	lseek(m_native, offset, SEEK_SET);
-	return ::read(m_native, buffer, sizeToRead);
+	const auto retval = ::pread(m_native, buffer, sizeToRead, offset);
+	return retval<0 ? 0ull:static_cast<size_t>(retval);
 }
 
 size_t CFilePOSIX::asyncWrite(const void* buffer, size_t offset, size_t sizeToWrite)
 {
-	lseek(m_native, offset, SEEK_SET);
-	return ::write(m_native, buffer, sizeToWrite);
+	const auto retval = ::pwrite(m_native, buffer, sizeToWrite, offset);
+	return retval<0 ? 0ull:static_cast<size_t>(retval);
 }
 #endif
\ No newline at end of file
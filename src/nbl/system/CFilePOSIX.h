@@ -23,6 +23,9 @@ class CFilePOSIX : public ISystemFile
 		//
 		inline size_t getSize() const override {return m_size;}
 
+		//
+		inline native_file_handle_t getNativeHandle() const {return m_native;}
+
 	protected:
 		~CFilePOSIX();
 
@@ -0,0 +1,348 @@
+#include "nbl/system/CFileReadQueueLinux.h"
+
+using namespace nbl;
+using namespace nbl::system;
+
+#ifdef _NBL_PLATFORM_LINUX_
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <cerrno>
+
+#if __has_include(<linux/io_uring.h>) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+// headers from before 5.6 have no `IORING_OP_READ`, it's an enumerator so there's nothing to `#ifdef`,
+// but this feature bit came in the same release, without it we just build the thread pool path
+#ifdef IORING_FEAT_RW_CUR_POS
+#define _NBL_IO_URING_AVAILABLE_
+#endif
+#endif
+
+namespace
+{
+#ifdef _NBL_IO_URING_AVAILABLE_
+// we don't depend on liburing, the raw interface is small enough
+inline int io_uring_setup(const uint32_t entries, io_uring_params* p)
+{
+	return static_cast<int>(syscall(__NR_io_uring_setup,entries,p));
+}
+inline int io_uring_enter(const int fd, const uint32_t toSubmit, const uint32_t minComplete, const uint32_t flags)
+{
+	return static_cast<int>(syscall(__NR_io_uring_enter,fd,toSubmit,minComplete,flags,nullptr,0));
+}
+// false only if the kernel positively says it can't do `opcode`, older kernels without the probe get judged by their feature bits
+inline bool io_uring_supports(const int fd, const uint8_t opcode)
+{
+#if defined(IO_URING_OP_SUPPORTED) && defined(__NR_io_uring_register)
+	constexpr uint32_t MaxOps = 256u;
+	alignas(io_uring_probe) uint8_t storage[sizeof(io_uring_probe)+MaxOps*sizeof(io_uring_probe_op)] = {};
+	auto* const probe = reinterpret_cast<io_uring_probe*>(storage);
+	if (syscall(__NR_io_uring_register,fd,IORING_REGISTER_PROBE,probe,MaxOps)<0)
+		return true;
+	return opcode<=probe->last_op && (probe->ops[opcode].flags&IO_URING_OP_SUPPORTED);
+#else
+	return true;
+#endif
+}
+#endif
+// user data of the NOP which wakes up the completion thread on exit
+constexpr uint64_t QuitUserData = ~0ull;
+}
+
+core::smart_refctd_ptr<CFileReadQueueLinux> CFileReadQueueLinux::create(const SCreationParams& params)
+{
+	if (params.queueDepth==0u)
+		return nullptr;
+
+	auto retval = core::smart_refctd_ptr<CFileReadQueueLinux>(new CFileReadQueueLinux(params.queueDepth),core::dont_grab);
+	if (params.forceThreadPool || !retval->initIOUring(params.queueDepth))
+		retval->initThreadPool(params.fallbackWorkerCount);
+	return retval;
+}
+
+CFileReadQueueLinux::CFileReadQueueLinux(const uint32_t depth) : m_slots(depth), m_requests(depth), m_freeHead(0u)
+{
+	for (uint32_t i=0u; i<depth; i++)
+		m_requests[i].next = i+1u<depth ? (i+1u):InvalidRequest;
+}
+
+CFileReadQueueLinux::~CFileReadQueueLinux()
+{
+	// wait for every read in flight to finish so no futures get left hanging
+	const auto depth = static_cast<uint32_t>(m_requests.size());
+	for (uint32_t i=0u; i<depth; i++)
+		m_slots.acquire();
+
+	m_quit = true;
+	if (usesIOUring())
+	{
+#ifdef _NBL_IO_URING_AVAILABLE_
+		pushSubmission(InvalidRequest,IORING_OP_NOP);
+#endif
+	}
+	else
+	{
+		std::unique_lock lock(m_poolLock);
+		m_poolCvar.notify_all();
+	}
+	for (auto& thread : m_threads)
+		thread.join();
+
+	if (usesIOUring())
+	{
+		munmap(m_ring.sqes,m_ring.sqesSize);
+		if (m_ring.cqPtr!=m_ring.sqPtr)
+			munmap(m_ring.cqPtr,m_ring.cqSize);
+		munmap(m_ring.sqPtr,m_ring.sqSize);
+		close(m_ring.fd);
+	}
+}
+
+void CFileReadQueueLinux::submit(const native_file_handle_t fd, ISystem::future_t<size_t>& future, void* buffer, const size_t offset, const size_t size)
+{
+	begin_result(future);
+
+	const auto ix = acquireRequest();
+	auto& req = m_requests[ix];
+	req.future = &future;
+	req.buffer = reinterpret_cast<uint8_t*>(buffer);
+	req.offset = offset;
+	req.size = size;
+	req.done = 0ull;
+	req.fd = fd;
+
+	if (usesIOUring())
+	{
+#ifdef _NBL_IO_URING_AVAILABLE_
+		pushSubmission(ix,IORING_OP_READ);
+#endif
+	}
+	else
+	{
+		std::unique_lock lock(m_poolLock);
+		m_poolQueue.push_back(ix);
+		m_poolCvar.notify_one();
+	}
+}
+
+uint32_t CFileReadQueueLinux::acquireRequest()
+{
+	m_slots.acquire();
+	std::unique_lock lock(m_requestLock);
+	const auto ix = m_freeHead;
+	assert(ix!=InvalidRequest);
+	m_freeHead = m_requests[ix].next;
+	return ix;
+}
+void CFileReadQueueLinux::releaseRequest(const uint32_t ix)
+{
+	{
+		std::unique_lock lock(m_requestLock);
+		m_requests[ix].next = m_freeHead;
+		m_freeHead = ix;
+	}
+	m_slots.release();
+}
+void CFileReadQueueLinux::complete(const uint32_t ix)
+{
+	auto& req = m_requests[ix];
+	auto* const future = req.future;
+	const auto done = req.done;
+	// recycle the slot before waking the waiter, it might immediately submit another read
+	releaseRequest(ix);
+	finish_result(*future,done);
+}
+
+
+bool CFileReadQueueLinux::initIOUring(const uint32_t depth)
+{
+#ifdef _NBL_IO_URING_AVAILABLE_
+	io_uring_params params = {};
+	const int fd = io_uring_setup(depth,&params);
+	// ENOSYS on old kernels, EPERM under restrictive seccomp (containers)
+	if (fd<0)
+		return false;
+	// `IORING_OP_READ` only exists since 5.6, which is also when this feature bit got introduced
+	if (!(params.features&IORING_FEAT_RW_CUR_POS) || !io_uring_supports(fd,IORING_OP_READ))
+	{
+		close(fd);
+		return false;
+	}
+
+	auto& ring = m_ring;
+	ring.sqSize = params.sq_off.array+params.sq_entries*sizeof(uint32_t);
+	ring.cqSize = params.cq_off.cqes+params.cq_entries*sizeof(io_uring_cqe);
+	const bool singleMmap = params.features&IORING_FEAT_SINGLE_MMAP;
+	if (singleMmap)
+		ring.sqSize = ring.cqSize = core::max(ring.sqSize,ring.cqSize);
+
+	ring.sqPtr = mmap(nullptr,ring.sqSize,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,fd,IORING_OFF_SQ_RING);
+	if (ring.sqPtr==MAP_FAILED)
+	{
+		close(fd);
+		return false;
+	}
+	if (singleMmap)
+		ring.cqPtr = ring.sqPtr;
+	else
+	{
+		ring.cqPtr = mmap(nullptr,ring.cqSize,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,fd,IORING_OFF_CQ_RING);
+		if (ring.cqPtr==MAP_FAILED)
+		{
+			munmap(ring.sqPtr,ring.sqSize);
+			close(fd);
+			return false;
+		}
+	}
+	ring.sqesSize = params.sq_entries*sizeof(io_uring_sqe);
+	ring.sqes = mmap(nullptr,ring.sqesSize,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,fd,IORING_OFF_SQES);
+	if (ring.sqes==MAP_FAILED)
+	{
+		if (!singleMmap)
+			munmap(ring.cqPtr,ring.cqSize);
+		munmap(ring.sqPtr,ring.sqSize);
+		close(fd);
+		return false;
+	}
+
+	auto* const sq = reinterpret_cast<uint8_t*>(ring.sqPtr);
+	ring.sqHead = reinterpret_cast<uint32_t*>(sq+params.sq_off.head);
+	ring.sqTail = reinterpret_cast<uint32_t*>(sq+params.sq_off.tail);
+	ring.sqMask = *reinterpret_cast<uint32_t*>(sq+params.sq_off.ring_mask);
+	ring.sqArray = reinterpret_cast<uint32_t*>(sq+params.sq_off.array);
+	auto* const cq = reinterpret_cast<uint8_t*>(ring.cqPtr);
+	ring.cqHead = reinterpret_cast<uint32_t*>(cq+params.cq_off.head);
+	ring.cqTail = reinterpret_cast<uint32_t*>(cq+params.cq_off.tail);
+	ring.cqMask = *reinterpret_cast<uint32_t*>(cq+params.cq_off.ring_mask);
+	ring.cqes = cq+params.cq_off.cqes;
+	// only now we're committed to using io_uring
+	ring.fd = fd;
+
+	m_threads.emplace_back(&CFileReadQueueLinux::reapCompletions,this);
+	return true;
+#else
+	return false;
+#endif
+}
+
+void CFileReadQueueLinux::pushSubmission(const uint32_t ix, const uint8_t opcode)
+{
+#ifdef _NBL_IO_URING_AVAILABLE_
+	std::unique_lock lock(m_submitLock);
+
+	auto& ring = m_ring;
+	// we're the only producer, so a relaxed load of our own tail is fine
+	const uint32_t tail = std::atomic_ref(*ring.sqTail).load(std::memory_order_relaxed);
+	const uint32_t sqIx = tail&ring.sqMask;
+
+	auto& sqe = reinterpret_cast<io_uring_sqe*>(ring.sqes)[sqIx];
+	memset(&sqe,0,sizeof(io_uring_sqe));
+	sqe.opcode = opcode;
+	if (ix!=InvalidRequest)
+	{
+		const auto& req = m_requests[ix];
+		sqe.fd = req.fd;
+		sqe.addr = reinterpret_cast<uint64_t>(req.buffer+req.done);
+		// single reads are capped at 2GB by the kernel anyway, the remainder gets resubmitted
+		sqe.len = static_cast<uint32_t>(core::min<size_t>(req.size-req.done,0x7ffff000ull));
+		sqe.off = req.offset+req.done;
+		sqe.user_data = ix;
+	}
+	else
+		sqe.user_data = QuitUserData;
+	ring.sqArray[sqIx] = sqIx;
+
+	std::atomic_ref(*ring.sqTail).store(tail+1u,std::memory_order_release);
+	// the kernel consumes the SQE during the call, so the SQ can never fill up as long as in-flight count is capped by `m_slots`
+	while (io_uring_enter(ring.fd,1u,0u,0u)<0 && (errno==EINTR || errno==EAGAIN)) {}
+#endif
+}
+
+void CFileReadQueueLinux::reapCompletions()
+{
+#ifdef _NBL_IO_URING_AVAILABLE_
+	auto& ring = m_ring;
+	const auto* const cqes = reinterpret_cast<const io_uring_cqe*>(ring.cqes);
+	for (bool quit=false; !quit; )
+	{
+		io_uring_enter(ring.fd,0u,1u,IORING_ENTER_GETEVENTS);
+
+		uint32_t head = std::atomic_ref(*ring.cqHead).load(std::memory_order_relaxed);
+		const uint32_t tail = std::atomic_ref(*ring.cqTail).load(std::memory_order_acquire);
+		for (; head!=tail; head++)
+		{
+			const auto& cqe = cqes[head&ring.cqMask];
+			if (cqe.user_data==QuitUserData)
+			{
+				quit = true;
+				continue;
+			}
+
+			const auto ix = static_cast<uint32_t>(cqe.user_data);
+			auto& req = m_requests[ix];
+			if (cqe.res>0)
+			{
+				req.done += static_cast<size_t>(cqe.res);
+				// short read not at EOF, keep going (the slot is still ours)
+				if (req.done<req.size)
+				{
+					pushSubmission(ix,IORING_OP_READ);
+					continue;
+				}
+			}
+			else if (cqe.res==-EINTR || cqe.res==-EAGAIN)
+			{
+				pushSubmission(ix,IORING_OP_READ);
+				continue;
+			}
+			// EOF or error, report what we've managed to read just like a blocking `read` would
+			complete(ix);
+		}
+		// hand the entries back to the kernel
+		std::atomic_ref(*ring.cqHead).store(head,std::memory_order_release);
+	}
+#endif
+}
+
+
+void CFileReadQueueLinux::initThreadPool(uint32_t workerCount)
+{
+	if (workerCount==0u)
+		workerCount = core::max(std::thread::hardware_concurrency(),1u);
+	// no point having more threads than reads in flight
+	workerCount = core::min<uint32_t>(workerCount,m_requests.size());
+
+	m_threads.reserve(workerCount);
+	for (uint32_t i=0u; i<workerCount; i++)
+		m_threads.emplace_back(&CFileReadQueueLinux::poolWorker,this);
+}
+
+void CFileReadQueueLinux::poolWorker()
+{
+	std::unique_lock lock(m_poolLock);
+	while (true)
+	{
+		m_poolCvar.wait(lock,[this]()->bool{return !m_poolQueue.empty()||m_quit;});
+		if (m_poolQueue.empty())
+			break;
+		const auto ix = m_poolQueue.front();
+		m_poolQueue.pop_front();
+		lock.unlock();
+
+		auto& req = m_requests[ix];
+		while (req.done<req.size)
+		{
+			const auto bytes = ::pread(req.fd,req.buffer+req.done,req.size-req.done,req.offset+req.done);
+			if (bytes<0 && errno==EINTR)
+				continue;
+			if (bytes<=0)
+				break;
+			req.done += static_cast<size_t>(bytes);
+		}
+		complete(ix);
+
+		lock.lock();
+	}
+}
+#endif
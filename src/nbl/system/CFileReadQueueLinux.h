@@ -0,0 +1,108 @@
+#ifndef _NBL_SYSTEM_C_FILE_READ_QUEUE_LINUX_H_INCLUDED_
+#define _NBL_SYSTEM_C_FILE_READ_QUEUE_LINUX_H_INCLUDED_
+
+#include "nbl/system/ISystem.h"
+
+#include <semaphore>
+
+namespace nbl::system
+{
+
+#ifdef _NBL_PLATFORM_LINUX_
+//! Keeps many unmapped reads in flight at once and completes their futures in whatever order the kernel finishes them.
+//! Uses io_uring when the kernel (and seccomp policy) allows it, otherwise falls back to a pool of threads doing blocking `pread`.
+class CFileReadQueueLinux final : public core::IReferenceCounted, private ISystem::IFutureManipulator
+{
+	public:
+		using native_file_handle_t = int;
+
+		struct SCreationParams
+		{
+			// max reads in flight, rounded up to PoT by the kernel
+			uint32_t queueDepth = 256u;
+			// 0 means `std::thread::hardware_concurrency()`
+			uint32_t fallbackWorkerCount = 0u;
+			// for benchmarking or broken kernels
+			bool forceThreadPool = false;
+		};
+		static core::smart_refctd_ptr<CFileReadQueueLinux> create(const SCreationParams& params);
+
+		//! `future` gets transitioned to the executing state right away, so its safe to let it go out of scope (it will block)
+		void submit(const native_file_handle_t fd, ISystem::future_t<size_t>& future, void* buffer, const size_t offset, const size_t size);
+
+		inline bool usesIOUring() const {return m_ring.fd>=0;}
+
+	protected:
+		~CFileReadQueueLinux();
+
+	private:
+		struct SRequest
+		{
+			ISystem::future_t<size_t>* future;
+			uint8_t* buffer;
+			size_t offset;
+			size_t size;
+			// bytes already read, short reads get resubmitted for the remainder
+			size_t done;
+			native_file_handle_t fd;
+			// free-list link
+			uint32_t next;
+		};
+		constexpr static inline uint32_t InvalidRequest = ~0u;
+
+		CFileReadQueueLinux(const uint32_t depth);
+
+		bool initIOUring(const uint32_t depth);
+		void initThreadPool(uint32_t workerCount);
+
+		// request slot management, the semaphore guarantees there's always a free slot when we take the lock
+		uint32_t acquireRequest();
+		void releaseRequest(const uint32_t ix);
+		void complete(const uint32_t ix);
+
+		// io_uring backend
+		void pushSubmission(const uint32_t ix, const uint8_t opcode);
+		void reapCompletions();
+
+		// thread pool fallback
+		void poolWorker();
+
+		std::counting_semaphore<> m_slots;
+		core::vector<SRequest> m_requests;
+		std::mutex m_requestLock;
+		uint32_t m_freeHead;
+
+		struct SRing
+		{
+			int fd = -1;
+			void* sqPtr = nullptr;
+			size_t sqSize = 0ull;
+			void* cqPtr = nullptr;
+			size_t cqSize = 0ull;
+			void* sqes = nullptr;
+			size_t sqesSize = 0ull;
+
+			uint32_t* sqHead;
+			uint32_t* sqTail;
+			uint32_t sqMask;
+			uint32_t* sqArray;
+			uint32_t* cqHead;
+			uint32_t* cqTail;
+			uint32_t cqMask;
+			void* cqes;
+		} m_ring;
+		// the SQ ring has a single producer, so submissions serialize on this
+		std::mutex m_submitLock;
+
+		std::mutex m_poolLock;
+		std::condition_variable m_poolCvar;
+		core::deque<uint32_t> m_poolQueue;
+
+		core::vector<std::thread> m_threads;
+		std::atomic_bool m_quit = false;
+};
+#endif
+
+}
+
+#endif
@@ -0,0 +1,150 @@
+#include "nbl/system/CWorkStealingThreadPool.h"
+
+using namespace nbl;
+using namespace nbl::system;
+
+namespace
+{
+thread_local CWorkStealingThreadPool* tl_pool = nullptr;
+thread_local uint32_t tl_queue = ~0u;
+// how long a thread with nothing to do sleeps before re-checking a `helpUntil` condition nobody notified about
+constexpr auto WaiterPollPeriod = std::chrono::milliseconds(1);
+}
+
+CWorkStealingThreadPool::CWorkStealingThreadPool(uint32_t workerCount)
+{
+	if (workerCount==0u)
+		workerCount = core::max(std::thread::hardware_concurrency(),2u)-1u;
+	m_queueCount = workerCount;
+	m_queues = std::make_unique<SQueue[]>(m_queueCount);
+
+	m_threads.reserve(workerCount);
+	for (uint32_t i=0u; i<workerCount; i++)
+		m_threads.emplace_back(&CWorkStealingThreadPool::worker,this,i);
+}
+
+CWorkStealingThreadPool::~CWorkStealingThreadPool()
+{
+	{
+		std::lock_guard lock(m_parkLock);
+		m_quit = true;
+	}
+	m_parkCvar.notify_all();
+	for (auto& thread : m_threads)
+		thread.join();
+}
+
+CWorkStealingThreadPool* CWorkStealingThreadPool::getCurrent()
+{
+	return tl_pool;
+}
+
+void CWorkStealingThreadPool::submit(CTaskGroup& group, task_t&& task)
+{
+	const uint32_t queueIx = tl_pool==this ? tl_queue:(m_nextQueue.fetch_add(1u,std::memory_order_relaxed)%m_queueCount);
+	group.m_pending.fetch_add(1u,std::memory_order_relaxed);
+	{
+		auto& queue = m_queues[queueIx];
+		std::lock_guard lock(queue.lock);
+		queue.tasks.push_back({std::move(task),&group});
+		// count before anyone can pop it
+		m_queued.fetch_add(1u,std::memory_order_release);
+	}
+	// taking the lock orders us against a worker which is about to park
+	{
+		std::lock_guard lock(m_parkLock);
+	}
+	m_parkCvar.notify_one();
+}
+
+void CWorkStealingThreadPool::helpUntil(const std::function<bool()>& pred)
+{
+	const uint32_t self = tl_pool==this ? tl_queue:~0u;
+	while (!pred())
+	{
+		if (tryRunOne(self))
+			continue;
+		std::unique_lock lock(m_parkLock);
+		m_parkCvar.wait_for(lock,WaiterPollPeriod,[&]()->bool{return m_queued.load(std::memory_order_acquire) || pred();});
+	}
+}
+
+void CWorkStealingThreadPool::waitOnly(const CTaskGroup& group)
+{
+	const uint32_t self = tl_pool==this ? tl_queue:~0u;
+	while (!group.done())
+	{
+		if (tryRunOne(self,&group))
+			continue;
+		// tasks of other groups being queued says nothing about ours, so no waking up on `m_queued`
+		std::unique_lock lock(m_parkLock);
+		m_parkCvar.wait_for(lock,WaiterPollPeriod,[&group]()->bool{return group.done();});
+	}
+}
+
+void CWorkStealingThreadPool::notifyWaiters()
+{
+	{
+		std::lock_guard lock(m_parkLock);
+	}
+	m_parkCvar.notify_all();
+}
+
+bool CWorkStealingThreadPool::tryRunOne(const uint32_t self, const CTaskGroup* only)
+{
+	if (m_queued.load(std::memory_order_acquire)==0u)
+		return false;
+
+	STask task;
+	bool found = false;
+	// own work first, newest first
+	if (self<m_queueCount)
+	{
+		auto& queue = m_queues[self];
+		std::lock_guard lock(queue.lock);
+		auto it = only ? std::find_if(queue.tasks.rbegin(),queue.tasks.rend(),[only](const STask& t)->bool{return t.group==only;}):queue.tasks.rbegin();
+		if (it!=queue.tasks.rend())
+		{
+			task = std::move(*it);
+			queue.tasks.erase(std::next(it).base());
+			found = true;
+		}
+	}
+	// then steal the oldest from someone else
+	const uint32_t start = self<m_queueCount ? (self+1u):m_nextQueue.load(std::memory_order_relaxed);
+	for (uint32_t i=0u; !found && i<m_queueCount; i++)
+	{
+		auto& queue = m_queues[(start+i)%m_queueCount];
+		std::lock_guard lock(queue.lock);
+		auto it = only ? std::find_if(queue.tasks.begin(),queue.tasks.end(),[only](const STask& t)->bool{return t.group==only;}):queue.tasks.begin();
+		if (it!=queue.tasks.end())
+		{
+			task = std::move(*it);
+			queue.tasks.erase(it);
+			found = true;
+		}
+	}
+	if (!found)
+		return false;
+	m_queued.fetch_sub(1u,std::memory_order_relaxed);
+
+	task.func();
+	if (task.group->m_pending.fetch_sub(1u,std::memory_order_acq_rel)==1u)
+		notifyWaiters();
+	return true;
+}
+
+void CWorkStealingThreadPool::worker(const uint32_t index)
+{
+	tl_pool = this;
+	tl_queue = index;
+	while (true)
+	{
+		if (tryRunOne(index))
+			continue;
+		std::unique_lock lock(m_parkLock);
+		m_parkCvar.wait(lock,[this]()->bool{return m_quit || m_queued.load(std::memory_order_acquire);});
+		if (m_quit && m_queued.load(std::memory_order_acquire)==0u)
+			break;
+	}
+}
@@ -11,6 +11,13 @@
 #include "nbl/system/CArchiveLoaderTar.h"
 #include "nbl/system/CMountDirectoryArchive.h"
 
+#include <random>
+#ifdef _NBL_PLATFORM_WINDOWS_
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
 using namespace nbl;
 using namespace nbl::system;
 
@@ -124,6 +131,21 @@ std::error_code ISystem::moveFileOrDirectory(const system::path& oldPath, const
     return ec;
 }
 
+system::path ISystem::getUniqueTemporaryPath(const system::path& target)
+{
+    // the process id tells processes apart, the counter threads and the random part a process which got the id of a crashed one
+    static std::atomic_uint32_t counter = 0u;
+    system::path retval = target;
+    #ifdef _NBL_PLATFORM_WINDOWS_
+    retval += "."+std::to_string(_getpid());
+    #else
+    retval += "."+std::to_string(getpid());
+    #endif
+    retval += "."+std::to_string(counter.fetch_add(1u,std::memory_order_relaxed));
+    retval += "."+std::to_string(std::random_device{}())+".tmp";
+    return retval;
+}
+
 bool ISystem::copy(const system::path& from, const system::path& to)
 {
     if (isPathReadOnly(to))
@@ -1,5 +1,8 @@
 #include "nbl/system/ISystemPOSIX.h"
 #include "nbl/system/CFilePOSIX.h"
+#ifdef _NBL_PLATFORM_LINUX_
+#include "nbl/system/CFileReadQueueLinux.h"
+#endif
 
 #include "nbl/system/IFile.h"
 
@@ -12,6 +15,34 @@ using namespace nbl::system;
 #include <sys/mman.h>
 #include <sys/stat.h>
 
+ISystemPOSIX::CCaller::CCaller(ISystemPOSIX* _system) : ICaller(_system)
+{
+#ifdef _NBL_PLATFORM_LINUX_
+	m_readQueue = CFileReadQueueLinux::create({});
+#endif
+}
+
+#ifdef _NBL_PLATFORM_LINUX_
+ISystemPOSIX::CCaller::~CCaller() = default;
+
+bool ISystemPOSIX::CCaller::submitRead(ISystemFile* file, future_t<size_t>& future, void* buffer, size_t offset, size_t size)
+{
+	// writes go through the dispatcher thread, so reads of a writable file have to queue behind them to see what got written
+	// (and the size clamping below would use a stale size anyway)
+	if (!m_readQueue || (file->getFlags()&IFile::ECF_WRITE))
+		return false;
+	// every `ISystemFile` this caller hands out is a `CFilePOSIX`
+	auto* const posixFile = static_cast<CFilePOSIX*>(file);
+	const size_t fileSize = posixFile->getSize();
+	if (offset>=fileSize)
+		size = 0ull;
+	else if (offset+size>fileSize)
+		size = fileSize-offset;
+	m_readQueue->submit(posixFile->getNativeHandle(),future,buffer,offset,size);
+	return true;
+}
+#endif
+
 core::smart_refctd_ptr<ISystemFile> ISystemPOSIX::CCaller::createFile(const std::filesystem::path& filename, const core::bitflag<IFile::E_CREATE_FLAGS> flags)
 {	
     const bool writeAccess = flags.value&IFile::ECF_WRITE;
@@ -243,6 +243,87 @@ core::smart_refctd_ptr<IGPUImage> CVulkanLogicalDevice::createImage(IGPUImage::S
     }
 }
 
+core::smart_refctd_ptr<IGPUPipelineCache> CVulkanLogicalDevice::createPipelineCache(const void* initialData, const size_t initialDataSize)
+{
+    const VkPipelineCache vk_pipelineCache = createVkPipelineCache(initialData, initialDataSize);
+    if (vk_pipelineCache == VK_NULL_HANDLE)
+        return nullptr;
+    return core::make_smart_refctd_ptr<CVulkanPipelineCache>(core::smart_refctd_ptr<ILogicalDevice>(this), vk_pipelineCache);
+}
+
+core::smart_refctd_dynamic_array<uint8_t> CVulkanLogicalDevice::getPipelineCacheData(VkPipelineCache pipelineCache) const
+{
+    if (pipelineCache == VK_NULL_HANDLE)
+        return nullptr;
+
+    // the cache can grow between the two calls when other threads create pipelines, so retry on VK_INCOMPLETE
+    for (uint32_t attempt = 0u; attempt < 4u; ++attempt)
+    {
+        size_t size = 0ull;
+        if (m_devf.vk.vkGetPipelineCacheData(m_vkdev, pipelineCache, &size, nullptr) != VK_SUCCESS || size == 0ull)
+            return nullptr;
+
+        auto retval = core::make_refctd_dynamic_array<core::smart_refctd_dynamic_array<uint8_t>>(size);
+        const VkResult result = m_devf.vk.vkGetPipelineCacheData(m_vkdev, pipelineCache, &size, retval->data());
+        if (result == VK_SUCCESS)
+        {
+            if (size == retval->size())
+                return retval;
+            auto shrunk = core::make_refctd_dynamic_array<core::smart_refctd_dynamic_array<uint8_t>>(size);
+            memcpy(shrunk->data(), retval->data(), size);
+            return shrunk;
+        }
+        if (result != VK_INCOMPLETE)
+            break;
+    }
+    return nullptr;
+}
+
+VkPipelineCache CVulkanLogicalDevice::createVkPipelineCache(const void* initialData, const size_t initialDataSize)
+{
+    // Drivers are meant to reject data they didn't write themselves, but not all of them do it gracefully,
+    // so check the header (layout fixed by the spec) before handing it over.
+    if (initialData && initialDataSize)
+    {
+        const auto& props = m_physicalDevice->getProperties();
+        VkPipelineCacheHeaderVersionOne header;
+        bool compatible = initialDataSize >= sizeof(header);
+        if (compatible)
+        {
+            memcpy(&header, initialData, sizeof(header));
+            compatible = header.headerSize >= sizeof(header) && header.headerSize <= initialDataSize &&
+                header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                header.vendorID == props.vendorID && header.deviceID == props.deviceID &&
+                memcmp(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+        }
+        if (!compatible)
+        {
+            if (auto* debugCallback = m_physicalDevice->getDebugCallback(); debugCallback && debugCallback->getLogger())
+                debugCallback->getLogger()->log("Pipeline Cache data was made by a different device or driver version, starting with an empty cache.", system::ILogger::ELL_INFO);
+            initialData = nullptr;
+        }
+    }
+
+    VkPipelineCacheCreateInfo vk_createInfo = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+    vk_createInfo.pNext = nullptr;
+    vk_createInfo.flags = static_cast<VkPipelineCacheCreateFlags>(0u);
+    vk_createInfo.initialDataSize = initialData ? initialDataSize : 0ull;
+    vk_createInfo.pInitialData = initialData;
+
+    VkPipelineCache vk_pipelineCache = VK_NULL_HANDLE;
+    if (m_devf.vk.vkCreatePipelineCache(m_vkdev, &vk_createInfo, nullptr, &vk_pipelineCache) == VK_SUCCESS)
+        return vk_pipelineCache;
+    // the driver may still refuse the data, an empty cache is better than none
+    if (initialData)
+    {
+        vk_createInfo.initialDataSize = 0ull;
+        vk_createInfo.pInitialData = nullptr;
+        if (m_devf.vk.vkCreatePipelineCache(m_vkdev, &vk_createInfo, nullptr, &vk_pipelineCache) == VK_SUCCESS)
+            return vk_pipelineCache;
+    }
+    return VK_NULL_HANDLE;
+}
+
 core::smart_refctd_ptr<IGPUGraphicsPipeline> CVulkanLogicalDevice::createGraphicsPipeline_impl(
     IGPUPipelineCache* pipelineCache,
     IGPUGraphicsPipeline::SCreationParams&& params)
@@ -261,9 +342,7 @@ bool CVulkanLogicalDevice::createGraphicsPipelines_impl(
 {
     IGPUGraphicsPipeline::SCreationParams* creationParams = const_cast<IGPUGraphicsPipeline::SCreationParams*>(params.begin());
 
-    VkPipelineCache vk_pipelineCache = VK_NULL_HANDLE;
-    if (pipelineCache && pipelineCache->getAPIType() == EAT_VULKAN)
-        vk_pipelineCache = IBackendObject::device_compatibility_cast<const CVulkanPipelineCache*>(pipelineCache, this)->getInternalObject();
+    const VkPipelineCache vk_pipelineCache = getVkPipelineCache(pipelineCache);
 
     // Shader stages
     uint32_t shaderStageCount_total = 0u;
@@ -70,10 +70,21 @@ public:
         }
 
         m_dummyDSLayout = createDescriptorSetLayout(nullptr, nullptr);
+
+        // used by all pipeline creation which doesn't get a cache passed
+        {
+            const auto initialData = readPipelineCacheFile(m_pipelineCachePath);
+            m_defaultPipelineCache = createVkPipelineCache(initialData ? initialData->data():nullptr, initialData ? initialData->size():0ull);
+        }
     }
             
     ~CVulkanLogicalDevice()
     {
+        if (m_defaultPipelineCache != VK_NULL_HANDLE)
+        {
+            saveDefaultPipelineCache();
+            m_devf.vk.vkDestroyPipelineCache(m_vkdev, m_defaultPipelineCache, nullptr);
+        }
         m_devf.vk.vkDestroyDevice(m_vkdev, nullptr);
     }
             
@@ -897,6 +908,16 @@ public:
     inline const void* getNativeHandle() const {return &m_vkdev;}
     VkDevice getInternalObject() const {return m_vkdev;}
 
+    core::smart_refctd_ptr<IGPUPipelineCache> createPipelineCache(const void* initialData=nullptr, const size_t initialDataSize=0ull) override;
+
+    core::smart_refctd_dynamic_array<uint8_t> getDefaultPipelineCacheData() const override
+    {
+        return getPipelineCacheData(m_defaultPipelineCache);
+    }
+
+    //! nullptr on failure
+    core::smart_refctd_dynamic_array<uint8_t> getPipelineCacheData(VkPipelineCache pipelineCache) const;
+
 protected:
     bool createCommandBuffers_impl(IGPUCommandPool* cmdPool, IGPUCommandBuffer::E_LEVEL level,
         uint32_t count, core::smart_refctd_ptr<IGPUCommandBuffer>* outCmdBufs) override;
@@ -1211,9 +1232,7 @@ protected:
             }
         }
 
-        VkPipelineCache vk_pipelineCache = VK_NULL_HANDLE;
-        if (pipelineCache && pipelineCache->getAPIType() == EAT_VULKAN)
-            vk_pipelineCache = IBackendObject::device_compatibility_cast<const CVulkanPipelineCache*>(pipelineCache, this)->getInternalObject();
+        const VkPipelineCache vk_pipelineCache = getVkPipelineCache(pipelineCache);
 
         VkPipelineShaderStageCreateInfo vk_shaderStageCreateInfos[MAX_PIPELINE_COUNT];
         VkSpecializationInfo vk_specializationInfos[MAX_PIPELINE_COUNT];
@@ -1409,6 +1428,20 @@ protected:
     bool createGraphicsPipelines_impl(IGPUPipelineCache* pipelineCache, core::SRange<const IGPUGraphicsPipeline::SCreationParams> params, core::smart_refctd_ptr<IGPUGraphicsPipeline>* output) override;
 
 private:
+    // the data gets validated first, an empty cache gets created if it doesn't match this device
+    VkPipelineCache createVkPipelineCache(const void* initialData, const size_t initialDataSize);
+
+    // null picks the default cache, VK_NULL_HANDLE if the cache isn't from this device
+    inline VkPipelineCache getVkPipelineCache(const IGPUPipelineCache* pipelineCache) const
+    {
+        if (!pipelineCache)
+            return m_defaultPipelineCache;
+        if (pipelineCache->getAPIType() != EAT_VULKAN)
+            return VK_NULL_HANDLE;
+        const auto* vulkanPipelineCache = IBackendObject::device_compatibility_cast<const CVulkanPipelineCache*>(pipelineCache, this);
+        return vulkanPipelineCache ? vulkanPipelineCache->getInternalObject():VK_NULL_HANDLE;
+    }
+
     inline void getVkMappedMemoryRanges(VkMappedMemoryRange* outRanges, const IDeviceMemoryAllocation::MappedMemoryRange* inRangeBegin, const IDeviceMemoryAllocation::MappedMemoryRange* inRangeEnd)
     {
         uint32_t k = 0u;
@@ -1435,6 +1468,8 @@ private:
     memory_pool_mt_t m_deferred_op_mempool;
 
     core::smart_refctd_ptr<video::IGPUDescriptorSetLayout> m_dummyDSLayout = nullptr;
+    // not an `IGPUPipelineCache`, that would keep the device alive forever
+    VkPipelineCache m_defaultPipelineCache = VK_NULL_HANDLE;
 };
 
 }
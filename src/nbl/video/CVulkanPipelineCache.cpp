@@ -12,6 +12,50 @@ CVulkanPipelineCache::~CVulkanPipelineCache()
     vk->vk.vkDestroyPipelineCache(vulkanDevice->getInternalObject(), m_pipelineCache, nullptr);
 }
 
+bool CVulkanPipelineCache::merge(uint32_t _count, const IGPUPipelineCache** _srcCaches)
+{
+    if (_count==0u)
+        return true;
+
+    const CVulkanLogicalDevice* vulkanDevice = static_cast<const CVulkanLogicalDevice*>(getOriginDevice());
+    core::vector<VkPipelineCache> vk_srcCaches(_count);
+    for (uint32_t i=0u; i<_count; ++i)
+    {
+        auto* srcCache = IBackendObject::device_compatibility_cast<const CVulkanPipelineCache*>(_srcCaches[i],vulkanDevice);
+        if (!srcCache || srcCache==this)
+            return false;
+        vk_srcCaches[i] = srcCache->getInternalObject();
+    }
+
+    auto* vk = vulkanDevice->getFunctionTable();
+    return vk->vk.vkMergePipelineCaches(vulkanDevice->getInternalObject(),m_pipelineCache,_count,vk_srcCaches.data())==VK_SUCCESS;
+}
+
+core::smart_refctd_dynamic_array<uint8_t> CVulkanPipelineCache::getData() const
+{
+    const CVulkanLogicalDevice* vulkanDevice = static_cast<const CVulkanLogicalDevice*>(getOriginDevice());
+    return vulkanDevice->getPipelineCacheData(m_pipelineCache);
+}
+
+core::smart_refctd_ptr<asset::ICPUPipelineCache> CVulkanPipelineCache::convertToCPUCache() const
+{
+    auto data = getData();
+    if (!data)
+        return nullptr;
+
+    const auto& props = getOriginDevice()->getPhysicalDevice()->getProperties();
+    asset::ICPUPipelineCache::SCacheKey key;
+    key.gpuid.backend = asset::ICPUPipelineCache::EB_VULKAN;
+    key.gpuid.UUID.assign(reinterpret_cast<const char*>(props.pipelineCacheUUID),VK_UUID_SIZE);
+    asset::ICPUPipelineCache::SCacheVal val;
+    val.extra = 0u;
+    val.bin = std::move(data);
+
+    asset::ICPUPipelineCache::entries_map_t entries;
+    entries.emplace(std::move(key),std::move(val));
+    return core::make_smart_refctd_ptr<asset::ICPUPipelineCache>(std::move(entries));
+}
+
 void CVulkanPipelineCache::setObjectDebugName(const char* label) const
 {
     IBackendObject::setObjectDebugName(label);
@@ -20,6 +20,13 @@ public:
 
     inline VkPipelineCache getInternalObject() const { return m_pipelineCache; }
 
+    bool merge(uint32_t _count, const IGPUPipelineCache** _srcCaches) override;
+
+    core::smart_refctd_dynamic_array<uint8_t> getData() const override;
+
+    //! single entry keyed by the device's `pipelineCacheUUID`
+    core::smart_refctd_ptr<asset::ICPUPipelineCache> convertToCPUCache() const override;
+
     void setObjectDebugName(const char* label) const override;
 
 private:
@@ -5,7 +5,7 @@ using namespace nbl::video;
 
 
 ILogicalDevice::ILogicalDevice(core::smart_refctd_ptr<IAPIConnection>&& api, IPhysicalDevice* physicalDevice, const SCreationParams& params)
-    : m_api(api), m_physicalDevice(physicalDevice), m_enabledFeatures(params.featuresToEnable), m_compilerSet(params.compilerSet)
+    : m_api(api), m_physicalDevice(physicalDevice), m_enabledFeatures(params.featuresToEnable), m_compilerSet(params.compilerSet), m_pipelineCachePath(params.pipelineCachePath)
 {
     uint32_t qcnt = 0u;
     uint8_t greatestFamNum = 0u;
@@ -101,3 +101,96 @@ bool ILogicalDevice::updateDescriptorSets(uint32_t descriptorWriteCount, const I
 
     return true;
 }
+
+core::smart_refctd_ptr<IGPUPipelineCache> ILogicalDevice::loadPipelineCache(const system::path& path)
+{
+    const auto data = readPipelineCacheFile(path);
+    if (data)
+        return createPipelineCache(data->data(),data->size());
+    return createPipelineCache();
+}
+
+bool ILogicalDevice::savePipelineCache(const IGPUPipelineCache* cache, const system::path& path)
+{
+    if (!cache || !cache->wasCreatedBy(this))
+        return false;
+    return writePipelineCacheFile(path,cache->getData());
+}
+
+bool ILogicalDevice::saveDefaultPipelineCache()
+{
+    if (m_pipelineCachePath.empty())
+        return false;
+    return writePipelineCacheFile(m_pipelineCachePath,getDefaultPipelineCacheData());
+}
+
+core::smart_refctd_dynamic_array<uint8_t> ILogicalDevice::readPipelineCacheFile(const system::path& path) const
+{
+    if (path.empty())
+        return nullptr;
+
+    core::smart_refctd_ptr<system::IFile> file;
+    {
+        system::ISystem::future_t<core::smart_refctd_ptr<system::IFile>> future;
+        m_physicalDevice->getSystem()->createFile(future,path,system::IFileBase::ECF_READ);
+        if (future.wait())
+            future.acquire().move_into(file);
+    }
+    // not being there yet is the normal state of affairs on the first run
+    if (!file || file->getSize()==0ull)
+        return nullptr;
+
+    auto retval = core::make_refctd_dynamic_array<core::smart_refctd_dynamic_array<uint8_t>>(file->getSize());
+    system::IFile::success_t succ;
+    file->read(succ,retval->data(),0,retval->size());
+    if (!succ)
+    {
+        if (auto* debugCallback=m_physicalDevice->getDebugCallback(); debugCallback && debugCallback->getLogger())
+            debugCallback->getLogger()->log("Could not read Pipeline Cache \"%s\", starting with an empty one.",system::ILogger::ELL_WARNING,path.string().c_str());
+        return nullptr;
+    }
+    return retval;
+}
+
+bool ILogicalDevice::writePipelineCacheFile(const system::path& path, const core::smart_refctd_dynamic_array<uint8_t>& data) const
+{
+    if (!data)
+        return false;
+
+    // write next to the old file and swap them, so a crash mid-write can't leave a truncated cache behind,
+    // every writer gets its own temporary as devices (or processes) can share the path
+    const system::path tmpPath = system::ISystem::getUniqueTemporaryPath(path);
+    auto removeTmp = [&tmpPath]() -> void
+    {
+        std::error_code error;
+        std::filesystem::remove(tmpPath,error);
+    };
+    {
+        core::smart_refctd_ptr<system::IFile> file;
+        {
+            system::ISystem::future_t<core::smart_refctd_ptr<system::IFile>> future;
+            m_physicalDevice->getSystem()->createFile(future,tmpPath,system::IFileBase::ECF_WRITE);
+            if (future.wait())
+                future.acquire().move_into(file);
+        }
+        system::IFile::success_t succ;
+        if (file)
+            file->write(succ,data->data(),0,data->size());
+        if (!file || !succ)
+        {
+            if (auto* debugCallback=m_physicalDevice->getDebugCallback(); debugCallback && debugCallback->getLogger())
+                debugCallback->getLogger()->log("Could not write Pipeline Cache to \"%s\".",system::ILogger::ELL_ERROR,tmpPath.string().c_str());
+            file = nullptr;
+            removeTmp();
+            return false;
+        }
+    }
+    if (const auto error=m_physicalDevice->getSystem()->moveFileOrDirectory(tmpPath,path); error)
+    {
+        if (auto* debugCallback=m_physicalDevice->getDebugCallback(); debugCallback && debugCallback->getLogger())
+            debugCallback->getLogger()->log("Could not replace Pipeline Cache \"%s\": %s",system::ILogger::ELL_ERROR,path.string().c_str(),error.message().c_str());
+        removeTmp();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,413 @@
+// Copyright (C) 2018-2023 - DevSH Graphics Programming Sp. z O.O.
+// This file is part of the "Nabla Engine".
+// For conditions of distribution and use, see copyright notice in nabla.h
+
+#include "nbl/video/IPhysicalDevice.h"
+#include "nbl/video/alloc/CDeviceMemorySubAllocator.h"
+
+#include "nbl/core/alloc/PoolAddressAllocator.h"
+#include "nbl/core/alloc/GeneralpurposeAddressAllocator.h"
+
+#include <thread>
+#include <atomic>
+
+using namespace nbl;
+using namespace video;
+
+struct CDeviceMemorySubAllocator::SBlock
+{
+    using pool_alctr_t = core::PoolAddressAllocator<size_t>;
+    using general_alctr_t = core::GeneralpurposeAddressAllocator<size_t>;
+    _NBL_STATIC_INLINE_CONSTEXPR uint32_t GeneralPurpose = ~0u;
+
+    inline SBlock(core::smart_refctd_ptr<IDeviceMemoryAllocation>&& _memory, const uint32_t _poolKey, const uint32_t _sizeClass)
+        : memory(std::move(_memory)), poolKey(_poolKey), sizeClass(_sizeClass) {}
+    inline ~SBlock()
+    {
+        if (reserved)
+            _NBL_ALIGNED_FREE(reserved);
+    }
+
+    inline size_t allocAddr(const size_t bytes, const size_t alignment)
+    {
+        const size_t addr = sizeClass!=GeneralPurpose ? poolAllocator.alloc_addr(bytes,alignment):generalAllocator.alloc_addr(bytes,alignment);
+        if (addr!=pool_alctr_t::invalid_address)
+            allocatedBytes += bytes;
+        return addr;
+    }
+
+    core::smart_refctd_ptr<IDeviceMemoryAllocation> memory;
+    void* reserved = nullptr;
+    // only the one matching `sizeClass` gets used
+    pool_alctr_t poolAllocator;
+    general_alctr_t generalAllocator;
+    const uint32_t poolKey;
+    const uint32_t sizeClass;
+    size_t allocatedBytes = 0ull;
+    // no allocations come out of the block while it gets evacuated
+    std::atomic_bool draining = false;
+};
+
+core::smart_refctd_ptr<CDeviceMemorySubAllocator> CDeviceMemorySubAllocator::create(SCreationParams&& params)
+{
+    if (!params.device)
+        return nullptr;
+    if (params.maxSubAllocationSize==0ull)
+        params.maxSubAllocationSize = params.blockSize>>1ull;
+    if (params.minSizeClass==0ull || params.minSizeClass>params.maxSizeClass || params.maxSizeClass>params.sizeClassBlockSize)
+        return nullptr;
+    if (params.maxSubAllocationSize>params.blockSize || !core::isPoT(params.maxAlignment))
+        return nullptr;
+    params.minSizeClass = core::roundUpToPoT(params.minSizeClass);
+    params.maxSizeClass = core::roundUpToPoT(params.maxSizeClass);
+
+    auto* retval = new CDeviceMemorySubAllocator(std::move(params));
+    return core::smart_refctd_ptr<CDeviceMemorySubAllocator>(retval,core::dont_grab);
+}
+
+CDeviceMemorySubAllocator::CDeviceMemorySubAllocator(SCreationParams&& params) : m_params(std::move(params))
+{
+    const auto* physicalDevice = m_params.device->getPhysicalDevice();
+    const auto& limits = physicalDevice->getLimits();
+    const auto& memoryProperties = physicalDevice->getMemoryProperties();
+    const size_t bufferImageGranularity = core::max<size_t>(core::min<size_t>(limits.bufferImageGranularity,m_params.maxAlignment),1ull);
+    for (uint32_t i=0u; i<32u; i++)
+    {
+        m_granularities[i] = bufferImageGranularity;
+        if (i>=memoryProperties.memoryTypeCount)
+            continue;
+        const auto propertyFlags = memoryProperties.memoryTypes[i].propertyFlags;
+        const bool hostVisible = propertyFlags.hasFlags(IDeviceMemoryAllocation::EMPF_HOST_READABLE_BIT)||propertyFlags.hasFlags(IDeviceMemoryAllocation::EMPF_HOST_WRITABLE_BIT);
+        if (hostVisible && !propertyFlags.hasFlags(IDeviceMemoryAllocation::EMPF_HOST_COHERENT_BIT))
+            m_granularities[i] = core::max<size_t>(m_granularities[i],limits.nonCoherentAtomSize);
+    }
+    // everything in the general purpose blocks is bigger than the biggest size class anyway
+    m_generalPurposeMinBlockSize = core::max<size_t>(bufferImageGranularity,m_params.maxSizeClass>>2ull);
+    m_minSizeClassLog2 = core::findMSB<uint64_t>(m_params.minSizeClass);
+    m_sizeClassCount = core::findMSB<uint64_t>(m_params.maxSizeClass)-m_minSizeClassLog2+1u;
+}
+
+CDeviceMemorySubAllocator::~CDeviceMemorySubAllocator()
+{
+    // resources still bound keep their block's memory alive through their own reference
+}
+
+auto CDeviceMemorySubAllocator::getThreadCache() -> SThreadCache&
+{
+    return m_threadCaches[std::hash<std::thread::id>()(std::this_thread::get_id())%ThreadCacheCount];
+}
+
+auto CDeviceMemorySubAllocator::allocate(const SAllocateInfo& info) -> SMemoryOffset
+{
+    const size_t granularity = m_granularities[info.memoryTypeIndex];
+    const size_t alignment = core::max<size_t>(0x1ull<<info.alignmentLog2,granularity);
+    if (info.dedication || info.size==0ull || info.size>m_params.maxSubAllocationSize || alignment>m_params.maxAlignment)
+        return m_params.device->allocate(info);
+
+    const uint32_t poolKey = getPoolKey(info);
+    const size_t size = core::roundUp<size_t>(info.size,granularity);
+    const size_t classBytes = core::max<size_t>(core::roundUpToPoT(core::max(size,alignment)),m_params.minSizeClass);
+    if (classBytes<=m_params.maxSizeClass)
+    {
+        const uint32_t sizeClass = core::findMSB<uint64_t>(classBytes)-m_minSizeClassLog2;
+        // allocations of blocks which started draining after they got cached go back to the blocks
+        core::vector<SCachedAllocation> draining;
+        {
+            auto& cache = getThreadCache();
+            std::lock_guard lock(cache.lock);
+            if (auto found=cache.allocations.find(getCacheKey(poolKey,sizeClass)); found!=cache.allocations.end())
+            while (!found->second.empty())
+            {
+                const auto cached = found->second.back();
+                found->second.pop_back();
+                if (!cached.block->draining)
+                    return {core::smart_refctd_ptr(cached.block->memory),cached.offset};
+                draining.push_back(cached);
+            }
+        }
+
+        std::lock_guard lock(m_lock);
+        for (const auto& cached : draining)
+            freeInBlock(cached.block,cached.offset,classBytes);
+        auto& pool = m_pools[poolKey];
+        pool.sizeClassBlocks.resize(m_sizeClassCount);
+        for (auto& block : pool.sizeClassBlocks[sizeClass])
+        if (!block->draining)
+        {
+            const size_t offset = block->allocAddr(classBytes,classBytes);
+            if (offset!=SBlock::pool_alctr_t::invalid_address)
+                return {core::smart_refctd_ptr(block->memory),offset};
+        }
+        if (auto* block=createBlock(info,sizeClass,classBytes); block)
+            return {core::smart_refctd_ptr(block->memory),block->allocAddr(classBytes,classBytes)};
+    }
+    else
+    {
+        std::lock_guard lock(m_lock);
+        for (auto& block : m_pools[poolKey].blocks)
+        if (!block->draining)
+        {
+            const size_t offset = block->allocAddr(size,alignment);
+            if (offset!=SBlock::general_alctr_t::invalid_address)
+                return {core::smart_refctd_ptr(block->memory),offset};
+        }
+        if (auto* block=createBlock(info,SBlock::GeneralPurpose,size); block)
+        {
+            const size_t offset = block->allocAddr(size,alignment);
+            if (offset!=SBlock::general_alctr_t::invalid_address)
+                return {core::smart_refctd_ptr(block->memory),offset};
+        }
+    }
+    return {nullptr,InvalidMemoryOffset};
+}
+
+void CDeviceMemorySubAllocator::deallocate(const SMemoryOffset& allocation, const size_t size)
+{
+    if (!allocation.isValid())
+        return;
+
+    SBlock* block;
+    {
+        std::shared_lock lock(m_blockLookupLock);
+        auto found = m_blockLookup.find(allocation.memory.get());
+        if (found==m_blockLookup.end())
+            return;
+        // the allocation being freed keeps the block from getting destroyed until `freeInBlock`
+        block = found->second;
+    }
+
+    if (block->sizeClass!=SBlock::GeneralPurpose)
+    {
+        if (!block->draining)
+        {
+            auto& cache = getThreadCache();
+            std::lock_guard lock(cache.lock);
+            auto& cached = cache.allocations[getCacheKey(block->poolKey,block->sizeClass)];
+            if (cached.size()<m_params.threadCacheSize)
+            {
+                cached.push_back({block,allocation.offset});
+                return;
+            }
+        }
+        std::lock_guard lock(m_lock);
+        freeInBlock(block,allocation.offset,getSizeClassBytes(block->sizeClass));
+    }
+    else
+    {
+        const size_t granularity = m_granularities[block->poolKey&0x1fu];
+        std::lock_guard lock(m_lock);
+        freeInBlock(block,allocation.offset,core::roundUp<size_t>(size,granularity));
+    }
+}
+
+uint32_t CDeviceMemorySubAllocator::trim()
+{
+    std::lock_guard lock(m_lock);
+    flushThreadCaches();
+    return freeEmptyBlocks(false);
+}
+
+uint32_t CDeviceMemorySubAllocator::defragment(const float maxOccupancy, const std::function<void(IDeviceMemoryAllocation*)>& evacuate)
+{
+    core::vector<core::smart_refctd_ptr<IDeviceMemoryAllocation>> candidates;
+    size_t candidateCount;
+    {
+        std::lock_guard lock(m_lock);
+        core::vector<std::pair<float,SBlock*>> sparse;
+        auto collect = [&sparse,maxOccupancy](core::vector<std::unique_ptr<SBlock>>& blocks) -> void
+        {
+            for (auto& block : blocks)
+            {
+                const float occupancy = float(block->allocatedBytes)/float(block->memory->getAllocationSize());
+                if (occupancy>maxOccupancy)
+                    continue;
+                block->draining = true;
+                sparse.emplace_back(occupancy,block.get());
+            }
+        };
+        for (auto& pool : m_pools)
+        {
+            collect(pool.second.blocks);
+            for (auto& blocks : pool.second.sizeClassBlocks)
+                collect(blocks);
+        }
+        std::sort(sparse.begin(),sparse.end(),[](const auto& lhs, const auto& rhs)->bool{return lhs.first<rhs.first;});
+        candidateCount = sparse.size();
+        candidates.reserve(candidateCount);
+        for (const auto& candidate : sparse)
+            candidates.push_back(candidate.second->memory);
+        // cached allocations of the draining blocks are free already, which might leave some empty
+        flushThreadCaches();
+        freeEmptyBlocks(true);
+    }
+
+    for (const auto& memory : candidates)
+    {
+        {
+            std::shared_lock lock(m_blockLookupLock);
+            if (m_blockLookup.find(memory.get())==m_blockLookup.end())
+                continue;
+        }
+        evacuate(memory.get());
+    }
+
+    std::lock_guard lock(m_lock);
+    size_t survivors = 0u;
+    for (const auto& memory : candidates)
+    {
+        std::shared_lock lookupLock(m_blockLookupLock);
+        if (auto found=m_blockLookup.find(memory.get()); found!=m_blockLookup.end())
+        {
+            found->second->draining = false;
+            survivors++;
+        }
+    }
+    return static_cast<uint32_t>(candidateCount-survivors);
+}
+
+auto CDeviceMemorySubAllocator::getStatistics() const -> SStatistics
+{
+    SStatistics retval;
+    std::lock_guard lock(m_lock);
+    auto accumulate = [&retval](const core::vector<std::unique_ptr<SBlock>>& blocks) -> void
+    {
+        for (const auto& block : blocks)
+        {
+            retval.blockCount++;
+            retval.blockBytes += block->memory->getAllocationSize();
+            retval.allocatedBytes += block->allocatedBytes;
+        }
+    };
+    for (const auto& pool : m_pools)
+    {
+        accumulate(pool.second.blocks);
+        for (const auto& blocks : pool.second.sizeClassBlocks)
+            accumulate(blocks);
+    }
+    return retval;
+}
+
+auto CDeviceMemorySubAllocator::createBlock(const SAllocateInfo& info, const uint32_t sizeClass, const size_t minSize) -> SBlock*
+{
+    SAllocateInfo blockInfo = info;
+    blockInfo.alignmentLog2 = 0u;
+    blockInfo.dedication = nullptr;
+
+    SMemoryOffset allocation = {nullptr,InvalidMemoryOffset};
+    const size_t preferredSize = sizeClass!=SBlock::GeneralPurpose ? m_params.sizeClassBlockSize:m_params.blockSize;
+    // out of device memory or over the heap's budget, see if a smaller block fits
+    for (size_t blockSize=preferredSize; blockSize>=minSize && !allocation.isValid(); blockSize>>=1ull)
+    {
+        blockInfo.size = blockSize;
+        allocation = m_params.device->allocate(blockInfo);
+    }
+    if (!allocation.isValid())
+        return nullptr;
+    const size_t blockSize = allocation.memory->getAllocationSize();
+
+    auto block = std::make_unique<SBlock>(std::move(allocation.memory),getPoolKey(info),sizeClass);
+    if (sizeClass!=SBlock::GeneralPurpose)
+    {
+        const size_t classBytes = getSizeClassBytes(sizeClass);
+        block->reserved = _NBL_ALIGNED_MALLOC(SBlock::pool_alctr_t::reserved_size(classBytes,blockSize,classBytes),_NBL_SIMD_ALIGNMENT);
+        block->poolAllocator = SBlock::pool_alctr_t(block->reserved,0ull,0ull,classBytes,blockSize,classBytes);
+    }
+    else
+    {
+        block->reserved = _NBL_ALIGNED_MALLOC(SBlock::general_alctr_t::reserved_size(m_params.maxAlignment,blockSize,m_generalPurposeMinBlockSize),_NBL_SIMD_ALIGNMENT);
+        block->generalAllocator = SBlock::general_alctr_t(block->reserved,0ull,0ull,m_params.maxAlignment,blockSize,m_generalPurposeMinBlockSize);
+    }
+
+    if (block->memory->isMappable())
+    {
+        const auto propertyFlags = block->memory->getMemoryPropertyFlags();
+        core::bitflag<IDeviceMemoryAllocation::E_MAPPING_CPU_ACCESS_FLAGS> access = IDeviceMemoryAllocation::EMCAF_NO_MAPPING_ACCESS;
+        if (propertyFlags.hasFlags(IDeviceMemoryAllocation::EMPF_HOST_READABLE_BIT))
+            access |= IDeviceMemoryAllocation::EMCAF_READ;
+        if (propertyFlags.hasFlags(IDeviceMemoryAllocation::EMPF_HOST_WRITABLE_BIT))
+            access |= IDeviceMemoryAllocation::EMCAF_WRITE;
+        m_params.device->mapMemory(IDeviceMemoryAllocation::MappedMemoryRange(block->memory.get(),0ull,blockSize),access);
+    }
+
+    auto* const retval = block.get();
+    {
+        std::unique_lock lock(m_blockLookupLock);
+        m_blockLookup[retval->memory.get()] = retval;
+    }
+    auto& pool = m_pools[retval->poolKey];
+    if (sizeClass!=SBlock::GeneralPurpose)
+        pool.sizeClassBlocks[sizeClass].push_back(std::move(block));
+    else
+        pool.blocks.push_back(std::move(block));
+    return retval;
+}
+
+void CDeviceMemorySubAllocator::freeInBlock(SBlock* block, const size_t offset, const size_t size)
+{
+    if (block->sizeClass!=SBlock::GeneralPurpose)
+        block->poolAllocator.free_addr(offset,size);
+    else
+        block->generalAllocator.free_addr(offset,size);
+    block->allocatedBytes -= size;
+    if (block->draining && block->allocatedBytes==0ull)
+        destroyBlock(block);
+}
+
+void CDeviceMemorySubAllocator::destroyBlock(SBlock* block)
+{
+    {
+        std::unique_lock lock(m_blockLookupLock);
+        m_blockLookup.erase(block->memory.get());
+    }
+    auto& pool = m_pools[block->poolKey];
+    auto& blocks = block->sizeClass!=SBlock::GeneralPurpose ? pool.sizeClassBlocks[block->sizeClass]:pool.blocks;
+    blocks.erase(std::find_if(blocks.begin(),blocks.end(),[block](const auto& item)->bool{return item.get()==block;}));
+}
+
+void CDeviceMemorySubAllocator::flushThreadCaches()
+{
+    for (auto& cache : m_threadCaches)
+    {
+        core::vector<SCachedAllocation> flushed;
+        {
+            std::lock_guard lock(cache.lock);
+            for (auto& cached : cache.allocations)
+            {
+                flushed.insert(flushed.end(),cached.second.begin(),cached.second.end());
+                cached.second.clear();
+            }
+        }
+        // the cache lock can't be held while blocks get destroyed
+        for (const auto& cached : flushed)
+            freeInBlock(cached.block,cached.offset,getSizeClassBytes(cached.block->sizeClass));
+    }
+}
+
+uint32_t CDeviceMemorySubAllocator::freeEmptyBlocks(const bool drainingOnly)
+{
+    uint32_t freed = 0u;
+    auto sweep = [&](core::vector<std::unique_ptr<SBlock>>& blocks) -> void
+    {
+        // not `remove_if`, the blocks past the new end need to stay valid until they're out of the lookup
+        auto newEnd = std::stable_partition(blocks.begin(),blocks.end(),[drainingOnly](const std::unique_ptr<SBlock>& block)->bool
+        {
+            return block->allocatedBytes!=0ull || (drainingOnly && !block->draining);
+        });
+        if (newEnd==blocks.end())
+            return;
+        {
+            std::unique_lock lock(m_blockLookupLock);
+            for (auto it=newEnd; it!=blocks.end(); it++)
+                m_blockLookup.erase((*it)->memory.get());
+        }
+        freed += static_cast<uint32_t>(std::distance(newEnd,blocks.end()));
+        blocks.erase(newEnd,blocks.end());
+    };
+    for (auto& pool : m_pools)
+    {
+        sweep(pool.second.blocks);
+        for (auto& blocks : pool.second.sizeClassBlocks)
+            sweep(blocks);
+    }
+    return freed;
+}